@@ -187,6 +187,30 @@ virAdmServerPtr virAdmConnectLookupServer(virAdmConnectPtr conn,
 
 # define VIR_THREADPOOL_JOB_QUEUE_DEPTH "jobQueueDepth"
 
+/**
+ * VIR_THREADPOOL_JOB_QUEUE_DEPTH_PRIORITY:
+ * Macro for the threadpool prioJobQueueDepth attribute: represents the
+ * number of high priority jobs among those waiting in the queue, as
+ * VIR_TYPED_PARAM_UINT.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ */
+
+# define VIR_THREADPOOL_JOB_QUEUE_DEPTH_PRIORITY "prioJobQueueDepth"
+
+/**
+ * VIR_THREADPOOL_JOB_QUEUE_AGE:
+ * Macro for the threadpool jobQueueAge attribute: represents how long, in
+ * milliseconds, the oldest job in the queue has been waiting for a worker,
+ * as VIR_TYPED_PARAM_UINT.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ */
+
+# define VIR_THREADPOOL_JOB_QUEUE_AGE "jobQueueAge"
+
 /* Tunables for a server workerpool */
 int virAdmServerGetThreadPoolParameters(virAdmServerPtr srv,
                                         virTypedParameterPtr *params,
@@ -1118,6 +1118,33 @@ virDomainPtr            virDomainLookupByUUID   (virConnectPtr conn,
                                                  const unsigned char *uuid);
 virDomainPtr            virDomainLookupByUUIDString     (virConnectPtr conn,
                                                          const char *uuid);
+int                     virConnectLookupDomainsByUUID(virConnectPtr conn,
+                                                      const unsigned char *uuids,
+                                                      unsigned int nuuids,
+                                                      virDomainPtr **domains,
+                                                      int **states,
+                                                      unsigned int flags);
+
+/**
+ * virDomainLookupCallback:
+ * @conn: connection the lookup was made on
+ * @dom: the domain found, or NULL on failure
+ * @opaque: application specified data
+ *
+ * Callback receiving the result of virDomainLookupByUUIDAsync().
+ * On failure, virGetLastError() describes the error. @dom is freed
+ * when the callback returns, use virDomainRef() to keep it.
+ */
+typedef void (*virDomainLookupCallback)(virConnectPtr conn,
+                                        virDomainPtr dom,
+                                        void *opaque);
+
+int                     virDomainLookupByUUIDAsync(virConnectPtr conn,
+                                                   const unsigned char *uuid,
+                                                   virDomainLookupCallback cb,
+                                                   void *opaque,
+                                                   virFreeCallback freecb,
+                                                   unsigned int flags);
 
 typedef enum {
     VIR_DOMAIN_SHUTDOWN_DEFAULT        = 0,        /* hypervisor choice */
@@ -2126,6 +2153,56 @@ int virDomainListGetStats(virDomainPtr *doms,
 
 void virDomainStatsRecordListFree(virDomainStatsRecordPtr *stats);
 
+/**
+ * virDomainStatsCallback:
+ * @conn: connection the statistics were queried on
+ * @stats: NULL terminated array of statistics records, or NULL on failure
+ * @nstats: number of records in @stats, or -1 on failure
+ * @opaque: application specified data
+ *
+ * Callback receiving the result of virConnectGetAllDomainStatsAsync()
+ * or virDomainListGetStatsAsync(). On failure, virGetLastError()
+ * describes the error. @stats is freed when the callback returns.
+ */
+typedef void (*virDomainStatsCallback)(virConnectPtr conn,
+                                       virDomainStatsRecordPtr *stats,
+                                       int nstats,
+                                       void *opaque);
+
+int virConnectGetAllDomainStatsAsync(virConnectPtr conn,
+                                     unsigned int stats,
+                                     unsigned int flags,
+                                     virDomainStatsCallback cb,
+                                     void *opaque,
+                                     virFreeCallback freecb);
+
+int virDomainListGetStatsAsync(virDomainPtr *doms,
+                               unsigned int stats,
+                               unsigned int flags,
+                               virDomainStatsCallback cb,
+                               void *opaque,
+                               virFreeCallback freecb);
+
+/**
+ * virDomainListLifecycleAction:
+ *
+ * Action performed on each domain by virDomainListLifecycle().
+ */
+typedef enum {
+    VIR_DOMAIN_LIST_LIFECYCLE_START = 0,    /* as virDomainCreateWithFlags */
+    VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN = 1, /* as virDomainShutdownFlags */
+    VIR_DOMAIN_LIST_LIFECYCLE_DESTROY = 2,  /* as virDomainDestroyFlags */
+
+# ifdef VIR_ENUM_SENTINELS
+    VIR_DOMAIN_LIST_LIFECYCLE_LAST
+# endif
+} virDomainListLifecycleAction;
+
+int virDomainListLifecycle(virDomainPtr *doms,
+                           int action,
+                           int **errors,
+                           unsigned int flags);
+
 /*
  * Perf Event API
  */
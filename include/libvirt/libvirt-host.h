@@ -481,6 +481,9 @@ int virNodeGetSEVInfo (virConnectPtr conn,
 typedef enum {
     VIR_CONNECT_RO         = (1 << 0),  /* A readonly connection */
     VIR_CONNECT_NO_ALIASES = (1 << 1),  /* Don't try to resolve URI aliases */
+    VIR_CONNECT_COALESCE_EVENTS = (1 << 2), /* Don't deliver events superseded
+                                               by a later event of the same
+                                               type for the same object */
 } virConnectFlags;
 
 
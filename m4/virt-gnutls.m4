@@ -23,6 +23,20 @@ AC_DEFUN([LIBVIRT_CHECK_GNUTLS],[
   dnl Require gnutls >= 3.2.0 because of 3.2.11 in Ubuntu 14.04
   dnl That should have all the functions we use (in >= 2.12)
   dnl and also use nettle, because it's >= 3.0
+
+  dnl Kernel TLS offload needs the session keys from GnuTLS, which
+  dnl only hands them out since 3.4.0, and <linux/tls.h> since 4.13
+  if test "$with_gnutls" = "yes" ; then
+    old_CFLAGS="$CFLAGS"
+    old_LIBS="$LIBS"
+    CFLAGS="$CFLAGS $GNUTLS_CFLAGS"
+    LIBS="$LIBS $GNUTLS_LIBS"
+    AC_CHECK_HEADERS([linux/tls.h])
+    AC_CHECK_FUNCS([gnutls_record_get_state])
+    AC_CHECK_DECLS([GNUTLS_TLS1_3], [], [], [[#include <gnutls/gnutls.h>]])
+    CFLAGS="$old_CFLAGS"
+    LIBS="$old_LIBS"
+  fi
 ])
 
 AC_DEFUN([LIBVIRT_RESULT_GNUTLS],[
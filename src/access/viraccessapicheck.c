@@ -1,4 +1,4 @@
-/* Automatically generated from ./remote/remote_protocol.x by gendispatch.pl.
+/* Automatically generated from /root/repo/src/remote/remote_protocol.x by gendispatch.pl.
  * Do not edit this file.  Any changes you make will be lost.
  */
 #include <config.h>
@@ -1331,6 +1331,47 @@ bool virConnectListStoragePoolsCheckACL(virConnectPtr conn, virStoragePoolDefPtr
     return true;
 }
 
+/* Returns: -1 on error/denied, 0 on allowed */
+int virConnectLookupDomainsByUUIDEnsureACL(virConnectPtr conn)
+{
+    virAccessManagerPtr mgr;
+    int rv;
+
+    if (!(mgr = virAccessManagerGetDefault())) {
+        return -1;
+    }
+
+    if ((rv = virAccessManagerCheckConnect(mgr, conn->driver->name, VIR_ACCESS_PERM_CONNECT_SEARCH_DOMAINS)) <= 0) {
+        virObjectUnref(mgr);
+        if (rv == 0)
+            virReportError(VIR_ERR_ACCESS_DENIED,
+                            _("'%s' denied access"), conn->driver->name);
+        return -1;
+    }
+    virObjectUnref(mgr);
+    return 0;
+}
+
+/* Returns: false on error/denied, true on allowed */
+bool virConnectLookupDomainsByUUIDCheckACL(virConnectPtr conn, virDomainDefPtr domain)
+{
+    virAccessManagerPtr mgr;
+    int rv;
+
+    if (!(mgr = virAccessManagerGetDefault())) {
+        virResetLastError();
+        return false;
+    }
+
+    if ((rv = virAccessManagerCheckDomain(mgr, conn->driver->name, domain, VIR_ACCESS_PERM_DOMAIN_GETATTR)) <= 0) {
+        virObjectUnref(mgr);
+        virResetLastError();
+        return false;
+    }
+    virObjectUnref(mgr);
+    return true;
+}
+
 /* Returns: -1 on error/denied, 0 on allowed */
 int virConnectNetworkEventDeregisterAnyEnsureACL(virConnectPtr conn)
 {
@@ -3822,6 +3863,44 @@ int virDomainListAllSnapshotsEnsureACL(virConnectPtr conn, virDomainDefPtr domai
     return 0;
 }
 
+/* Returns: -1 on error/denied, 0 on allowed */
+int virDomainListLifecycleEnsureACL(virConnectPtr conn, virDomainDefPtr domain, unsigned int flags)
+{
+    virAccessManagerPtr mgr;
+    int rv;
+
+    if (!(mgr = virAccessManagerGetDefault())) {
+        return -1;
+    }
+
+    if (((flags & (VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN|VIR_DOMAIN_LIST_LIFECYCLE_DESTROY)) == 0) &&
+        (rv = virAccessManagerCheckDomain(mgr, conn->driver->name, domain, VIR_ACCESS_PERM_DOMAIN_START)) <= 0) {
+        virObjectUnref(mgr);
+        if (rv == 0)
+            virReportError(VIR_ERR_ACCESS_DENIED,
+                            _("'%s' denied access"), conn->driver->name);
+        return -1;
+    }
+    if (((flags & (VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN)) == (VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN)) &&
+        (rv = virAccessManagerCheckDomain(mgr, conn->driver->name, domain, VIR_ACCESS_PERM_DOMAIN_INIT_CONTROL)) <= 0) {
+        virObjectUnref(mgr);
+        if (rv == 0)
+            virReportError(VIR_ERR_ACCESS_DENIED,
+                            _("'%s' denied access"), conn->driver->name);
+        return -1;
+    }
+    if (((flags & (VIR_DOMAIN_LIST_LIFECYCLE_DESTROY)) == (VIR_DOMAIN_LIST_LIFECYCLE_DESTROY)) &&
+        (rv = virAccessManagerCheckDomain(mgr, conn->driver->name, domain, VIR_ACCESS_PERM_DOMAIN_STOP)) <= 0) {
+        virObjectUnref(mgr);
+        if (rv == 0)
+            virReportError(VIR_ERR_ACCESS_DENIED,
+                            _("'%s' denied access"), conn->driver->name);
+        return -1;
+    }
+    virObjectUnref(mgr);
+    return 0;
+}
+
 /* Returns: -1 on error/denied, 0 on allowed */
 int virDomainLookupByIDEnsureACL(virConnectPtr conn, virDomainDefPtr domain)
 {
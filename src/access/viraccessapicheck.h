@@ -1,4 +1,4 @@
-/* Automatically generated from ./remote/remote_protocol.x by gendispatch.pl.
+/* Automatically generated from /root/repo/src/remote/remote_protocol.x by gendispatch.pl.
  * Do not edit this file.  Any changes you make will be lost.
  */
 #include "internal.h"
@@ -75,6 +75,8 @@ extern int virConnectListSecretsEnsureACL(virConnectPtr conn);
 extern bool virConnectListSecretsCheckACL(virConnectPtr conn, virSecretDefPtr secret);
 extern int virConnectListStoragePoolsEnsureACL(virConnectPtr conn);
 extern bool virConnectListStoragePoolsCheckACL(virConnectPtr conn, virStoragePoolDefPtr pool);
+extern int virConnectLookupDomainsByUUIDEnsureACL(virConnectPtr conn);
+extern bool virConnectLookupDomainsByUUIDCheckACL(virConnectPtr conn, virDomainDefPtr domain);
 extern int virConnectNetworkEventDeregisterAnyEnsureACL(virConnectPtr conn);
 extern int virConnectNetworkEventRegisterAnyEnsureACL(virConnectPtr conn);
 extern bool virConnectNetworkEventRegisterAnyCheckACL(virConnectPtr conn, virNetworkDefPtr network);
@@ -188,6 +190,7 @@ extern int virDomainIsActiveEnsureACL(virConnectPtr conn, virDomainDefPtr domain
 extern int virDomainIsPersistentEnsureACL(virConnectPtr conn, virDomainDefPtr domain);
 extern int virDomainIsUpdatedEnsureACL(virConnectPtr conn, virDomainDefPtr domain);
 extern int virDomainListAllSnapshotsEnsureACL(virConnectPtr conn, virDomainDefPtr domain);
+extern int virDomainListLifecycleEnsureACL(virConnectPtr conn, virDomainDefPtr domain, unsigned int flags);
 extern int virDomainLookupByIDEnsureACL(virConnectPtr conn, virDomainDefPtr domain);
 extern int virDomainLookupByNameEnsureACL(virConnectPtr conn, virDomainDefPtr domain);
 extern int virDomainLookupByUUIDEnsureACL(virConnectPtr conn, virDomainDefPtr domain);
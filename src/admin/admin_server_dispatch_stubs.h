@@ -1,4 +1,4 @@
-/* Automatically generated from ./admin/admin_protocol.x by gendispatch.pl.
+/* Automatically generated from /root/repo/src/admin/admin_protocol.x by gendispatch.pl.
  * Do not edit this file.  Any changes you make will be lost.
  */
 static int adminDispatchClientClose(
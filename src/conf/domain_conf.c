@@ -29392,6 +29392,1786 @@ virDomainDiskDefForeachPath(virDomainDiskDefPtr disk,
 }
 
 
+/* Duplicates a structure which doesn't own any memory itself. */
+static int
+virDomainCopyPlainStruct(void *dstptr,
+                         const void *src,
+                         size_t size)
+{
+    char *copy = NULL;
+
+    *(void **)dstptr = NULL;
+
+    if (!src)
+        return 0;
+
+    if (VIR_ALLOC_N(copy, size) < 0)
+        return -1;
+
+    memcpy(copy, src, size);
+    *(void **)dstptr = copy;
+    return 0;
+}
+
+
+/* Fills @dst with a deep copy of the backend description of @src.
+ * @dst might be a shallow copy of @src on entry. */
+static int
+virDomainChrSourceDefCopyFull(virDomainChrSourceDefPtr dst,
+                              virDomainChrSourceDefPtr src)
+{
+    size_t i;
+
+    memset(&dst->data, 0, sizeof(dst->data));
+    dst->type = src->type;
+    dst->logfile = NULL;
+    dst->logappend = src->logappend;
+    dst->nseclabels = 0;
+    dst->seclabels = NULL;
+
+    switch ((virDomainChrType) src->type) {
+    case VIR_DOMAIN_CHR_TYPE_PTY:
+    case VIR_DOMAIN_CHR_TYPE_DEV:
+    case VIR_DOMAIN_CHR_TYPE_FILE:
+    case VIR_DOMAIN_CHR_TYPE_PIPE:
+        dst->data.file.append = src->data.file.append;
+        if (VIR_STRDUP(dst->data.file.path, src->data.file.path) < 0)
+            return -1;
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_NMDM:
+        if (VIR_STRDUP(dst->data.nmdm.master, src->data.nmdm.master) < 0 ||
+            VIR_STRDUP(dst->data.nmdm.slave, src->data.nmdm.slave) < 0)
+            return -1;
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_TCP:
+        dst->data.tcp = src->data.tcp;
+        dst->data.tcp.host = NULL;
+        dst->data.tcp.service = NULL;
+        if (VIR_STRDUP(dst->data.tcp.host, src->data.tcp.host) < 0 ||
+            VIR_STRDUP(dst->data.tcp.service, src->data.tcp.service) < 0)
+            return -1;
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_UDP:
+        if (VIR_STRDUP(dst->data.udp.bindHost, src->data.udp.bindHost) < 0 ||
+            VIR_STRDUP(dst->data.udp.bindService, src->data.udp.bindService) < 0 ||
+            VIR_STRDUP(dst->data.udp.connectHost, src->data.udp.connectHost) < 0 ||
+            VIR_STRDUP(dst->data.udp.connectService, src->data.udp.connectService) < 0)
+            return -1;
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_UNIX:
+        dst->data.nix = src->data.nix;
+        dst->data.nix.path = NULL;
+        if (VIR_STRDUP(dst->data.nix.path, src->data.nix.path) < 0)
+            return -1;
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_SPICEVMC:
+        dst->data.spicevmc = src->data.spicevmc;
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_SPICEPORT:
+        if (VIR_STRDUP(dst->data.spiceport.channel,
+                       src->data.spiceport.channel) < 0)
+            return -1;
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_NULL:
+    case VIR_DOMAIN_CHR_TYPE_VC:
+    case VIR_DOMAIN_CHR_TYPE_STDIO:
+    case VIR_DOMAIN_CHR_TYPE_LAST:
+        break;
+    }
+
+    if (VIR_STRDUP(dst->logfile, src->logfile) < 0)
+        return -1;
+
+    if (src->nseclabels) {
+        if (VIR_ALLOC_N(dst->seclabels, src->nseclabels) < 0)
+            return -1;
+
+        for (i = 0; i < src->nseclabels; i++) {
+            if (!(dst->seclabels[i] =
+                  virSecurityDeviceLabelDefCopy(src->seclabels[i])))
+                return -1;
+            dst->nseclabels++;
+        }
+    }
+
+    return 0;
+}
+
+
+static virDomainChrSourceDefPtr
+virDomainChrSourceDefDup(virDomainChrSourceDefPtr src,
+                         virDomainXMLOptionPtr xmlopt)
+{
+    virDomainChrSourceDefPtr def;
+
+    if (!(def = virDomainChrSourceDefNew(xmlopt)))
+        return NULL;
+
+    if (virDomainChrSourceDefCopyFull(def, src) < 0) {
+        virObjectUnref(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainDiskDefPtr
+virDomainDiskDefCopy(virDomainDiskDefPtr src,
+                     virDomainXMLOptionPtr xmlopt)
+{
+    virDomainDiskDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->src = NULL;
+    def->privateData = NULL;
+    def->dst = NULL;
+    def->mirror = NULL;
+    def->blkdeviotune.group_name = NULL;
+    def->driverName = NULL;
+    def->serial = NULL;
+    def->wwn = NULL;
+    def->vendor = NULL;
+    def->product = NULL;
+    def->domain_name = NULL;
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    if (xmlopt &&
+        xmlopt->privateData.diskNew &&
+        !(def->privateData = xmlopt->privateData.diskNew()))
+        goto error;
+
+    if (!(def->src = virStorageSourceCopy(src->src, true)))
+        goto error;
+
+    if (src->mirror &&
+        !(def->mirror = virStorageSourceCopy(src->mirror, true)))
+        goto error;
+
+    if (VIR_STRDUP(def->dst, src->dst) < 0 ||
+        VIR_STRDUP(def->blkdeviotune.group_name,
+                   src->blkdeviotune.group_name) < 0 ||
+        VIR_STRDUP(def->driverName, src->driverName) < 0 ||
+        VIR_STRDUP(def->serial, src->serial) < 0 ||
+        VIR_STRDUP(def->wwn, src->wwn) < 0 ||
+        VIR_STRDUP(def->vendor, src->vendor) < 0 ||
+        VIR_STRDUP(def->product, src->product) < 0 ||
+        VIR_STRDUP(def->domain_name, src->domain_name) < 0)
+        goto error;
+
+    if (virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0)
+        goto error;
+
+    return def;
+
+ error:
+    virDomainDiskDefFree(def);
+    return NULL;
+}
+
+
+static virDomainControllerDefPtr
+virDomainControllerDefCopy(virDomainControllerDefPtr src)
+{
+    virDomainControllerDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0 ||
+        virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0) {
+        virDomainControllerDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainLeaseDefPtr
+virDomainLeaseDefCopy(virDomainLeaseDefPtr src)
+{
+    virDomainLeaseDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    def->offset = src->offset;
+
+    if (VIR_STRDUP(def->lockspace, src->lockspace) < 0 ||
+        VIR_STRDUP(def->key, src->key) < 0 ||
+        VIR_STRDUP(def->path, src->path) < 0) {
+        virDomainLeaseDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainFSDefPtr
+virDomainFSDefCopy(virDomainFSDefPtr src)
+{
+    virDomainFSDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->src = NULL;
+    def->dst = NULL;
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    if (src->src &&
+        !(def->src = virStorageSourceCopy(src->src, false)))
+        goto error;
+
+    if (VIR_STRDUP(def->dst, src->dst) < 0 ||
+        virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0)
+        goto error;
+
+    return def;
+
+ error:
+    virDomainFSDefFree(def);
+    return NULL;
+}
+
+
+/* Fills the host side of @dst, which must be a shallow copy of @src,
+ * with a deep copy. The guest address is left for the caller. */
+static int
+virDomainHostdevDefCopySource(virDomainHostdevDefPtr dst,
+                              virDomainHostdevDefPtr src)
+{
+    virDomainHostdevSubsysSCSIPtr scsisrc = &src->source.subsys.u.scsi;
+    virDomainHostdevSubsysSCSIPtr scsidst = &dst->source.subsys.u.scsi;
+
+    switch ((virDomainHostdevMode) src->mode) {
+    case VIR_DOMAIN_HOSTDEV_MODE_CAPABILITIES:
+        switch ((virDomainHostdevCapsType) src->source.caps.type) {
+        case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_STORAGE:
+            dst->source.caps.u.storage.block = NULL;
+            return VIR_STRDUP(dst->source.caps.u.storage.block,
+                              src->source.caps.u.storage.block);
+
+        case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_MISC:
+            dst->source.caps.u.misc.chardev = NULL;
+            return VIR_STRDUP(dst->source.caps.u.misc.chardev,
+                              src->source.caps.u.misc.chardev);
+
+        case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_NET:
+            dst->source.caps.u.net.ifname = NULL;
+            memset(&dst->source.caps.u.net.ip, 0,
+                   sizeof(dst->source.caps.u.net.ip));
+            if (VIR_STRDUP(dst->source.caps.u.net.ifname,
+                           src->source.caps.u.net.ifname) < 0)
+                return -1;
+            return virNetDevIPInfoCopy(&dst->source.caps.u.net.ip,
+                                       &src->source.caps.u.net.ip);
+
+        case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_LAST:
+            break;
+        }
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_MODE_SUBSYS:
+        switch ((virDomainHostdevSubsysType) src->source.subsys.type) {
+        case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_SCSI:
+            if (scsisrc->protocol == VIR_DOMAIN_HOSTDEV_SCSI_PROTOCOL_TYPE_ISCSI) {
+                scsidst->u.iscsi.src = NULL;
+                if (scsisrc->u.iscsi.src &&
+                    !(scsidst->u.iscsi.src =
+                      virStorageSourceCopy(scsisrc->u.iscsi.src, false)))
+                    return -1;
+            } else {
+                scsidst->u.host.adapter = NULL;
+                if (VIR_STRDUP(scsidst->u.host.adapter,
+                               scsisrc->u.host.adapter) < 0)
+                    return -1;
+            }
+            break;
+
+        case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_SCSI_HOST:
+            dst->source.subsys.u.scsi_host.wwpn = NULL;
+            return VIR_STRDUP(dst->source.subsys.u.scsi_host.wwpn,
+                              src->source.subsys.u.scsi_host.wwpn);
+
+        case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_USB:
+        case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_PCI:
+        case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_MDEV:
+        case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_LAST:
+            break;
+        }
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_MODE_LAST:
+        break;
+    }
+
+    return 0;
+}
+
+
+/* Copies a hostdev which isn't part of any other device. */
+static virDomainHostdevDefPtr
+virDomainHostdevDefCopy(virDomainHostdevDefPtr src)
+{
+    virDomainHostdevDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->info = NULL;
+
+    if (virDomainHostdevDefCopySource(def, src) < 0)
+        goto error;
+
+    if (VIR_ALLOC(def->info) < 0 ||
+        virDomainDeviceInfoCopy(def->info, src->info) < 0)
+        goto error;
+
+    return def;
+
+ error:
+    virDomainHostdevDefFree(def);
+    return NULL;
+}
+
+
+static virDomainActualNetDefPtr
+virDomainActualNetDefCopy(virDomainActualNetDefPtr src,
+                          virDomainNetDefPtr parent)
+{
+    virDomainActualNetDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->virtPortProfile = NULL;
+    def->bandwidth = NULL;
+    memset(&def->vlan, 0, sizeof(def->vlan));
+
+    switch (src->type) {
+    case VIR_DOMAIN_NET_TYPE_BRIDGE:
+    case VIR_DOMAIN_NET_TYPE_NETWORK:
+        def->data.bridge.brname = NULL;
+        if (VIR_STRDUP(def->data.bridge.brname, src->data.bridge.brname) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_DIRECT:
+        def->data.direct.linkdev = NULL;
+        if (VIR_STRDUP(def->data.direct.linkdev, src->data.direct.linkdev) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_HOSTDEV:
+        def->data.hostdev.def.parent.data.net = parent;
+        def->data.hostdev.def.info = &parent->info;
+        if (virDomainHostdevDefCopySource(&def->data.hostdev.def,
+                                          &src->data.hostdev.def) < 0)
+            goto error;
+        break;
+
+    default:
+        break;
+    }
+
+    if (virDomainCopyPlainStruct(&def->virtPortProfile, src->virtPortProfile,
+                                 sizeof(*src->virtPortProfile)) < 0 ||
+        virNetDevBandwidthCopy(&def->bandwidth, src->bandwidth) < 0 ||
+        virNetDevVlanCopy(&def->vlan, &src->vlan) < 0)
+        goto error;
+
+    return def;
+
+ error:
+    virDomainActualNetDefFree(def);
+    return NULL;
+}
+
+
+static virDomainNetDefPtr
+virDomainNetDefCopy(virDomainNetDefPtr src,
+                    virDomainXMLOptionPtr xmlopt)
+{
+    virDomainNetDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    memset(&def->data, 0, sizeof(def->data));
+    def->model = NULL;
+    def->backend.tap = NULL;
+    def->backend.vhost = NULL;
+    def->virtPortProfile = NULL;
+    def->script = NULL;
+    def->domain_name = NULL;
+    def->ifname = NULL;
+    memset(&def->hostIP, 0, sizeof(def->hostIP));
+    def->ifname_guest_actual = NULL;
+    def->ifname_guest = NULL;
+    memset(&def->guestIP, 0, sizeof(def->guestIP));
+    def->filter = NULL;
+    def->filterparams = NULL;
+    def->bandwidth = NULL;
+    memset(&def->vlan, 0, sizeof(def->vlan));
+    def->coalesce = NULL;
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    switch (src->type) {
+    case VIR_DOMAIN_NET_TYPE_VHOSTUSER:
+        if (!(def->data.vhostuser =
+              virDomainChrSourceDefDup(src->data.vhostuser, xmlopt)))
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_SERVER:
+    case VIR_DOMAIN_NET_TYPE_CLIENT:
+    case VIR_DOMAIN_NET_TYPE_MCAST:
+    case VIR_DOMAIN_NET_TYPE_UDP:
+        def->data.socket.port = src->data.socket.port;
+        def->data.socket.localport = src->data.socket.localport;
+        if (VIR_STRDUP(def->data.socket.address,
+                       src->data.socket.address) < 0 ||
+            VIR_STRDUP(def->data.socket.localaddr,
+                       src->data.socket.localaddr) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_NETWORK:
+        if (VIR_STRDUP(def->data.network.name, src->data.network.name) < 0 ||
+            VIR_STRDUP(def->data.network.portgroup,
+                       src->data.network.portgroup) < 0)
+            goto error;
+        if (src->data.network.actual &&
+            !(def->data.network.actual =
+              virDomainActualNetDefCopy(src->data.network.actual, def)))
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_BRIDGE:
+        if (VIR_STRDUP(def->data.bridge.brname, src->data.bridge.brname) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_INTERNAL:
+        if (VIR_STRDUP(def->data.internal.name, src->data.internal.name) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_DIRECT:
+        def->data.direct.mode = src->data.direct.mode;
+        if (VIR_STRDUP(def->data.direct.linkdev, src->data.direct.linkdev) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_HOSTDEV:
+        def->data.hostdev.def = src->data.hostdev.def;
+        def->data.hostdev.def.parent.data.net = def;
+        def->data.hostdev.def.info = &def->info;
+        if (virDomainHostdevDefCopySource(&def->data.hostdev.def,
+                                          &src->data.hostdev.def) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_ETHERNET:
+    case VIR_DOMAIN_NET_TYPE_USER:
+    case VIR_DOMAIN_NET_TYPE_LAST:
+        break;
+    }
+
+    if (VIR_STRDUP(def->model, src->model) < 0 ||
+        VIR_STRDUP(def->backend.tap, src->backend.tap) < 0 ||
+        VIR_STRDUP(def->backend.vhost, src->backend.vhost) < 0 ||
+        VIR_STRDUP(def->script, src->script) < 0 ||
+        VIR_STRDUP(def->domain_name, src->domain_name) < 0 ||
+        VIR_STRDUP(def->ifname, src->ifname) < 0 ||
+        VIR_STRDUP(def->ifname_guest_actual, src->ifname_guest_actual) < 0 ||
+        VIR_STRDUP(def->ifname_guest, src->ifname_guest) < 0 ||
+        VIR_STRDUP(def->filter, src->filter) < 0)
+        goto error;
+
+    if (virNetDevIPInfoCopy(&def->hostIP, &src->hostIP) < 0 ||
+        virNetDevIPInfoCopy(&def->guestIP, &src->guestIP) < 0)
+        goto error;
+
+    if (src->filterparams &&
+        (!(def->filterparams = virNWFilterHashTableCreate(0)) ||
+         virNWFilterHashTablePutAll(src->filterparams, def->filterparams) < 0))
+        goto error;
+
+    if (virDomainCopyPlainStruct(&def->virtPortProfile, src->virtPortProfile,
+                                 sizeof(*src->virtPortProfile)) < 0 ||
+        virNetDevBandwidthCopy(&def->bandwidth, src->bandwidth) < 0 ||
+        virNetDevVlanCopy(&def->vlan, &src->vlan) < 0 ||
+        virDomainCopyPlainStruct(&def->coalesce, src->coalesce,
+                                 sizeof(*src->coalesce)) < 0 ||
+        virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0)
+        goto error;
+
+    return def;
+
+ error:
+    virDomainNetDefFree(def);
+    return NULL;
+}
+
+
+static virDomainInputDefPtr
+virDomainInputDefCopy(virDomainInputDefPtr src)
+{
+    virDomainInputDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->source.evdev = NULL;
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0 ||
+        VIR_STRDUP(def->source.evdev, src->source.evdev) < 0 ||
+        virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0) {
+        virDomainInputDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainSoundDefPtr
+virDomainSoundDefCopy(virDomainSoundDefPtr src)
+{
+    virDomainSoundDefPtr def;
+    size_t i;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->ncodecs = 0;
+    def->codecs = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    if (src->ncodecs &&
+        VIR_ALLOC_N(def->codecs, src->ncodecs) < 0)
+        goto error;
+
+    for (i = 0; i < src->ncodecs; i++) {
+        if (virDomainCopyPlainStruct(&def->codecs[i], src->codecs[i],
+                                     sizeof(*src->codecs[i])) < 0)
+            goto error;
+        def->ncodecs++;
+    }
+
+    return def;
+
+ error:
+    virDomainSoundDefFree(def);
+    return NULL;
+}
+
+
+static virDomainVideoDefPtr
+virDomainVideoDefCopy(virDomainVideoDefPtr src)
+{
+    virDomainVideoDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->accel = NULL;
+    def->driver = NULL;
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0 ||
+        virDomainCopyPlainStruct(&def->accel, src->accel,
+                                 sizeof(*src->accel)) < 0 ||
+        virDomainCopyPlainStruct(&def->driver, src->driver,
+                                 sizeof(*src->driver)) < 0 ||
+        virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0) {
+        virDomainVideoDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainGraphicsDefPtr
+virDomainGraphicsDefCopy(virDomainGraphicsDefPtr src)
+{
+    virDomainGraphicsDefPtr def;
+    size_t i;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    memset(&def->data, 0, sizeof(def->data));
+    def->nListens = 0;
+    def->listens = NULL;
+
+    switch (src->type) {
+    case VIR_DOMAIN_GRAPHICS_TYPE_VNC:
+        def->data.vnc = src->data.vnc;
+        def->data.vnc.keymap = NULL;
+        def->data.vnc.auth.passwd = NULL;
+        if (VIR_STRDUP(def->data.vnc.keymap, src->data.vnc.keymap) < 0 ||
+            VIR_STRDUP(def->data.vnc.auth.passwd,
+                       src->data.vnc.auth.passwd) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SDL:
+        def->data.sdl = src->data.sdl;
+        def->data.sdl.display = NULL;
+        def->data.sdl.xauth = NULL;
+        if (VIR_STRDUP(def->data.sdl.display, src->data.sdl.display) < 0 ||
+            VIR_STRDUP(def->data.sdl.xauth, src->data.sdl.xauth) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_RDP:
+        def->data.rdp = src->data.rdp;
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_DESKTOP:
+        def->data.desktop = src->data.desktop;
+        def->data.desktop.display = NULL;
+        if (VIR_STRDUP(def->data.desktop.display,
+                       src->data.desktop.display) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SPICE:
+        def->data.spice = src->data.spice;
+        def->data.spice.keymap = NULL;
+        def->data.spice.auth.passwd = NULL;
+        def->data.spice.rendernode = NULL;
+        if (VIR_STRDUP(def->data.spice.keymap, src->data.spice.keymap) < 0 ||
+            VIR_STRDUP(def->data.spice.auth.passwd,
+                       src->data.spice.auth.passwd) < 0 ||
+            VIR_STRDUP(def->data.spice.rendernode,
+                       src->data.spice.rendernode) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_EGL_HEADLESS:
+        if (VIR_STRDUP(def->data.egl_headless.rendernode,
+                       src->data.egl_headless.rendernode) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_LAST:
+        break;
+    }
+
+    if (src->nListens &&
+        VIR_ALLOC_N(def->listens, src->nListens) < 0)
+        goto error;
+
+    for (i = 0; i < src->nListens; i++) {
+        virDomainGraphicsListenDefPtr listen = &def->listens[i];
+
+        def->nListens++;
+        listen->type = src->listens[i].type;
+        listen->fromConfig = src->listens[i].fromConfig;
+        listen->autoGenerated = src->listens[i].autoGenerated;
+
+        if (VIR_STRDUP(listen->address, src->listens[i].address) < 0 ||
+            VIR_STRDUP(listen->network, src->listens[i].network) < 0 ||
+            VIR_STRDUP(listen->socket, src->listens[i].socket) < 0)
+            goto error;
+    }
+
+    return def;
+
+ error:
+    virDomainGraphicsDefFree(def);
+    return NULL;
+}
+
+
+static virDomainHubDefPtr
+virDomainHubDefCopy(virDomainHubDefPtr src)
+{
+    virDomainHubDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0) {
+        virDomainHubDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainRedirdevDefPtr
+virDomainRedirdevDefCopy(virDomainRedirdevDefPtr src,
+                         virDomainXMLOptionPtr xmlopt)
+{
+    virDomainRedirdevDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->source = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0 ||
+        !(def->source = virDomainChrSourceDefDup(src->source, xmlopt))) {
+        virDomainRedirdevDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainSmartcardDefPtr
+virDomainSmartcardDefCopy(virDomainSmartcardDefPtr src,
+                          virDomainXMLOptionPtr xmlopt)
+{
+    virDomainSmartcardDefPtr def;
+    size_t i;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    memset(&def->data, 0, sizeof(def->data));
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    switch (src->type) {
+    case VIR_DOMAIN_SMARTCARD_TYPE_HOST_CERTIFICATES:
+        for (i = 0; i < VIR_DOMAIN_SMARTCARD_NUM_CERTIFICATES; i++) {
+            if (VIR_STRDUP(def->data.cert.file[i], src->data.cert.file[i]) < 0)
+                goto error;
+        }
+        if (VIR_STRDUP(def->data.cert.database, src->data.cert.database) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_SMARTCARD_TYPE_PASSTHROUGH:
+        if (!(def->data.passthru =
+              virDomainChrSourceDefDup(src->data.passthru, xmlopt)))
+            goto error;
+        break;
+
+    default:
+        break;
+    }
+
+    return def;
+
+ error:
+    virDomainSmartcardDefFree(def);
+    return NULL;
+}
+
+
+static virDomainChrDefPtr
+virDomainChrDefCopy(virDomainChrDefPtr src,
+                    virDomainXMLOptionPtr xmlopt)
+{
+    virDomainChrDefPtr def;
+    bool guestfwd = false;
+    bool named = false;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    if (src->deviceType == VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL) {
+        switch (src->targetType) {
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_GUESTFWD:
+            guestfwd = true;
+            break;
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_XEN:
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_VIRTIO:
+            named = true;
+            break;
+        }
+    }
+
+    *def = *src;
+    def->source = NULL;
+    if (guestfwd)
+        def->target.addr = NULL;
+    if (named)
+        def->target.name = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    if (guestfwd &&
+        virDomainCopyPlainStruct(&def->target.addr, src->target.addr,
+                                 sizeof(*src->target.addr)) < 0)
+        goto error;
+
+    if (named &&
+        VIR_STRDUP(def->target.name, src->target.name) < 0)
+        goto error;
+
+    if (!(def->source = virDomainChrSourceDefDup(src->source, xmlopt)))
+        goto error;
+
+    return def;
+
+ error:
+    virDomainChrDefFree(def);
+    return NULL;
+}
+
+
+static virDomainRNGDefPtr
+virDomainRNGDefCopy(virDomainRNGDefPtr src,
+                    virDomainXMLOptionPtr xmlopt)
+{
+    virDomainRNGDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    memset(&def->source, 0, sizeof(def->source));
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    switch ((virDomainRNGBackend) src->backend) {
+    case VIR_DOMAIN_RNG_BACKEND_RANDOM:
+        if (VIR_STRDUP(def->source.file, src->source.file) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_RNG_BACKEND_EGD:
+        if (!(def->source.chardev =
+              virDomainChrSourceDefDup(src->source.chardev, xmlopt)))
+            goto error;
+        break;
+
+    case VIR_DOMAIN_RNG_BACKEND_LAST:
+        break;
+    }
+
+    if (virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0)
+        goto error;
+
+    return def;
+
+ error:
+    virDomainRNGDefFree(def);
+    return NULL;
+}
+
+
+static virDomainShmemDefPtr
+virDomainShmemDefCopy(virDomainShmemDefPtr src)
+{
+    virDomainShmemDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->name = NULL;
+    memset(&def->server.chr.data, 0, sizeof(def->server.chr.data));
+    def->server.chr.logfile = NULL;
+    def->server.chr.nseclabels = 0;
+    def->server.chr.seclabels = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0 ||
+        VIR_STRDUP(def->name, src->name) < 0 ||
+        virDomainChrSourceDefCopyFull(&def->server.chr, &src->server.chr) < 0) {
+        virDomainShmemDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainTPMDefPtr
+virDomainTPMDefCopy(virDomainTPMDefPtr src)
+{
+    virDomainTPMDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    memset(&def->data, 0, sizeof(def->data));
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0)
+        goto error;
+
+    switch ((virDomainTPMBackendType) src->type) {
+    case VIR_DOMAIN_TPM_TYPE_PASSTHROUGH:
+        if (virDomainChrSourceDefCopyFull(&def->data.passthrough.source,
+                                          &src->data.passthrough.source) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_TPM_TYPE_EMULATOR:
+        if (virDomainChrSourceDefCopyFull(&def->data.emulator.source,
+                                          &src->data.emulator.source) < 0 ||
+            VIR_STRDUP(def->data.emulator.storagepath,
+                       src->data.emulator.storagepath) < 0 ||
+            VIR_STRDUP(def->data.emulator.logfile,
+                       src->data.emulator.logfile) < 0)
+            goto error;
+        break;
+
+    case VIR_DOMAIN_TPM_TYPE_LAST:
+        break;
+    }
+
+    return def;
+
+ error:
+    virDomainTPMDefFree(def);
+    return NULL;
+}
+
+
+static virDomainMemoryDefPtr
+virDomainMemoryDefCopy(virDomainMemoryDefPtr src)
+{
+    virDomainMemoryDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->sourceNodes = NULL;
+    def->nvdimmPath = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0 ||
+        VIR_STRDUP(def->nvdimmPath, src->nvdimmPath) < 0)
+        goto error;
+
+    if (src->sourceNodes &&
+        !(def->sourceNodes = virBitmapNewCopy(src->sourceNodes)))
+        goto error;
+
+    return def;
+
+ error:
+    virDomainMemoryDefFree(def);
+    return NULL;
+}
+
+
+static virDomainVsockDefPtr
+virDomainVsockDefCopy(virDomainVsockDefPtr src,
+                      virDomainXMLOptionPtr xmlopt)
+{
+    virDomainVsockDefPtr def;
+
+    if (!(def = virDomainVsockDefNew(xmlopt)))
+        return NULL;
+
+    def->model = src->model;
+    def->guest_cid = src->guest_cid;
+    def->auto_cid = src->auto_cid;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0) {
+        virDomainVsockDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainWatchdogDefPtr
+virDomainWatchdogDefCopy(virDomainWatchdogDefPtr src)
+{
+    virDomainWatchdogDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0) {
+        virDomainWatchdogDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainNVRAMDefPtr
+virDomainNVRAMDefCopy(virDomainNVRAMDefPtr src)
+{
+    virDomainNVRAMDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0) {
+        virDomainNVRAMDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainPanicDefPtr
+virDomainPanicDefCopy(virDomainPanicDefPtr src)
+{
+    virDomainPanicDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0) {
+        virDomainPanicDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+static virDomainMemballoonDefPtr
+virDomainMemballoonDefCopy(virDomainMemballoonDefPtr src)
+{
+    virDomainMemballoonDefPtr def;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+    def->virtio = NULL;
+
+    if (virDomainDeviceInfoCopy(&def->info, &src->info) < 0 ||
+        virDomainCopyPlainStruct(&def->virtio, src->virtio,
+                                 sizeof(*src->virtio)) < 0) {
+        virDomainMemballoonDefFree(def);
+        return NULL;
+    }
+
+    return def;
+}
+
+
+/* Fills @dst, a shallow copy of @src, with copies of everything @src
+ * owns. */
+static int
+virDomainOSDefCopy(virDomainOSDefPtr dst,
+                   virDomainOSDefPtr src)
+{
+    size_t i;
+
+    dst->machine = NULL;
+    dst->init = NULL;
+    dst->initargv = NULL;
+    dst->initenv = NULL;
+    dst->initdir = NULL;
+    dst->inituser = NULL;
+    dst->initgroup = NULL;
+    dst->kernel = NULL;
+    dst->initrd = NULL;
+    dst->cmdline = NULL;
+    dst->dtb = NULL;
+    dst->root = NULL;
+    dst->slic_table = NULL;
+    dst->loader = NULL;
+    dst->bootloader = NULL;
+    dst->bootloaderArgs = NULL;
+
+    if (VIR_STRDUP(dst->machine, src->machine) < 0 ||
+        VIR_STRDUP(dst->init, src->init) < 0 ||
+        VIR_STRDUP(dst->initdir, src->initdir) < 0 ||
+        VIR_STRDUP(dst->inituser, src->inituser) < 0 ||
+        VIR_STRDUP(dst->initgroup, src->initgroup) < 0 ||
+        VIR_STRDUP(dst->kernel, src->kernel) < 0 ||
+        VIR_STRDUP(dst->initrd, src->initrd) < 0 ||
+        VIR_STRDUP(dst->cmdline, src->cmdline) < 0 ||
+        VIR_STRDUP(dst->dtb, src->dtb) < 0 ||
+        VIR_STRDUP(dst->root, src->root) < 0 ||
+        VIR_STRDUP(dst->slic_table, src->slic_table) < 0 ||
+        VIR_STRDUP(dst->bootloader, src->bootloader) < 0 ||
+        VIR_STRDUP(dst->bootloaderArgs, src->bootloaderArgs) < 0)
+        return -1;
+
+    if (src->initargv &&
+        virStringListCopy(&dst->initargv, (const char **)src->initargv) < 0)
+        return -1;
+
+    if (src->initenv) {
+        for (i = 0; src->initenv[i]; i++)
+            ;
+
+        if (VIR_ALLOC_N(dst->initenv, i + 1) < 0)
+            return -1;
+
+        for (i = 0; src->initenv[i]; i++) {
+            if (VIR_ALLOC(dst->initenv[i]) < 0 ||
+                VIR_STRDUP(dst->initenv[i]->name, src->initenv[i]->name) < 0 ||
+                VIR_STRDUP(dst->initenv[i]->value, src->initenv[i]->value) < 0)
+                return -1;
+        }
+    }
+
+    if (src->loader) {
+        if (VIR_ALLOC(dst->loader) < 0)
+            return -1;
+
+        dst->loader->readonly = src->loader->readonly;
+        dst->loader->type = src->loader->type;
+        dst->loader->secure = src->loader->secure;
+
+        if (VIR_STRDUP(dst->loader->path, src->loader->path) < 0 ||
+            VIR_STRDUP(dst->loader->nvram, src->loader->nvram) < 0 ||
+            VIR_STRDUP(dst->loader->templt, src->loader->templt) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+/* Fills @dst, a shallow copy of @src, with copies of everything @src
+ * owns. */
+static int
+virDomainClockDefCopy(virDomainClockDefPtr dst,
+                      virDomainClockDefPtr src)
+{
+    size_t i;
+
+    dst->ntimers = 0;
+    dst->timers = NULL;
+
+    if (src->offset == VIR_DOMAIN_CLOCK_OFFSET_TIMEZONE) {
+        dst->data.timezone = NULL;
+        if (VIR_STRDUP(dst->data.timezone, src->data.timezone) < 0)
+            return -1;
+    }
+
+    if (src->ntimers &&
+        VIR_ALLOC_N(dst->timers, src->ntimers) < 0)
+        return -1;
+
+    for (i = 0; i < src->ntimers; i++) {
+        if (virDomainCopyPlainStruct(&dst->timers[i], src->timers[i],
+                                     sizeof(*src->timers[i])) < 0)
+            return -1;
+        dst->ntimers++;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virDomainDefCanCopyNative:
+ * @def: domain definition
+ *
+ * Returns true if virDomainDefCopyNative() is able to copy @def. That
+ * isn't the case for definitions with data private to a hypervisor
+ * driver's XML namespace or with resource control allocations.
+ */
+static bool
+virDomainDefCanCopyNative(virDomainDefPtr def)
+{
+    size_t i;
+
+    if (def->namespaceData || def->nresctrls)
+        return false;
+
+    for (i = 0; i < def->nhostdevs; i++) {
+        int type = def->hostdevs[i]->parent.type;
+
+        if (type != VIR_DOMAIN_DEVICE_NONE &&
+            type != VIR_DOMAIN_DEVICE_NET)
+            return false;
+    }
+
+    return true;
+}
+
+
+/* Hostdevs which are part of an <interface> are shared with the
+ * interface, find the copy of the interface @hostdev belongs to. */
+static virDomainHostdevDefPtr
+virDomainDefCopyFindNetHostdev(virDomainDefPtr dst,
+                               virDomainDefPtr src,
+                               virDomainHostdevDefPtr hostdev)
+{
+    size_t i;
+
+    for (i = 0; i < src->nnets; i++) {
+        if (src->nets[i] == hostdev->parent.data.net)
+            return virDomainNetGetActualHostdev(dst->nets[i]);
+    }
+
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("hostdev belongs to an unknown interface"));
+    return NULL;
+}
+
+
+/**
+ * virDomainDefCopyNative:
+ * @src: domain definition
+ * @xmlopt: XML parser configuration object
+ *
+ * Creates an exact deep copy of @src, including any runtime state it
+ * holds, without formatting it to XML and parsing it back. Private data
+ * of the devices is not copied, fresh instances are created via
+ * @xmlopt instead.
+ *
+ * Returns the copy or NULL on error.
+ */
+static virDomainDefPtr
+virDomainDefCopyNative(virDomainDefPtr src,
+                       virDomainXMLOptionPtr xmlopt)
+{
+    virDomainDefPtr def;
+    size_t i;
+
+    if (VIR_ALLOC(def) < 0)
+        return NULL;
+
+    *def = *src;
+
+    def->name = NULL;
+    def->title = NULL;
+    def->description = NULL;
+    def->blkio.ndevices = 0;
+    def->blkio.devices = NULL;
+    def->mem.nhugepages = 0;
+    def->mem.hugepages = NULL;
+    def->maxvcpus = 0;
+    def->vcpus = NULL;
+    def->cpumask = NULL;
+    def->niothreadids = 0;
+    def->iothreadids = NULL;
+    def->cputune.emulatorpin = NULL;
+    def->nresctrls = 0;
+    def->resctrls = NULL;
+    def->numa = NULL;
+    def->resource = NULL;
+    memset(&def->idmap, 0, sizeof(def->idmap));
+    memset(&def->os, 0, sizeof(def->os));
+    memset(&def->clock, 0, sizeof(def->clock));
+    def->emulator = NULL;
+    def->hyperv_vendor_id = NULL;
+    def->ngraphics = 0;
+    def->graphics = NULL;
+    def->ndisks = 0;
+    def->disks = NULL;
+    def->ncontrollers = 0;
+    def->controllers = NULL;
+    def->nfss = 0;
+    def->fss = NULL;
+    def->nnets = 0;
+    def->nets = NULL;
+    def->ninputs = 0;
+    def->inputs = NULL;
+    def->nsounds = 0;
+    def->sounds = NULL;
+    def->nvideos = 0;
+    def->videos = NULL;
+    def->nhostdevs = 0;
+    def->hostdevs = NULL;
+    def->nredirdevs = 0;
+    def->redirdevs = NULL;
+    def->nsmartcards = 0;
+    def->smartcards = NULL;
+    def->nserials = 0;
+    def->serials = NULL;
+    def->nparallels = 0;
+    def->parallels = NULL;
+    def->nchannels = 0;
+    def->channels = NULL;
+    def->nconsoles = 0;
+    def->consoles = NULL;
+    def->nleases = 0;
+    def->leases = NULL;
+    def->nhubs = 0;
+    def->hubs = NULL;
+    def->nseclabels = 0;
+    def->seclabels = NULL;
+    def->nrngs = 0;
+    def->rngs = NULL;
+    def->nshmems = 0;
+    def->shmems = NULL;
+    def->nmems = 0;
+    def->mems = NULL;
+    def->npanics = 0;
+    def->panics = NULL;
+    def->watchdog = NULL;
+    def->memballoon = NULL;
+    def->nvram = NULL;
+    def->tpm = NULL;
+    def->cpu = NULL;
+    def->sysinfo = NULL;
+    def->redirfilter = NULL;
+    def->iommu = NULL;
+    def->vsock = NULL;
+    def->namespaceData = NULL;
+    def->keywrap = NULL;
+    def->sev = NULL;
+    def->metadata = NULL;
+
+    if (VIR_STRDUP(def->name, src->name) < 0 ||
+        VIR_STRDUP(def->title, src->title) < 0 ||
+        VIR_STRDUP(def->description, src->description) < 0 ||
+        VIR_STRDUP(def->emulator, src->emulator) < 0 ||
+        VIR_STRDUP(def->hyperv_vendor_id, src->hyperv_vendor_id) < 0)
+        goto error;
+
+    if (src->blkio.ndevices &&
+        VIR_ALLOC_N(def->blkio.devices, src->blkio.ndevices) < 0)
+        goto error;
+
+    for (i = 0; i < src->blkio.ndevices; i++) {
+        def->blkio.devices[i] = src->blkio.devices[i];
+        def->blkio.devices[i].path = NULL;
+        def->blkio.ndevices++;
+        if (VIR_STRDUP(def->blkio.devices[i].path,
+                       src->blkio.devices[i].path) < 0)
+            goto error;
+    }
+
+    if (src->mem.nhugepages &&
+        VIR_ALLOC_N(def->mem.hugepages, src->mem.nhugepages) < 0)
+        goto error;
+
+    for (i = 0; i < src->mem.nhugepages; i++) {
+        def->mem.hugepages[i].size = src->mem.hugepages[i].size;
+        def->mem.nhugepages++;
+        if (src->mem.hugepages[i].nodemask &&
+            !(def->mem.hugepages[i].nodemask =
+              virBitmapNewCopy(src->mem.hugepages[i].nodemask)))
+            goto error;
+    }
+
+    if (src->maxvcpus &&
+        VIR_ALLOC_N(def->vcpus, src->maxvcpus) < 0)
+        goto error;
+
+    for (i = 0; i < src->maxvcpus; i++) {
+        virDomainVcpuDefPtr vcpu = src->vcpus[i];
+
+        if (!(def->vcpus[i] = virDomainVcpuDefNew(xmlopt)))
+            goto error;
+        def->maxvcpus++;
+
+        def->vcpus[i]->online = vcpu->online;
+        def->vcpus[i]->hotpluggable = vcpu->hotpluggable;
+        def->vcpus[i]->order = vcpu->order;
+        def->vcpus[i]->sched = vcpu->sched;
+
+        if (vcpu->cpumask &&
+            !(def->vcpus[i]->cpumask = virBitmapNewCopy(vcpu->cpumask)))
+            goto error;
+    }
+
+    if (src->cpumask &&
+        !(def->cpumask = virBitmapNewCopy(src->cpumask)))
+        goto error;
+
+    if (src->niothreadids &&
+        VIR_ALLOC_N(def->iothreadids, src->niothreadids) < 0)
+        goto error;
+
+    for (i = 0; i < src->niothreadids; i++) {
+        if (virDomainCopyPlainStruct(&def->iothreadids[i], src->iothreadids[i],
+                                     sizeof(*src->iothreadids[i])) < 0)
+            goto error;
+        def->iothreadids[i]->cpumask = NULL;
+        def->niothreadids++;
+
+        if (src->iothreadids[i]->cpumask &&
+            !(def->iothreadids[i]->cpumask =
+              virBitmapNewCopy(src->iothreadids[i]->cpumask)))
+            goto error;
+    }
+
+    if (src->cputune.emulatorpin &&
+        !(def->cputune.emulatorpin = virBitmapNewCopy(src->cputune.emulatorpin)))
+        goto error;
+
+    if (src->numa &&
+        !(def->numa = virDomainNumaCopy(src->numa)))
+        goto error;
+
+    if (src->resource &&
+        (VIR_ALLOC(def->resource) < 0 ||
+         VIR_STRDUP(def->resource->partition, src->resource->partition) < 0))
+        goto error;
+
+    if (src->idmap.nuidmap) {
+        if (VIR_ALLOC_N(def->idmap.uidmap, src->idmap.nuidmap) < 0)
+            goto error;
+        memcpy(def->idmap.uidmap, src->idmap.uidmap,
+               sizeof(*src->idmap.uidmap) * src->idmap.nuidmap);
+        def->idmap.nuidmap = src->idmap.nuidmap;
+    }
+
+    if (src->idmap.ngidmap) {
+        if (VIR_ALLOC_N(def->idmap.gidmap, src->idmap.ngidmap) < 0)
+            goto error;
+        memcpy(def->idmap.gidmap, src->idmap.gidmap,
+               sizeof(*src->idmap.gidmap) * src->idmap.ngidmap);
+        def->idmap.ngidmap = src->idmap.ngidmap;
+    }
+
+    def->os = src->os;
+    if (virDomainOSDefCopy(&def->os, &src->os) < 0)
+        goto error;
+
+    def->clock = src->clock;
+    if (virDomainClockDefCopy(&def->clock, &src->clock) < 0)
+        goto error;
+
+    if (src->ngraphics &&
+        VIR_ALLOC_N(def->graphics, src->ngraphics) < 0)
+        goto error;
+    for (i = 0; i < src->ngraphics; i++) {
+        if (!(def->graphics[i] = virDomainGraphicsDefCopy(src->graphics[i])))
+            goto error;
+        def->ngraphics++;
+    }
+
+    if (src->ndisks &&
+        VIR_ALLOC_N(def->disks, src->ndisks) < 0)
+        goto error;
+    for (i = 0; i < src->ndisks; i++) {
+        if (!(def->disks[i] = virDomainDiskDefCopy(src->disks[i], xmlopt)))
+            goto error;
+        def->ndisks++;
+    }
+
+    if (src->ncontrollers &&
+        VIR_ALLOC_N(def->controllers, src->ncontrollers) < 0)
+        goto error;
+    for (i = 0; i < src->ncontrollers; i++) {
+        if (!(def->controllers[i] =
+              virDomainControllerDefCopy(src->controllers[i])))
+            goto error;
+        def->ncontrollers++;
+    }
+
+    if (src->nfss &&
+        VIR_ALLOC_N(def->fss, src->nfss) < 0)
+        goto error;
+    for (i = 0; i < src->nfss; i++) {
+        if (!(def->fss[i] = virDomainFSDefCopy(src->fss[i])))
+            goto error;
+        def->nfss++;
+    }
+
+    if (src->nnets &&
+        VIR_ALLOC_N(def->nets, src->nnets) < 0)
+        goto error;
+    for (i = 0; i < src->nnets; i++) {
+        if (!(def->nets[i] = virDomainNetDefCopy(src->nets[i], xmlopt)))
+            goto error;
+        def->nnets++;
+    }
+
+    if (src->ninputs &&
+        VIR_ALLOC_N(def->inputs, src->ninputs) < 0)
+        goto error;
+    for (i = 0; i < src->ninputs; i++) {
+        if (!(def->inputs[i] = virDomainInputDefCopy(src->inputs[i])))
+            goto error;
+        def->ninputs++;
+    }
+
+    if (src->nsounds &&
+        VIR_ALLOC_N(def->sounds, src->nsounds) < 0)
+        goto error;
+    for (i = 0; i < src->nsounds; i++) {
+        if (!(def->sounds[i] = virDomainSoundDefCopy(src->sounds[i])))
+            goto error;
+        def->nsounds++;
+    }
+
+    if (src->nvideos &&
+        VIR_ALLOC_N(def->videos, src->nvideos) < 0)
+        goto error;
+    for (i = 0; i < src->nvideos; i++) {
+        if (!(def->videos[i] = virDomainVideoDefCopy(src->videos[i])))
+            goto error;
+        def->nvideos++;
+    }
+
+    /* must come after nets, see virDomainDefCopyFindNetHostdev */
+    if (src->nhostdevs &&
+        VIR_ALLOC_N(def->hostdevs, src->nhostdevs) < 0)
+        goto error;
+    for (i = 0; i < src->nhostdevs; i++) {
+        virDomainHostdevDefPtr hostdev = src->hostdevs[i];
+
+        if (hostdev->parent.type == VIR_DOMAIN_DEVICE_NET)
+            def->hostdevs[i] = virDomainDefCopyFindNetHostdev(def, src, hostdev);
+        else
+            def->hostdevs[i] = virDomainHostdevDefCopy(hostdev);
+
+        if (!def->hostdevs[i])
+            goto error;
+        def->nhostdevs++;
+    }
+
+    if (src->nredirdevs &&
+        VIR_ALLOC_N(def->redirdevs, src->nredirdevs) < 0)
+        goto error;
+    for (i = 0; i < src->nredirdevs; i++) {
+        if (!(def->redirdevs[i] =
+              virDomainRedirdevDefCopy(src->redirdevs[i], xmlopt)))
+            goto error;
+        def->nredirdevs++;
+    }
+
+    if (src->nsmartcards &&
+        VIR_ALLOC_N(def->smartcards, src->nsmartcards) < 0)
+        goto error;
+    for (i = 0; i < src->nsmartcards; i++) {
+        if (!(def->smartcards[i] =
+              virDomainSmartcardDefCopy(src->smartcards[i], xmlopt)))
+            goto error;
+        def->nsmartcards++;
+    }
+
+    if (src->nserials &&
+        VIR_ALLOC_N(def->serials, src->nserials) < 0)
+        goto error;
+    for (i = 0; i < src->nserials; i++) {
+        if (!(def->serials[i] = virDomainChrDefCopy(src->serials[i], xmlopt)))
+            goto error;
+        def->nserials++;
+    }
+
+    if (src->nparallels &&
+        VIR_ALLOC_N(def->parallels, src->nparallels) < 0)
+        goto error;
+    for (i = 0; i < src->nparallels; i++) {
+        if (!(def->parallels[i] =
+              virDomainChrDefCopy(src->parallels[i], xmlopt)))
+            goto error;
+        def->nparallels++;
+    }
+
+    if (src->nchannels &&
+        VIR_ALLOC_N(def->channels, src->nchannels) < 0)
+        goto error;
+    for (i = 0; i < src->nchannels; i++) {
+        if (!(def->channels[i] = virDomainChrDefCopy(src->channels[i], xmlopt)))
+            goto error;
+        def->nchannels++;
+    }
+
+    if (src->nconsoles &&
+        VIR_ALLOC_N(def->consoles, src->nconsoles) < 0)
+        goto error;
+    for (i = 0; i < src->nconsoles; i++) {
+        if (!(def->consoles[i] = virDomainChrDefCopy(src->consoles[i], xmlopt)))
+            goto error;
+        def->nconsoles++;
+    }
+
+    if (src->nleases &&
+        VIR_ALLOC_N(def->leases, src->nleases) < 0)
+        goto error;
+    for (i = 0; i < src->nleases; i++) {
+        if (!(def->leases[i] = virDomainLeaseDefCopy(src->leases[i])))
+            goto error;
+        def->nleases++;
+    }
+
+    if (src->nhubs &&
+        VIR_ALLOC_N(def->hubs, src->nhubs) < 0)
+        goto error;
+    for (i = 0; i < src->nhubs; i++) {
+        if (!(def->hubs[i] = virDomainHubDefCopy(src->hubs[i])))
+            goto error;
+        def->nhubs++;
+    }
+
+    if (src->nseclabels &&
+        VIR_ALLOC_N(def->seclabels, src->nseclabels) < 0)
+        goto error;
+    for (i = 0; i < src->nseclabels; i++) {
+        if (!(def->seclabels[i] = virSecurityLabelDefCopy(src->seclabels[i])))
+            goto error;
+        def->nseclabels++;
+    }
+
+    if (src->nrngs &&
+        VIR_ALLOC_N(def->rngs, src->nrngs) < 0)
+        goto error;
+    for (i = 0; i < src->nrngs; i++) {
+        if (!(def->rngs[i] = virDomainRNGDefCopy(src->rngs[i], xmlopt)))
+            goto error;
+        def->nrngs++;
+    }
+
+    if (src->nshmems &&
+        VIR_ALLOC_N(def->shmems, src->nshmems) < 0)
+        goto error;
+    for (i = 0; i < src->nshmems; i++) {
+        if (!(def->shmems[i] = virDomainShmemDefCopy(src->shmems[i])))
+            goto error;
+        def->nshmems++;
+    }
+
+    if (src->nmems &&
+        VIR_ALLOC_N(def->mems, src->nmems) < 0)
+        goto error;
+    for (i = 0; i < src->nmems; i++) {
+        if (!(def->mems[i] = virDomainMemoryDefCopy(src->mems[i])))
+            goto error;
+        def->nmems++;
+    }
+
+    if (src->npanics &&
+        VIR_ALLOC_N(def->panics, src->npanics) < 0)
+        goto error;
+    for (i = 0; i < src->npanics; i++) {
+        if (!(def->panics[i] = virDomainPanicDefCopy(src->panics[i])))
+            goto error;
+        def->npanics++;
+    }
+
+    if (src->watchdog &&
+        !(def->watchdog = virDomainWatchdogDefCopy(src->watchdog)))
+        goto error;
+
+    if (src->memballoon &&
+        !(def->memballoon = virDomainMemballoonDefCopy(src->memballoon)))
+        goto error;
+
+    if (src->nvram &&
+        !(def->nvram = virDomainNVRAMDefCopy(src->nvram)))
+        goto error;
+
+    if (src->tpm &&
+        !(def->tpm = virDomainTPMDefCopy(src->tpm)))
+        goto error;
+
+    if (src->cpu &&
+        !(def->cpu = virCPUDefCopy(src->cpu)))
+        goto error;
+
+    if (src->sysinfo &&
+        !(def->sysinfo = virSysinfoDefCopy(src->sysinfo)))
+        goto error;
+
+    if (src->redirfilter) {
+        if (VIR_ALLOC(def->redirfilter) < 0)
+            goto error;
+
+        if (src->redirfilter->nusbdevs &&
+            VIR_ALLOC_N(def->redirfilter->usbdevs,
+                        src->redirfilter->nusbdevs) < 0)
+            goto error;
+
+        for (i = 0; i < src->redirfilter->nusbdevs; i++) {
+            if (virDomainCopyPlainStruct(&def->redirfilter->usbdevs[i],
+                                         src->redirfilter->usbdevs[i],
+                                         sizeof(*src->redirfilter->usbdevs[i])) < 0)
+                goto error;
+            def->redirfilter->nusbdevs++;
+        }
+    }
+
+    if (src->vsock &&
+        !(def->vsock = virDomainVsockDefCopy(src->vsock, xmlopt)))
+        goto error;
+
+    if (virDomainCopyPlainStruct(&def->iommu, src->iommu,
+                                 sizeof(*src->iommu)) < 0 ||
+        virDomainCopyPlainStruct(&def->keywrap, src->keywrap,
+                                 sizeof(*src->keywrap)) < 0)
+        goto error;
+
+    if (src->sev) {
+        if (VIR_ALLOC(def->sev) < 0)
+            goto error;
+
+        *def->sev = *src->sev;
+        def->sev->dh_cert = NULL;
+        def->sev->session = NULL;
+
+        if (VIR_STRDUP(def->sev->dh_cert, src->sev->dh_cert) < 0 ||
+            VIR_STRDUP(def->sev->session, src->sev->session) < 0)
+            goto error;
+    }
+
+    if (src->metadata &&
+        !(def->metadata = xmlCopyNode(src->metadata, 1))) {
+        virReportOOMError();
+        goto error;
+    }
+
+    return def;
+
+ error:
+    virDomainDefFree(def);
+    return NULL;
+}
+
+
 /* Copy src into a new definition; with the quality of the copy
  * depending on the migratable flag (false for transitions between
  * persistent and active, true for transitions across save files or
@@ -29409,6 +31189,11 @@ virDomainDefCopy(virDomainDefPtr src,
     unsigned int parse_flags = VIR_DOMAIN_DEF_PARSE_INACTIVE |
                                VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE;
 
+    /* Nothing needs to be left out of the copy, which can thus be
+     * made without the expensive round-trip through XML.  */
+    if (!migratable && virDomainDefCanCopyNative(src))
+        return virDomainDefCopyNative(src, xmlopt);
+
     if (migratable)
         format_flags |= VIR_DOMAIN_DEF_FORMAT_INACTIVE | VIR_DOMAIN_DEF_FORMAT_MIGRATABLE;
 
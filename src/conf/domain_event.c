@@ -1239,6 +1239,7 @@ virDomainEventBalloonChangeNewFromDom(virDomainPtr dom,
         return NULL;
 
     ev->actual = actual;
+    ev->parent.parent.coalesce = true;
 
     return (virObjectEventPtr)ev;
 }
@@ -1257,6 +1258,7 @@ virDomainEventBalloonChangeNewFromObj(virDomainObjPtr obj,
         return NULL;
 
     ev->actual = actual;
+    ev->parent.parent.coalesce = true;
 
     return (virObjectEventPtr)ev;
 }
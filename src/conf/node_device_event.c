@@ -276,5 +276,7 @@ virNodeDeviceEventUpdateNew(const char *name)
                                     0, name, NULL, name)))
         return NULL;
 
+    event->parent.parent.coalesce = true;
+
     return (virObjectEventPtr)event;
 }
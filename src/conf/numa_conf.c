@@ -1086,6 +1086,61 @@ virDomainNumaNew(void)
 }
 
 
+virDomainNumaPtr
+virDomainNumaCopy(const virDomainNuma *src)
+{
+    virDomainNumaPtr ret = NULL;
+    size_t i;
+
+    if (VIR_ALLOC(ret) < 0)
+        return NULL;
+
+    ret->memory = src->memory;
+    ret->memory.nodeset = NULL;
+
+    if (src->memory.nodeset &&
+        !(ret->memory.nodeset = virBitmapNewCopy(src->memory.nodeset)))
+        goto error;
+
+    if (src->nmem_nodes &&
+        VIR_ALLOC_N(ret->mem_nodes, src->nmem_nodes) < 0)
+        goto error;
+
+    for (i = 0; i < src->nmem_nodes; i++) {
+        struct _virDomainNumaNode *node = &ret->mem_nodes[i];
+
+        *node = src->mem_nodes[i];
+        node->cpumask = NULL;
+        node->nodeset = NULL;
+        node->distances = NULL;
+        node->ndistances = 0;
+        ret->nmem_nodes++;
+
+        if (src->mem_nodes[i].cpumask &&
+            !(node->cpumask = virBitmapNewCopy(src->mem_nodes[i].cpumask)))
+            goto error;
+
+        if (src->mem_nodes[i].nodeset &&
+            !(node->nodeset = virBitmapNewCopy(src->mem_nodes[i].nodeset)))
+            goto error;
+
+        if (src->mem_nodes[i].ndistances) {
+            if (VIR_ALLOC_N(node->distances, src->mem_nodes[i].ndistances) < 0)
+                goto error;
+            memcpy(node->distances, src->mem_nodes[i].distances,
+                   sizeof(*node->distances) * src->mem_nodes[i].ndistances);
+            node->ndistances = src->mem_nodes[i].ndistances;
+        }
+    }
+
+    return ret;
+
+ error:
+    virDomainNumaFree(ret);
+    return NULL;
+}
+
+
 bool
 virDomainNumaCheckABIStability(virDomainNumaPtr src,
                                virDomainNumaPtr tgt)
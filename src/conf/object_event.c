@@ -30,6 +30,7 @@
 #include "datatypes.h"
 #include "viralloc.h"
 #include "virerror.h"
+#include "virhash.h"
 #include "virobject.h"
 #include "virstring.h"
 
@@ -52,6 +53,7 @@ struct _virObjectEventCallback {
     virFreeCallback freecb;
     bool deleted;
     bool legacy; /* true if end user does not know callbackID */
+    bool coalesce; /* skip events superseded by a later one */
 };
 typedef struct _virObjectEventCallback virObjectEventCallback;
 typedef virObjectEventCallback *virObjectEventCallbackPtr;
@@ -443,6 +445,7 @@ virObjectEventCallbackListAddID(virConnectPtr conn,
     cb->filter = filter;
     cb->filter_opaque = filter_opaque;
     cb->legacy = legacy;
+    cb->coalesce = conn && (conn->flags & VIR_CONNECT_COALESCE_EVENTS);
 
     if (VIR_APPEND_ELEMENT(cbList->callbacks, cbList->count, cb) < 0)
         goto cleanup;
@@ -673,6 +676,8 @@ virObjectEventDispatchMatchCallback(virObjectEventPtr event,
         return false;
     if (cb->remoteID != event->remoteID)
         return false;
+    if (cb->coalesce && event->superseded)
+        return false;
 
     if (cb->filter && !(cb->filter)(cb->conn, event, cb->filter_opaque))
         return false;
@@ -800,6 +805,80 @@ virObjectEventStateCleanupTimer(virObjectEventStatePtr state, bool clear_queue)
 }
 
 
+/**
+ * virObjectEventQueueMarkSuperseded:
+ * @queue: the queue of events about to be dispatched
+ * @callbacks: the callbacks the events will be dispatched to
+ *
+ * Mark the events in @queue which are superseded by a later event of
+ * the same type for the same object. Only events which describe the
+ * complete state of the object are considered, see
+ * virObjectEvent.coalesce. The marked events are not dispatched to
+ * callbacks of connections opened with VIR_CONNECT_COALESCE_EVENTS,
+ * which end up seeing the same state as if all of the events were
+ * dispatched since the survivor is the most recent event.
+ */
+static void
+virObjectEventQueueMarkSuperseded(virObjectEventQueuePtr queue,
+                                  virObjectEventCallbackListPtr callbacks)
+{
+    virHashTablePtr seen = NULL;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < callbacks->count; i++) {
+        if (callbacks->callbacks[i]->coalesce)
+            break;
+    }
+    if (i == callbacks->count)
+        return;
+
+    for (i = 0; i < queue->count; i++) {
+        if (queue->events[i]->coalesce)
+            break;
+    }
+    /* Nothing can be superseded by an event which comes later */
+    if (i + 1 >= queue->count)
+        return;
+
+    if (!(seen = virHashCreate(queue->count - i, NULL))) {
+        virResetLastError();
+        return;
+    }
+
+    /* Walk backwards, so that the most recent event of each kind
+     * is the one kept */
+    for (j = queue->count; j > i; j--) {
+        virObjectEventPtr event = queue->events[j - 1];
+        char *key = NULL;
+        int rc = 0;
+
+        if (!event->coalesce)
+            continue;
+
+        if (virAsprintfQuiet(&key, "%s:%d:%d:%s",
+                             virClassName(event->parent.klass),
+                             event->eventID, event->remoteID,
+                             event->meta.key) < 0)
+            break;
+
+        if (virHashLookup(seen, key)) {
+            VIR_DEBUG("Event %p is superseded", event);
+            event->superseded = true;
+        } else {
+            rc = virHashAddEntry(seen, key, event);
+        }
+        VIR_FREE(key);
+        if (rc < 0) {
+            virResetLastError();
+            break;
+        }
+    }
+
+    virHashFree(seen);
+}
+
+
 static void
 virObjectEventStateFlush(virObjectEventStatePtr state)
 {
@@ -820,6 +899,8 @@ virObjectEventStateFlush(virObjectEventStatePtr state)
     if (state->timer != -1)
         virEventUpdateTimeout(state->timer, -1);
 
+    virObjectEventQueueMarkSuperseded(&tempQueue, state->callbacks);
+
     virObjectEventStateQueueDispatch(state,
                                      &tempQueue,
                                      state->callbacks);
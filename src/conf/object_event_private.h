@@ -49,6 +49,12 @@ struct _virObjectEvent {
     virObjectMeta meta;
     int remoteID;
     virObjectEventDispatchFunc dispatch;
+    /* The event describes the complete current state of the object,
+     * so of several queued ones only the most recent needs to be
+     * dispatched to connections which asked for it */
+    bool coalesce;
+    /* A later queued event carries the same information */
+    bool superseded;
 };
 
 /**
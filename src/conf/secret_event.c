@@ -298,5 +298,7 @@ virSecretEventValueChangedNew(const unsigned char *uuid,
                                     usage_type, usage_id, uuid, uuidstr)))
         return NULL;
 
+    event->parent.parent.coalesce = true;
+
     return (virObjectEventPtr)event;
 }
@@ -293,5 +293,7 @@ virStoragePoolEventRefreshNew(const char *name,
                                     0, name, uuid, uuidstr)))
         return NULL;
 
+    event->parent.parent.coalesce = true;
+
     return (virObjectEventPtr)event;
 }
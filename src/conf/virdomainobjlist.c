@@ -28,7 +28,9 @@
 #include "snapshot_conf.h"
 #include "viralloc.h"
 #include "virfile.h"
+#include "virhashcode.h"
 #include "virlog.h"
+#include "virrandom.h"
 #include "virstring.h"
 
 #define VIR_FROM_THIS VIR_FROM_DOMAIN
@@ -39,22 +41,39 @@ static virClassPtr virDomainObjListClass;
 static void virDomainObjListDispose(void *obj);
 
 
-struct _virDomainObjList {
-    virObjectRWLockable parent;
+/* Lookups of different domains mostly go to different shards and thus
+ * don't contend for the same lock */
+#define VIR_DOMAIN_OBJ_LIST_SHARDS 16
+
+typedef struct _virDomainObjListShard virDomainObjListShard;
+typedef virDomainObjListShard *virDomainObjListShardPtr;
+struct _virDomainObjListShard {
+    virRWLock lock;
 
-    /* uuid string -> virDomainObj  mapping
-     * for O(1), lockless lookup-by-uuid */
+    /* uuid string -> virDomainObj mapping for domains
+     * whose uuid hashes into this shard */
     virHashTable *objs;
 
-    /* name -> virDomainObj mapping for O(1),
-     * lockless lookup-by-name */
+    /* name -> virDomainObj mapping for domains
+     * whose name hashes into this shard */
     virHashTable *objsName;
 };
 
+struct _virDomainObjList {
+    virObject parent;
+
+    uint32_t seed;
+
+    /* Both the uuid and the name of a domain select a shard, which
+     * can be different ones. Operations needing more than one shard
+     * lock them in the order of this array. */
+    virDomainObjListShard shards[VIR_DOMAIN_OBJ_LIST_SHARDS];
+};
+
 
 static int virDomainObjListOnceInit(void)
 {
-    if (!VIR_CLASS_NEW(virDomainObjList, virClassForObjectRWLockable()))
+    if (!VIR_CLASS_NEW(virDomainObjList, virClassForObject()))
         return -1;
 
     return 0;
@@ -65,17 +84,31 @@ VIR_ONCE_GLOBAL_INIT(virDomainObjList)
 virDomainObjListPtr virDomainObjListNew(void)
 {
     virDomainObjListPtr doms;
+    size_t i;
 
     if (virDomainObjListInitialize() < 0)
         return NULL;
 
-    if (!(doms = virObjectRWLockableNew(virDomainObjListClass)))
+    if (!(doms = virObjectNew(virDomainObjListClass)))
         return NULL;
 
-    if (!(doms->objs = virHashCreate(50, virObjectFreeHashData)) ||
-        !(doms->objsName = virHashCreate(50, virObjectFreeHashData))) {
-        virObjectUnref(doms);
-        return NULL;
+    doms->seed = virRandomBits(32);
+
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++) {
+        virDomainObjListShardPtr shard = &doms->shards[i];
+
+        if (virRWLockInit(&shard->lock) < 0) {
+            virReportSystemError(errno, "%s",
+                                 _("Unable to initialize domain list lock"));
+            virObjectUnref(doms);
+            return NULL;
+        }
+
+        if (!(shard->objs = virHashCreate(10, virObjectFreeHashData)) ||
+            !(shard->objsName = virHashCreate(10, virObjectFreeHashData))) {
+            virObjectUnref(doms);
+            return NULL;
+        }
     }
 
     return doms;
@@ -85,9 +118,103 @@ virDomainObjListPtr virDomainObjListNew(void)
 static void virDomainObjListDispose(void *obj)
 {
     virDomainObjListPtr doms = obj;
+    size_t i;
+
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++) {
+        virHashFree(doms->shards[i].objs);
+        virHashFree(doms->shards[i].objsName);
+        virRWLockDestroy(&doms->shards[i].lock);
+    }
+}
+
+
+static virDomainObjListShardPtr
+virDomainObjListGetShard(virDomainObjListPtr doms,
+                         const char *key)
+{
+    uint32_t code = virHashCodeGen(key, strlen(key), doms->seed);
+
+    return &doms->shards[code % VIR_DOMAIN_OBJ_LIST_SHARDS];
+}
+
+
+static virDomainObjListShardPtr
+virDomainObjListGetUUIDShard(virDomainObjListPtr doms,
+                             const unsigned char *uuid)
+{
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+
+    virUUIDFormat(uuid, uuidstr);
+    return virDomainObjListGetShard(doms, uuidstr);
+}
+
+
+/* Write lock both @a and @b, which may be the same shard */
+static void
+virDomainObjListLockPair(virDomainObjListShardPtr a,
+                         virDomainObjListShardPtr b)
+{
+    if (a > b) {
+        virDomainObjListShardPtr tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    virRWLockWrite(&a->lock);
+    if (b != a)
+        virRWLockWrite(&b->lock);
+}
+
+
+static void
+virDomainObjListUnlockPair(virDomainObjListShardPtr a,
+                           virDomainObjListShardPtr b)
+{
+    if (b != a)
+        virRWLockUnlock(&b->lock);
+    virRWLockUnlock(&a->lock);
+}
+
+
+/* Lock all shards which gives a consistent view of the whole list */
+static void
+virDomainObjListLockAll(virDomainObjListPtr doms,
+                        bool write)
+{
+    size_t i;
 
-    virHashFree(doms->objs);
-    virHashFree(doms->objsName);
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++) {
+        if (write)
+            virRWLockWrite(&doms->shards[i].lock);
+        else
+            virRWLockRead(&doms->shards[i].lock);
+    }
+}
+
+
+static void
+virDomainObjListUnlockAll(virDomainObjListPtr doms)
+{
+    size_t i = VIR_DOMAIN_OBJ_LIST_SHARDS;
+
+    while (i-- > 0)
+        virRWLockUnlock(&doms->shards[i].lock);
+}
+
+
+/* Calls @iter on all domains in the list with all shards read
+ * locked. */
+static void
+virDomainObjListIterate(virDomainObjListPtr doms,
+                        virHashIterator iter,
+                        void *opaque)
+{
+    size_t i;
+
+    virDomainObjListLockAll(doms, false);
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++)
+        virHashForEach(doms->shards[i].objs, iter, opaque);
+    virDomainObjListUnlockAll(doms);
 }
 
 
@@ -112,12 +239,18 @@ virDomainObjPtr
 virDomainObjListFindByID(virDomainObjListPtr doms,
                          int id)
 {
-    virDomainObjPtr obj;
+    virDomainObjPtr obj = NULL;
+    size_t i;
+
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS && !obj; i++) {
+        virDomainObjListShardPtr shard = &doms->shards[i];
+
+        virRWLockRead(&shard->lock);
+        obj = virHashSearch(shard->objs, virDomainObjListSearchID, &id, NULL);
+        virObjectRef(obj);
+        virRWLockUnlock(&shard->lock);
+    }
 
-    virObjectRWLockRead(doms);
-    obj = virHashSearch(doms->objs, virDomainObjListSearchID, &id, NULL);
-    virObjectRef(obj);
-    virObjectRWUnlock(doms);
     if (obj) {
         virObjectLock(obj);
         if (obj->removing) {
@@ -139,7 +272,8 @@ virDomainObjListFindByUUIDLocked(virDomainObjListPtr doms,
     virDomainObjPtr obj;
 
     virUUIDFormat(uuid, uuidstr);
-    obj = virHashLookup(doms->objs, uuidstr);
+    obj = virHashLookup(virDomainObjListGetShard(doms, uuidstr)->objs,
+                        uuidstr);
     virObjectRef(obj);
     if (obj) {
         virObjectLock(obj);
@@ -165,11 +299,12 @@ virDomainObjPtr
 virDomainObjListFindByUUID(virDomainObjListPtr doms,
                            const unsigned char *uuid)
 {
+    virDomainObjListShardPtr shard = virDomainObjListGetUUIDShard(doms, uuid);
     virDomainObjPtr obj;
 
-    virObjectRWLockRead(doms);
+    virRWLockRead(&shard->lock);
     obj = virDomainObjListFindByUUIDLocked(doms, uuid);
-    virObjectRWUnlock(doms);
+    virRWLockUnlock(&shard->lock);
 
     return obj;
 }
@@ -181,7 +316,7 @@ virDomainObjListFindByNameLocked(virDomainObjListPtr doms,
 {
     virDomainObjPtr obj;
 
-    obj = virHashLookup(doms->objsName, name);
+    obj = virHashLookup(virDomainObjListGetShard(doms, name)->objsName, name);
     virObjectRef(obj);
     if (obj) {
         virObjectLock(obj);
@@ -207,11 +342,12 @@ virDomainObjPtr
 virDomainObjListFindByName(virDomainObjListPtr doms,
                            const char *name)
 {
+    virDomainObjListShardPtr shard = virDomainObjListGetShard(doms, name);
     virDomainObjPtr obj;
 
-    virObjectRWLockRead(doms);
+    virRWLockRead(&shard->lock);
     obj = virDomainObjListFindByNameLocked(doms, name);
-    virObjectRWUnlock(doms);
+    virRWLockUnlock(&shard->lock);
 
     return obj;
 }
@@ -238,14 +374,17 @@ virDomainObjListAddObjLocked(virDomainObjListPtr doms,
                              virDomainObjPtr vm)
 {
     char uuidstr[VIR_UUID_STRING_BUFLEN];
+    virHashTablePtr objs;
 
     virUUIDFormat(vm->def->uuid, uuidstr);
-    if (virHashAddEntry(doms->objs, uuidstr, vm) < 0)
+    objs = virDomainObjListGetShard(doms, uuidstr)->objs;
+    if (virHashAddEntry(objs, uuidstr, vm) < 0)
         return -1;
     virObjectRef(vm);
 
-    if (virHashAddEntry(doms->objsName, vm->def->name, vm) < 0) {
-        virHashRemoveEntry(doms->objs, uuidstr);
+    if (virHashAddEntry(virDomainObjListGetShard(doms, vm->def->name)->objsName,
+                        vm->def->name, vm) < 0) {
+        virHashRemoveEntry(objs, uuidstr);
         return -1;
     }
     virObjectRef(vm);
@@ -257,6 +396,9 @@ virDomainObjListAddObjLocked(virDomainObjListPtr doms,
 /*
  * virDomainObjListAddLocked:
  *
+ * The caller must hold write locks on the shards of both the UUID
+ * and the name of @def.
+ *
  * If flags & VIR_DOMAIN_OBJ_LIST_ADD_CHECK_LIVE then
  * this will refuse updating an existing def if the
  * current def is Live
@@ -347,17 +489,22 @@ virDomainObjPtr virDomainObjListAdd(virDomainObjListPtr doms,
                                     unsigned int flags,
                                     virDomainDefPtr *oldDef)
 {
+    virDomainObjListShardPtr uuidShard;
+    virDomainObjListShardPtr nameShard;
     virDomainObjPtr ret;
 
-    virObjectRWLockWrite(doms);
+    uuidShard = virDomainObjListGetUUIDShard(doms, def->uuid);
+    nameShard = virDomainObjListGetShard(doms, def->name);
+
+    virDomainObjListLockPair(uuidShard, nameShard);
     ret = virDomainObjListAddLocked(doms, def, xmlopt, flags, oldDef);
-    virObjectRWUnlock(doms);
+    virDomainObjListUnlockPair(uuidShard, nameShard);
     return ret;
 }
 
 
-/* The caller must hold lock on 'doms' in addition to 'virDomainObjListRemove'
- * requirements
+/* The caller must hold lock on the shards of 'doms' containing 'dom' in
+ * addition to 'virDomainObjListRemove' requirements
  *
  * Can be used to remove current element while iterating with
  * virDomainObjListForEach
@@ -370,8 +517,10 @@ virDomainObjListRemoveLocked(virDomainObjListPtr doms,
 
     virUUIDFormat(dom->def->uuid, uuidstr);
 
-    virHashRemoveEntry(doms->objs, uuidstr);
-    virHashRemoveEntry(doms->objsName, dom->def->name);
+    virHashRemoveEntry(virDomainObjListGetShard(doms, uuidstr)->objs,
+                       uuidstr);
+    virHashRemoveEntry(virDomainObjListGetShard(doms, dom->def->name)->objsName,
+                       dom->def->name);
 }
 
 
@@ -392,14 +541,20 @@ void
 virDomainObjListRemove(virDomainObjListPtr doms,
                        virDomainObjPtr dom)
 {
+    virDomainObjListShardPtr uuidShard;
+    virDomainObjListShardPtr nameShard;
+
+    uuidShard = virDomainObjListGetUUIDShard(doms, dom->def->uuid);
+    nameShard = virDomainObjListGetShard(doms, dom->def->name);
+
     dom->removing = true;
     virObjectRef(dom);
     virObjectUnlock(dom);
-    virObjectRWLockWrite(doms);
+    virDomainObjListLockPair(uuidShard, nameShard);
     virObjectLock(dom);
     virDomainObjListRemoveLocked(doms, dom);
     virObjectUnref(dom);
-    virObjectRWUnlock(doms);
+    virDomainObjListUnlockPair(uuidShard, nameShard);
 }
 
 
@@ -420,6 +575,8 @@ virDomainObjListRename(virDomainObjListPtr doms,
                        virDomainObjListRenameCallback callback,
                        void *opaque)
 {
+    virDomainObjListShardPtr oldShard;
+    virDomainObjListShardPtr newShard;
     int ret = -1;
     char *old_name = NULL;
     int rc;
@@ -433,23 +590,26 @@ virDomainObjListRename(virDomainObjListPtr doms,
     if (VIR_STRDUP(old_name, dom->def->name) < 0)
         return ret;
 
+    oldShard = virDomainObjListGetShard(doms, old_name);
+    newShard = virDomainObjListGetShard(doms, new_name);
+
     /* doms and dom locks must be attained in right order thus relock dom. */
     /* dom reference is touched for the benefit of those callers that
      * hold a lock on dom but not refcount it. */
     virObjectRef(dom);
     virObjectUnlock(dom);
-    virObjectRWLockWrite(doms);
+    virDomainObjListLockPair(oldShard, newShard);
     virObjectLock(dom);
     virObjectUnref(dom);
 
-    if (virHashLookup(doms->objsName, new_name) != NULL) {
+    if (virHashLookup(newShard->objsName, new_name) != NULL) {
         virReportError(VIR_ERR_OPERATION_INVALID,
                        _("domain with name '%s' already exists"),
                        new_name);
         goto cleanup;
     }
 
-    if (virHashAddEntry(doms->objsName, new_name, dom) < 0)
+    if (virHashAddEntry(newShard->objsName, new_name, dom) < 0)
         goto cleanup;
 
     /* Increment the refcnt for @new_name. We're about to remove
@@ -460,13 +620,16 @@ virDomainObjListRename(virDomainObjListPtr doms,
     virObjectRef(dom);
 
     rc = callback(dom, new_name, flags, opaque);
-    virHashRemoveEntry(doms->objsName, rc < 0 ? new_name : old_name);
-    if (rc < 0)
+    if (rc < 0) {
+        virHashRemoveEntry(newShard->objsName, new_name);
         goto cleanup;
+    }
+
+    virHashRemoveEntry(oldShard->objsName, old_name);
 
     ret = 0;
  cleanup:
-    virObjectRWUnlock(doms);
+    virDomainObjListUnlockPair(oldShard, newShard);
     VIR_FREE(old_name);
     return ret;
 }
@@ -502,7 +665,7 @@ virDomainObjListLoadConfig(virDomainObjListPtr doms,
     if ((autostart = virFileLinkPointsTo(autostartLink, configFile)) < 0)
         goto error;
 
-    if (!(dom = virDomainObjListAddLocked(doms, def, xmlopt, 0, &oldDef)))
+    if (!(dom = virDomainObjListAdd(doms, def, xmlopt, 0, &oldDef)))
         goto error;
 
     dom->autostart = autostart;
@@ -534,7 +697,10 @@ virDomainObjListLoadStatus(virDomainObjListPtr doms,
 {
     char *statusFile = NULL;
     virDomainObjPtr obj = NULL;
+    virDomainObjListShardPtr uuidShard;
+    virDomainObjListShardPtr nameShard;
     char uuidstr[VIR_UUID_STRING_BUFLEN];
+    int rc;
 
     if ((statusFile = virDomainConfigFile(statusDir, name)) == NULL)
         goto error;
@@ -548,15 +714,21 @@ virDomainObjListLoadStatus(virDomainObjListPtr doms,
         goto error;
 
     virUUIDFormat(obj->def->uuid, uuidstr);
+    uuidShard = virDomainObjListGetShard(doms, uuidstr);
+    nameShard = virDomainObjListGetShard(doms, obj->def->name);
 
-    if (virHashLookup(doms->objs, uuidstr) != NULL) {
+    virDomainObjListLockPair(uuidShard, nameShard);
+    if (virHashLookup(uuidShard->objs, uuidstr) != NULL) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("unexpected domain %s already exists"),
                        obj->def->name);
-        goto error;
+        rc = -1;
+    } else {
+        rc = virDomainObjListAddObjLocked(doms, obj);
     }
+    virDomainObjListUnlockPair(uuidShard, nameShard);
 
-    if (virDomainObjListAddObjLocked(doms, obj) < 0)
+    if (rc < 0)
         goto error;
 
     if (notify)
@@ -592,8 +764,6 @@ virDomainObjListLoadAllConfigs(virDomainObjListPtr doms,
     if ((rc = virDirOpenIfExists(&dir, configDir)) <= 0)
         return rc;
 
-    virObjectRWLockWrite(doms);
-
     while ((ret = virDirRead(dir, &entry, configDir)) > 0) {
         virDomainObjPtr dom;
 
@@ -630,7 +800,6 @@ virDomainObjListLoadAllConfigs(virDomainObjListPtr doms,
     }
 
     VIR_DIR_CLOSE(dir);
-    virObjectRWUnlock(doms);
     return ret;
 }
 
@@ -674,9 +843,7 @@ virDomainObjListNumOfDomains(virDomainObjListPtr doms,
                              virConnectPtr conn)
 {
     struct virDomainObjListData data = { filter, conn, active, 0 };
-    virObjectRWLockRead(doms);
-    virHashForEach(doms->objs, virDomainObjListCount, &data);
-    virObjectRWUnlock(doms);
+    virDomainObjListIterate(doms, virDomainObjListCount, &data);
     return data.count;
 }
 
@@ -718,9 +885,7 @@ virDomainObjListGetActiveIDs(virDomainObjListPtr doms,
 {
     struct virDomainIDData data = { filter, conn,
                                     0, maxids, ids };
-    virObjectRWLockRead(doms);
-    virHashForEach(doms->objs, virDomainObjListCopyActiveIDs, &data);
-    virObjectRWUnlock(doms);
+    virDomainObjListIterate(doms, virDomainObjListCopyActiveIDs, &data);
     return data.numids;
 }
 
@@ -772,9 +937,7 @@ virDomainObjListGetInactiveNames(virDomainObjListPtr doms,
     struct virDomainNameData data = { filter, conn,
                                       0, 0, maxnames, names };
     size_t i;
-    virObjectRWLockRead(doms);
-    virHashForEach(doms->objs, virDomainObjListCopyInactiveNames, &data);
-    virObjectRWUnlock(doms);
+    virDomainObjListIterate(doms, virDomainObjListCopyInactiveNames, &data);
     if (data.oom) {
         for (i = 0; i < data.numnames; i++)
             VIR_FREE(data.names[i]);
@@ -813,9 +976,7 @@ virDomainObjListForEach(virDomainObjListPtr doms,
     struct virDomainListIterData data = {
         callback, opaque, 0,
     };
-    virObjectRWLockRead(doms);
-    virHashForEach(doms->objs, virDomainObjListHelper, &data);
-    virObjectRWUnlock(doms);
+    virDomainObjListIterate(doms, virDomainObjListHelper, &data);
     return data.ret;
 }
 
@@ -945,16 +1106,22 @@ virDomainObjListCollect(virDomainObjListPtr domlist,
                         unsigned int flags)
 {
     struct virDomainListData data = { NULL, 0 };
+    size_t count = 0;
+    size_t i;
+
+    virDomainObjListLockAll(domlist, false);
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++)
+        count += virHashSize(domlist->shards[i].objs);
 
-    virObjectRWLockRead(domlist);
-    sa_assert(domlist->objs);
-    if (VIR_ALLOC_N(data.vms, virHashSize(domlist->objs)) < 0) {
-        virObjectRWUnlock(domlist);
+    if (VIR_ALLOC_N(data.vms, count) < 0) {
+        virDomainObjListUnlockAll(domlist);
         return -1;
     }
 
-    virHashForEach(domlist->objs, virDomainObjListCollectIterator, &data);
-    virObjectRWUnlock(domlist);
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++)
+        virHashForEach(domlist->shards[i].objs,
+                       virDomainObjListCollectIterator, &data);
+    virDomainObjListUnlockAll(domlist);
 
     virDomainObjListFilter(&data.vms, &data.nvms, conn, filter, flags);
 
@@ -965,6 +1132,26 @@ virDomainObjListCollect(virDomainObjListPtr domlist,
 }
 
 
+/* Returns a new reference to the object with @uuid, or NULL */
+static virDomainObjPtr
+virDomainObjListLookupUUIDRef(virDomainObjListPtr domlist,
+                              const unsigned char *uuid)
+{
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+    virDomainObjListShardPtr shard;
+    virDomainObjPtr vm;
+
+    virUUIDFormat(uuid, uuidstr);
+    shard = virDomainObjListGetShard(domlist, uuidstr);
+
+    virRWLockRead(&shard->lock);
+    vm = virObjectRef(virHashLookup(shard->objs, uuidstr));
+    virRWLockUnlock(&shard->lock);
+
+    return vm;
+}
+
+
 int
 virDomainObjListConvert(virDomainObjListPtr domlist,
                         virConnectPtr conn,
@@ -983,32 +1170,25 @@ virDomainObjListConvert(virDomainObjListPtr domlist,
     *nvms = 0;
     *vms = NULL;
 
-    virObjectRWLockRead(domlist);
     for (i = 0; i < ndoms; i++) {
         virDomainPtr dom = doms[i];
 
-        virUUIDFormat(dom->uuid, uuidstr);
-
-        if (!(vm = virHashLookup(domlist->objs, uuidstr))) {
+        if (!(vm = virDomainObjListLookupUUIDRef(domlist, dom->uuid))) {
             if (skip_missing)
                 continue;
 
-            virObjectRWUnlock(domlist);
+            virUUIDFormat(dom->uuid, uuidstr);
             virReportError(VIR_ERR_NO_DOMAIN,
                            _("no domain with matching uuid '%s' (%s)"),
                            uuidstr, dom->name);
             goto error;
         }
 
-        virObjectRef(vm);
-
         if (VIR_APPEND_ELEMENT(*vms, *nvms, vm) < 0) {
-            virObjectRWUnlock(domlist);
             virObjectUnref(vm);
             goto error;
         }
     }
-    virObjectRWUnlock(domlist);
 
     sa_assert(*vms);
     virDomainObjListFilter(vms, nvms, conn, filter, flags);
@@ -1024,6 +1204,202 @@ virDomainObjListConvert(virDomainObjListPtr domlist,
 }
 
 
+/**
+ * virDomainObjListLookupUUIDs:
+ * @domlist: list of domain objects
+ * @conn: connection the domain handles belong to
+ * @uuids: @nuuids raw UUIDs stored back to back
+ * @nuuids: number of UUIDs
+ * @domains: filled with an array of @nuuids domain handles
+ * @states: optional, filled with an array of @nuuids domain states
+ * @filter: ACL filter
+ *
+ * Bulk counterpart of looking up domains one by one by UUID. The
+ * returned arrays are indexed like @uuids; domains which do not exist,
+ * are being removed or are hidden by @filter get a NULL handle and
+ * VIR_DOMAIN_NOSTATE.
+ *
+ * Returns the number of domains found, -1 on error.
+ */
+int
+virDomainObjListLookupUUIDs(virDomainObjListPtr domlist,
+                            virConnectPtr conn,
+                            const unsigned char *uuids,
+                            size_t nuuids,
+                            virDomainPtr **domains,
+                            int **states,
+                            virDomainObjListACLFilter filter)
+{
+    virDomainPtr *doms = NULL;
+    int *st = NULL;
+    size_t i;
+    int nfound = 0;
+    int ret = -1;
+
+    if (VIR_ALLOC_N(doms, nuuids) < 0 ||
+        (states && VIR_ALLOC_N(st, nuuids) < 0))
+        goto cleanup;
+
+    for (i = 0; i < nuuids; i++) {
+        virDomainObjPtr vm;
+
+        if (st)
+            st[i] = VIR_DOMAIN_NOSTATE;
+
+        if (!(vm = virDomainObjListLookupUUIDRef(domlist,
+                                                 uuids + i * VIR_UUID_BUFLEN)))
+            continue;
+
+        virObjectLock(vm);
+        if (!vm->removing &&
+            (!filter || filter(conn, vm->def))) {
+            if (!(doms[i] = virGetDomain(conn, vm->def->name,
+                                         vm->def->uuid, vm->def->id))) {
+                virObjectUnlock(vm);
+                virObjectUnref(vm);
+                goto cleanup;
+            }
+            if (st)
+                st[i] = virDomainObjGetState(vm, NULL);
+            nfound++;
+        }
+        virObjectUnlock(vm);
+        virObjectUnref(vm);
+    }
+
+    *domains = doms;
+    doms = NULL;
+    if (states) {
+        *states = st;
+        st = NULL;
+    }
+    ret = nfound;
+
+ cleanup:
+    if (doms) {
+        for (i = 0; i < nuuids; i++)
+            virObjectUnref(doms[i]);
+        VIR_FREE(doms);
+    }
+    VIR_FREE(st);
+    return ret;
+}
+
+
+/* Records the error the last lifecycle action failed with */
+static int
+virDomainObjListLifecycleError(void)
+{
+    int code = virGetLastErrorCode();
+
+    virResetLastError();
+    return code == VIR_ERR_OK ? VIR_ERR_INTERNAL_ERROR : code;
+}
+
+
+/**
+ * virDomainObjListLifecycle:
+ * @domlist: list of domain objects
+ * @conn: connection the domain handles belong to
+ * @doms: domain handles
+ * @ndoms: number of domains in @doms
+ * @action: one of virDomainListLifecycleAction
+ * @errors: optional, filled with an array of @ndoms error codes
+ * @flags: flags for @action
+ * @ensureACL: checks the permission needed for @action on a domain, may
+ *             be NULL
+ * @start: driver's virDomainCreateWithFlags
+ * @shutdown: driver's virDomainShutdownFlags
+ * @destroy: driver's virDomainDestroyFlags
+ *
+ * Does the job of virDomainListLifecycle for drivers. @flags are checked
+ * against the ones the public API of @action knows about. Then each
+ * domain is checked with @ensureACL and handed to the driver's entry
+ * point for @action, which does its own checks and job handling. A
+ * failure is recorded in @errors for the domain and doesn't stop the
+ * others.
+ *
+ * Returns the number of domains @action succeeded on, -1 on error.
+ */
+int
+virDomainObjListLifecycle(virDomainObjListPtr domlist,
+                          virConnectPtr conn,
+                          virDomainPtr *doms,
+                          size_t ndoms,
+                          int action,
+                          int **errors,
+                          unsigned int flags,
+                          virDomainObjListLifecycleACL ensureACL,
+                          virDomainObjListLifecycleFunc start,
+                          virDomainObjListLifecycleFunc shutdown,
+                          virDomainObjListLifecycleFunc destroy)
+{
+    virDomainObjListLifecycleFunc func = NULL;
+    int *errs = NULL;
+    size_t i;
+    int nok = 0;
+
+    switch ((virDomainListLifecycleAction) action) {
+    case VIR_DOMAIN_LIST_LIFECYCLE_START:
+        virCheckFlags(VIR_DOMAIN_START_PAUSED |
+                      VIR_DOMAIN_START_AUTODESTROY |
+                      VIR_DOMAIN_START_BYPASS_CACHE |
+                      VIR_DOMAIN_START_FORCE_BOOT |
+                      VIR_DOMAIN_START_VALIDATE, -1);
+        func = start;
+        break;
+    case VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN:
+        virCheckFlags(VIR_DOMAIN_SHUTDOWN_ACPI_POWER_BTN |
+                      VIR_DOMAIN_SHUTDOWN_GUEST_AGENT |
+                      VIR_DOMAIN_SHUTDOWN_INITCTL |
+                      VIR_DOMAIN_SHUTDOWN_SIGNAL |
+                      VIR_DOMAIN_SHUTDOWN_PARAVIRT, -1);
+        func = shutdown;
+        break;
+    case VIR_DOMAIN_LIST_LIFECYCLE_DESTROY:
+        virCheckFlags(VIR_DOMAIN_DESTROY_GRACEFUL, -1);
+        func = destroy;
+        break;
+    case VIR_DOMAIN_LIST_LIFECYCLE_LAST:
+        break;
+    }
+
+    if (!func) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("unknown lifecycle action %d"), action);
+        return -1;
+    }
+
+    if (VIR_ALLOC_N(errs, ndoms) < 0)
+        return -1;
+
+    for (i = 0; i < ndoms; i++) {
+        virDomainObjPtr vm;
+        int rc;
+
+        if (!(vm = virDomainObjListFindByUUID(domlist, doms[i]->uuid))) {
+            errs[i] = VIR_ERR_NO_DOMAIN;
+            continue;
+        }
+
+        rc = ensureACL ? ensureACL(conn, vm->def, action) : 0;
+        virDomainObjEndAPI(&vm);
+
+        /* the driver's entry point looks the domain up again, it may
+         * have gone meanwhile, which is reported as any other failure */
+        if (rc < 0 || func(doms[i], flags) < 0)
+            errs[i] = virDomainObjListLifecycleError();
+        else
+            nok++;
+    }
+
+    if (errors)
+        VIR_STEAL_PTR(*errors, errs);
+    VIR_FREE(errs);
+    return nok;
+}
+
+
 int
 virDomainObjListExport(virDomainObjListPtr domlist,
                        virConnectPtr conn,
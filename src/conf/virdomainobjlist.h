@@ -149,5 +149,29 @@ int virDomainObjListConvert(virDomainObjListPtr domlist,
                             virDomainObjListACLFilter filter,
                             unsigned int flags,
                             bool skip_missing);
+int virDomainObjListLookupUUIDs(virDomainObjListPtr domlist,
+                                virConnectPtr conn,
+                                const unsigned char *uuids,
+                                size_t nuuids,
+                                virDomainPtr **domains,
+                                int **states,
+                                virDomainObjListACLFilter filter);
+
+typedef int (*virDomainObjListLifecycleFunc)(virDomainPtr dom,
+                                             unsigned int flags);
+typedef int (*virDomainObjListLifecycleACL)(virConnectPtr conn,
+                                            virDomainDefPtr def,
+                                            unsigned int action);
+int virDomainObjListLifecycle(virDomainObjListPtr domlist,
+                              virConnectPtr conn,
+                              virDomainPtr *doms,
+                              size_t ndoms,
+                              int action,
+                              int **errors,
+                              unsigned int flags,
+                              virDomainObjListLifecycleACL ensureACL,
+                              virDomainObjListLifecycleFunc start,
+                              virDomainObjListLifecycleFunc shutdown,
+                              virDomainObjListLifecycleFunc destroy);
 
 #endif /* LIBVIRT_VIRDOMAINOBJLIST_H */
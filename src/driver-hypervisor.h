@@ -1255,6 +1255,40 @@ typedef int
                                   virDomainStatsRecordPtr **retStats,
                                   unsigned int flags);
 
+typedef int
+(*virDrvConnectLookupDomainsByUUID)(virConnectPtr conn,
+                                    const unsigned char *uuids,
+                                    unsigned int nuuids,
+                                    virDomainPtr **domains,
+                                    int **states,
+                                    unsigned int flags);
+
+typedef int
+(*virDrvDomainListLifecycle)(virConnectPtr conn,
+                             virDomainPtr *doms,
+                             unsigned int ndoms,
+                             int action,
+                             int **errors,
+                             unsigned int flags);
+
+typedef int
+(*virDrvDomainLookupByUUIDAsync)(virConnectPtr conn,
+                                 const unsigned char *uuid,
+                                 virDomainLookupCallback cb,
+                                 void *opaque,
+                                 virFreeCallback freecb,
+                                 unsigned int flags);
+
+typedef int
+(*virDrvConnectGetAllDomainStatsAsync)(virConnectPtr conn,
+                                       virDomainPtr *doms,
+                                       unsigned int ndoms,
+                                       unsigned int stats,
+                                       unsigned int flags,
+                                       virDomainStatsCallback cb,
+                                       void *opaque,
+                                       virFreeCallback freecb);
+
 typedef int
 (*virDrvNodeAllocPages)(virConnectPtr conn,
                         unsigned int npages,
@@ -1580,6 +1614,10 @@ struct _virHypervisorDriver {
     virDrvConnectBaselineHypervisorCPU connectBaselineHypervisorCPU;
     virDrvNodeGetSEVInfo nodeGetSEVInfo;
     virDrvDomainGetLaunchSecurityInfo domainGetLaunchSecurityInfo;
+    virDrvConnectLookupDomainsByUUID connectLookupDomainsByUUID;
+    virDrvDomainListLifecycle domainListLifecycle;
+    virDrvDomainLookupByUUIDAsync domainLookupByUUIDAsync;
+    virDrvConnectGetAllDomainStatsAsync connectGetAllDomainStatsAsync;
 };
 
 
@@ -393,6 +393,122 @@ virDomainLookupByUUIDString(virConnectPtr conn, const char *uuidstr)
 }
 
 
+/**
+ * virConnectLookupDomainsByUUID:
+ * @conn: pointer to the hypervisor connection
+ * @uuids: @nuuids raw UUIDs, each VIR_UUID_BUFLEN bytes long, stored
+ *         back to back
+ * @nuuids: number of UUIDs in @uuids
+ * @domains: pointer that will be filled with an array of @nuuids domains
+ * @states: optional pointer that will be filled with an array of @nuuids
+ *          domain states
+ * @flags: extra flags; not used yet, so callers should always pass 0
+ *
+ * Look up several domains at once.  This is equivalent to calling
+ * virDomainLookupByUUID() and virDomainGetState() for each UUID in
+ * @uuids, but costs a single round trip to the hypervisor.
+ *
+ * The i-th entry of @domains corresponds to the i-th UUID in @uuids and
+ * is NULL if no such domain exists (or the caller is not allowed to
+ * see it).  If @states is not NULL, its i-th entry is filled with the
+ * virDomainState of the i-th domain, or VIR_DOMAIN_NOSTATE for domains
+ * which were not found.
+ *
+ * The caller must call virDomainFree() on each non-NULL entry of
+ * @domains and then free() both arrays.
+ *
+ * Returns the number of domains found on success, -1 on error.
+ */
+int
+virConnectLookupDomainsByUUID(virConnectPtr conn,
+                              const unsigned char *uuids,
+                              unsigned int nuuids,
+                              virDomainPtr **domains,
+                              int **states,
+                              unsigned int flags)
+{
+    VIR_DEBUG("conn=%p, uuids=%p, nuuids=%u, domains=%p, states=%p, flags=0x%x",
+              conn, uuids, nuuids, domains, states, flags);
+
+    virResetLastError();
+
+    virCheckConnectReturn(conn, -1);
+    virCheckNonNullArgGoto(uuids, error);
+    virCheckPositiveArgGoto(nuuids, error);
+    virCheckNonNullArgGoto(domains, error);
+
+    if (conn->driver->connectLookupDomainsByUUID) {
+        int ret;
+        ret = conn->driver->connectLookupDomainsByUUID(conn, uuids, nuuids,
+                                                       domains, states, flags);
+        if (ret < 0)
+            goto error;
+        return ret;
+    }
+
+    virReportUnsupportedError();
+
+ error:
+    virDispatchError(conn);
+    return -1;
+}
+
+
+/**
+ * virDomainLookupByUUIDAsync:
+ * @conn: pointer to the hypervisor connection
+ * @uuid: the raw UUID for the domain
+ * @cb: callback receiving the result
+ * @opaque: opaque data to pass to @cb
+ * @freecb: optional function to deallocate @opaque
+ * @flags: extra flags; not used yet, so callers should always pass 0
+ *
+ * Start looking up a domain like virDomainLookupByUUID() does, but
+ * return without waiting for the result. @cb is called with the
+ * result from the thread running the event loop, then @freecb is
+ * called on @opaque.
+ *
+ * This requires an event loop implementation to be registered with
+ * virEventRegisterImpl() or virEventRegisterDefaultImpl() before the
+ * connection is opened, and to be run.
+ *
+ * Returns 0 if the lookup was started, in which case @cb will be called
+ * exactly once, -1 on error, in which case neither @cb nor @freecb
+ * will be called.
+ */
+int
+virDomainLookupByUUIDAsync(virConnectPtr conn,
+                           const unsigned char *uuid,
+                           virDomainLookupCallback cb,
+                           void *opaque,
+                           virFreeCallback freecb,
+                           unsigned int flags)
+{
+    VIR_UUID_DEBUG(conn, uuid);
+    VIR_DEBUG("cb=%p, opaque=%p, freecb=%p, flags=0x%x",
+              cb, opaque, freecb, flags);
+
+    virResetLastError();
+
+    virCheckConnectReturn(conn, -1);
+    virCheckNonNullArgGoto(uuid, error);
+    virCheckNonNullArgGoto(cb, error);
+
+    if (conn->driver->domainLookupByUUIDAsync) {
+        if (conn->driver->domainLookupByUUIDAsync(conn, uuid, cb, opaque,
+                                                  freecb, flags) < 0)
+            goto error;
+        return 0;
+    }
+
+    virReportUnsupportedError();
+
+ error:
+    virDispatchError(conn);
+    return -1;
+}
+
+
 /**
  * virDomainLookupByName:
  * @conn: pointer to the hypervisor connection
@@ -11612,6 +11728,11 @@ virConnectGetDomainCapabilities(virConnectPtr conn,
  *                      will use it's iothread_id value as the <id>. There
  *                      may be fewer <id> entries than the iothread.cnt
  *                      value if the polling values are not supported.
+ *     "iothread.<id>.time" - CPU time spent by the IOThread in ns as an
+ *                            unsigned long long.
+ *     "iothread.<id>.wait" - time the IOThread spent waiting for a host CPU
+ *                            in ns as an unsigned long long. A 0 (zero)
+ *                            means the host does not account for it.
  *     "iothread.<id>.poll-max-ns" - maximum polling time in ns as an unsigned
  *                                   long long. A 0 (zero) means polling is
  *                                   disabled.
@@ -11805,6 +11926,230 @@ virDomainListGetStats(virDomainPtr *doms,
 }
 
 
+/**
+ * virConnectGetAllDomainStatsAsync:
+ * @conn: pointer to the hypervisor connection
+ * @stats: stats to return, binary-OR of virDomainStatsTypes
+ * @flags: extra flags; binary-OR of virConnectGetAllDomainStatsFlags
+ * @cb: callback receiving the result
+ * @opaque: opaque data to pass to @cb
+ * @freecb: optional function to deallocate @opaque
+ *
+ * Start querying statistics like virConnectGetAllDomainStats() does,
+ * but return without waiting for the result. @cb is called with the
+ * statistics from the thread running the event loop, then @freecb is
+ * called on @opaque. Many queries can be in flight at once without
+ * tying up a thread each.
+ *
+ * This requires an event loop implementation to be registered with
+ * virEventRegisterImpl() or virEventRegisterDefaultImpl() before the
+ * connection is opened, and to be run.
+ *
+ * Returns 0 if the query was started, in which case @cb will be called
+ * exactly once, -1 on error, in which case neither @cb nor @freecb
+ * will be called.
+ */
+int
+virConnectGetAllDomainStatsAsync(virConnectPtr conn,
+                                 unsigned int stats,
+                                 unsigned int flags,
+                                 virDomainStatsCallback cb,
+                                 void *opaque,
+                                 virFreeCallback freecb)
+{
+    VIR_DEBUG("conn=%p, stats=0x%x, flags=0x%x, cb=%p, opaque=%p",
+              conn, stats, flags, cb, opaque);
+
+    virResetLastError();
+
+    virCheckConnectReturn(conn, -1);
+    virCheckNonNullArgGoto(cb, error);
+
+    if (!conn->driver->connectGetAllDomainStatsAsync) {
+        virReportUnsupportedError();
+        goto error;
+    }
+
+    if (conn->driver->connectGetAllDomainStatsAsync(conn, NULL, 0, stats, flags,
+                                                    cb, opaque, freecb) < 0)
+        goto error;
+
+    return 0;
+
+ error:
+    virDispatchError(conn);
+    return -1;
+}
+
+
+/**
+ * virDomainListGetStatsAsync:
+ * @doms: NULL terminated array of domains
+ * @stats: stats to return, binary-OR of virDomainStatsTypes
+ * @flags: extra flags; binary-OR of virConnectGetAllDomainStatsFlags
+ * @cb: callback receiving the result
+ * @opaque: opaque data to pass to @cb
+ * @freecb: optional function to deallocate @opaque
+ *
+ * Start querying statistics for the domains in @doms like
+ * virDomainListGetStats() does, but return without waiting for the
+ * result. See virConnectGetAllDomainStatsAsync() for how the result
+ * is delivered.
+ *
+ * Returns 0 if the query was started, in which case @cb will be called
+ * exactly once, -1 on error, in which case neither @cb nor @freecb
+ * will be called.
+ */
+int
+virDomainListGetStatsAsync(virDomainPtr *doms,
+                           unsigned int stats,
+                           unsigned int flags,
+                           virDomainStatsCallback cb,
+                           void *opaque,
+                           virFreeCallback freecb)
+{
+    virConnectPtr conn = NULL;
+    virDomainPtr *nextdom = doms;
+    unsigned int ndoms = 0;
+    int ret = -1;
+
+    VIR_DEBUG("doms=%p, stats=0x%x, flags=0x%x, cb=%p, opaque=%p",
+              doms, stats, flags, cb, opaque);
+
+    virResetLastError();
+
+    virCheckNonNullArgGoto(doms, cleanup);
+    virCheckNonNullArgGoto(cb, cleanup);
+
+    if (!*doms) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("doms array in %s must contain at least one domain"),
+                       __FUNCTION__);
+        goto cleanup;
+    }
+
+    conn = doms[0]->conn;
+    virCheckConnectReturn(conn, -1);
+
+    if (!conn->driver->connectGetAllDomainStatsAsync) {
+        virReportUnsupportedError();
+        goto cleanup;
+    }
+
+    while (*nextdom) {
+        virDomainPtr dom = *nextdom;
+
+        virCheckDomainGoto(dom, cleanup);
+
+        if (dom->conn != conn) {
+            virReportError(VIR_ERR_INVALID_ARG, "%s",
+                           _("domains in 'doms' array must belong to a "
+                             "single connection"));
+            goto cleanup;
+        }
+
+        ndoms++;
+        nextdom++;
+    }
+
+    ret = conn->driver->connectGetAllDomainStatsAsync(conn, doms, ndoms,
+                                                      stats, flags,
+                                                      cb, opaque, freecb);
+
+ cleanup:
+    if (ret < 0)
+        virDispatchError(conn);
+    return ret;
+}
+
+
+/**
+ * virDomainListLifecycle:
+ * @doms: NULL terminated array of domains
+ * @action: action to perform, one of virDomainListLifecycleAction
+ * @errors: optional pointer that will be filled with an array of
+ *          per-domain error codes
+ * @flags: bitwise-OR of virDomainCreateFlags, virDomainShutdownFlagValues
+ *         or virDomainDestroyFlagsValues, matching @action
+ *
+ * Start, shut down or destroy all domains in @doms.  Note that all
+ * domains in @doms must share the same connection.  For each domain,
+ * this behaves like virDomainCreateWithFlags(), virDomainShutdownFlags()
+ * or virDomainDestroyFlags() (depending on @action) called with @flags,
+ * but the whole list costs a single round trip to the hypervisor.
+ * Flags which don't belong to @action fail the whole request.  Each
+ * domain needs the permission its single-domain API needs.
+ *
+ * A failure to act on one domain does not stop the action on the rest
+ * of the list.  If @errors is not NULL, it is filled with an array of
+ * as many entries as there are domains in @doms; an entry is VIR_ERR_OK
+ * if the action succeeded on the corresponding domain, otherwise it is
+ * the virErrorNumber the action failed with.  The caller must free()
+ * the array.
+ *
+ * Returns the number of domains the action succeeded on, or -1 if the
+ * request as a whole failed.
+ */
+int
+virDomainListLifecycle(virDomainPtr *doms,
+                       int action,
+                       int **errors,
+                       unsigned int flags)
+{
+    virConnectPtr conn = NULL;
+    virDomainPtr *nextdom = doms;
+    unsigned int ndoms = 0;
+    int ret = -1;
+
+    VIR_DEBUG("doms=%p, action=%d, errors=%p, flags=0x%x",
+              doms, action, errors, flags);
+
+    virResetLastError();
+
+    virCheckNonNullArgGoto(doms, cleanup);
+
+    if (!*doms) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("doms array in %s must contain at least one domain"),
+                       __FUNCTION__);
+        goto cleanup;
+    }
+
+    conn = doms[0]->conn;
+    virCheckConnectReturn(conn, -1);
+    virCheckReadOnlyGoto(conn->flags, cleanup);
+
+    if (!conn->driver->domainListLifecycle) {
+        virReportUnsupportedError();
+        goto cleanup;
+    }
+
+    while (*nextdom) {
+        virDomainPtr dom = *nextdom;
+
+        virCheckDomainGoto(dom, cleanup);
+
+        if (dom->conn != conn) {
+            virReportError(VIR_ERR_INVALID_ARG, "%s",
+                           _("domains in 'doms' array must belong to a "
+                             "single connection"));
+            goto cleanup;
+        }
+
+        ndoms++;
+        nextdom++;
+    }
+
+    ret = conn->driver->domainListLifecycle(conn, doms, ndoms,
+                                            action, errors, flags);
+
+ cleanup:
+    if (ret < 0)
+        virDispatchError(conn);
+    return ret;
+}
+
+
 /**
  * virDomainStatsRecordListFree:
  * @stats: NULL terminated array of virDomainStatsRecords to free
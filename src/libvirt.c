@@ -954,7 +954,11 @@ virConnectOpenInternal(const char *name,
     }
 
     /* Cleansing flags */
-    ret->flags = flags & VIR_CONNECT_RO;
+    ret->flags = flags & (VIR_CONNECT_RO | VIR_CONNECT_COALESCE_EVENTS);
+
+    /* Events are coalesced by the event code based on ret->flags,
+     * drivers don't need to know about it */
+    flags &= ~VIR_CONNECT_COALESCE_EVENTS;
 
     for (i = 0; i < virConnectDriverTabCount; i++) {
         /* We're going to probe the remote driver next. So we have already
@@ -1177,6 +1181,14 @@ virConnectOpenReadOnly(const char *name)
  * See virConnectOpen for notes about environment variables which can
  * have an effect on opening drivers and freeing the connection resources
  *
+ * If @flags contains VIR_CONNECT_COALESCE_EVENTS, an event which is
+ * superseded by a later event of the same type for the same object
+ * before it could be delivered is not delivered to the event callbacks
+ * registered on the connection. This only applies to events which
+ * describe the complete current state of an object, such as balloon
+ * change or storage pool refresh events, and saves applications
+ * interested only in the latest state from processing bursts of them.
+ *
  * URIs are documented at https://libvirt.org/uri.html
  *
  * Returns a pointer to the hypervisor connection or NULL in case of error
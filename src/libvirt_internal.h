@@ -123,6 +123,11 @@ typedef enum {
      * Support for driver close callback rpc
      */
     VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK = 15,
+
+    /*
+     * Support for passing large replies through a shared memory ring
+     */
+    VIR_DRV_FEATURE_REMOTE_SHARED_RING = 16,
 } virDrvFeature;
 
 
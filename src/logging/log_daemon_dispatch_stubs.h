@@ -1,4 +1,4 @@
-/* Automatically generated from ./logging/log_protocol.x by gendispatch.pl.
+/* Automatically generated from /root/repo/src/logging/log_protocol.x by gendispatch.pl.
  * Do not edit this file.  Any changes you make will be lost.
  */
 static int virLogManagerProtocolDispatchDomainAppendLogFile(
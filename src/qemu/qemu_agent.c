@@ -103,6 +103,9 @@ struct _qemuAgent {
     int fd;
     int watch;
 
+    /* Event loop watching @fd, the main one if NULL */
+    virEventThreadPtr eventThread;
+
     bool running;
 
     virDomainObjPtr vm;
@@ -172,6 +175,7 @@ static void qemuAgentDispose(void *obj)
         (mon->cb->destroy)(mon, mon->vm);
     virCondDestroy(&mon->notify);
     VIR_FREE(mon->buffer);
+    virObjectUnref(mon->eventThread);
     virResetError(&mon->lastError);
 }
 
@@ -538,7 +542,10 @@ static void qemuAgentUpdateWatch(qemuAgentPtr mon)
             events |= VIR_EVENT_HANDLE_WRITABLE;
     }
 
-    virEventUpdateHandle(mon->watch, events);
+    if (mon->eventThread)
+        virEventThreadUpdateHandle(mon->eventThread, mon->watch, events);
+    else
+        virEventUpdateHandle(mon->watch, events);
 }
 
 
@@ -679,9 +686,13 @@ qemuAgentIO(int watch, int fd, int events, void *opaque)
 qemuAgentPtr
 qemuAgentOpen(virDomainObjPtr vm,
               const virDomainChrSourceDef *config,
+              virEventThreadPtr eventThread,
               qemuAgentCallbacksPtr cb)
 {
     qemuAgentPtr mon;
+    int events = VIR_EVENT_HANDLE_HANGUP |
+                 VIR_EVENT_HANDLE_ERROR |
+                 VIR_EVENT_HANDLE_READABLE;
 
     if (!cb || !cb->eofNotify) {
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
@@ -703,6 +714,7 @@ qemuAgentOpen(virDomainObjPtr vm,
         return NULL;
     }
     mon->vm = vm;
+    mon->eventThread = virObjectRef(eventThread);
     mon->cb = cb;
 
     switch (config->type) {
@@ -725,13 +737,16 @@ qemuAgentOpen(virDomainObjPtr vm,
         goto cleanup;
 
     virObjectRef(mon);
-    if ((mon->watch = virEventAddHandle(mon->fd,
-                                        VIR_EVENT_HANDLE_HANGUP |
-                                        VIR_EVENT_HANDLE_ERROR |
-                                        VIR_EVENT_HANDLE_READABLE,
-                                        qemuAgentIO,
-                                        mon,
-                                        virObjectFreeCallback)) < 0) {
+    if (mon->eventThread)
+        mon->watch = virEventThreadAddHandle(mon->eventThread, mon->fd, events,
+                                             qemuAgentIO, mon,
+                                             virObjectFreeCallback);
+    else
+        mon->watch = virEventAddHandle(mon->fd, events,
+                                       qemuAgentIO, mon,
+                                       virObjectFreeCallback);
+
+    if (mon->watch < 0) {
         virObjectUnref(mon);
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
                        _("unable to register monitor events"));
@@ -796,7 +811,10 @@ void qemuAgentClose(qemuAgentPtr mon)
 
     if (mon->fd >= 0) {
         if (mon->watch) {
-            virEventRemoveHandle(mon->watch);
+            if (mon->eventThread)
+                virEventThreadRemoveHandle(mon->eventThread, mon->watch);
+            else
+                virEventRemoveHandle(mon->watch);
             mon->watch = 0;
         }
         VIR_FORCE_CLOSE(mon->fd);
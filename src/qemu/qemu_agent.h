@@ -24,6 +24,7 @@
 
 # include "internal.h"
 # include "domain_conf.h"
+# include "vireventthread.h"
 
 typedef struct _qemuAgent qemuAgent;
 typedef qemuAgent *qemuAgentPtr;
@@ -42,6 +43,7 @@ struct _qemuAgentCallbacks {
 
 qemuAgentPtr qemuAgentOpen(virDomainObjPtr vm,
                            const virDomainChrSourceDef *config,
+                           virEventThreadPtr eventThread,
                            qemuAgentCallbacksPtr cb);
 
 void qemuAgentClose(qemuAgentPtr mon);
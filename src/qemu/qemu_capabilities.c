@@ -30,6 +30,8 @@
 #include "virfilecache.h"
 #include "virpidfile.h"
 #include "virprocess.h"
+#include "virtime.h"
+#include "viratomic.h"
 #include "cpu/cpu.h"
 #include "cpu/cpu_x86.h"
 #include "domain_conf.h"
@@ -57,6 +59,10 @@
 
 VIR_LOG_INIT("qemu.qemu_capabilities");
 
+/* How long, in milliseconds, a successfully validated cache entry is
+ * trusted without checking the binary and host again */
+#define QEMU_CAPS_VALIDATE_INTERVAL 1000
+
 /* While not public, these strings must not change. They
  * are used in domain status files which are read on
  * daemon restarts
@@ -547,6 +553,9 @@ struct _virQEMUCapsHostCPUData {
      * combined with features reported by QEMU. This is used for backward
      * compatible comparison between a guest CPU and a host CPU. */
     virCPUDefPtr full;
+    /* The definitions above have not been computed yet, which is deferred
+     * until they are first needed when loading the cache. */
+    bool pending;
 };
 
 /*
@@ -590,8 +599,15 @@ struct _virQEMUCaps {
 
     virSEVCapability *sevCapabilities;
 
+    /* Protects kvmCPU and tcgCPU while their pending definitions are
+     * being computed */
+    virMutex hostCPULock;
+    virArch hostArch;
     virQEMUCapsHostCPUData kvmCPU;
     virQEMUCapsHostCPUData tcgCPU;
+
+    /* When the checks in virQEMUCapsIsValid last succeeded */
+    unsigned long long lastValidated;
 };
 
 struct virQEMUCapsSearchData {
@@ -602,6 +618,8 @@ struct virQEMUCapsSearchData {
 
 static virClassPtr virQEMUCapsClass;
 static void virQEMUCapsDispose(void *obj);
+static void virQEMUCapsResolveHostCPUModel(virQEMUCapsPtr qemuCaps,
+                                           virDomainVirtType type);
 
 static int virQEMUCapsOnceInit(void)
 {
@@ -755,27 +773,38 @@ virQEMUCapsFindBinaryForArch(virArch hostarch,
 }
 
 static int
-virQEMUCapsInitGuest(virCapsPtr caps,
-                     virFileCachePtr cache,
-                     virArch hostarch,
-                     virArch guestarch)
+virQEMUCapsFindGuestBinary(virArch hostarch,
+                           virArch guestarch,
+                           char **binary)
 {
-    char *binary = NULL;
-    virQEMUCapsPtr qemuCaps = NULL;
-    int ret = -1;
-
     /* Check for existence of base emulator, or alternate base
      * which can be used with magic cpu choice
      */
-    binary = virQEMUCapsFindBinaryForArch(hostarch, guestarch);
+    *binary = virQEMUCapsFindBinaryForArch(hostarch, guestarch);
 
     /* RHEL doesn't follow the usual naming for QEMU binaries and ships
      * a single binary named qemu-kvm outside of $PATH instead */
-    if (virQEMUCapsGuestIsNative(hostarch, guestarch) && !binary) {
-        if (VIR_STRDUP(binary, "/usr/libexec/qemu-kvm") < 0)
+    if (virQEMUCapsGuestIsNative(hostarch, guestarch) && !*binary) {
+        if (VIR_STRDUP(*binary, "/usr/libexec/qemu-kvm") < 0)
             return -1;
     }
 
+    return 0;
+}
+
+static int
+virQEMUCapsInitGuest(virCapsPtr caps,
+                     virFileCachePtr cache,
+                     virArch hostarch,
+                     virArch guestarch)
+{
+    char *binary = NULL;
+    virQEMUCapsPtr qemuCaps = NULL;
+    int ret = -1;
+
+    if (virQEMUCapsFindGuestBinary(hostarch, guestarch, &binary) < 0)
+        return -1;
+
     /* Ignore binary if extracting version info fails */
     if (binary) {
         if (!(qemuCaps = virQEMUCapsCacheLookup(cache, binary))) {
@@ -895,6 +924,88 @@ virQEMUCapsProbeHostCPUForEmulator(virArch hostArch,
 }
 
 
+typedef struct _virQEMUCapsPrefetchData virQEMUCapsPrefetchData;
+typedef virQEMUCapsPrefetchData *virQEMUCapsPrefetchDataPtr;
+struct _virQEMUCapsPrefetchData {
+    virFileCachePtr cache;
+    const char *binary;
+    virThread thread;
+    bool started;
+};
+
+
+static void
+virQEMUCapsPrefetchThread(void *opaque)
+{
+    virQEMUCapsPrefetchDataPtr data = opaque;
+
+    /* Failures are reported again by the lookup done afterwards */
+    virObjectUnref(virQEMUCapsCacheLookup(data->cache, data->binary));
+    virResetLastError();
+}
+
+
+/*
+ * Looks up the capabilities of all QEMU binaries found on the host, each
+ * from a separate thread, so that those which need to be probed are probed
+ * in parallel rather than one after another.
+ */
+static int
+virQEMUCapsPrefetch(virFileCachePtr cache,
+                    virArch hostarch)
+{
+    char **binaries = NULL;
+    size_t nbinaries;
+    virQEMUCapsPrefetchDataPtr data = NULL;
+    size_t i;
+    int ret = -1;
+
+    for (i = 0; i < VIR_ARCH_LAST; i++) {
+        VIR_AUTOFREE(char *) binary = NULL;
+
+        if (virQEMUCapsFindGuestBinary(hostarch, i, &binary) < 0)
+            goto cleanup;
+
+        if (binary &&
+            !virStringListHasString((const char **)binaries, binary) &&
+            virStringListAdd(&binaries, binary) < 0)
+            goto cleanup;
+    }
+
+    nbinaries = virStringListLength((const char **)binaries);
+    if (nbinaries < 2) {
+        ret = 0;
+        goto cleanup;
+    }
+
+    if (VIR_ALLOC_N(data, nbinaries) < 0)
+        goto cleanup;
+
+    for (i = 0; i < nbinaries; i++) {
+        data[i].cache = cache;
+        data[i].binary = binaries[i];
+        if (virThreadCreate(&data[i].thread, true,
+                            virQEMUCapsPrefetchThread, &data[i]) < 0) {
+            VIR_WARN("Failed to create thread probing %s", binaries[i]);
+            continue;
+        }
+        data[i].started = true;
+    }
+
+    for (i = 0; i < nbinaries; i++) {
+        if (data[i].started)
+            virThreadJoin(&data[i].thread);
+    }
+
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(data);
+    virStringListFree(binaries);
+    return ret;
+}
+
+
 virCapsPtr
 virQEMUCapsInit(virFileCachePtr cache)
 {
@@ -936,6 +1047,9 @@ virQEMUCapsInit(virFileCachePtr cache)
     virCapabilitiesAddHostMigrateTransport(caps, "tcp");
     virCapabilitiesAddHostMigrateTransport(caps, "rdma");
 
+    if (virQEMUCapsPrefetch(cache, hostarch) < 0)
+        goto error;
+
     /* QEMU can support pretty much every arch that exists,
      * so just probe for them all - we gracefully fail
      * if a qemu-system-$ARCH binary can't be found
@@ -1470,6 +1584,13 @@ virQEMUCapsNew(void)
     if (!(qemuCaps = virObjectNew(virQEMUCapsClass)))
         return NULL;
 
+    if (virMutexInit(&qemuCaps->hostCPULock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("cannot initialize mutex"));
+        virObjectUnref(qemuCaps);
+        return NULL;
+    }
+
     if (!(qemuCaps->flags = virBitmapNew(QEMU_CAPS_LAST)))
         goto error;
 
@@ -1578,6 +1699,13 @@ virQEMUCapsPtr virQEMUCapsNewCopy(virQEMUCapsPtr qemuCaps)
             goto error;
     }
 
+    /* Copies are made for every domain start, compute the host CPU
+     * models once in the original rather than in each copy */
+    virMutexLock(&qemuCaps->hostCPULock);
+    virQEMUCapsResolveHostCPUModel(qemuCaps, VIR_DOMAIN_VIRT_KVM);
+    virQEMUCapsResolveHostCPUModel(qemuCaps, VIR_DOMAIN_VIRT_QEMU);
+    virMutexUnlock(&qemuCaps->hostCPULock);
+
     if (virQEMUCapsHostCPUDataCopy(&ret->kvmCPU, &qemuCaps->kvmCPU) < 0 ||
         virQEMUCapsHostCPUDataCopy(&ret->tcgCPU, &qemuCaps->tcgCPU) < 0)
         goto error;
@@ -1640,6 +1768,8 @@ void virQEMUCapsDispose(void *obj)
 
     virQEMUCapsHostCPUDataClear(&qemuCaps->kvmCPU);
     virQEMUCapsHostCPUDataClear(&qemuCaps->tcgCPU);
+
+    virMutexDestroy(&qemuCaps->hostCPULock);
 }
 
 void
@@ -1842,6 +1972,24 @@ virQEMUCapsGetHostCPUData(virQEMUCapsPtr qemuCaps,
 }
 
 
+/*
+ * Computes the host CPU model definitions of @type for a capabilities
+ * object loaded from the cache, if that was not done yet. Must be called
+ * with hostCPULock held.
+ */
+static void
+virQEMUCapsResolveHostCPUModel(virQEMUCapsPtr qemuCaps,
+                               virDomainVirtType type)
+{
+    if (!virQEMUCapsGetHostCPUData(qemuCaps, type)->pending)
+        return;
+
+    VIR_DEBUG("Computing %s host CPU model for '%s'",
+              virDomainVirtTypeToString(type), NULLSTR(qemuCaps->binary));
+    virQEMUCapsInitHostCPUModel(qemuCaps, qemuCaps->hostArch, type);
+}
+
+
 virCPUDefPtr
 virQEMUCapsGetHostModel(virQEMUCapsPtr qemuCaps,
                         virDomainVirtType type,
@@ -1849,6 +1997,10 @@ virQEMUCapsGetHostModel(virQEMUCapsPtr qemuCaps,
 {
     virQEMUCapsHostCPUDataPtr cpuData = virQEMUCapsGetHostCPUData(qemuCaps, type);
 
+    virMutexLock(&qemuCaps->hostCPULock);
+    virQEMUCapsResolveHostCPUModel(qemuCaps, type);
+    virMutexUnlock(&qemuCaps->hostCPULock);
+
     switch (cpuType) {
     case VIR_QEMU_CAPS_HOST_CPU_REPORTED:
         return cpuData->reported;
@@ -2957,6 +3109,8 @@ virQEMUCapsInitHostCPUModel(virQEMUCapsPtr qemuCaps,
     size_t i;
     int rc;
 
+    virQEMUCapsGetHostCPUData(qemuCaps, type)->pending = false;
+
     if (!virQEMUCapsGuestIsNative(hostArch, qemuCaps->arch))
         return;
 
@@ -3280,6 +3434,7 @@ struct _virQEMUCapsCachePriv {
     char *kernelVersion;
 
     /* cache whether /dev/kvm is usable as runUid:runGuid */
+    virMutex kvmLock;
     virTristateBool kvmUsable;
     time_t kvmCtime;
 };
@@ -3294,6 +3449,7 @@ virQEMUCapsCachePrivFree(void *privData)
 
     VIR_FREE(priv->libDir);
     VIR_FREE(priv->kernelVersion);
+    virMutexDestroy(&priv->kvmLock);
     VIR_FREE(priv);
 }
 
@@ -3606,8 +3762,12 @@ virQEMUCapsLoadCache(virArch hostArch,
     if (virQEMUCapsParseSEVInfo(qemuCaps, ctxt) < 0)
         goto cleanup;
 
-    virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_KVM);
-    virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_QEMU);
+    /* Computing the host CPU models is the most expensive part of loading
+     * the cache and many users never look at them, so wait until they are
+     * asked for */
+    qemuCaps->hostArch = hostArch;
+    qemuCaps->kvmCPU.pending = true;
+    qemuCaps->tcgCPU.pending = true;
 
     if (virXPathBoolean("boolean(./kvmSupportsNesting)", ctxt) > 0)
         qemuCaps->kvmSupportsNesting = true;
@@ -3916,9 +4076,15 @@ virQEMUCapsKVMUsable(virQEMUCapsCachePrivPtr priv)
     struct stat sb;
     static const char *kvm_device = "/dev/kvm";
     virTristateBool value;
-    virTristateBool cached_value = priv->kvmUsable;
+    virTristateBool cached_value;
     time_t kvm_ctime;
-    time_t cached_kvm_ctime = priv->kvmCtime;
+    time_t cached_kvm_ctime;
+
+    /* Capabilities of several binaries may be validated at once */
+    virMutexLock(&priv->kvmLock);
+    cached_value = priv->kvmUsable;
+    cached_kvm_ctime = priv->kvmCtime;
+    virMutexUnlock(&priv->kvmLock);
 
     if (stat(kvm_device, &sb) < 0) {
         if (errno != ENOENT) {
@@ -3950,8 +4116,10 @@ virQEMUCapsKVMUsable(virQEMUCapsCachePrivPtr priv)
      * detecting changes *after* the virFileAccessibleAs check, we can
      * neglect this here.
      */
+    virMutexLock(&priv->kvmLock);
     priv->kvmCtime = kvm_ctime;
     priv->kvmUsable = value;
+    virMutexUnlock(&priv->kvmLock);
 
     return value == VIR_TRISTATE_BOOL_YES;
 }
@@ -3966,6 +4134,7 @@ virQEMUCapsIsValid(void *data,
     bool kvmUsable;
     struct stat sb;
     bool kvmSupportsNesting;
+    unsigned long long now = 0;
 
     if (!qemuCaps->binary)
         return true;
@@ -3982,6 +4151,16 @@ virQEMUCapsIsValid(void *data,
         return false;
     }
 
+    /* Every lookup validates the capabilities, don't hit the filesystem
+     * again if we did so very recently. Data in the cache is validated
+     * only with the cache locked, so nothing else touches lastValidated
+     * meanwhile. */
+    if (virTimeMillisNowRaw(&now) == 0 &&
+        qemuCaps->lastValidated &&
+        now >= qemuCaps->lastValidated &&
+        now - qemuCaps->lastValidated < QEMU_CAPS_VALIDATE_INTERVAL)
+        return true;
+
     if (stat(qemuCaps->binary, &sb) < 0) {
         char ebuf[1024];
         VIR_DEBUG("Failed to stat QEMU binary '%s': %s",
@@ -4003,6 +4182,7 @@ virQEMUCapsIsValid(void *data,
                   "skipping KVM-related checks",
                   virArchToString(qemuCaps->arch),
                   virArchToString(priv->hostArch));
+        qemuCaps->lastValidated = now;
         return true;
     }
 
@@ -4052,6 +4232,7 @@ virQEMUCapsIsValid(void *data,
         }
     }
 
+    qemuCaps->lastValidated = now;
     return true;
 }
 
@@ -4437,11 +4618,16 @@ virQEMUCapsInitQMPCommandNew(char *binary,
                              gid_t runGid,
                              char **qmperr)
 {
+    static int lastProbe;
     virQEMUCapsInitQMPCommandPtr cmd = NULL;
+    int probe;
 
     if (VIR_ALLOC(cmd) < 0)
         goto error;
 
+    /* Several binaries may be probed at once */
+    probe = virAtomicIntInc(&lastProbe);
+
     if (VIR_STRDUP(cmd->binary, binary) < 0)
         goto error;
 
@@ -4452,8 +4638,8 @@ virQEMUCapsInitQMPCommandNew(char *binary,
     /* the ".sock" sufix is important to avoid a possible clash with a qemu
      * domain called "capabilities"
      */
-    if (virAsprintf(&cmd->monpath, "%s/%s", libDir,
-                    "capabilities.monitor.sock") < 0)
+    if (virAsprintf(&cmd->monpath, "%s/capabilities.%d.monitor.sock",
+                    libDir, probe) < 0)
         goto error;
     if (virAsprintf(&cmd->monarg, "unix:%s,server,nowait", cmd->monpath) < 0)
         goto error;
@@ -4464,7 +4650,8 @@ virQEMUCapsInitQMPCommandNew(char *binary,
      * -daemonize we need QEMU to be allowed to create them, rather
      * than libvirtd. So we're using libDir which QEMU can write to
      */
-    if (virAsprintf(&cmd->pidfile, "%s/%s", libDir, "capabilities.pidfile") < 0)
+    if (virAsprintf(&cmd->pidfile, "%s/capabilities.%d.pidfile",
+                    libDir, probe) < 0)
         goto error;
 
     virPidFileForceCleanupPath(cmd->pidfile);
@@ -4548,7 +4735,7 @@ virQEMUCapsInitQMPCommandRun(virQEMUCapsInitQMPCommandPtr cmd,
     cmd->vm->pid = cmd->pid;
 
     if (!(cmd->mon = qemuMonitorOpen(cmd->vm, &cmd->config, true, true,
-                                     0, &callbacks, NULL)))
+                                     0, NULL, &callbacks, NULL)))
         goto ignore;
 
     virObjectLock(cmd->mon);
@@ -4818,6 +5005,13 @@ virQEMUCapsCacheNew(const char *libDir,
 
     if (VIR_ALLOC(priv) < 0)
         goto error;
+
+    if (virMutexInit(&priv->kvmLock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("cannot initialize mutex"));
+        VIR_FREE(priv);
+        goto error;
+    }
     virFileCacheSetPriv(cache, priv);
 
     if (VIR_STRDUP(priv->libDir, libDir) < 0)
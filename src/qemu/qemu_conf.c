@@ -855,6 +855,16 @@ int virQEMUDriverConfigLoadFile(virQEMUDriverConfigPtr cfg,
     if (virConfGetValueUInt(conf, "max_queued", &cfg->maxQueuedJobs) < 0)
         goto cleanup;
 
+    if (virConfGetValueUInt(conf, "stats_workers", &cfg->statsWorkers) < 0)
+        goto cleanup;
+    if (virConfGetValueUInt(conf, "stats_domain_timeout",
+                            &cfg->statsDomainTimeout) < 0)
+        goto cleanup;
+
+    if (virConfGetValueUInt(conf, "monitor_io_threads",
+                            &cfg->monitorIOThreads) < 0)
+        goto cleanup;
+
     if (virConfGetValueInt(conf, "keepalive_interval", &cfg->keepAliveInterval) < 0)
         goto cleanup;
     if (virConfGetValueUInt(conf, "keepalive_count", &cfg->keepAliveCount) < 0)
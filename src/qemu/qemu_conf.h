@@ -39,8 +39,10 @@
 # include "cpu_conf.h"
 # include "driver.h"
 # include "virportallocator.h"
+# include "virprocstat.h"
 # include "vircommand.h"
 # include "virthreadpool.h"
+# include "vireventthread.h"
 # include "locking/lock_manager.h"
 # include "qemu_capabilities.h"
 # include "virclosecallbacks.h"
@@ -172,6 +174,11 @@ struct _virQEMUDriverConfig {
 
     unsigned int maxQueuedJobs;
 
+    unsigned int statsWorkers;
+    unsigned int statsDomainTimeout;
+
+    unsigned int monitorIOThreads;
+
     char **securityDriverNames;
     bool securityDefaultConfined;
     bool securityRequireConfined;
@@ -227,6 +234,15 @@ struct _virQEMUDriver {
     /* Immutable pointer, self-locking APIs */
     virThreadPoolPtr workerPool;
 
+    /* Immutable pointer, self-locking APIs. NULL if bulk stats
+     * are gathered serially */
+    virThreadPoolPtr statsPool;
+
+    /* Immutable pointers, self-locking APIs. Empty if monitors
+     * are watched in the main event loop */
+    virEventThreadPtr *monitorThreads;
+    size_t nmonitorThreads;
+
     /* Atomic increment only */
     int lastvmid;
 
@@ -291,6 +307,9 @@ struct _virQEMUDriver {
 
     /* Immutable pointer, self-locking APIs */
     virHashAtomicPtr migrationErrors;
+
+    /* Immutable pointer, self-locking APIs */
+    virProcStatCollectorPtr procStats;
 };
 
 typedef struct _qemuDomainCmdlineDef qemuDomainCmdlineDef;
@@ -2454,6 +2454,9 @@ qemuDomainObjPrivateXMLFormat(virBufferPtr buf,
     if (qemuDomainObjPrivateXMLFormatJob(buf, vm, priv) < 0)
         return -1;
 
+    if (priv->jobStatusSeq)
+        virBufferAsprintf(buf, "<jobstatus seq='%llu'/>\n", priv->jobStatusSeq);
+
     if (priv->fakeReboot)
         virBufferAddLit(buf, "<fakereboot/>\n");
 
@@ -2943,6 +2946,13 @@ qemuDomainObjPrivateXMLParse(xmlXPathContextPtr ctxt,
     if (qemuDomainObjPrivateXMLParseJob(vm, priv, ctxt) < 0)
         goto error;
 
+    if (virXPathULongLong("string(./jobstatus/@seq)", ctxt,
+                          &priv->jobStatusSeq) == -2) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("invalid job status sequence number"));
+        goto error;
+    }
+
     priv->fakeReboot = virXPathBoolean("boolean(./fakereboot)", ctxt) == 1;
 
     if ((n = virXPathNodeSet("./devices/device", ctxt, &nodes)) < 0) {
@@ -6770,8 +6780,182 @@ virDomainDefParserConfig virQEMUDriverDomainDefParserConfig = {
 };
 
 
+/*
+ * Job transitions happen very often and they don't change anything but
+ * the <job/> element of the status XML. Instead of formatting and
+ * writing the complete status XML (which can be huge for domains with
+ * lots of devices) every time, only the job state is saved into a small
+ * ${name}.job file next to the status XML. Each save bumps a sequence
+ * number which is also stored in the status XML; the job file is only
+ * taken into account if it is newer than the status XML, so any full
+ * status save effectively compacts the pending job state.
+ */
+static char *
+qemuDomainObjJobStatusPath(virQEMUDriverConfigPtr cfg,
+                           virDomainObjPtr vm)
+{
+    char *ret;
+
+    ignore_value(virAsprintf(&ret, "%s/%s.job", cfg->stateDir, vm->def->name));
+    return ret;
+}
+
+
+static int
+qemuDomainObjSaveJobStatus(virQEMUDriverPtr driver,
+                           virDomainObjPtr obj)
+{
+    qemuDomainObjPrivatePtr priv = obj->privateData;
+    virQEMUDriverConfigPtr cfg = virQEMUDriverGetConfig(driver);
+    virBuffer buf = VIR_BUFFER_INITIALIZER;
+    char *path = NULL;
+    char *xml = NULL;
+    int ret = -1;
+
+    if (!(path = qemuDomainObjJobStatusPath(cfg, obj)))
+        goto cleanup;
+
+    virBufferAsprintf(&buf, "<jobstatus seq='%llu'>\n", priv->jobStatusSeq + 1);
+    virBufferAdjustIndent(&buf, 2);
+    if (qemuDomainObjPrivateXMLFormatJob(&buf, obj, priv) < 0)
+        goto cleanup;
+    virBufferAdjustIndent(&buf, -2);
+    virBufferAddLit(&buf, "</jobstatus>\n");
+
+    if (virBufferCheckError(&buf) < 0)
+        goto cleanup;
+
+    xml = virBufferContentAndReset(&buf);
+
+    if (virFileRewriteStr(path, S_IRUSR | S_IWUSR, xml) < 0)
+        goto cleanup;
+
+    priv->jobStatusSeq++;
+    ret = 0;
+
+ cleanup:
+    virBufferFreeAndReset(&buf);
+    VIR_FREE(xml);
+    VIR_FREE(path);
+    virObjectUnref(cfg);
+    return ret;
+}
+
+
+/**
+ * qemuDomainObjLoadJobStatus:
+ * @driver: qemu driver
+ * @vm: domain object with status XML already loaded
+ *
+ * Updates job data of @vm from the job status file if it is newer than
+ * the status XML @vm was loaded from.
+ *
+ * Returns 0 on success (including when there's nothing to load),
+ *        -1 on error.
+ */
+int
+qemuDomainObjLoadJobStatus(virQEMUDriverPtr driver,
+                           virDomainObjPtr vm)
+{
+    qemuDomainObjPrivatePtr priv = vm->privateData;
+    virQEMUDriverConfigPtr cfg = virQEMUDriverGetConfig(driver);
+    xmlDocPtr xml = NULL;
+    xmlXPathContextPtr ctxt = NULL;
+    unsigned long long seq = 0;
+    char *path = NULL;
+    size_t i;
+    int ret = -1;
+
+    if (!(path = qemuDomainObjJobStatusPath(cfg, vm)))
+        goto cleanup;
+
+    if (!virFileExists(path)) {
+        ret = 0;
+        goto cleanup;
+    }
+
+    if (!(xml = virXMLParseFileCtxt(path, &ctxt)))
+        goto cleanup;
+
+    if (!virXMLNodeNameEqual(ctxt->node, "jobstatus")) {
+        virReportError(VIR_ERR_XML_ERROR,
+                       _("unexpected root element <%s> in %s"),
+                       ctxt->node->name, path);
+        goto cleanup;
+    }
+
+    if (virXPathULongLong("string(./@seq)", ctxt, &seq) < 0) {
+        virReportError(VIR_ERR_XML_ERROR,
+                       _("missing or invalid sequence number in %s"), path);
+        goto cleanup;
+    }
+
+    if (seq <= priv->jobStatusSeq) {
+        VIR_DEBUG("Job status of domain %s is older than status XML "
+                  "(%llu <= %llu)", vm->def->name, seq, priv->jobStatusSeq);
+        ret = 0;
+        goto cleanup;
+    }
+
+    VIR_DEBUG("Loading job status of domain %s (seq=%llu)",
+              vm->def->name, seq);
+
+    qemuDomainObjResetJob(priv);
+    qemuDomainObjResetAsyncJob(priv);
+    for (i = 0; i < vm->def->ndisks; i++) {
+        qemuDomainDiskPrivatePtr diskPriv =
+            QEMU_DOMAIN_DISK_PRIVATE(vm->def->disks[i]);
+
+        diskPriv->migrating = false;
+        virStorageSourceFree(diskPriv->migrSource);
+        diskPriv->migrSource = NULL;
+    }
+
+    if (qemuDomainObjPrivateXMLParseJob(vm, priv, ctxt) < 0)
+        goto cleanup;
+
+    priv->jobStatusSeq = seq;
+    ret = 0;
+
+ cleanup:
+    xmlXPathFreeContext(ctxt);
+    xmlFreeDoc(xml);
+    VIR_FREE(path);
+    virObjectUnref(cfg);
+    return ret;
+}
+
+
+int
+qemuDomainObjRemoveJobStatus(virQEMUDriverPtr driver,
+                             virDomainObjPtr vm)
+{
+    qemuDomainObjPrivatePtr priv = vm->privateData;
+    virQEMUDriverConfigPtr cfg = virQEMUDriverGetConfig(driver);
+    char *path = NULL;
+    int ret = -1;
+
+    if (!(path = qemuDomainObjJobStatusPath(cfg, vm)))
+        goto cleanup;
+
+    if (unlink(path) < 0 && errno != ENOENT) {
+        virReportSystemError(errno, _("Failed to remove job status file %s"),
+                             path);
+        goto cleanup;
+    }
+
+    priv->jobStatusSeq = 0;
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(path);
+    virObjectUnref(cfg);
+    return ret;
+}
+
+
 static void
-qemuDomainObjSaveJob(virQEMUDriverPtr driver, virDomainObjPtr obj)
+qemuDomainObjSaveStatus(virQEMUDriverPtr driver, virDomainObjPtr obj)
 {
     virQEMUDriverConfigPtr cfg = virQEMUDriverGetConfig(driver);
 
@@ -6783,6 +6967,20 @@ qemuDomainObjSaveJob(virQEMUDriverPtr driver, virDomainObjPtr obj)
     virObjectUnref(cfg);
 }
 
+
+static void
+qemuDomainObjSaveJob(virQEMUDriverPtr driver, virDomainObjPtr obj)
+{
+    if (!virDomainObjIsActive(obj))
+        return;
+
+    if (qemuDomainObjSaveJobStatus(driver, obj) < 0) {
+        VIR_WARN("Failed to save job status on vm %s, saving full status",
+                 obj->def->name);
+        qemuDomainObjSaveStatus(driver, obj);
+    }
+}
+
 void
 qemuDomainObjSetJobPhase(virQEMUDriverPtr driver,
                          virDomainObjPtr obj,
@@ -6883,11 +7081,12 @@ qemuDomainObjCanSetJob(qemuDomainObjPrivatePtr priv,
  * @job: qemuDomainJob to start
  * @asyncJob: qemuDomainAsyncJob to start
  * @nowait: don't wait trying to acquire @job
+ * @timeout: how long to wait for @job (in milliseconds)
  *
  * Acquires job for a domain object which must be locked before
- * calling. If there's already a job running waits up to
- * QEMU_JOB_WAIT_TIME after which the functions fails reporting
- * an error unless @nowait is set.
+ * calling. If there's already a job running waits up to @timeout
+ * (or QEMU_JOB_WAIT_TIME if @timeout is 0) after which the
+ * functions fails reporting an error unless @nowait is set.
  *
  * If @nowait is true this function tries to acquire job and if
  * it fails, then it returns immediately without waiting. No
@@ -6904,7 +7103,8 @@ qemuDomainObjBeginJobInternal(virQEMUDriverPtr driver,
                               qemuDomainJob job,
                               qemuDomainAgentJob agentJob,
                               qemuDomainAsyncJob asyncJob,
-                              bool nowait)
+                              bool nowait,
+                              unsigned long long timeout)
 {
     qemuDomainObjPrivatePtr priv = obj->privateData;
     unsigned long long now;
@@ -6935,7 +7135,7 @@ qemuDomainObjBeginJobInternal(virQEMUDriverPtr driver,
     }
 
     priv->jobs_queued++;
-    then = now + QEMU_JOB_WAIT_TIME;
+    then = now + (timeout ? timeout : QEMU_JOB_WAIT_TIME);
 
  retry:
     if ((!async && job != QEMU_JOB_DESTROY) &&
@@ -7124,7 +7324,7 @@ int qemuDomainObjBeginJob(virQEMUDriverPtr driver,
 {
     if (qemuDomainObjBeginJobInternal(driver, obj, job,
                                       QEMU_AGENT_JOB_NONE,
-                                      QEMU_ASYNC_JOB_NONE, false) < 0)
+                                      QEMU_ASYNC_JOB_NONE, false, 0) < 0)
         return -1;
     else
         return 0;
@@ -7144,7 +7344,7 @@ qemuDomainObjBeginAgentJob(virQEMUDriverPtr driver,
 {
     return qemuDomainObjBeginJobInternal(driver, obj, QEMU_JOB_NONE,
                                          agentJob,
-                                         QEMU_ASYNC_JOB_NONE, false);
+                                         QEMU_ASYNC_JOB_NONE, false, 0);
 }
 
 /**
@@ -7164,7 +7364,7 @@ qemuDomainObjBeginJobWithAgent(virQEMUDriverPtr driver,
                                qemuDomainAgentJob agentJob)
 {
     return qemuDomainObjBeginJobInternal(driver, obj, job, agentJob,
-                                         QEMU_ASYNC_JOB_NONE, false);
+                                         QEMU_ASYNC_JOB_NONE, false, 0);
 }
 
 int qemuDomainObjBeginAsyncJob(virQEMUDriverPtr driver,
@@ -7177,7 +7377,7 @@ int qemuDomainObjBeginAsyncJob(virQEMUDriverPtr driver,
 
     if (qemuDomainObjBeginJobInternal(driver, obj, QEMU_JOB_ASYNC,
                                       QEMU_AGENT_JOB_NONE,
-                                      asyncJob, false) < 0)
+                                      asyncJob, false, 0) < 0)
         return -1;
 
     priv = obj->privateData;
@@ -7209,7 +7409,7 @@ qemuDomainObjBeginNestedJob(virQEMUDriverPtr driver,
                                          QEMU_JOB_ASYNC_NESTED,
                                          QEMU_AGENT_JOB_NONE,
                                          QEMU_ASYNC_JOB_NONE,
-                                         false);
+                                         false, 0);
 }
 
 /**
@@ -7232,7 +7432,34 @@ qemuDomainObjBeginJobNowait(virQEMUDriverPtr driver,
 {
     return qemuDomainObjBeginJobInternal(driver, obj, job,
                                          QEMU_AGENT_JOB_NONE,
-                                         QEMU_ASYNC_JOB_NONE, true);
+                                         QEMU_ASYNC_JOB_NONE, true, 0);
+}
+
+/**
+ * qemuDomainObjBeginJobTimeout:
+ *
+ * @driver: qemu driver
+ * @obj: domain object
+ * @job: qemuDomainJob to start
+ * @timeout: how long to wait for @job (in milliseconds)
+ *
+ * Acquires job for a domain object which must be locked before
+ * calling. Unlike qemuDomainObjBeginJob the caller can choose how
+ * long it is willing to wait for another job to finish. A @timeout
+ * of 0 means the default QEMU_JOB_WAIT_TIME.
+ *
+ * Returns: see qemuDomainObjBeginJobInternal
+ */
+int
+qemuDomainObjBeginJobTimeout(virQEMUDriverPtr driver,
+                             virDomainObjPtr obj,
+                             qemuDomainJob job,
+                             unsigned long long timeout)
+{
+    return qemuDomainObjBeginJobInternal(driver, obj, job,
+                                         QEMU_AGENT_JOB_NONE,
+                                         QEMU_ASYNC_JOB_NONE, false,
+                                         timeout);
 }
 
 /*
@@ -7318,7 +7545,9 @@ qemuDomainObjEndAsyncJob(virQEMUDriverPtr driver, virDomainObjPtr obj)
               obj, obj->def->name);
 
     qemuDomainObjResetAsyncJob(priv);
-    qemuDomainObjSaveJob(driver, obj);
+    /* Async jobs usually change more than just the job data and
+     * this is a good time to compact the job status anyway. */
+    qemuDomainObjSaveStatus(driver, obj);
     virCondBroadcast(&priv->job.asyncCond);
 }
 
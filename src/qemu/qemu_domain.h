@@ -272,6 +272,9 @@ struct _qemuDomainObjPrivate {
     virQEMUDriverPtr driver;
 
     qemuDomainJobObj job;
+    /* sequence number of the last job status saved into the
+     * ${name}.job file next to the status XML */
+    unsigned long long jobStatusSeq;
 
     virBitmapPtr namespaces;
 
@@ -373,6 +376,9 @@ struct _qemuDomainObjPrivate {
 
     /* true if global -mem-prealloc appears on cmd line */
     bool memPrealloc;
+
+    /* number of parameters in the last stats record of the domain */
+    size_t statsParamsHint;
 };
 
 # define QEMU_DOMAIN_PRIVATE(vm) \
@@ -555,6 +561,16 @@ int qemuDomainObjBeginJobNowait(virQEMUDriverPtr driver,
                                 virDomainObjPtr obj,
                                 qemuDomainJob job)
     ATTRIBUTE_RETURN_CHECK;
+int qemuDomainObjBeginJobTimeout(virQEMUDriverPtr driver,
+                                 virDomainObjPtr obj,
+                                 qemuDomainJob job,
+                                 unsigned long long timeout)
+    ATTRIBUTE_RETURN_CHECK;
+
+int qemuDomainObjLoadJobStatus(virQEMUDriverPtr driver,
+                               virDomainObjPtr vm);
+int qemuDomainObjRemoveJobStatus(virQEMUDriverPtr driver,
+                                 virDomainObjPtr vm);
 
 void qemuDomainObjEndJob(virQEMUDriverPtr driver,
                          virDomainObjPtr obj);
@@ -130,6 +130,7 @@ VIR_LOG_INIT("qemu.qemu_driver");
 #define QEMU_NB_BANDWIDTH_PARAM 7
 
 static void qemuProcessEventHandler(void *data, void *opaque);
+static void qemuConnectGetAllDomainStatsWorker(void *jobdata, void *opaque);
 
 static int qemuStateCleanup(void);
 
@@ -555,6 +556,25 @@ qemuDomainNetsRestart(virDomainObjPtr vm,
 }
 
 
+static int
+qemuDomainLoadJobStatus(virDomainObjPtr vm,
+                        void *opaque)
+{
+    virQEMUDriverPtr driver = opaque;
+
+    virObjectLock(vm);
+
+    if (qemuDomainObjLoadJobStatus(driver, vm) < 0) {
+        VIR_WARN("Failed to load job status of domain %s: %s",
+                 vm->def->name, virGetLastErrorMessage());
+        virResetLastError();
+    }
+
+    virObjectUnlock(vm);
+    return 0;
+}
+
+
 static int
 qemuDomainFindMaxID(virDomainObjPtr vm,
                     void *data)
@@ -726,6 +746,10 @@ qemuStateInitialize(bool privileged,
     if (!(qemu_driver->sharedDevices = virHashCreate(30, qemuSharedDeviceEntryFree)))
         goto error;
 
+    /* Keep the files of every vCPU and IOThread open */
+    if (!(qemu_driver->procStats = virProcStatCollectorNew(true)))
+        goto error;
+
     if (qemuMigrationDstErrorInit(qemu_driver) < 0)
         goto error;
 
@@ -874,6 +898,11 @@ qemuStateInitialize(bool privileged,
                                        NULL, NULL) < 0)
         goto error;
 
+    /* Job state may have changed since the status XML was written */
+    virDomainObjListForEach(qemu_driver->domains,
+                            qemuDomainLoadJobStatus,
+                            qemu_driver);
+
     /* find the maximum ID from active and transient configs to initialize
      * the driver with. This is to avoid race between autostart and reconnect
      * threads */
@@ -909,6 +938,30 @@ qemuStateInitialize(bool privileged,
     if (!qemu_driver->workerPool)
         goto error;
 
+    if (cfg->statsWorkers > 0 &&
+        !(qemu_driver->statsPool = virThreadPoolNew(0, cfg->statsWorkers, 0,
+                                                    qemuConnectGetAllDomainStatsWorker,
+                                                    qemu_driver)))
+        goto error;
+
+    /* must be running before reconnecting to the domains too */
+    if (cfg->monitorIOThreads > 0) {
+        if (VIR_ALLOC_N(qemu_driver->monitorThreads, cfg->monitorIOThreads) < 0)
+            goto error;
+
+        for (i = 0; i < cfg->monitorIOThreads; i++) {
+            char *name;
+
+            if (virAsprintf(&name, "qemu-mon-io-%zu", i) < 0)
+                goto error;
+            qemu_driver->monitorThreads[i] = virEventThreadNew(name);
+            VIR_FREE(name);
+            if (!qemu_driver->monitorThreads[i])
+                goto error;
+            qemu_driver->nmonitorThreads++;
+        }
+    }
+
     qemuProcessReconnectAll(qemu_driver);
 
     return 0;
@@ -1047,13 +1100,22 @@ qemuStateStop(void)
 static int
 qemuStateCleanup(void)
 {
+    size_t i;
+
     if (!qemu_driver)
         return -1;
 
     virThreadPoolFree(qemu_driver->workerPool);
+    virThreadPoolFree(qemu_driver->statsPool);
+    for (i = 0; i < qemu_driver->nmonitorThreads; i++) {
+        virEventThreadStop(qemu_driver->monitorThreads[i]);
+        virObjectUnref(qemu_driver->monitorThreads[i]);
+    }
+    VIR_FREE(qemu_driver->monitorThreads);
     virObjectUnref(qemu_driver->config);
     virObjectUnref(qemu_driver->hostdevMgr);
     virHashFree(qemu_driver->sharedDevices);
+    virObjectUnref(qemu_driver->procStats);
     virObjectUnref(qemu_driver->caps);
     virObjectUnref(qemu_driver->qemuCapsCache);
 
@@ -1187,6 +1249,7 @@ qemuConnectSupportsFeature(virConnectPtr conn, int feature)
     case VIR_DRV_FEATURE_REMOTE:
     case VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK:
     case VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK:
+    case VIR_DRV_FEATURE_REMOTE_SHARED_RING:
     default:
         return 0;
     }
@@ -1287,144 +1350,31 @@ static char *qemuConnectGetCapabilities(virConnectPtr conn) {
 
 
 static int
-qemuGetSchedInfo(unsigned long long *cpuWait,
-                 pid_t pid, pid_t tid)
-{
-    char *proc = NULL;
-    char *data = NULL;
-    char **lines = NULL;
-    size_t i;
-    int ret = -1;
-    double val;
-
-    *cpuWait = 0;
-
-    /* In general, we cannot assume pid_t fits in int; but /proc parsing
-     * is specific to Linux where int works fine.  */
-    if (tid)
-        ret = virAsprintf(&proc, "/proc/%d/task/%d/sched", (int)pid, (int)tid);
-    else
-        ret = virAsprintf(&proc, "/proc/%d/sched", (int)pid);
-    if (ret < 0)
-        goto cleanup;
-    ret = -1;
-
-    /* The file is not guaranteed to exist (needs CONFIG_SCHED_DEBUG) */
-    if (access(proc, R_OK) < 0) {
-        ret = 0;
-        goto cleanup;
-    }
-
-    if (virFileReadAll(proc, (1<<16), &data) < 0)
-        goto cleanup;
-
-    lines = virStringSplit(data, "\n", 0);
-    if (!lines)
-        goto cleanup;
-
-    for (i = 0; lines[i] != NULL; i++) {
-        const char *line = lines[i];
-
-        /* Needs CONFIG_SCHEDSTATS. The second check
-         * is the old name the kernel used in past */
-        if (STRPREFIX(line, "se.statistics.wait_sum") ||
-            STRPREFIX(line, "se.wait_sum")) {
-            line = strchr(line, ':');
-            if (!line) {
-                virReportError(VIR_ERR_INTERNAL_ERROR,
-                               _("Missing separator in sched info '%s'"),
-                               lines[i]);
-                goto cleanup;
-            }
-            line++;
-            while (*line == ' ')
-                line++;
-
-            if (virStrToDouble(line, NULL, &val) < 0) {
-                virReportError(VIR_ERR_INTERNAL_ERROR,
-                               _("Unable to parse sched info value '%s'"),
-                               line);
-                goto cleanup;
-            }
-
-            *cpuWait = (unsigned long long)(val * 1000000);
-            break;
-        }
-    }
-
-    ret = 0;
-
- cleanup:
-    VIR_FREE(data);
-    VIR_FREE(proc);
-    virStringListFree(lines);
-    return ret;
-}
-
-
-static int
-qemuGetProcessInfo(unsigned long long *cpuTime, int *lastCpu, long *vm_rss,
+qemuGetProcessInfo(virQEMUDriverPtr driver,
+                   unsigned long long *cpuTime, int *lastCpu, long *vm_rss,
                    pid_t pid, int tid)
 {
-    char *proc;
-    FILE *pidinfo;
-    unsigned long long usertime = 0, systime = 0;
-    long rss = 0;
-    int cpu = 0;
-    int ret;
-
-    /* In general, we cannot assume pid_t fits in int; but /proc parsing
-     * is specific to Linux where int works fine.  */
-    if (tid)
-        ret = virAsprintf(&proc, "/proc/%d/task/%d/stat", (int)pid, tid);
-    else
-        ret = virAsprintf(&proc, "/proc/%d/stat", (int)pid);
-    if (ret < 0)
-        return -1;
-
-    pidinfo = fopen(proc, "r");
-    VIR_FREE(proc);
-
-    /* See 'man proc' for information about what all these fields are. We're
-     * only interested in a very few of them */
-    if (!pidinfo ||
-        fscanf(pidinfo,
-               /* pid -> stime */
-               "%*d (%*[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu"
-               /* cutime -> endcode */
-               "%*d %*d %*d %*d %*d %*d %*u %*u %ld %*u %*u %*u"
-               /* startstack -> processor */
-               "%*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*d %d",
-               &usertime, &systime, &rss, &cpu) != 4) {
-        VIR_WARN("cannot parse process status data");
-    }
-
-    /* We got jiffies
-     * We want nanoseconds
-     * _SC_CLK_TCK is jiffies per second
-     * So calculate thus....
-     */
-    if (cpuTime)
-        *cpuTime = 1000ull * 1000ull * 1000ull * (usertime + systime)
-            / (unsigned long long)sysconf(_SC_CLK_TCK);
-    if (lastCpu)
-        *lastCpu = cpu;
-
-    if (vm_rss)
-        *vm_rss = rss * virGetSystemPageSizeKB();
-
-
-    VIR_DEBUG("Got status for %d/%d user=%llu sys=%llu cpu=%d rss=%ld",
-              (int)pid, tid, usertime, systime, cpu, rss);
+    if (virProcStatCollectorGetStat(driver->procStats, pid, tid,
+                                    cpuTime, lastCpu, vm_rss) < 0) {
+        VIR_WARN("cannot parse process status data: %s",
+                 virGetLastErrorMessage());
+        virResetLastError();
 
-    VIR_FORCE_FCLOSE(pidinfo);
+        if (cpuTime)
+            *cpuTime = 0;
+        if (lastCpu)
+            *lastCpu = 0;
+        if (vm_rss)
+            *vm_rss = 0;
+    }
 
     return 0;
 }
 
 
 static int
-qemuDomainHelperGetVcpus(virDomainObjPtr vm,
+qemuDomainHelperGetVcpus(virQEMUDriverPtr driver,
+                         virDomainObjPtr vm,
                          virVcpuInfoPtr info,
                          unsigned long long *cpuwait,
                          int maxinfo,
@@ -1461,7 +1411,7 @@ qemuDomainHelperGetVcpus(virDomainObjPtr vm,
             vcpuinfo->number = i;
             vcpuinfo->state = VIR_VCPU_RUNNING;
 
-            if (qemuGetProcessInfo(&vcpuinfo->cpuTime,
+            if (qemuGetProcessInfo(driver, &vcpuinfo->cpuTime,
                                    &vcpuinfo->cpu, NULL,
                                    vm->pid, vcpupid) < 0) {
                 virReportSystemError(errno, "%s",
@@ -1482,7 +1432,9 @@ qemuDomainHelperGetVcpus(virDomainObjPtr vm,
         }
 
         if (cpuwait) {
-            if (qemuGetSchedInfo(&(cpuwait[ncpuinfo]), vm->pid, vcpupid) < 0)
+            if (virProcStatCollectorGetSchedWait(driver->procStats,
+                                                 vm->pid, vcpupid,
+                                                 &(cpuwait[ncpuinfo])) < 0)
                 return -1;
         }
 
@@ -2615,7 +2567,7 @@ qemuDomainGetInfo(virDomainPtr dom,
     }
 
     if (virDomainObjIsActive(vm)) {
-        if (qemuGetProcessInfo(&(info->cpuTime), NULL, NULL, vm->pid, 0) < 0) {
+        if (qemuGetProcessInfo(driver, &(info->cpuTime), NULL, NULL, vm->pid, 0) < 0) {
             virReportError(VIR_ERR_OPERATION_FAILED, "%s",
                            _("cannot read cputime for domain"));
             goto cleanup;
@@ -2737,6 +2689,8 @@ typedef enum {
      */
     QEMU_SAVE_FORMAT_XZ = 3,
     QEMU_SAVE_FORMAT_LZOP = 4,
+    QEMU_SAVE_FORMAT_ZSTD = 5,
+    QEMU_SAVE_FORMAT_PZSTD = 6,
     /* Note: add new members only at the end.
        These values are used in the on-disk format.
        Do not change or re-use numbers. */
@@ -2750,7 +2704,9 @@ VIR_ENUM_IMPL(qemuSaveCompression, QEMU_SAVE_FORMAT_LAST,
               "gzip",
               "bzip2",
               "xz",
-              "lzop")
+              "lzop",
+              "zstd",
+              "pzstd")
 
 VIR_ENUM_DECL(qemuDumpFormat)
 VIR_ENUM_IMPL(qemuDumpFormat, VIR_DOMAIN_CORE_DUMP_FORMAT_LAST,
@@ -2965,6 +2921,31 @@ qemuCompressGetCommand(virQEMUSaveFormat compression)
     return ret;
 }
 
+
+/**
+ * qemuCompressGetSaveCommand:
+ * @compression: compression format
+ * @compressedpath: path to the compression program
+ *
+ * Returns a command which compresses data read from its standard input
+ * using @compression format and writes them to its standard output.
+ * Formats which support it are told to use all available host CPUs.
+ */
+static virCommandPtr
+qemuCompressGetSaveCommand(virQEMUSaveFormat compression,
+                           const char *compressedpath)
+{
+    virCommandPtr ret = virCommandNew(compressedpath);
+
+    virCommandAddArg(ret, "-c");
+
+    /* pzstd uses as many threads as there are CPUs by default */
+    if (compression == QEMU_SAVE_FORMAT_ZSTD)
+        virCommandAddArg(ret, "-T0");
+
+    return ret;
+}
+
 /**
  * qemuOpenFile:
  * @driver: driver object
@@ -3180,6 +3161,7 @@ qemuDomainSaveMemory(virQEMUDriverPtr driver,
     int directFlag = 0;
     virFileWrapperFdPtr wrapperFd = NULL;
     unsigned int wrapperFlags = VIR_FILE_WRAPPER_NON_BLOCKING;
+    virCommandPtr compressor = NULL;
 
     /* Obtain the file handle.  */
     if ((flags & VIR_DOMAIN_SAVE_BYPASS_CACHE)) {
@@ -3207,8 +3189,12 @@ qemuDomainSaveMemory(virQEMUDriverPtr driver,
     if (virQEMUSaveDataWrite(data, fd, path) < 0)
         goto cleanup;
 
+    if (compressedpath)
+        compressor = qemuCompressGetSaveCommand(data->header.compressed,
+                                                compressedpath);
+
     /* Perform the migration */
-    if (qemuMigrationSrcToFile(driver, vm, fd, compressedpath, asyncJob) < 0)
+    if (qemuMigrationSrcToFile(driver, vm, fd, compressor, asyncJob) < 0)
         goto cleanup;
 
     /* Touch up file header to mark image complete. */
@@ -3234,6 +3220,7 @@ qemuDomainSaveMemory(virQEMUDriverPtr driver,
  cleanup:
     VIR_FORCE_CLOSE(fd);
     virFileWrapperFdFree(wrapperFd);
+    virCommandFree(compressor);
     virObjectUnref(cfg);
 
     if (ret < 0 && needUnlink)
@@ -3762,14 +3749,18 @@ doCoreDump(virQEMUDriverPtr driver,
     const char *memory_dump_format = NULL;
     virQEMUDriverConfigPtr cfg = virQEMUDriverGetConfig(driver);
     char *compressedpath = NULL;
+    virCommandPtr compressor = NULL;
+    int compressed;
 
     /* We reuse "save" flag for "dump" here. Then, we can support the same
      * format in "save" and "dump". This path doesn't need the compression
      * program to exist and can ignore the return value - it only cares to
      * get the compressedpath */
-    ignore_value(qemuGetCompressionProgram(cfg->dumpImageFormat,
+    compressed = qemuGetCompressionProgram(cfg->dumpImageFormat,
                                            &compressedpath,
-                                           "dump", true));
+                                           "dump", true);
+    if (compressedpath)
+        compressor = qemuCompressGetSaveCommand(compressed, compressedpath);
 
     /* Create an empty file with appropriate ownership.  */
     if (dump_flags & VIR_DUMP_BYPASS_CACHE) {
@@ -3816,7 +3807,7 @@ doCoreDump(virQEMUDriverPtr driver,
         if (!qemuMigrationSrcIsAllowed(driver, vm, false, 0))
             goto cleanup;
 
-        ret = qemuMigrationSrcToFile(driver, vm, fd, compressedpath,
+        ret = qemuMigrationSrcToFile(driver, vm, fd, compressor,
                                      QEMU_ASYNC_JOB_DUMP);
     }
 
@@ -3839,6 +3830,7 @@ doCoreDump(virQEMUDriverPtr driver,
     if (ret != 0)
         unlink(path);
     virFileWrapperFdFree(wrapperFd);
+    virCommandFree(compressor);
     VIR_FREE(compressedpath);
     virObjectUnref(cfg);
     return ret;
@@ -5432,6 +5424,7 @@ qemuDomainGetVcpus(virDomainPtr dom,
                    unsigned char *cpumaps,
                    int maplen)
 {
+    virQEMUDriverPtr driver = dom->conn->privateData;
     virDomainObjPtr vm;
     int ret = -1;
 
@@ -5447,7 +5440,8 @@ qemuDomainGetVcpus(virDomainPtr dom,
         goto cleanup;
     }
 
-    ret = qemuDomainHelperGetVcpus(vm, info, NULL, maxinfo, cpumaps, maplen);
+    ret = qemuDomainHelperGetVcpus(driver, vm, info, NULL, maxinfo,
+                                   cpumaps, maplen);
 
  cleanup:
     virDomainObjEndAPI(&vm);
@@ -11961,7 +11955,7 @@ qemuDomainMemoryStatsInternal(virQEMUDriverPtr driver,
         ret = 0;
     }
 
-    if (qemuGetProcessInfo(NULL, NULL, &rss, vm->pid, 0) < 0) {
+    if (qemuGetProcessInfo(driver, NULL, NULL, &rss, vm->pid, 0) < 0) {
         virReportError(VIR_ERR_OPERATION_FAILED, "%s",
                        _("cannot get RSS for domain"));
     } else {
@@ -19957,22 +19951,13 @@ qemuConnectGetDomainCapabilities(virConnectPtr conn,
 static int
 qemuDomainGetStatsState(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
                         virDomainObjPtr dom,
-                        virDomainStatsRecordPtr record,
-                        int *maxparams,
+                        virTypedParamListPtr params,
                         unsigned int privflags ATTRIBUTE_UNUSED)
 {
-    if (virTypedParamsAddInt(&record->params,
-                             &record->nparams,
-                             maxparams,
-                             "state.state",
-                             dom->state.state) < 0)
+    if (virTypedParamListAddInt(params, dom->state.state, "state.state") < 0)
         return -1;
 
-    if (virTypedParamsAddInt(&record->params,
-                             &record->nparams,
-                             maxparams,
-                             "state.reason",
-                             dom->state.reason) < 0)
+    if (virTypedParamListAddInt(params, dom->state.reason, "state.reason") < 0)
         return -1;
 
     return 0;
@@ -20086,10 +20071,8 @@ qemuDomainGetResctrlMonData(virDomainObjPtr dom,
 
 static int
 qemuDomainGetStatsCpuCache(virDomainObjPtr dom,
-                           virDomainStatsRecordPtr record,
-                           int *maxparams)
+                           virTypedParamListPtr params)
 {
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH];
     virQEMUResctrlMonDataPtr *resdata = NULL;
     size_t nresdata = 0;
     size_t i = 0;
@@ -20103,49 +20086,32 @@ qemuDomainGetStatsCpuCache(virDomainObjPtr dom,
                                     VIR_RESCTRL_MONITOR_TYPE_CACHE) < 0)
         goto cleanup;
 
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-             "cpu.cache.monitor.count");
-    if (virTypedParamsAddUInt(&record->params, &record->nparams,
-                              maxparams, param_name, nresdata) < 0)
+    if (virTypedParamListAddUInt(params, nresdata,
+                                 "cpu.cache.monitor.count") < 0)
         goto cleanup;
 
     for (i = 0; i < nresdata; i++) {
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                 "cpu.cache.monitor.%zu.name", i);
-        if (virTypedParamsAddString(&record->params,
-                                    &record->nparams,
-                                    maxparams,
-                                    param_name,
-                                    resdata[i]->name) < 0)
+        if (virTypedParamListAddString(params, resdata[i]->name,
+                                       "cpu.cache.monitor.%zu.name", i) < 0)
             goto cleanup;
 
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                 "cpu.cache.monitor.%zu.vcpus", i);
-        if (virTypedParamsAddString(&record->params, &record->nparams,
-                                    maxparams, param_name,
-                                    resdata[i]->vcpus) < 0)
+        if (virTypedParamListAddString(params, resdata[i]->vcpus,
+                                       "cpu.cache.monitor.%zu.vcpus", i) < 0)
             goto cleanup;
 
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                 "cpu.cache.monitor.%zu.bank.count", i);
-        if (virTypedParamsAddUInt(&record->params, &record->nparams,
-                                  maxparams, param_name,
-                                  resdata[i]->nstats) < 0)
+        if (virTypedParamListAddUInt(params, resdata[i]->nstats,
+                                     "cpu.cache.monitor.%zu.bank.count", i) < 0)
             goto cleanup;
 
         for (j = 0; j < resdata[i]->nstats; j++) {
-            snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                     "cpu.cache.monitor.%zu.bank.%zu.id", i, j);
-            if (virTypedParamsAddUInt(&record->params, &record->nparams,
-                                      maxparams, param_name,
-                                      resdata[i]->stats[j]->id) < 0)
+            if (virTypedParamListAddUInt(params, resdata[i]->stats[j]->id,
+                                         "cpu.cache.monitor.%zu.bank.%zu.id",
+                                         i, j) < 0)
                 goto cleanup;
 
-            snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                     "cpu.cache.monitor.%zu.bank.%zu.bytes", i, j);
-            if (virTypedParamsAddUInt(&record->params, &record->nparams,
-                                      maxparams, param_name,
-                                      resdata[i]->stats[j]->val) < 0)
+            if (virTypedParamListAddUInt(params, resdata[i]->stats[j]->val,
+                                         "cpu.cache.monitor.%zu.bank.%zu.bytes",
+                                         i, j) < 0)
                 goto cleanup;
         }
     }
@@ -20161,8 +20127,7 @@ qemuDomainGetStatsCpuCache(virDomainObjPtr dom,
 
 static int
 qemuDomainGetStatsCpuCgroup(virDomainObjPtr dom,
-                            virDomainStatsRecordPtr record,
-                            int *maxparams)
+                            virTypedParamListPtr params)
 {
     qemuDomainObjPrivatePtr priv = dom->privateData;
     unsigned long long cpu_time = 0;
@@ -20174,25 +20139,13 @@ qemuDomainGetStatsCpuCgroup(virDomainObjPtr dom,
         return 0;
 
     err = virCgroupGetCpuacctUsage(priv->cgroup, &cpu_time);
-    if (!err && virTypedParamsAddULLong(&record->params,
-                                        &record->nparams,
-                                        maxparams,
-                                        "cpu.time",
-                                        cpu_time) < 0)
+    if (!err && virTypedParamListAddULLong(params, cpu_time, "cpu.time") < 0)
         return -1;
 
     err = virCgroupGetCpuacctStat(priv->cgroup, &user_time, &sys_time);
-    if (!err && virTypedParamsAddULLong(&record->params,
-                                        &record->nparams,
-                                        maxparams,
-                                        "cpu.user",
-                                        user_time) < 0)
+    if (!err && virTypedParamListAddULLong(params, user_time, "cpu.user") < 0)
         return -1;
-    if (!err && virTypedParamsAddULLong(&record->params,
-                                        &record->nparams,
-                                        maxparams,
-                                        "cpu.system",
-                                        sys_time) < 0)
+    if (!err && virTypedParamListAddULLong(params, sys_time, "cpu.system") < 0)
         return -1;
 
     return 0;
@@ -20202,14 +20155,13 @@ qemuDomainGetStatsCpuCgroup(virDomainObjPtr dom,
 static int
 qemuDomainGetStatsCpu(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
                       virDomainObjPtr dom,
-                      virDomainStatsRecordPtr record,
-                      int *maxparams,
+                      virTypedParamListPtr params,
                       unsigned int privflags ATTRIBUTE_UNUSED)
 {
-    if (qemuDomainGetStatsCpuCgroup(dom, record, maxparams) < 0)
+    if (qemuDomainGetStatsCpuCgroup(dom, params) < 0)
         return -1;
 
-    if (qemuDomainGetStatsCpuCache(dom, record, maxparams) < 0)
+    if (qemuDomainGetStatsCpuCache(dom, params) < 0)
         return -1;
 
     return 0;
@@ -20219,8 +20171,7 @@ qemuDomainGetStatsCpu(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
 static int
 qemuDomainGetStatsBalloon(virQEMUDriverPtr driver,
                           virDomainObjPtr dom,
-                          virDomainStatsRecordPtr record,
-                          int *maxparams,
+                          virTypedParamListPtr params,
                           unsigned int privflags)
 {
     qemuDomainObjPrivatePtr priv = dom->privateData;
@@ -20238,18 +20189,12 @@ qemuDomainGetStatsBalloon(virQEMUDriverPtr driver,
         err = -1;
     }
 
-    if (!err && virTypedParamsAddULLong(&record->params,
-                                        &record->nparams,
-                                        maxparams,
-                                        "balloon.current",
-                                        cur_balloon) < 0)
+    if (!err && virTypedParamListAddULLong(params, cur_balloon,
+                                           "balloon.current") < 0)
         return -1;
 
-    if (virTypedParamsAddULLong(&record->params,
-                                &record->nparams,
-                                maxparams,
-                                "balloon.maximum",
-                                virDomainDefGetMemoryTotal(dom->def)) < 0)
+    if (virTypedParamListAddULLong(params, virDomainDefGetMemoryTotal(dom->def),
+                                   "balloon.maximum") < 0)
         return -1;
 
     if (!HAVE_JOB(privflags) || !virDomainObjIsActive(dom))
@@ -20262,11 +20207,8 @@ qemuDomainGetStatsBalloon(virQEMUDriverPtr driver,
 
 #define STORE_MEM_RECORD(TAG, NAME) \
     if (stats[i].tag == VIR_DOMAIN_MEMORY_STAT_ ##TAG) \
-        if (virTypedParamsAddULLong(&record->params, \
-                                    &record->nparams, \
-                                    maxparams, \
-                                    "balloon." NAME, \
-                                    stats[i].val) < 0) \
+        if (virTypedParamListAddULLong(params, stats[i].val, \
+                                       "balloon." NAME) < 0) \
             return -1;
 
     for (i = 0; i < nr_stats; i++) {
@@ -20291,30 +20233,22 @@ qemuDomainGetStatsBalloon(virQEMUDriverPtr driver,
 static int
 qemuDomainGetStatsVcpu(virQEMUDriverPtr driver,
                        virDomainObjPtr dom,
-                       virDomainStatsRecordPtr record,
-                       int *maxparams,
+                       virTypedParamListPtr params,
                        unsigned int privflags)
 {
     virDomainVcpuDefPtr vcpu;
     qemuDomainVcpuPrivatePtr vcpupriv;
     size_t i;
     int ret = -1;
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH];
     virVcpuInfoPtr cpuinfo = NULL;
     unsigned long long *cpuwait = NULL;
 
-    if (virTypedParamsAddUInt(&record->params,
-                              &record->nparams,
-                              maxparams,
-                              "vcpu.current",
-                              virDomainDefGetVcpus(dom->def)) < 0)
+    if (virTypedParamListAddUInt(params, virDomainDefGetVcpus(dom->def),
+                                 "vcpu.current") < 0)
         return -1;
 
-    if (virTypedParamsAddUInt(&record->params,
-                              &record->nparams,
-                              maxparams,
-                              "vcpu.maximum",
-                              virDomainDefGetVcpusMax(dom->def)) < 0)
+    if (virTypedParamListAddUInt(params, virDomainDefGetVcpusMax(dom->def),
+                                 "vcpu.maximum") < 0)
         return -1;
 
     if (VIR_ALLOC_N(cpuinfo, virDomainDefGetVcpus(dom->def)) < 0 ||
@@ -20328,7 +20262,7 @@ qemuDomainGetStatsVcpu(virQEMUDriverPtr driver,
             virResetLastError();
     }
 
-    if (qemuDomainHelperGetVcpus(dom, cpuinfo, cpuwait,
+    if (qemuDomainHelperGetVcpus(driver, dom, cpuinfo, cpuwait,
                                  virDomainDefGetVcpus(dom->def),
                                  NULL, 0) < 0) {
         virResetLastError();
@@ -20337,34 +20271,19 @@ qemuDomainGetStatsVcpu(virQEMUDriverPtr driver,
     }
 
     for (i = 0; i < virDomainDefGetVcpus(dom->def); i++) {
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                 "vcpu.%u.state", cpuinfo[i].number);
-        if (virTypedParamsAddInt(&record->params,
-                                 &record->nparams,
-                                 maxparams,
-                                 param_name,
-                                 cpuinfo[i].state) < 0)
+        if (virTypedParamListAddInt(params, cpuinfo[i].state,
+                                    "vcpu.%u.state", cpuinfo[i].number) < 0)
             goto cleanup;
 
         /* stats below are available only if the VM is alive */
         if (!virDomainObjIsActive(dom))
             continue;
 
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                 "vcpu.%u.time", cpuinfo[i].number);
-        if (virTypedParamsAddULLong(&record->params,
-                                    &record->nparams,
-                                    maxparams,
-                                    param_name,
-                                    cpuinfo[i].cpuTime) < 0)
+        if (virTypedParamListAddULLong(params, cpuinfo[i].cpuTime,
+                                       "vcpu.%u.time", cpuinfo[i].number) < 0)
             goto cleanup;
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                 "vcpu.%u.wait", cpuinfo[i].number);
-        if (virTypedParamsAddULLong(&record->params,
-                                    &record->nparams,
-                                    maxparams,
-                                    param_name,
-                                    cpuwait[i]) < 0)
+        if (virTypedParamListAddULLong(params, cpuwait[i],
+                                       "vcpu.%u.wait", cpuinfo[i].number) < 0)
             goto cleanup;
 
         /* state below is extracted from the individual vcpu structs */
@@ -20374,13 +20293,10 @@ qemuDomainGetStatsVcpu(virQEMUDriverPtr driver,
         vcpupriv = QEMU_DOMAIN_VCPU_PRIVATE(vcpu);
 
         if (vcpupriv->halted != VIR_TRISTATE_BOOL_ABSENT) {
-            snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH,
-                     "vcpu.%u.halted", cpuinfo[i].number);
-            if (virTypedParamsAddBoolean(&record->params,
-                                         &record->nparams,
-                                         maxparams,
-                                         param_name,
-                                         vcpupriv->halted == VIR_TRISTATE_BOOL_YES) < 0)
+            if (virTypedParamListAddBoolean(params,
+                                            vcpupriv->halted == VIR_TRISTATE_BOOL_YES,
+                                            "vcpu.%u.halted",
+                                            cpuinfo[i].number) < 0)
                 goto cleanup;
         }
     }
@@ -20393,49 +20309,30 @@ qemuDomainGetStatsVcpu(virQEMUDriverPtr driver,
     return ret;
 }
 
-#define QEMU_ADD_COUNT_PARAM(record, maxparams, type, count) \
+#define QEMU_ADD_COUNT_PARAM(params, type, count) \
 do { \
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, "%s.count", type); \
-    if (virTypedParamsAddUInt(&(record)->params, \
-                              &(record)->nparams, \
-                              maxparams, \
-                              param_name, \
-                              count) < 0) \
+    if (virTypedParamListAddUInt(params, count, "%s.count", type) < 0) \
         goto cleanup; \
 } while (0)
 
-#define QEMU_ADD_NAME_PARAM(record, maxparams, type, subtype, num, name) \
+#define QEMU_ADD_NAME_PARAM(params, type, subtype, num, name) \
 do { \
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, \
-             "%s.%zu.%s", type, num, subtype); \
-    if (virTypedParamsAddString(&(record)->params, \
-                                &(record)->nparams, \
-                                maxparams, \
-                                param_name, \
-                                name) < 0) \
+    if (virTypedParamListAddString(params, name, \
+                                   "%s.%zu.%s", type, num, subtype) < 0) \
         goto cleanup; \
 } while (0)
 
-#define QEMU_ADD_NET_PARAM(record, maxparams, num, name, value) \
+#define QEMU_ADD_NET_PARAM(params, num, name, value) \
 do { \
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, \
-             "net.%zu.%s", num, name); \
-    if (value >= 0 && virTypedParamsAddULLong(&(record)->params, \
-                                              &(record)->nparams, \
-                                              maxparams, \
-                                              param_name, \
-                                              value) < 0) \
+    if (value >= 0 && virTypedParamListAddULLong(params, value, \
+                                                 "net.%zu.%s", num, name) < 0) \
         return -1; \
 } while (0)
 
 static int
 qemuDomainGetStatsInterface(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
                             virDomainObjPtr dom,
-                            virDomainStatsRecordPtr record,
-                            int *maxparams,
+                            virTypedParamListPtr params,
                             unsigned int privflags ATTRIBUTE_UNUSED)
 {
     size_t i;
@@ -20445,7 +20342,7 @@ qemuDomainGetStatsInterface(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
     if (!virDomainObjIsActive(dom))
         return 0;
 
-    QEMU_ADD_COUNT_PARAM(record, maxparams, "net", dom->def->nnets);
+    QEMU_ADD_COUNT_PARAM(params, "net", dom->def->nnets);
 
     /* Check the path is one of the domain's network interfaces. */
     for (i = 0; i < dom->def->nnets; i++) {
@@ -20459,8 +20356,7 @@ qemuDomainGetStatsInterface(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
 
         actualType = virDomainNetGetActualType(net);
 
-        QEMU_ADD_NAME_PARAM(record, maxparams,
-                            "net", "name", i, net->ifname);
+        QEMU_ADD_NAME_PARAM(params, "net", "name", i, net->ifname);
 
         if (actualType == VIR_DOMAIN_NET_TYPE_VHOSTUSER) {
             if (virNetDevOpenvswitchInterfaceStats(net->ifname, &tmp) < 0) {
@@ -20475,21 +20371,21 @@ qemuDomainGetStatsInterface(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
             }
         }
 
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "rx.bytes", tmp.rx_bytes);
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "rx.pkts", tmp.rx_packets);
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "rx.errs", tmp.rx_errs);
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "rx.drop", tmp.rx_drop);
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "tx.bytes", tmp.tx_bytes);
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "tx.pkts", tmp.tx_packets);
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "tx.errs", tmp.tx_errs);
-        QEMU_ADD_NET_PARAM(record, maxparams, i,
+        QEMU_ADD_NET_PARAM(params, i,
                            "tx.drop", tmp.tx_drop);
     }
 
@@ -20500,43 +20396,25 @@ qemuDomainGetStatsInterface(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
 
 #undef QEMU_ADD_NET_PARAM
 
-#define QEMU_ADD_BLOCK_PARAM_UI(record, maxparams, num, name, value) \
+#define QEMU_ADD_BLOCK_PARAM_UI(params, num, name, value) \
     do { \
-        char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, \
-                 "block.%zu.%s", num, name); \
-        if (virTypedParamsAddUInt(&(record)->params, \
-                                  &(record)->nparams, \
-                                  maxparams, \
-                                  param_name, \
-                                  value) < 0) \
+        if (virTypedParamListAddUInt(params, value, \
+                                     "block.%zu.%s", num, name) < 0) \
             goto cleanup; \
     } while (0)
 
 /* expects a LL, but typed parameter must be ULL */
-#define QEMU_ADD_BLOCK_PARAM_LL(record, maxparams, num, name, value) \
+#define QEMU_ADD_BLOCK_PARAM_LL(params, num, name, value) \
 do { \
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, \
-             "block.%zu.%s", num, name); \
-    if (value >= 0 && virTypedParamsAddULLong(&(record)->params, \
-                                              &(record)->nparams, \
-                                              maxparams, \
-                                              param_name, \
-                                              value) < 0) \
+    if (value >= 0 && virTypedParamListAddULLong(params, value, \
+                                                 "block.%zu.%s", num, name) < 0) \
         goto cleanup; \
 } while (0)
 
-#define QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, num, name, value) \
+#define QEMU_ADD_BLOCK_PARAM_ULL(params, num, name, value) \
 do { \
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, \
-             "block.%zu.%s", num, name); \
-    if (virTypedParamsAddULLong(&(record)->params, \
-                                &(record)->nparams, \
-                                maxparams, \
-                                param_name, \
-                                value) < 0) \
+    if (virTypedParamListAddULLong(params, value, \
+                                   "block.%zu.%s", num, name) < 0) \
         goto cleanup; \
 } while (0)
 
@@ -20545,8 +20423,7 @@ static int
 qemuDomainGetStatsOneBlockFallback(virQEMUDriverPtr driver,
                                    virQEMUDriverConfigPtr cfg,
                                    virDomainObjPtr dom,
-                                   virDomainStatsRecordPtr record,
-                                   int *maxparams,
+                                   virTypedParamListPtr params,
                                    virStorageSourcePtr src,
                                    size_t block_idx)
 {
@@ -20561,13 +20438,13 @@ qemuDomainGetStatsOneBlockFallback(virQEMUDriverPtr driver,
     }
 
     if (src->allocation)
-        QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, block_idx,
+        QEMU_ADD_BLOCK_PARAM_ULL(params, block_idx,
                                  "allocation", src->allocation);
     if (src->capacity)
-        QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, block_idx,
+        QEMU_ADD_BLOCK_PARAM_ULL(params, block_idx,
                                  "capacity", src->capacity);
     if (src->physical)
-        QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, block_idx,
+        QEMU_ADD_BLOCK_PARAM_ULL(params, block_idx,
                                  "physical", src->physical);
     ret = 0;
  cleanup:
@@ -20615,8 +20492,7 @@ static int
 qemuDomainGetStatsOneBlock(virQEMUDriverPtr driver,
                            virQEMUDriverConfigPtr cfg,
                            virDomainObjPtr dom,
-                           virDomainStatsRecordPtr record,
-                           int *maxparams,
+                           virTypedParamListPtr params,
                            const char *entryname,
                            virStorageSourcePtr src,
                            size_t block_idx,
@@ -20628,8 +20504,8 @@ qemuDomainGetStatsOneBlock(virQEMUDriverPtr driver,
     /* the VM is offline so we have to go and load the stast from the disk by
      * ourselves */
     if (!virDomainObjIsActive(dom)) {
-        ret = qemuDomainGetStatsOneBlockFallback(driver, cfg, dom, record,
-                                                 maxparams, src, block_idx);
+        ret = qemuDomainGetStatsOneBlockFallback(driver, cfg, dom, params,
+                                                 src, block_idx);
         goto cleanup;
     }
 
@@ -20641,18 +20517,18 @@ qemuDomainGetStatsOneBlock(virQEMUDriverPtr driver,
         goto cleanup;
     }
 
-    QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, block_idx,
+    QEMU_ADD_BLOCK_PARAM_ULL(params, block_idx,
                              "allocation", entry->wr_highest_offset);
 
     if (entry->capacity)
-        QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, block_idx,
+        QEMU_ADD_BLOCK_PARAM_ULL(params, block_idx,
                                  "capacity", entry->capacity);
     if (entry->physical) {
-        QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, block_idx,
+        QEMU_ADD_BLOCK_PARAM_ULL(params, block_idx,
                                  "physical", entry->physical);
     } else {
         if (qemuDomainStorageUpdatePhysical(driver, cfg, dom, src) == 0) {
-            QEMU_ADD_BLOCK_PARAM_ULL(record, maxparams, block_idx,
+            QEMU_ADD_BLOCK_PARAM_ULL(params, block_idx,
                                      "physical", src->physical);
         } else {
             virResetLastError();
@@ -20669,8 +20545,7 @@ static int
 qemuDomainGetStatsBlockExportBackendStorage(const char *entryname,
                                             virHashTablePtr stats,
                                             size_t recordnr,
-                                            virDomainStatsRecordPtr records,
-                                            int *nrecords)
+                                            virTypedParamListPtr params)
 {
     qemuBlockStats *entry;
     int ret = -1;
@@ -20681,7 +20556,7 @@ qemuDomainGetStatsBlockExportBackendStorage(const char *entryname,
     }
 
     if (entry->write_threshold)
-        QEMU_ADD_BLOCK_PARAM_ULL(records, nrecords, recordnr, "threshold",
+        QEMU_ADD_BLOCK_PARAM_ULL(params, recordnr, "threshold",
                                  entry->write_threshold);
 
     ret = 0;
@@ -20694,8 +20569,7 @@ static int
 qemuDomainGetStatsBlockExportFrontend(const char *frontendname,
                                       virHashTablePtr stats,
                                       size_t recordnr,
-                                      virDomainStatsRecordPtr records,
-                                      int *nrecords)
+                                      virTypedParamListPtr params)
 {
     qemuBlockStats *entry;
     int ret = -1;
@@ -20708,14 +20582,14 @@ qemuDomainGetStatsBlockExportFrontend(const char *frontendname,
         goto cleanup;
     }
 
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "rd.reqs", entry->rd_req);
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "rd.bytes", entry->rd_bytes);
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "rd.times", entry->rd_total_times);
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "wr.reqs", entry->wr_req);
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "wr.bytes", entry->wr_bytes);
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "wr.times", entry->wr_total_times);
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "fl.reqs", entry->flush_req);
-    QEMU_ADD_BLOCK_PARAM_LL(records, nrecords, recordnr, "fl.times", entry->flush_total_times);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "rd.reqs", entry->rd_req);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "rd.bytes", entry->rd_bytes);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "rd.times", entry->rd_total_times);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "wr.reqs", entry->wr_req);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "wr.bytes", entry->wr_bytes);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "wr.times", entry->wr_total_times);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "fl.reqs", entry->flush_req);
+    QEMU_ADD_BLOCK_PARAM_LL(params, recordnr, "fl.times", entry->flush_total_times);
 
     ret = 0;
  cleanup:
@@ -20727,17 +20601,16 @@ static int
 qemuDomainGetStatsBlockExportHeader(virDomainDiskDefPtr disk,
                                     virStorageSourcePtr src,
                                     size_t recordnr,
-                                    virDomainStatsRecordPtr records,
-                                    int *nrecords)
+                                    virTypedParamListPtr params)
 {
     int ret = -1;
 
-    QEMU_ADD_NAME_PARAM(records, nrecords, "block", "name", recordnr, disk->dst);
+    QEMU_ADD_NAME_PARAM(params, "block", "name", recordnr, disk->dst);
 
     if (virStorageSourceIsLocalStorage(src) && src->path)
-        QEMU_ADD_NAME_PARAM(records, nrecords, "block", "path", recordnr, src->path);
+        QEMU_ADD_NAME_PARAM(params, "block", "path", recordnr, src->path);
     if (src->id)
-        QEMU_ADD_BLOCK_PARAM_UI(records, nrecords, recordnr, "backingIndex",
+        QEMU_ADD_BLOCK_PARAM_UI(params, recordnr, "backingIndex",
                                 src->id);
 
     ret = 0;
@@ -20750,8 +20623,7 @@ static int
 qemuDomainGetStatsBlockExportDisk(virDomainDiskDefPtr disk,
                                   virHashTablePtr stats,
                                   virHashTablePtr nodestats,
-                                  virDomainStatsRecordPtr records,
-                                  int *nrecords,
+                                  virTypedParamListPtr params,
                                   size_t *recordnr,
                                   bool visitBacking,
                                   virQEMUDriverPtr driver,
@@ -20778,7 +20650,7 @@ qemuDomainGetStatsBlockExportDisk(virDomainDiskDefPtr disk,
                  "skip getting stats", disk->dst);
 
         return qemuDomainGetStatsBlockExportHeader(disk, disk->src, *recordnr,
-                                                   records, nrecords);
+                                                   params);
     }
 
     for (n = disk->src; virStorageSourceIsBacking(n); n = n->backingStore) {
@@ -20800,24 +20672,24 @@ qemuDomainGetStatsBlockExportDisk(virDomainDiskDefPtr disk,
         }
 
         if (qemuDomainGetStatsBlockExportHeader(disk, n, *recordnr,
-                                                records, nrecords) < 0)
+                                                params) < 0)
             goto cleanup;
 
         /* The following stats make sense only for the frontend device */
         if (n == disk->src) {
             if (qemuDomainGetStatsBlockExportFrontend(frontendalias, stats, *recordnr,
-                                                      records, nrecords) < 0)
+                                                      params) < 0)
                 goto cleanup;
         }
 
-        if (qemuDomainGetStatsOneBlock(driver, cfg, dom, records, nrecords,
+        if (qemuDomainGetStatsOneBlock(driver, cfg, dom, params,
                                        backendalias, n, *recordnr,
                                        stats) < 0)
             goto cleanup;
 
         if (qemuDomainGetStatsBlockExportBackendStorage(backendstoragealias,
                                                         stats, *recordnr,
-                                                        records, nrecords) < 0)
+                                                        params) < 0)
             goto cleanup;
 
         VIR_FREE(alias);
@@ -20838,8 +20710,7 @@ qemuDomainGetStatsBlockExportDisk(virDomainDiskDefPtr disk,
 static int
 qemuDomainGetStatsBlock(virQEMUDriverPtr driver,
                         virDomainObjPtr dom,
-                        virDomainStatsRecordPtr record,
-                        int *maxparams,
+                        virTypedParamListPtr params,
                         unsigned int privflags)
 {
     size_t i;
@@ -20860,18 +20731,9 @@ qemuDomainGetStatsBlock(virQEMUDriverPtr driver,
     if (HAVE_JOB(privflags) && virDomainObjIsActive(dom)) {
         qemuDomainObjEnterMonitor(driver, dom);
 
-        rc = qemuMonitorGetAllBlockStatsInfo(priv->mon, &stats, visitBacking);
-
-        if (rc >= 0) {
-            if (blockdev)
-                rc = qemuMonitorBlockStatsUpdateCapacityBlockdev(priv->mon, stats);
-            else
-                ignore_value(qemuMonitorBlockStatsUpdateCapacity(priv->mon, stats,
-                                                                 visitBacking));
-        }
-
-        if (fetchnodedata)
-            nodedata = qemuMonitorQueryNamedBlockNodes(priv->mon);
+        rc = qemuMonitorGetAllBlockStatsAndCapacity(priv->mon, &stats,
+                                                    visitBacking, blockdev,
+                                                    fetchnodedata ? &nodedata : NULL);
 
         if (qemuDomainObjExitMonitor(driver, dom) < 0)
             goto cleanup;
@@ -20888,18 +20750,18 @@ qemuDomainGetStatsBlock(virQEMUDriverPtr driver,
     /* When listing backing chains, it's easier to fix up the count
      * after the iteration than it is to iterate twice; but we still
      * want count listed first.  */
-    count_index = record->nparams;
-    QEMU_ADD_COUNT_PARAM(record, maxparams, "block", 0);
+    count_index = params->npar;
+    QEMU_ADD_COUNT_PARAM(params, "block", 0);
 
     for (i = 0; i < dom->def->ndisks; i++) {
         if (qemuDomainGetStatsBlockExportDisk(dom->def->disks[i], stats, nodestats,
-                                              record, maxparams, &visited,
+                                              params, &visited,
                                               visitBacking, driver, cfg, dom,
                                               blockdev) < 0)
             goto cleanup;
     }
 
-    record->params[count_index].value.ui = visited;
+    params->par[count_index].value.ui = visited;
     ret = 0;
 
  cleanup:
@@ -20916,37 +20778,24 @@ qemuDomainGetStatsBlock(virQEMUDriverPtr driver,
 
 #undef QEMU_ADD_NAME_PARAM
 
-#define QEMU_ADD_IOTHREAD_PARAM_UI(record, maxparams, id, name, value) \
+#define QEMU_ADD_IOTHREAD_PARAM_UI(params, id, name, value) \
     do { \
-        char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-        snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, \
-                 "iothread.%u.%s", id, name); \
-        if (virTypedParamsAddUInt(&(record)->params, \
-                                  &(record)->nparams, \
-                                  maxparams, \
-                                  param_name, \
-                                  value) < 0) \
+        if (virTypedParamListAddUInt(params, value, \
+                                     "iothread.%u.%s", id, name) < 0) \
             goto cleanup; \
     } while (0)
 
-#define QEMU_ADD_IOTHREAD_PARAM_ULL(record, maxparams, id, name, value) \
+#define QEMU_ADD_IOTHREAD_PARAM_ULL(params, id, name, value) \
 do { \
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH]; \
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, \
-             "iothread.%u.%s", id, name); \
-    if (virTypedParamsAddULLong(&(record)->params, \
-                                &(record)->nparams, \
-                                maxparams, \
-                                param_name, \
-                                value) < 0) \
+    if (virTypedParamListAddULLong(params, value, \
+                                   "iothread.%u.%s", id, name) < 0) \
         goto cleanup; \
 } while (0)
 
 static int
 qemuDomainGetStatsIOThread(virQEMUDriverPtr driver,
                            virDomainObjPtr dom,
-                           virDomainStatsRecordPtr record,
-                           int *maxparams,
+                           virTypedParamListPtr params,
                            unsigned int privflags ATTRIBUTE_UNUSED)
 {
     qemuDomainObjPrivatePtr priv = dom->privateData;
@@ -20967,20 +20816,35 @@ qemuDomainGetStatsIOThread(virQEMUDriverPtr driver,
     if (niothreads == 0)
         return 0;
 
-    QEMU_ADD_COUNT_PARAM(record, maxparams, "iothread", niothreads);
+    QEMU_ADD_COUNT_PARAM(params, "iothread", niothreads);
 
     for (i = 0; i < niothreads; i++) {
+        unsigned long long cpuTime;
+        unsigned long long cpuWait;
+
+        if (virProcStatCollectorGetStat(driver->procStats, dom->pid,
+                                        iothreads[i]->thread_id,
+                                        &cpuTime, NULL, NULL) == 0 &&
+            virProcStatCollectorGetSchedWait(driver->procStats, dom->pid,
+                                             iothreads[i]->thread_id,
+                                             &cpuWait) == 0) {
+            QEMU_ADD_IOTHREAD_PARAM_ULL(params, iothreads[i]->iothread_id,
+                                        "time", cpuTime);
+            QEMU_ADD_IOTHREAD_PARAM_ULL(params, iothreads[i]->iothread_id,
+                                        "wait", cpuWait);
+        } else {
+            /* it's ok to be silent and go ahead */
+            virResetLastError();
+        }
+
         if (iothreads[i]->poll_valid) {
-            QEMU_ADD_IOTHREAD_PARAM_ULL(record, maxparams,
-                                        iothreads[i]->iothread_id,
+            QEMU_ADD_IOTHREAD_PARAM_ULL(params, iothreads[i]->iothread_id,
                                         "poll-max-ns",
                                         iothreads[i]->poll_max_ns);
-            QEMU_ADD_IOTHREAD_PARAM_UI(record, maxparams,
-                                       iothreads[i]->iothread_id,
+            QEMU_ADD_IOTHREAD_PARAM_UI(params, iothreads[i]->iothread_id,
                                        "poll-grow",
                                        iothreads[i]->poll_grow);
-            QEMU_ADD_IOTHREAD_PARAM_UI(record, maxparams,
-                                       iothreads[i]->iothread_id,
+            QEMU_ADD_IOTHREAD_PARAM_UI(params, iothreads[i]->iothread_id,
                                        "poll-shrink",
                                        iothreads[i]->poll_shrink);
         }
@@ -21005,23 +20869,15 @@ qemuDomainGetStatsIOThread(virQEMUDriverPtr driver,
 static int
 qemuDomainGetStatsPerfOneEvent(virPerfPtr perf,
                                virPerfEventType type,
-                               virDomainStatsRecordPtr record,
-                               int *maxparams)
+                               virTypedParamListPtr params)
 {
-    char param_name[VIR_TYPED_PARAM_FIELD_LENGTH];
     uint64_t value = 0;
 
     if (virPerfReadEvent(perf, type, &value) < 0)
         return -1;
 
-    snprintf(param_name, VIR_TYPED_PARAM_FIELD_LENGTH, "perf.%s",
-             virPerfEventTypeToString(type));
-
-    if (virTypedParamsAddULLong(&record->params,
-                                &record->nparams,
-                                maxparams,
-                                param_name,
-                                value) < 0)
+    if (virTypedParamListAddULLong(params, value, "perf.%s",
+                                   virPerfEventTypeToString(type)) < 0)
         return -1;
 
     return 0;
@@ -21030,8 +20886,7 @@ qemuDomainGetStatsPerfOneEvent(virPerfPtr perf,
 static int
 qemuDomainGetStatsPerf(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
                        virDomainObjPtr dom,
-                       virDomainStatsRecordPtr record,
-                       int *maxparams,
+                       virTypedParamListPtr params,
                        unsigned int privflags ATTRIBUTE_UNUSED)
 {
     size_t i;
@@ -21042,8 +20897,7 @@ qemuDomainGetStatsPerf(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
         if (!virPerfEventIsEnabled(priv->perf, i))
              continue;
 
-        if (qemuDomainGetStatsPerfOneEvent(priv->perf, i,
-                                           record, maxparams) < 0)
+        if (qemuDomainGetStatsPerfOneEvent(priv->perf, i, params) < 0)
             goto cleanup;
     }
 
@@ -21056,8 +20910,7 @@ qemuDomainGetStatsPerf(virQEMUDriverPtr driver ATTRIBUTE_UNUSED,
 typedef int
 (*qemuDomainGetStatsFunc)(virQEMUDriverPtr driver,
                           virDomainObjPtr dom,
-                          virDomainStatsRecordPtr record,
-                          int *maxparams,
+                          virTypedParamListPtr params,
                           unsigned int flags);
 
 struct qemuDomainGetStatsWorker {
@@ -21128,36 +20981,282 @@ qemuDomainGetStats(virConnectPtr conn,
                    virDomainStatsRecordPtr *record,
                    unsigned int flags)
 {
-    int maxparams = 0;
+    qemuDomainObjPrivatePtr priv = dom->privateData;
+    VIR_AUTOPTR(virTypedParamList) params = NULL;
     virDomainStatsRecordPtr tmp;
     size_t i;
     int ret = -1;
 
-    if (VIR_ALLOC(tmp) < 0)
-        goto cleanup;
+    if (VIR_ALLOC(params) < 0)
+        return -1;
+
+    /* Records of a domain tend to be of the same size each time, so make
+     * room for as many parameters as the previous one had upfront. */
+    if (virTypedParamListReserve(params, priv->statsParamsHint) < 0)
+        return -1;
 
     for (i = 0; qemuDomainGetStatsWorkers[i].func; i++) {
         if (stats & qemuDomainGetStatsWorkers[i].stats) {
-            if (qemuDomainGetStatsWorkers[i].func(conn->privateData, dom, tmp,
-                                                  &maxparams, flags) < 0)
-                goto cleanup;
+            if (qemuDomainGetStatsWorkers[i].func(conn->privateData, dom,
+                                                  params, flags) < 0)
+                return -1;
         }
     }
 
+    if (VIR_ALLOC(tmp) < 0)
+        goto cleanup;
+
     if (!(tmp->dom = virGetDomain(conn, dom->def->name,
                                   dom->def->uuid, dom->def->id)))
         goto cleanup;
 
+    priv->statsParamsHint = params->npar;
+    tmp->nparams = virTypedParamListStealParams(params, &tmp->params);
     *record = tmp;
     tmp = NULL;
     ret = 0;
 
  cleanup:
-    if (tmp) {
-        virTypedParamsFree(tmp->params, tmp->nparams);
-        VIR_FREE(tmp);
+    VIR_FREE(tmp);
+    return ret;
+}
+
+
+/**
+ * qemuConnectGetAllDomainStatsOne:
+ * @driver: qemu driver
+ * @conn: connection the stats are gathered for
+ * @vm: domain object (unlocked)
+ * @stats: mask of stats groups to gather
+ * @privflags: QEMU_DOMAIN_STATS_* flags common to all domains
+ * @flags: flags passed to virConnectGetAllDomainStats
+ * @record: filled with the stats record of @vm
+ *
+ * Gathers stats of a single domain. Locks @vm and acquires a query
+ * job if any of the stats groups needs the monitor. If the job can't
+ * be acquired (because of VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT or
+ * because the job wait deadline expired) the record contains only the
+ * stats which don't need to talk to QEMU.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int
+qemuConnectGetAllDomainStatsOne(virQEMUDriverPtr driver,
+                                virConnectPtr conn,
+                                virDomainObjPtr vm,
+                                unsigned int stats,
+                                unsigned int privflags,
+                                unsigned int flags,
+                                virDomainStatsRecordPtr *record)
+{
+    virQEMUDriverConfigPtr cfg = virQEMUDriverGetConfig(driver);
+    unsigned int domflags = 0;
+    int ret = -1;
+
+    virObjectLock(vm);
+
+    if (HAVE_JOB(privflags)) {
+        int rv;
+
+        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
+            rv = qemuDomainObjBeginJobNowait(driver, vm, QEMU_JOB_QUERY);
+        else if (cfg->statsDomainTimeout)
+            rv = qemuDomainObjBeginJobTimeout(driver, vm, QEMU_JOB_QUERY,
+                                              cfg->statsDomainTimeout);
+        else
+            rv = qemuDomainObjBeginJob(driver, vm, QEMU_JOB_QUERY);
+
+        if (rv == 0)
+            domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
     }
+    /* else: without a job it's still possible to gather some data */
 
+    if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
+        domflags |= QEMU_DOMAIN_STATS_BACKING;
+    if (qemuDomainGetStats(conn, vm, stats, record, domflags) < 0)
+        goto endjob;
+
+    ret = 0;
+
+ endjob:
+    if (HAVE_JOB(domflags))
+        qemuDomainObjEndJob(driver, vm);
+
+    virObjectUnlock(vm);
+    virObjectUnref(cfg);
+    return ret;
+}
+
+
+typedef struct _qemuDomainGetStatsBatch qemuDomainGetStatsBatch;
+typedef qemuDomainGetStatsBatch *qemuDomainGetStatsBatchPtr;
+struct _qemuDomainGetStatsBatch {
+    virMutex lock;
+    virCond cond;
+    size_t pending; /* number of jobs not finished yet */
+
+    virConnectPtr conn;
+    unsigned int stats;
+    unsigned int privflags;
+    unsigned int flags;
+
+    virDomainStatsRecordPtr *records; /* indexed the same way as domains */
+    virErrorPtr err; /* first error encountered by any of the workers */
+};
+
+typedef struct _qemuDomainGetStatsBatchJob qemuDomainGetStatsBatchJob;
+typedef qemuDomainGetStatsBatchJob *qemuDomainGetStatsBatchJobPtr;
+struct _qemuDomainGetStatsBatchJob {
+    qemuDomainGetStatsBatchPtr batch;
+    virDomainObjPtr vm;
+    size_t idx;
+};
+
+
+static void
+qemuDomainGetStatsBatchJobDone(qemuDomainGetStatsBatchPtr batch,
+                               size_t idx,
+                               virDomainStatsRecordPtr record,
+                               bool failed)
+{
+    virMutexLock(&batch->lock);
+
+    batch->records[idx] = record;
+    if (failed && !batch->err)
+        batch->err = virSaveLastError();
+
+    if (--batch->pending == 0)
+        virCondSignal(&batch->cond);
+
+    virMutexUnlock(&batch->lock);
+}
+
+
+/**
+ * qemuConnectGetAllDomainStatsWorker:
+ *
+ * Job function of driver->statsPool. Gathers stats of one domain of a
+ * virConnectGetAllDomainStats call and stores the record in the slot
+ * reserved for the domain so that the order of records matches the
+ * order of domains.
+ */
+static void
+qemuConnectGetAllDomainStatsWorker(void *jobdata,
+                                   void *opaque)
+{
+    virQEMUDriverPtr driver = opaque;
+    qemuDomainGetStatsBatchJobPtr job = jobdata;
+    qemuDomainGetStatsBatchPtr batch = job->batch;
+    virDomainStatsRecordPtr record = NULL;
+    bool failed = false;
+
+    /* Skip the work if some other domain has already failed, the
+     * whole call is going to fail anyway. */
+    virMutexLock(&batch->lock);
+    failed = !!batch->err;
+    virMutexUnlock(&batch->lock);
+
+    if (!failed &&
+        qemuConnectGetAllDomainStatsOne(driver, batch->conn, job->vm,
+                                        batch->stats, batch->privflags,
+                                        batch->flags, &record) < 0)
+        failed = true;
+
+    qemuDomainGetStatsBatchJobDone(batch, job->idx, record, failed);
+    VIR_FREE(job);
+    virResetLastError();
+}
+
+
+/**
+ * qemuConnectGetAllDomainStatsParallel:
+ *
+ * Hands every domain in @vms over to driver->statsPool and waits until
+ * stats of all of them are gathered. Records are stored into @records
+ * in the order of @vms. Even on failure @records may contain some
+ * records which are then owned by the caller.
+ *
+ * Returns number of records on success, -1 on error.
+ */
+static int
+qemuConnectGetAllDomainStatsParallel(virQEMUDriverPtr driver,
+                                     virConnectPtr conn,
+                                     virDomainObjPtr *vms,
+                                     size_t nvms,
+                                     unsigned int stats,
+                                     unsigned int privflags,
+                                     unsigned int flags,
+                                     virDomainStatsRecordPtr *records)
+{
+    qemuDomainGetStatsBatch batch;
+    qemuDomainGetStatsBatchJobPtr job = NULL;
+    int nrecords = 0;
+    size_t i;
+    int ret = -1;
+
+    memset(&batch, 0, sizeof(batch));
+
+    if (virMutexInit(&batch.lock) < 0) {
+        virReportSystemError(errno, "%s", _("cannot initialize mutex"));
+        return -1;
+    }
+    if (virCondInit(&batch.cond) < 0) {
+        virReportSystemError(errno, "%s", _("cannot initialize condition"));
+        virMutexDestroy(&batch.lock);
+        return -1;
+    }
+
+    batch.conn = conn;
+    batch.stats = stats;
+    batch.privflags = privflags;
+    batch.flags = flags;
+
+    if (VIR_ALLOC_N(batch.records, nvms) < 0)
+        goto cleanup;
+
+    virMutexLock(&batch.lock);
+    for (i = 0; i < nvms && !batch.err; i++) {
+        if (VIR_ALLOC(job) < 0) {
+            batch.err = virSaveLastError();
+            break;
+        }
+
+        job->batch = &batch;
+        job->vm = vms[i];
+        job->idx = i;
+
+        if (virThreadPoolSendJob(driver->statsPool, 0, job) < 0) {
+            VIR_FREE(job);
+            batch.err = virSaveLastError();
+            break;
+        }
+        batch.pending++;
+        job = NULL;
+    }
+
+    /* Workers reference @batch which lives on our stack, so we have to
+     * wait for all of them even if we failed to dispatch some domains. */
+    while (batch.pending)
+        ignore_value(virCondWait(&batch.cond, &batch.lock));
+    virMutexUnlock(&batch.lock);
+
+    for (i = 0; i < nvms; i++) {
+        if (batch.records[i])
+            records[nrecords++] = batch.records[i];
+    }
+
+    if (batch.err) {
+        virSetError(batch.err);
+        goto cleanup;
+    }
+
+    ret = nrecords;
+
+ cleanup:
+    VIR_FREE(batch.records);
+    virFreeError(batch.err);
+    virCondDestroy(&batch.cond);
+    virMutexDestroy(&batch.lock);
     return ret;
 }
 
@@ -21173,7 +21272,6 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
     virQEMUDriverPtr driver = conn->privateData;
     virErrorPtr orig_err = NULL;
     virDomainObjPtr *vms = NULL;
-    virDomainObjPtr vm;
     size_t nvms;
     virDomainStatsRecordPtr *tmpstats = NULL;
     bool enforce = !!(flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS);
@@ -21181,7 +21279,6 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
     size_t i;
     int ret = -1;
     unsigned int privflags = 0;
-    unsigned int domflags = 0;
     unsigned int lflags = flags & (VIR_CONNECT_LIST_DOMAINS_FILTERS_ACTIVE |
                                    VIR_CONNECT_LIST_DOMAINS_FILTERS_PERSISTENT |
                                    VIR_CONNECT_LIST_DOMAINS_FILTERS_STATE);
@@ -21217,43 +21314,24 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
     if (qemuDomainGetStatsNeedMonitor(stats))
         privflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
 
-    for (i = 0; i < nvms; i++) {
-        virDomainStatsRecordPtr tmp = NULL;
-        domflags = 0;
-        vm = vms[i];
-
-        virObjectLock(vm);
-
-        if (HAVE_JOB(privflags)) {
-            int rv;
-
-            if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
-                rv = qemuDomainObjBeginJobNowait(driver, vm, QEMU_JOB_QUERY);
-            else
-                rv = qemuDomainObjBeginJob(driver, vm, QEMU_JOB_QUERY);
-
-            if (rv == 0)
-                domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
-        }
-        /* else: without a job it's still possible to gather some data */
-
-        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
-            domflags |= QEMU_DOMAIN_STATS_BACKING;
-        if (qemuDomainGetStats(conn, vm, stats, &tmp, domflags) < 0) {
-            if (HAVE_JOB(domflags) && vm)
-                qemuDomainObjEndJob(driver, vm);
-
-            virObjectUnlock(vm);
+    if (driver->statsPool && nvms > 1) {
+        if ((nstats = qemuConnectGetAllDomainStatsParallel(driver, conn,
+                                                           vms, nvms,
+                                                           stats, privflags,
+                                                           flags,
+                                                           tmpstats)) < 0)
             goto cleanup;
-        }
-
-        if (tmp)
-            tmpstats[nstats++] = tmp;
+    } else {
+        for (i = 0; i < nvms; i++) {
+            virDomainStatsRecordPtr tmp = NULL;
 
-        if (HAVE_JOB(domflags))
-            qemuDomainObjEndJob(driver, vm);
+            if (qemuConnectGetAllDomainStatsOne(driver, conn, vms[i], stats,
+                                                privflags, flags, &tmp) < 0)
+                goto cleanup;
 
-        virObjectUnlock(vm);
+            if (tmp)
+                tmpstats[nstats++] = tmp;
+        }
     }
 
     *retStats = tmpstats;
@@ -21271,6 +21349,46 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
 }
 
 
+static int
+qemuConnectLookupDomainsByUUID(virConnectPtr conn,
+                               const unsigned char *uuids,
+                               unsigned int nuuids,
+                               virDomainPtr **domains,
+                               int **states,
+                               unsigned int flags)
+{
+    virQEMUDriverPtr driver = conn->privateData;
+
+    virCheckFlags(0, -1);
+
+    if (virConnectLookupDomainsByUUIDEnsureACL(conn) < 0)
+        return -1;
+
+    return virDomainObjListLookupUUIDs(driver->domains, conn, uuids, nuuids,
+                                       domains, states,
+                                       virConnectLookupDomainsByUUIDCheckACL);
+}
+
+
+static int
+qemuDomainListLifecycle(virConnectPtr conn,
+                        virDomainPtr *doms,
+                        unsigned int ndoms,
+                        int action,
+                        int **errors,
+                        unsigned int flags)
+{
+    virQEMUDriverPtr driver = conn->privateData;
+
+    return virDomainObjListLifecycle(driver->domains, conn, doms, ndoms,
+                                     action, errors, flags,
+                                     virDomainListLifecycleEnsureACL,
+                                     qemuDomainCreateWithFlags,
+                                     qemuDomainShutdownFlags,
+                                     qemuDomainDestroyFlags);
+}
+
+
 static int
 qemuNodeAllocPages(virConnectPtr conn,
                    unsigned int npages,
@@ -22591,6 +22709,8 @@ static virHypervisorDriver qemuHypervisorDriver = {
     .connectBaselineHypervisorCPU = qemuConnectBaselineHypervisorCPU, /* 4.4.0 */
     .nodeGetSEVInfo = qemuNodeGetSEVInfo, /* 4.5.0 */
     .domainGetLaunchSecurityInfo = qemuDomainGetLaunchSecurityInfo, /* 4.5.0 */
+    .connectLookupDomainsByUUID = qemuConnectLookupDomainsByUUID, /* 5.1.0 */
+    .domainListLifecycle = qemuDomainListLifecycle, /* 5.1.0 */
 };
 
 
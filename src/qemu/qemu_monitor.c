@@ -80,14 +80,18 @@ struct _qemuMonitor {
     int watch;
     int hasSendFD;
 
+    /* Event loop watching @fd, the main one if NULL */
+    virEventThreadPtr eventThread;
+
     virDomainObjPtr vm;
 
     qemuMonitorCallbacksPtr cb;
     void *callbackOpaque;
 
-    /* If there's a command being processed this will be
-     * non-NULL */
-    qemuMonitorMessagePtr msg;
+    /* Commands being written or waiting for their reply, in the
+     * order they are sent to QEMU in */
+    qemuMonitorMessagePtr *msgs;
+    size_t nmsgs;
 
     /* Buffer incoming data ready for Text/QMP monitor
      * code to process & find message boundaries */
@@ -327,6 +331,8 @@ qemuMonitorDispose(void *obj)
     virResetError(&mon->lastError);
     virCondDestroy(&mon->notify);
     VIR_FREE(mon->buffer);
+    VIR_FREE(mon->msgs);
+    virObjectUnref(mon->eventThread);
     virJSONValueFree(mon->options);
     VIR_FREE(mon->balloonpath);
 }
@@ -415,6 +421,84 @@ qemuMonitorOpenPty(const char *monitor)
 }
 
 
+/* Returns the first message which was not written completely yet */
+static qemuMonitorMessagePtr
+qemuMonitorGetWriteMessage(qemuMonitorPtr mon)
+{
+    size_t i;
+
+    for (i = 0; i < mon->nmsgs; i++) {
+        if (mon->msgs[i]->txOffset < mon->msgs[i]->txLength)
+            return mon->msgs[i];
+    }
+
+    return NULL;
+}
+
+
+/**
+ * qemuMonitorGetReplyMessage:
+ * @mon: the locked monitor
+ * @id: ID of the reply, may be NULL
+ *
+ * Looks up the message which was sent with @id. QEMU replies to
+ * commands in the order it received them though, so if @id is NULL
+ * or unknown the reply belongs to the oldest command which did not
+ * get one yet. That command must have been written completely, any
+ * other reply is not one we are waiting for.
+ *
+ * For use by the JSON monitor code only.
+ *
+ * Returns the message the reply belongs to, or NULL if there is none
+ */
+qemuMonitorMessagePtr
+qemuMonitorGetReplyMessage(qemuMonitorPtr mon,
+                           const char *id)
+{
+    qemuMonitorMessagePtr oldest = NULL;
+    size_t i;
+
+    for (i = 0; i < mon->nmsgs; i++) {
+        qemuMonitorMessagePtr msg = mon->msgs[i];
+
+        if (msg->finished)
+            continue;
+
+        if (msg->txOffset < msg->txLength)
+            break;
+
+        if (!id || STREQ_NULLABLE(msg->id, id))
+            return msg;
+
+        if (!oldest)
+            oldest = msg;
+    }
+
+    return oldest;
+}
+
+
+/* Wakes up the threads waiting for their commands, marking all the
+ * commands as finished first if @error is true */
+static void
+qemuMonitorWakeupMessages(qemuMonitorPtr mon,
+                          bool error)
+{
+    bool finished = false;
+    size_t i;
+
+    for (i = 0; i < mon->nmsgs; i++) {
+        if (error)
+            mon->msgs[i]->finished = 1;
+        if (mon->msgs[i]->finished)
+            finished = true;
+    }
+
+    if (finished)
+        virCondBroadcast(&mon->notify);
+}
+
+
 /* This method processes data that has been received
  * from the monitor. Looking for async events and
  * replies/errors.
@@ -423,18 +507,13 @@ static int
 qemuMonitorIOProcess(qemuMonitorPtr mon)
 {
     int len;
-    qemuMonitorMessagePtr msg = NULL;
-
-    /* See if there's a message & whether its ready for its reply
-     * ie whether its completed writing all its data */
-    if (mon->msg && mon->msg->txOffset == mon->msg->txLength)
-        msg = mon->msg;
 
 #if DEBUG_IO
 # if DEBUG_RAW_IO
+    qemuMonitorMessagePtr msg = qemuMonitorGetReplyMessage(mon, NULL);
     char *str1 = qemuMonitorEscapeNonPrintable(msg ? msg->txBuffer : "");
     char *str2 = qemuMonitorEscapeNonPrintable(mon->buffer);
-    VIR_ERROR(_("Process %d %p %p [[[[%s]]][[[%s]]]"), (int)mon->bufferOffset, mon->msg, msg, str1, str2);
+    VIR_ERROR(_("Process %d %zu %p [[[[%s]]][[[%s]]]"), (int)mon->bufferOffset, mon->nmsgs, msg, str1, str2);
     VIR_FREE(str1);
     VIR_FREE(str2);
 # else
@@ -446,8 +525,7 @@ qemuMonitorIOProcess(qemuMonitorPtr mon)
                 mon, mon->buffer, mon->bufferOffset);
 
     len = qemuMonitorJSONIOProcess(mon,
-                                   mon->buffer, mon->bufferOffset,
-                                   msg);
+                                   mon->buffer, mon->bufferOffset);
     if (len < 0)
         return -1;
 
@@ -465,11 +543,7 @@ qemuMonitorIOProcess(qemuMonitorPtr mon)
     VIR_DEBUG("Process done %d used %d", (int)mon->bufferOffset, len);
 #endif
 
-    /* As the monitor mutex was unlocked in qemuMonitorJSONIOProcess()
-     * while dealing with qemu event, mon->msg could be changed which
-     * means the above 'msg' may be invalid, thus we use 'mon->msg' here */
-    if (mon->msg && mon->msg->finished)
-        virCondBroadcast(&mon->notify);
+    qemuMonitorWakeupMessages(mon, false);
     return len;
 }
 
@@ -519,51 +593,62 @@ qemuMonitorIOWriteWithFD(qemuMonitorPtr mon,
 /*
  * Called when the monitor is able to write data
  * Call this function while holding the monitor lock.
+ *
+ * Writes as many of the queued messages as the socket
+ * takes without blocking, so that a batch of commands
+ * reaches QEMU without waiting for the replies in between.
  */
 static int
 qemuMonitorIOWrite(qemuMonitorPtr mon)
 {
+    qemuMonitorMessagePtr msg;
+    int total = 0;
     int done;
     char *buf;
     size_t len;
 
-    /* If no active message, or fully transmitted, the no-op */
-    if (!mon->msg || mon->msg->txOffset == mon->msg->txLength)
-        return 0;
+    /* If no active message, or all fully transmitted, the no-op */
+    while ((msg = qemuMonitorGetWriteMessage(mon))) {
+        if (msg->txFD != -1 && !mon->hasSendFD) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("Monitor does not support sending of file descriptors"));
+            return -1;
+        }
 
-    if (mon->msg->txFD != -1 && !mon->hasSendFD) {
-        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
-                       _("Monitor does not support sending of file descriptors"));
-        return -1;
-    }
+        buf = msg->txBuffer + msg->txOffset;
+        len = msg->txLength - msg->txOffset;
+        if (msg->txFD == -1)
+            done = write(mon->fd, buf, len);
+        else
+            done = qemuMonitorIOWriteWithFD(mon, buf, len, msg->txFD);
 
-    buf = mon->msg->txBuffer + mon->msg->txOffset;
-    len = mon->msg->txLength - mon->msg->txOffset;
-    if (mon->msg->txFD == -1)
-        done = write(mon->fd, buf, len);
-    else
-        done = qemuMonitorIOWriteWithFD(mon, buf, len, mon->msg->txFD);
+        PROBE(QEMU_MONITOR_IO_WRITE,
+              "mon=%p buf=%s len=%zu ret=%d errno=%d",
+              mon, buf, len, done, done < 0 ? errno : 0);
 
-    PROBE(QEMU_MONITOR_IO_WRITE,
-          "mon=%p buf=%s len=%zu ret=%d errno=%d",
-          mon, buf, len, done, done < 0 ? errno : 0);
+        if (msg->txFD != -1) {
+            PROBE(QEMU_MONITOR_IO_SEND_FD,
+                  "mon=%p fd=%d ret=%d errno=%d",
+                  mon, msg->txFD, done, done < 0 ? errno : 0);
+        }
 
-    if (mon->msg->txFD != -1) {
-        PROBE(QEMU_MONITOR_IO_SEND_FD,
-              "mon=%p fd=%d ret=%d errno=%d",
-              mon, mon->msg->txFD, done, done < 0 ? errno : 0);
-    }
+        if (done < 0) {
+            if (errno == EAGAIN)
+                break;
 
-    if (done < 0) {
-        if (errno == EAGAIN)
-            return 0;
+            virReportSystemError(errno, "%s",
+                                 _("Unable to write to monitor"));
+            return -1;
+        }
+        msg->txOffset += done;
+        total += done;
 
-        virReportSystemError(errno, "%s",
-                             _("Unable to write to monitor"));
-        return -1;
+        /* Short write, the socket is full */
+        if (done < len)
+            break;
     }
-    mon->msg->txOffset += done;
-    return done;
+
+    return total;
 }
 
 
@@ -638,12 +723,15 @@ qemuMonitorUpdateWatch(qemuMonitorPtr mon)
     if (mon->lastError.code == VIR_ERR_OK) {
         events |= VIR_EVENT_HANDLE_READABLE;
 
-        if ((mon->msg && mon->msg->txOffset < mon->msg->txLength) &&
+        if (qemuMonitorGetWriteMessage(mon) &&
             !mon->waitGreeting)
             events |= VIR_EVENT_HANDLE_WRITABLE;
     }
 
-    virEventUpdateHandle(mon->watch, events);
+    if (mon->eventThread)
+        virEventThreadUpdateHandle(mon->eventThread, mon->watch, events);
+    else
+        virEventUpdateHandle(mon->watch, events);
 }
 
 
@@ -761,12 +849,9 @@ qemuMonitorIO(int watch, int fd, int events, void *opaque)
         }
 
         VIR_DEBUG("Error on monitor %s", NULLSTR(mon->lastError.message));
-        /* If IO process resulted in an error & we have a message,
-         * then wakeup that waiter */
-        if (mon->msg && !mon->msg->finished) {
-            mon->msg->finished = 1;
-            virCondSignal(&mon->notify);
-        }
+        /* If IO process resulted in an error & we have messages,
+         * then wakeup their waiters */
+        qemuMonitorWakeupMessages(mon, true);
     }
 
     qemuMonitorUpdateWatch(mon);
@@ -806,6 +891,7 @@ qemuMonitorOpenInternal(virDomainObjPtr vm,
                         int fd,
                         bool hasSendFD,
                         bool json,
+                        virEventThreadPtr eventThread,
                         qemuMonitorCallbacksPtr cb,
                         void *opaque)
 {
@@ -836,6 +922,7 @@ qemuMonitorOpenInternal(virDomainObjPtr vm,
     mon->fd = fd;
     mon->hasSendFD = hasSendFD;
     mon->vm = virObjectRef(vm);
+    mon->eventThread = virObjectRef(eventThread);
     mon->json = json;
     if (json)
         mon->waitGreeting = true;
@@ -891,6 +978,7 @@ qemuMonitorOpenInternal(virDomainObjPtr vm,
  * @config: monitor configuration
  * @json: enable JSON on the monitor
  * @timeout: number of seconds to add to default timeout
+ * @eventThread: event loop to watch the monitor in, NULL for the main one
  * @cb: monitor event handles
  * @opaque: opaque data for @cb
  *
@@ -908,6 +996,7 @@ qemuMonitorOpen(virDomainObjPtr vm,
                 bool json,
                 bool retry,
                 unsigned long long timeout,
+                virEventThreadPtr eventThread,
                 qemuMonitorCallbacksPtr cb,
                 void *opaque)
 {
@@ -937,7 +1026,8 @@ qemuMonitorOpen(virDomainObjPtr vm,
         return NULL;
     }
 
-    ret = qemuMonitorOpenInternal(vm, fd, hasSendFD, json, cb, opaque);
+    ret = qemuMonitorOpenInternal(vm, fd, hasSendFD, json, eventThread,
+                                  cb, opaque);
     if (!ret)
         VIR_FORCE_CLOSE(fd);
     return ret;
@@ -951,7 +1041,7 @@ qemuMonitorOpenFD(virDomainObjPtr vm,
                   qemuMonitorCallbacksPtr cb,
                   void *opaque)
 {
-    return qemuMonitorOpenInternal(vm, sockfd, true, json, cb, opaque);
+    return qemuMonitorOpenInternal(vm, sockfd, true, json, NULL, cb, opaque);
 }
 
 
@@ -967,14 +1057,21 @@ qemuMonitorOpenFD(virDomainObjPtr vm,
 bool
 qemuMonitorRegister(qemuMonitorPtr mon)
 {
+    int events = VIR_EVENT_HANDLE_HANGUP |
+                 VIR_EVENT_HANDLE_ERROR |
+                 VIR_EVENT_HANDLE_READABLE;
+
     virObjectRef(mon);
-    if ((mon->watch = virEventAddHandle(mon->fd,
-                                        VIR_EVENT_HANDLE_HANGUP |
-                                        VIR_EVENT_HANDLE_ERROR |
-                                        VIR_EVENT_HANDLE_READABLE,
-                                        qemuMonitorIO,
-                                        mon,
-                                        virObjectFreeCallback)) < 0) {
+    if (mon->eventThread)
+        mon->watch = virEventThreadAddHandle(mon->eventThread, mon->fd, events,
+                                             qemuMonitorIO, mon,
+                                             virObjectFreeCallback);
+    else
+        mon->watch = virEventAddHandle(mon->fd, events,
+                                       qemuMonitorIO, mon,
+                                       virObjectFreeCallback);
+
+    if (mon->watch < 0) {
         virObjectUnref(mon);
         return false;
     }
@@ -987,7 +1084,10 @@ void
 qemuMonitorUnregister(qemuMonitorPtr mon)
 {
     if (mon->watch) {
-        virEventRemoveHandle(mon->watch);
+        if (mon->eventThread)
+            virEventThreadRemoveHandle(mon->eventThread, mon->watch);
+        else
+            virEventRemoveHandle(mon->watch);
         mon->watch = 0;
     }
 }
@@ -1012,7 +1112,7 @@ qemuMonitorClose(qemuMonitorPtr mon)
     /* In case another thread is waiting for its monitor command to be
      * processed, we need to wake it up with appropriate error set.
      */
-    if (mon->msg) {
+    if (mon->nmsgs) {
         if (mon->lastError.code == VIR_ERR_OK) {
             virErrorPtr err = virSaveLastError();
 
@@ -1026,8 +1126,7 @@ qemuMonitorClose(qemuMonitorPtr mon)
                 virResetLastError();
             }
         }
-        mon->msg->finished = 1;
-        virCondSignal(&mon->notify);
+        qemuMonitorWakeupMessages(mon, true);
     }
 
     /* Propagate existing monitor error in case the current thread has no
@@ -1059,10 +1158,26 @@ qemuMonitorResetCommandID(qemuMonitorPtr mon)
 }
 
 
+/**
+ * qemuMonitorSendBatch:
+ * @mon: the locked monitor
+ * @msgs: the messages to send
+ * @nmsgs: number of messages in @msgs
+ *
+ * Sends all of @msgs to QEMU at once and waits until each of them
+ * got its reply. Compared to sending them one by one this saves a
+ * round trip through the event loop and QEMU for every message but
+ * the first one.
+ *
+ * Returns 0 on success, -1 on error
+ */
 int
-qemuMonitorSend(qemuMonitorPtr mon,
-                qemuMonitorMessagePtr msg)
+qemuMonitorSendBatch(qemuMonitorPtr mon,
+                     qemuMonitorMessagePtr *msgs,
+                     size_t nmsgs)
 {
+    size_t i;
+    size_t j;
     int ret = -1;
 
     /* Check whether qemu quit unexpectedly */
@@ -1073,18 +1188,25 @@ qemuMonitorSend(qemuMonitorPtr mon,
         return -1;
     }
 
-    mon->msg = msg;
+    if (VIR_REALLOC_N(mon->msgs, mon->nmsgs + nmsgs) < 0)
+        return -1;
+    memcpy(mon->msgs + mon->nmsgs, msgs, nmsgs * sizeof(*msgs));
+    mon->nmsgs += nmsgs;
     qemuMonitorUpdateWatch(mon);
 
-    PROBE(QEMU_MONITOR_SEND_MSG,
-          "mon=%p msg=%s fd=%d",
-          mon, mon->msg->txBuffer, mon->msg->txFD);
+    for (i = 0; i < nmsgs; i++) {
+        PROBE(QEMU_MONITOR_SEND_MSG,
+              "mon=%p msg=%s fd=%d",
+              mon, msgs[i]->txBuffer, msgs[i]->txFD);
+    }
 
-    while (!mon->msg->finished) {
-        if (virCondWait(&mon->notify, &mon->parent.lock) < 0) {
-            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
-                           _("Unable to wait on monitor condition"));
-            goto cleanup;
+    for (i = 0; i < nmsgs; i++) {
+        while (!msgs[i]->finished) {
+            if (virCondWait(&mon->notify, &mon->parent.lock) < 0) {
+                virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                               _("Unable to wait on monitor condition"));
+                goto cleanup;
+            }
         }
     }
 
@@ -1098,13 +1220,28 @@ qemuMonitorSend(qemuMonitorPtr mon,
     ret = 0;
 
  cleanup:
-    mon->msg = NULL;
+    for (i = 0; i < nmsgs; i++) {
+        for (j = 0; j < mon->nmsgs; j++) {
+            if (mon->msgs[j] == msgs[i]) {
+                VIR_DELETE_ELEMENT(mon->msgs, j, mon->nmsgs);
+                break;
+            }
+        }
+    }
     qemuMonitorUpdateWatch(mon);
 
     return ret;
 }
 
 
+int
+qemuMonitorSend(qemuMonitorPtr mon,
+                qemuMonitorMessagePtr msg)
+{
+    return qemuMonitorSendBatch(mon, &msg, 1);
+}
+
+
 /**
  * This function returns a new virError object; the caller is responsible
  * for freeing it.
@@ -2338,6 +2475,57 @@ qemuMonitorBlockStatsUpdateCapacityBlockdev(qemuMonitorPtr mon,
     return qemuMonitorJSONBlockStatsUpdateCapacityBlockdev(mon, stats);
 }
 
+
+/**
+ * qemuMonitorGetAllBlockStatsAndCapacity:
+ * @mon: monitor object
+ * @ret_stats: pointer that is filled with a hash table containing the stats
+ * @backingChain: recurse into the backing chain of devices
+ * @blockdev: whether the domain uses -blockdev
+ * @nodedata: filled with the data of all the block nodes, may be NULL
+ *
+ * Equivalent to qemuMonitorGetAllBlockStatsInfo followed by
+ * qemuMonitorBlockStatsUpdateCapacity (or its blockdev variant) and
+ * qemuMonitorQueryNamedBlockNodes, but needs a single round trip to
+ * QEMU. Failing to get the capacity or @nodedata is not an error, the
+ * stats are left without capacity and @nodedata is set to NULL.
+ *
+ * Returns < 0 on error, count of supported block stats fields on success.
+ */
+int
+qemuMonitorGetAllBlockStatsAndCapacity(qemuMonitorPtr mon,
+                                       virHashTablePtr *ret_stats,
+                                       bool backingChain,
+                                       bool blockdev,
+                                       virJSONValuePtr *nodedata)
+{
+    int ret = -1;
+    VIR_DEBUG("ret_stats=%p, backing=%d, blockdev=%d, nodedata=%p",
+              ret_stats, backingChain, blockdev, nodedata);
+
+    if (nodedata)
+        *nodedata = NULL;
+
+    QEMU_CHECK_MONITOR(mon);
+
+    if (!(*ret_stats = virHashCreate(10, virHashValueFree)))
+        goto error;
+
+    ret = qemuMonitorJSONGetAllBlockStatsAndCapacity(mon, *ret_stats,
+                                                     backingChain, blockdev,
+                                                     nodedata);
+
+    if (ret < 0)
+        goto error;
+
+    return ret;
+
+ error:
+    virHashFree(*ret_stats);
+    *ret_stats = NULL;
+    return -1;
+}
+
 int
 qemuMonitorBlockResize(qemuMonitorPtr mon,
                        const char *device,
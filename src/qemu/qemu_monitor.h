@@ -28,6 +28,7 @@
 # include "virbitmap.h"
 # include "virhash.h"
 # include "virjson.h"
+# include "vireventthread.h"
 # include "virnetdev.h"
 # include "device_conf.h"
 # include "cpu/cpu.h"
@@ -48,6 +49,9 @@ typedef int (*qemuMonitorPasswordHandler)(qemuMonitorPtr mon,
 struct _qemuMonitorMessage {
     int txFD;
 
+    /* ID of the JSON command, if any, which QEMU puts into its reply */
+    char *id;
+
     char *txBuffer;
     int txOffset;
     int txLength;
@@ -342,9 +346,10 @@ qemuMonitorPtr qemuMonitorOpen(virDomainObjPtr vm,
                                bool json,
                                bool retry,
                                unsigned long long timeout,
+                               virEventThreadPtr eventThread,
                                qemuMonitorCallbacksPtr cb,
                                void *opaque)
-    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(6);
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(7);
 qemuMonitorPtr qemuMonitorOpenFD(virDomainObjPtr vm,
                                  int sockfd,
                                  bool json,
@@ -371,6 +376,11 @@ int qemuMonitorSetLink(qemuMonitorPtr mon,
 char *qemuMonitorNextCommandID(qemuMonitorPtr mon);
 int qemuMonitorSend(qemuMonitorPtr mon,
                     qemuMonitorMessagePtr msg);
+int qemuMonitorSendBatch(qemuMonitorPtr mon,
+                         qemuMonitorMessagePtr *msgs,
+                         size_t nmsgs);
+qemuMonitorMessagePtr qemuMonitorGetReplyMessage(qemuMonitorPtr mon,
+                                                 const char *id);
 virJSONValuePtr qemuMonitorGetOptions(qemuMonitorPtr mon)
     ATTRIBUTE_NONNULL(1);
 void qemuMonitorSetOptions(qemuMonitorPtr mon, virJSONValuePtr options)
@@ -630,6 +640,13 @@ int qemuMonitorBlockStatsUpdateCapacityBlockdev(qemuMonitorPtr mon,
                                                 virHashTablePtr stats)
     ATTRIBUTE_NONNULL(2);
 
+int qemuMonitorGetAllBlockStatsAndCapacity(qemuMonitorPtr mon,
+                                           virHashTablePtr *ret_stats,
+                                           bool backingChain,
+                                           bool blockdev,
+                                           virJSONValuePtr *nodedata)
+    ATTRIBUTE_NONNULL(2);
+
 int qemuMonitorBlockResize(qemuMonitorPtr mon,
                            const char *device,
                            const char *nodename,
@@ -212,8 +212,16 @@ qemuMonitorJSONIOProcessLine(qemuMonitorPtr mon,
         ret = qemuMonitorJSONIOProcessEvent(mon, obj);
     } else if (virJSONValueObjectHasKey(obj, "error") == 1 ||
                virJSONValueObjectHasKey(obj, "return") == 1) {
+        const char *id = virJSONValueObjectGetString(obj, "id");
+
         PROBE(QEMU_MONITOR_RECV_REPLY,
               "mon=%p reply=%s", mon, line);
+
+        /* @msg is the oldest command waiting for its reply, which is
+         * where the reply belongs to unless its ID says otherwise */
+        if (msg && id && STRNEQ_NULLABLE(id, msg->id))
+            msg = qemuMonitorGetReplyMessage(mon, id);
+
         if (msg) {
             msg->rxObject = obj;
             msg->finished = 1;
@@ -235,8 +243,7 @@ qemuMonitorJSONIOProcessLine(qemuMonitorPtr mon,
 
 int qemuMonitorJSONIOProcess(qemuMonitorPtr mon,
                              const char *data,
-                             size_t len,
-                             qemuMonitorMessagePtr msg)
+                             size_t len)
 {
     int used = 0;
     /*VIR_DEBUG("Data %d bytes [%s]", len, data);*/
@@ -251,7 +258,10 @@ int qemuMonitorJSONIOProcess(qemuMonitorPtr mon,
                 return -1;
             used += got + strlen(LINE_ENDING);
             line[got] = '\0'; /* kill \n */
-            if (qemuMonitorJSONIOProcessLine(mon, line, msg) < 0) {
+            /* Look the message up for every line as processing an event
+             * unlocks the monitor */
+            if (qemuMonitorJSONIOProcessLine(mon, line,
+                                             qemuMonitorGetReplyMessage(mon, NULL)) < 0) {
                 VIR_FREE(line);
                 return -1;
             }
@@ -270,24 +280,20 @@ int qemuMonitorJSONIOProcess(qemuMonitorPtr mon,
 }
 
 static int
-qemuMonitorJSONCommandWithFd(qemuMonitorPtr mon,
-                             virJSONValuePtr cmd,
-                             int scm_fd,
-                             virJSONValuePtr *reply)
+qemuMonitorJSONMessageInit(qemuMonitorPtr mon,
+                           virJSONValuePtr cmd,
+                           int scm_fd,
+                           qemuMonitorMessagePtr msg)
 {
-    int ret = -1;
-    qemuMonitorMessage msg;
     char *cmdstr = NULL;
-    char *id = NULL;
-
-    *reply = NULL;
+    int ret = -1;
 
-    memset(&msg, 0, sizeof(msg));
+    memset(msg, 0, sizeof(*msg));
 
     if (virJSONValueObjectHasKey(cmd, "execute") == 1) {
-        if (!(id = qemuMonitorNextCommandID(mon)))
+        if (!(msg->id = qemuMonitorNextCommandID(mon)))
             goto cleanup;
-        if (virJSONValueObjectAppendString(cmd, "id", id) < 0) {
+        if (virJSONValueObjectAppendString(cmd, "id", msg->id) < 0) {
             virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
                            _("Unable to append command 'id' string"));
             goto cleanup;
@@ -296,13 +302,43 @@ qemuMonitorJSONCommandWithFd(qemuMonitorPtr mon,
 
     if (!(cmdstr = virJSONValueToString(cmd, false)))
         goto cleanup;
-    if (virAsprintf(&msg.txBuffer, "%s\r\n", cmdstr) < 0)
+    if (virAsprintf(&msg->txBuffer, "%s\r\n", cmdstr) < 0)
         goto cleanup;
-    msg.txLength = strlen(msg.txBuffer);
-    msg.txFD = scm_fd;
+    msg->txLength = strlen(msg->txBuffer);
+    msg->txFD = scm_fd;
 
     VIR_DEBUG("Send command '%s' for write with FD %d", cmdstr, scm_fd);
 
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(cmdstr);
+    return ret;
+}
+
+
+static void
+qemuMonitorJSONMessageClear(qemuMonitorMessagePtr msg)
+{
+    VIR_FREE(msg->id);
+    VIR_FREE(msg->txBuffer);
+}
+
+
+static int
+qemuMonitorJSONCommandWithFd(qemuMonitorPtr mon,
+                             virJSONValuePtr cmd,
+                             int scm_fd,
+                             virJSONValuePtr *reply)
+{
+    int ret = -1;
+    qemuMonitorMessage msg;
+
+    *reply = NULL;
+
+    if (qemuMonitorJSONMessageInit(mon, cmd, scm_fd, &msg) < 0)
+        goto cleanup;
+
     ret = qemuMonitorSend(mon, &msg);
 
     VIR_DEBUG("Receive command reply ret=%d rxObject=%p",
@@ -320,10 +356,78 @@ qemuMonitorJSONCommandWithFd(qemuMonitorPtr mon,
     }
 
  cleanup:
-    VIR_FREE(id);
-    VIR_FREE(cmdstr);
-    VIR_FREE(msg.txBuffer);
+    qemuMonitorJSONMessageClear(&msg);
+
+    return ret;
+}
+
 
+/**
+ * qemuMonitorJSONCommands:
+ * @mon: the monitor
+ * @cmds: the commands to execute
+ * @ncmds: number of commands in @cmds
+ * @replies: filled with the reply to each command
+ *
+ * Like qemuMonitorJSONCommand but sends all of @cmds to QEMU before
+ * waiting for the first reply. The replies still need to be checked
+ * with qemuMonitorJSONCheckError, one failed command doesn't stop QEMU
+ * from running the following ones.
+ *
+ * Returns 0 on success, -1 on error with all of @replies set to NULL
+ */
+static int
+qemuMonitorJSONCommands(qemuMonitorPtr mon,
+                        virJSONValuePtr *cmds,
+                        size_t ncmds,
+                        virJSONValuePtr *replies)
+{
+    qemuMonitorMessagePtr msgs = NULL;
+    qemuMonitorMessagePtr *msgptrs = NULL;
+    size_t nmsgs = 0;
+    size_t i;
+    int ret = -1;
+
+    for (i = 0; i < ncmds; i++)
+        replies[i] = NULL;
+
+    if (VIR_ALLOC_N(msgs, ncmds) < 0 ||
+        VIR_ALLOC_N(msgptrs, ncmds) < 0)
+        goto cleanup;
+
+    for (nmsgs = 0; nmsgs < ncmds; nmsgs++) {
+        if (qemuMonitorJSONMessageInit(mon, cmds[nmsgs], -1, &msgs[nmsgs]) < 0)
+            goto cleanup;
+        msgptrs[nmsgs] = &msgs[nmsgs];
+    }
+
+    if (qemuMonitorSendBatch(mon, msgptrs, nmsgs) < 0)
+        goto cleanup;
+
+    for (i = 0; i < nmsgs; i++) {
+        if (!msgs[i].rxObject) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("Missing monitor reply object"));
+            goto cleanup;
+        }
+    }
+
+    for (i = 0; i < nmsgs; i++) {
+        replies[i] = msgs[i].rxObject;
+        msgs[i].rxObject = NULL;
+    }
+
+    ret = 0;
+
+ cleanup:
+    for (i = 0; i < nmsgs; i++) {
+        virJSONValueFree(msgs[i].rxObject);
+        qemuMonitorJSONMessageClear(&msgs[i]);
+    }
+    if (msgs && nmsgs < ncmds)
+        qemuMonitorJSONMessageClear(&msgs[nmsgs]);
+    VIR_FREE(msgptrs);
+    VIR_FREE(msgs);
     return ret;
 }
 
@@ -2509,19 +2613,14 @@ qemuMonitorJSONQueryBlockstats(qemuMonitorPtr mon)
 }
 
 
-int
-qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitorPtr mon,
-                                    virHashTablePtr hash,
-                                    bool backingChain)
+static int
+qemuMonitorJSONParseAllBlockStatsInfo(virJSONValuePtr devices,
+                                      virHashTablePtr hash,
+                                      bool backingChain)
 {
-    int ret = -1;
     int nstats = 0;
     int rc;
     size_t i;
-    virJSONValuePtr devices;
-
-    if (!(devices = qemuMonitorJSONQueryBlockstats(mon)))
-        return -1;
 
     for (i = 0; i < virJSONValueArraySize(devices); i++) {
         virJSONValuePtr dev = virJSONValueArrayGet(devices, i);
@@ -2531,14 +2630,14 @@ qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitorPtr mon,
             virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
                            _("blockstats device entry was not "
                              "in expected format"));
-            goto cleanup;
+            return -1;
         }
 
         if (!(dev_name = virJSONValueObjectGetString(dev, "device"))) {
             virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
                            _("blockstats device entry was not "
                              "in expected format"));
-            goto cleanup;
+            return -1;
         }
 
         if (*dev_name == '\0')
@@ -2548,15 +2647,29 @@ qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitorPtr mon,
                                                  backingChain);
 
         if (rc < 0)
-            goto cleanup;
+            return -1;
 
         if (rc > nstats)
             nstats = rc;
     }
 
-    ret = nstats;
+    return nstats;
+}
+
+
+int
+qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitorPtr mon,
+                                    virHashTablePtr hash,
+                                    bool backingChain)
+{
+    int ret;
+    virJSONValuePtr devices;
+
+    if (!(devices = qemuMonitorJSONQueryBlockstats(mon)))
+        return -1;
+
+    ret = qemuMonitorJSONParseAllBlockStatsInfo(devices, hash, backingChain);
 
- cleanup:
     virJSONValueFree(devices);
     return ret;
 }
@@ -2628,17 +2741,12 @@ qemuMonitorJSONBlockStatsUpdateCapacityOne(virJSONValuePtr image,
 }
 
 
-int
-qemuMonitorJSONBlockStatsUpdateCapacity(qemuMonitorPtr mon,
-                                        virHashTablePtr stats,
-                                        bool backingChain)
+static int
+qemuMonitorJSONParseBlockStatsCapacity(virJSONValuePtr devices,
+                                       virHashTablePtr stats,
+                                       bool backingChain)
 {
-    int ret = -1;
     size_t i;
-    virJSONValuePtr devices;
-
-    if (!(devices = qemuMonitorJSONQueryBlock(mon)))
-        return -1;
 
     for (i = 0; i < virJSONValueArraySize(devices); i++) {
         virJSONValuePtr dev;
@@ -2647,10 +2755,10 @@ qemuMonitorJSONBlockStatsUpdateCapacity(qemuMonitorPtr mon,
         const char *dev_name;
 
         if (!(dev = qemuMonitorJSONGetBlockDev(devices, i)))
-            goto cleanup;
+            return -1;
 
         if (!(dev_name = qemuMonitorJSONGetBlockDevDevice(dev)))
-            goto cleanup;
+            return -1;
 
         /* drive may be empty */
         if (!(inserted = virJSONValueObjectGetObject(dev, "inserted")) ||
@@ -2660,12 +2768,26 @@ qemuMonitorJSONBlockStatsUpdateCapacity(qemuMonitorPtr mon,
         if (qemuMonitorJSONBlockStatsUpdateCapacityOne(image, dev_name, 0,
                                                        stats,
                                                        backingChain) < 0)
-            goto cleanup;
+            return -1;
     }
 
-    ret = 0;
+    return 0;
+}
+
+
+int
+qemuMonitorJSONBlockStatsUpdateCapacity(qemuMonitorPtr mon,
+                                        virHashTablePtr stats,
+                                        bool backingChain)
+{
+    int ret;
+    virJSONValuePtr devices;
+
+    if (!(devices = qemuMonitorJSONQueryBlock(mon)))
+        return -1;
+
+    ret = qemuMonitorJSONParseBlockStatsCapacity(devices, stats, backingChain);
 
- cleanup:
     virJSONValueFree(devices);
     return ret;
 }
@@ -2722,6 +2844,107 @@ qemuMonitorJSONBlockStatsUpdateCapacityBlockdev(qemuMonitorPtr mon,
 }
 
 
+/* Steals the "return" array of @reply to @cmd, NULL on error */
+static virJSONValuePtr
+qemuMonitorJSONStealReplyArray(virJSONValuePtr cmd,
+                               virJSONValuePtr reply)
+{
+    if (qemuMonitorJSONCheckReply(cmd, reply, VIR_JSON_TYPE_ARRAY) < 0)
+        return NULL;
+
+    return virJSONValueObjectStealArray(reply, "return");
+}
+
+
+/**
+ * qemuMonitorJSONGetAllBlockStatsAndCapacity:
+ * @mon: the monitor
+ * @hash: filled with the block stats
+ * @backingChain: recurse into the backing chain of devices
+ * @blockdev: take the capacity from query-named-block-nodes
+ * @nodedata: filled with the result of query-named-block-nodes, may be NULL
+ *
+ * Does the job of qemuMonitorJSONGetAllBlockStatsInfo followed by either
+ * qemuMonitorJSONBlockStatsUpdateCapacity or its blockdev variant and
+ * qemuMonitorJSONQueryNamedBlockNodes, but sends all the commands at
+ * once. With @blockdev the capacity comes from query-named-block-nodes
+ * already, so its reply is used for @nodedata as well instead of being
+ * asked for twice. Failing to get the capacity or @nodedata is not fatal
+ * and leaves the stats without capacity or @nodedata NULL respectively.
+ *
+ * Returns < 0 on error, count of supported block stats fields on success
+ */
+int
+qemuMonitorJSONGetAllBlockStatsAndCapacity(qemuMonitorPtr mon,
+                                           virHashTablePtr hash,
+                                           bool backingChain,
+                                           bool blockdev,
+                                           virJSONValuePtr *nodedata)
+{
+    virJSONValuePtr cmds[3] = { NULL, NULL, NULL };
+    virJSONValuePtr replies[3] = { NULL, NULL, NULL };
+    virJSONValuePtr devices = NULL;
+    virJSONValuePtr capacity = NULL;
+    size_t ncmds = 2;
+    size_t i;
+    int rc;
+    int ret = -1;
+
+    if (nodedata) {
+        *nodedata = NULL;
+        if (!blockdev)
+            ncmds++;
+    }
+
+    if (!(cmds[0] = qemuMonitorJSONMakeCommand("query-blockstats", NULL)) ||
+        !(cmds[1] = qemuMonitorJSONMakeCommand(blockdev ? "query-named-block-nodes" :
+                                                          "query-block", NULL)) ||
+        (ncmds > 2 &&
+         !(cmds[2] = qemuMonitorJSONMakeCommand("query-named-block-nodes", NULL))))
+        goto cleanup;
+
+    if (qemuMonitorJSONCommands(mon, cmds, ncmds, replies) < 0)
+        goto cleanup;
+
+    if (!(devices = qemuMonitorJSONStealReplyArray(cmds[0], replies[0])) ||
+        (ret = qemuMonitorJSONParseAllBlockStatsInfo(devices, hash,
+                                                     backingChain)) < 0)
+        goto cleanup;
+
+    /* the capacity and node data are optional */
+    if (!(capacity = qemuMonitorJSONStealReplyArray(cmds[1], replies[1]))) {
+        rc = -1;
+    } else if (blockdev) {
+        rc = virJSONValueArrayForeachSteal(capacity,
+                                           qemuMonitorJSONBlockStatsUpdateCapacityBlockdevWorker,
+                                           hash);
+    } else {
+        rc = qemuMonitorJSONParseBlockStatsCapacity(capacity, hash,
+                                                    backingChain);
+    }
+    if (rc < 0)
+        virResetLastError();
+
+    if (!nodedata) {
+        /* nothing more to do */
+    } else if (blockdev) {
+        /* the worker above leaves the array intact */
+        VIR_STEAL_PTR(*nodedata, capacity);
+    } else if (!(*nodedata = qemuMonitorJSONStealReplyArray(cmds[2], replies[2]))) {
+        virResetLastError();
+    }
+
+ cleanup:
+    for (i = 0; i < ncmds; i++) {
+        virJSONValueFree(cmds[i]);
+        virJSONValueFree(replies[i]);
+    }
+    virJSONValueFree(devices);
+    virJSONValueFree(capacity);
+    return ret;
+}
+
+
 int qemuMonitorJSONBlockResize(qemuMonitorPtr mon,
                                const char *device,
                                const char *nodename,
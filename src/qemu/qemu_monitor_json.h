@@ -39,8 +39,7 @@ int qemuMonitorJSONIOProcessLine(qemuMonitorPtr mon,
 
 int qemuMonitorJSONIOProcess(qemuMonitorPtr mon,
                              const char *data,
-                             size_t len,
-                             qemuMonitorMessagePtr msg);
+                             size_t len);
 
 int qemuMonitorJSONHumanCommandWithFd(qemuMonitorPtr mon,
                                       const char *cmd,
@@ -92,6 +91,11 @@ int qemuMonitorJSONBlockStatsUpdateCapacity(qemuMonitorPtr mon,
                                             bool backingChain);
 int qemuMonitorJSONBlockStatsUpdateCapacityBlockdev(qemuMonitorPtr mon,
                                                     virHashTablePtr stats);
+int qemuMonitorJSONGetAllBlockStatsAndCapacity(qemuMonitorPtr mon,
+                                               virHashTablePtr hash,
+                                               bool backingChain,
+                                               bool blockdev,
+                                               virJSONValuePtr *nodedata);
 
 int qemuMonitorJSONBlockResize(qemuMonitorPtr mon,
                                const char *device,
@@ -113,6 +113,12 @@ qemuProcessRemoveDomainStatus(virQEMUDriverPtr driver,
                  vm->def->name, virStrerror(errno, ebuf, sizeof(ebuf)));
     VIR_FREE(file);
 
+    if (qemuDomainObjRemoveJobStatus(driver, vm) < 0) {
+        VIR_WARN("Failed to remove job status for %s: %s",
+                 vm->def->name, virGetLastErrorMessage());
+        virResetLastError();
+    }
+
     if (priv->pidfile &&
         unlink(priv->pidfile) < 0 &&
         errno != ENOENT)
@@ -199,6 +205,23 @@ static void qemuProcessHandleAgentDestroy(qemuAgentPtr agent,
 }
 
 
+/*
+ * Returns the event loop the monitor and agent of @vm are watched
+ * in, NULL for the main one. Domains are spread over the dedicated
+ * loops by their ID.
+ */
+static virEventThreadPtr
+qemuProcessGetEventThread(virQEMUDriverPtr driver,
+                          virDomainObjPtr vm)
+{
+    if (!driver->nmonitorThreads)
+        return NULL;
+
+    return driver->monitorThreads[(unsigned int)vm->def->id %
+                                  driver->nmonitorThreads];
+}
+
+
 static qemuAgentCallbacks agentCallbacks = {
     .destroy = qemuProcessHandleAgentDestroy,
     .eofNotify = qemuProcessHandleAgentEOF,
@@ -239,6 +262,7 @@ qemuConnectAgent(virQEMUDriverPtr driver, virDomainObjPtr vm)
 
     agent = qemuAgentOpen(vm,
                           config->source,
+                          qemuProcessGetEventThread(driver, vm),
                           &agentCallbacks);
 
     virObjectLock(vm);
@@ -1863,6 +1887,7 @@ qemuConnectMonitor(virQEMUDriverPtr driver, virDomainObjPtr vm, int asyncJob,
                           priv->monJSON,
                           retry,
                           timeout,
+                          qemuProcessGetEventThread(driver, vm),
                           &monitorCallbacks,
                           driver);
 
@@ -7348,6 +7373,8 @@ void qemuProcessStop(virQEMUDriverPtr driver,
         }
     }
 
+    virProcStatCollectorForgetProcess(driver->procStats, vm->pid);
+
     vm->taint = 0;
     vm->pid = -1;
     virDomainObjSetState(vm, VIR_DOMAIN_SHUTOFF, reason);
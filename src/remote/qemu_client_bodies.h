@@ -1,4 +1,4 @@
-/* Automatically generated from ./remote/qemu_protocol.x by gendispatch.pl.
+/* Automatically generated from /root/repo/src/remote/qemu_protocol.x by gendispatch.pl.
  * Do not edit this file.  Any changes you make will be lost.
  */
 
@@ -514,6 +514,8 @@ daemonSetupNetworking(virNetServerPtr srv,
                     goto cleanup;
             }
 
+            virNetTLSContextSetKernelOffload(ctxt, config->tls_kernel_offload);
+
             VIR_DEBUG("Registering TLS socket %s:%s",
                       config->listen_addr, config->tls_port);
             if (!(svcTLS =
@@ -1278,7 +1280,7 @@ int main(int argc, char **argv) {
                                 remoteClientNew,
                                 NULL,
                                 remoteClientFree,
-                                NULL))) {
+                                config))) {
         ret = VIR_DAEMON_ERR_INIT;
         goto cleanup;
     }
@@ -62,6 +62,9 @@ struct daemonClientPrivate {
     size_t nsecretEventCallbacks;
     bool closeRegistered;
 
+    /* Size of the shared memory ring to offer, 0 if disabled */
+    size_t sharedRingSize;
+
 # if WITH_SASL
     virNetSASLSessionPtr sasl;
 # endif
@@ -299,6 +299,8 @@ daemonConfigLoadOptions(struct daemonConfig *data,
 
     if (virConfGetValueString(conf, "unix_sock_dir", &data->unix_sock_dir) < 0)
         goto error;
+    if (virConfGetValueUInt(conf, "unix_sock_ring_size", &data->unix_sock_ring_size) < 0)
+        goto error;
 
     if (virConfGetValueBool(conf, "mdns_adv", &data->mdns_adv) < 0)
         goto error;
@@ -331,6 +333,9 @@ daemonConfigLoadOptions(struct daemonConfig *data,
     if (virConfGetValueString(conf, "tls_priority", &data->tls_priority) < 0)
         goto error;
 
+    if (virConfGetValueBool(conf, "tls_kernel_offload", &data->tls_kernel_offload) < 0)
+        goto error;
+
     if (virConfGetValueUInt(conf, "min_workers", &data->min_workers) < 0)
         goto error;
     if (virConfGetValueUInt(conf, "max_workers", &data->max_workers) < 0)
@@ -39,6 +39,7 @@ struct daemonConfig {
     char *unix_sock_rw_perms;
     char *unix_sock_group;
     char *unix_sock_dir;
+    unsigned int unix_sock_ring_size;
 
     int auth_unix_rw;
     int auth_unix_ro;
@@ -55,6 +56,7 @@ struct daemonConfig {
     char **tls_allowed_dn_list;
     char **sasl_allowed_username_list;
     char *tls_priority;
+    bool tls_kernel_offload;
 
     char *key_file;
     char *cert_file;
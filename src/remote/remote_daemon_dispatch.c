@@ -24,6 +24,7 @@
 
 #include "remote_daemon_dispatch.h"
 #include "remote_daemon.h"
+#include "remote_daemon_config.h"
 #include "libvirt_internal.h"
 #include "datatypes.h"
 #include "viralloc.h"
@@ -34,6 +35,7 @@
 #include "intprops.h"
 #include "virnetserverservice.h"
 #include "virnetserver.h"
+#include "virnetsharedring.h"
 #include "virfile.h"
 #include "virtypedparam.h"
 #include "virdbus.h"
@@ -1922,8 +1924,9 @@ static void remoteClientCloseFunc(virNetServerClientPtr client)
 
 
 void *remoteClientNew(virNetServerClientPtr client,
-                      void *opaque ATTRIBUTE_UNUSED)
+                      void *opaque)
 {
+    struct daemonConfig *config = opaque;
     struct daemonClientPrivate *priv;
 
     if (VIR_ALLOC(priv) < 0)
@@ -1935,6 +1938,9 @@ void *remoteClientNew(virNetServerClientPtr client,
         return NULL;
     }
 
+    if (config)
+        priv->sharedRingSize = config->unix_sock_ring_size * 1024ULL * 1024ULL;
+
     virNetServerClientSetCloseHook(client, remoteClientCloseFunc);
     return priv;
 }
@@ -1950,6 +1956,7 @@ remoteDispatchConnectOpen(virNetServerPtr server ATTRIBUTE_UNUSED,
 {
     const char *name;
     unsigned int flags;
+    unsigned int openFlags;
     struct daemonClientPrivate *priv = virNetServerClientGetPrivateData(client);
     int rv = -1;
 
@@ -1970,10 +1977,11 @@ remoteDispatchConnectOpen(virNetServerPtr server ATTRIBUTE_UNUSED,
     if (virNetServerClientGetReadonly(client))
         flags |= VIR_CONNECT_RO;
 
-    priv->conn =
-        flags & VIR_CONNECT_RO
-        ? virConnectOpenReadOnly(name)
-        : virConnectOpen(name);
+    openFlags = flags & VIR_CONNECT_RO;
+    if (flags & REMOTE_CONNECT_OPEN_COALESCE_EVENTS)
+        openFlags |= VIR_CONNECT_COALESCE_EVENTS;
+
+    priv->conn = virConnectOpenAuth(name, NULL, openFlags);
 
     if (priv->conn == NULL)
         goto cleanup;
@@ -4880,6 +4888,11 @@ static int remoteDispatchConnectSupportsFeature(virNetServerPtr server ATTRIBUTE
     case VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK:
         supported = 1;
         break;
+    case VIR_DRV_FEATURE_REMOTE_SHARED_RING:
+        supported = priv->sharedRingSize > 0 &&
+            virNetSharedRingIsSupported() &&
+            virNetServerClientIsLocal(client);
+        break;
     case VIR_DRV_FEATURE_MIGRATION_V1:
     case VIR_DRV_FEATURE_REMOTE:
     case VIR_DRV_FEATURE_MIGRATION_V2:
@@ -4995,6 +5008,50 @@ remoteDispatchDomainOpenGraphicsFd(virNetServerPtr server ATTRIBUTE_UNUSED,
 }
 
 
+static int
+remoteDispatchConnectOpenSharedRing(virNetServerPtr server ATTRIBUTE_UNUSED,
+                                    virNetServerClientPtr client,
+                                    virNetMessagePtr msg,
+                                    virNetMessageErrorPtr rerr,
+                                    remote_connect_open_shared_ring_args *args)
+{
+    virNetSharedRingPtr ring = NULL;
+    unsigned int flags = args->flags;
+    int rv = -1;
+    struct daemonClientPrivate *priv =
+        virNetServerClientGetPrivateData(client);
+
+    virCheckFlagsGoto(0, cleanup);
+
+    if (priv->sharedRingSize == 0 ||
+        !virNetServerClientIsLocal(client)) {
+        virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                       _("shared memory ring is not available"));
+        goto cleanup;
+    }
+
+    if (!(ring = virNetSharedRingNew(priv->sharedRingSize)))
+        goto cleanup;
+
+    if (virNetMessageAddFD(msg, virNetSharedRingGetFD(ring)) < 0)
+        goto cleanup;
+
+    /* The reply carries a FD, so it is never itself put into the ring */
+    if (virNetServerClientSetSharedRing(client, ring) < 0)
+        goto cleanup;
+
+    /* return 1 here to let virNetServerProgramDispatchCall know
+     * we are passing a FD */
+    rv = 1;
+
+ cleanup:
+    if (rv < 0)
+        virNetMessageSaveError(rerr);
+    virObjectUnref(ring);
+    return rv;
+}
+
+
 static int
 remoteDispatchDomainGetInterfaceParameters(virNetServerPtr server ATTRIBUTE_UNUSED,
                                            virNetServerClientPtr client ATTRIBUTE_UNUSED,
@@ -6862,6 +6919,116 @@ remoteDispatchConnectGetAllDomainStats(virNetServerPtr server ATTRIBUTE_UNUSED,
 }
 
 
+static int
+remoteDispatchConnectLookupDomainsByUUID(virNetServerPtr server ATTRIBUTE_UNUSED,
+                                         virNetServerClientPtr client,
+                                         virNetMessagePtr msg ATTRIBUTE_UNUSED,
+                                         virNetMessageErrorPtr rerr,
+                                         remote_connect_lookup_domains_by_uuid_args *args,
+                                         remote_connect_lookup_domains_by_uuid_ret *ret)
+{
+    int rv = -1;
+    size_t i;
+    struct daemonClientPrivate *priv = virNetServerClientGetPrivateData(client);
+    unsigned int nuuids = args->uuids.uuids_len;
+    virDomainPtr *doms = NULL;
+    int *states = NULL;
+
+    if (!priv->conn) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s", _("connection not open"));
+        goto cleanup;
+    }
+
+    if (virConnectLookupDomainsByUUID(priv->conn,
+                                      (const unsigned char *) args->uuids.uuids_val,
+                                      nuuids, &doms,
+                                      args->need_states ? &states : NULL,
+                                      args->flags) < 0)
+        goto cleanup;
+
+    if (VIR_ALLOC_N(ret->doms.doms_val, nuuids) < 0)
+        goto cleanup;
+    ret->doms.doms_len = nuuids;
+
+    for (i = 0; i < nuuids; i++) {
+        if (!doms[i])
+            continue;
+
+        if (VIR_ALLOC(ret->doms.doms_val[i]) < 0 ||
+            make_nonnull_domain(ret->doms.doms_val[i], doms[i]) < 0)
+            goto cleanup;
+    }
+
+    if (states) {
+        ret->states.states_val = states;
+        ret->states.states_len = nuuids;
+        states = NULL;
+    }
+
+    rv = 0;
+
+ cleanup:
+    if (rv < 0)
+        virNetMessageSaveError(rerr);
+
+    if (doms) {
+        for (i = 0; i < nuuids; i++)
+            virObjectUnref(doms[i]);
+        VIR_FREE(doms);
+    }
+    VIR_FREE(states);
+
+    return rv;
+}
+
+
+static int
+remoteDispatchDomainListLifecycle(virNetServerPtr server ATTRIBUTE_UNUSED,
+                                  virNetServerClientPtr client,
+                                  virNetMessagePtr msg ATTRIBUTE_UNUSED,
+                                  virNetMessageErrorPtr rerr,
+                                  remote_domain_list_lifecycle_args *args,
+                                  remote_domain_list_lifecycle_ret *ret)
+{
+    int rv = -1;
+    size_t i;
+    struct daemonClientPrivate *priv = virNetServerClientGetPrivateData(client);
+    virDomainPtr *doms = NULL;
+    int *errors = NULL;
+
+    if (!priv->conn) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s", _("connection not open"));
+        goto cleanup;
+    }
+
+    if (VIR_ALLOC_N(doms, args->doms.doms_len + 1) < 0)
+        goto cleanup;
+
+    for (i = 0; i < args->doms.doms_len; i++) {
+        if (!(doms[i] = get_nonnull_domain(priv->conn, args->doms.doms_val[i])))
+            goto cleanup;
+    }
+
+    if (virDomainListLifecycle(doms, args->action, &errors, args->flags) < 0)
+        goto cleanup;
+
+    ret->errors.errors_val = errors;
+    ret->errors.errors_len = args->doms.doms_len;
+    errors = NULL;
+
+    rv = 0;
+
+ cleanup:
+    if (rv < 0)
+        virNetMessageSaveError(rerr);
+
+    virObjectListFree(doms);
+    VIR_FREE(errors);
+
+    return rv;
+}
+
+
 static int
 remoteDispatchNodeAllocPages(virNetServerPtr server ATTRIBUTE_UNUSED,
                              virNetServerClientPtr client,
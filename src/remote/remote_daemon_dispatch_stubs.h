@@ -1,4 +1,4 @@
-/* Automatically generated from ./remote/remote_protocol.x by gendispatch.pl.
+/* Automatically generated from /root/repo/src/remote/remote_protocol.x by gendispatch.pl.
  * Do not edit this file.  Any changes you make will be lost.
  */
 static int remoteDispatchAuthList(
@@ -2676,6 +2676,33 @@ cleanup:
 
 
 
+static int remoteDispatchConnectLookupDomainsByUUID(
+    virNetServerPtr server,
+    virNetServerClientPtr client,
+    virNetMessagePtr msg,
+    virNetMessageErrorPtr rerr,
+    remote_connect_lookup_domains_by_uuid_args *args,
+    remote_connect_lookup_domains_by_uuid_ret *ret);
+static int remoteDispatchConnectLookupDomainsByUUIDHelper(
+    virNetServerPtr server,
+    virNetServerClientPtr client,
+    virNetMessagePtr msg,
+    virNetMessageErrorPtr rerr,
+    void *args,
+    void *ret)
+{
+  int rv;
+  virThreadJobSet("remoteDispatchConnectLookupDomainsByUUID");
+  VIR_DEBUG("server=%p client=%p msg=%p rerr=%p args=%p ret=%p",
+            server, client, msg, rerr, args, ret);
+  rv = remoteDispatchConnectLookupDomainsByUUID(server, client, msg, rerr, args, ret);
+  virThreadJobClear(rv);
+  return rv;
+}
+/* remoteDispatchConnectLookupDomainsByUUID body has to be implemented manually */
+
+
+
 static int remoteDispatchConnectNetworkEventDeregisterAny(
     virNetServerPtr server,
     virNetServerClientPtr client,
@@ -3338,6 +3365,32 @@ static int remoteDispatchConnectOpenHelper(
 
 
 
+static int remoteDispatchConnectOpenSharedRing(
+    virNetServerPtr server,
+    virNetServerClientPtr client,
+    virNetMessagePtr msg,
+    virNetMessageErrorPtr rerr,
+    remote_connect_open_shared_ring_args *args);
+static int remoteDispatchConnectOpenSharedRingHelper(
+    virNetServerPtr server,
+    virNetServerClientPtr client,
+    virNetMessagePtr msg,
+    virNetMessageErrorPtr rerr,
+    void *args,
+    void *ret ATTRIBUTE_UNUSED)
+{
+  int rv;
+  virThreadJobSet("remoteDispatchConnectOpenSharedRing");
+  VIR_DEBUG("server=%p client=%p msg=%p rerr=%p args=%p ret=%p",
+            server, client, msg, rerr, args, ret);
+  rv = remoteDispatchConnectOpenSharedRing(server, client, msg, rerr, args);
+  virThreadJobClear(rv);
+  return rv;
+}
+/* remoteDispatchConnectOpenSharedRing body has to be implemented manually */
+
+
+
 static int remoteDispatchConnectRegisterCloseCallback(
     virNetServerPtr server,
     virNetServerClientPtr client,
@@ -7231,6 +7284,33 @@ cleanup:
 
 
 
+static int remoteDispatchDomainListLifecycle(
+    virNetServerPtr server,
+    virNetServerClientPtr client,
+    virNetMessagePtr msg,
+    virNetMessageErrorPtr rerr,
+    remote_domain_list_lifecycle_args *args,
+    remote_domain_list_lifecycle_ret *ret);
+static int remoteDispatchDomainListLifecycleHelper(
+    virNetServerPtr server,
+    virNetServerClientPtr client,
+    virNetMessagePtr msg,
+    virNetMessageErrorPtr rerr,
+    void *args,
+    void *ret)
+{
+  int rv;
+  virThreadJobSet("remoteDispatchDomainListLifecycle");
+  VIR_DEBUG("server=%p client=%p msg=%p rerr=%p args=%p ret=%p",
+            server, client, msg, rerr, args, ret);
+  rv = remoteDispatchDomainListLifecycle(server, client, msg, rerr, args, ret);
+  virThreadJobClear(rv);
+  return rv;
+}
+/* remoteDispatchDomainListLifecycle body has to be implemented manually */
+
+
+
 static int remoteDispatchDomainLookupByID(
     virNetServerPtr server,
     virNetServerClientPtr client,
@@ -22198,5 +22278,32 @@ virNetServerProgramProc remoteProcs[] = {
    true,
    0
 },
+{ /* Method ConnectLookupDomainsByUUID => 403 */
+   remoteDispatchConnectLookupDomainsByUUIDHelper,
+   sizeof(remote_connect_lookup_domains_by_uuid_args),
+   (xdrproc_t)xdr_remote_connect_lookup_domains_by_uuid_args,
+   sizeof(remote_connect_lookup_domains_by_uuid_ret),
+   (xdrproc_t)xdr_remote_connect_lookup_domains_by_uuid_ret,
+   true,
+   0
+},
+{ /* Method DomainListLifecycle => 404 */
+   remoteDispatchDomainListLifecycleHelper,
+   sizeof(remote_domain_list_lifecycle_args),
+   (xdrproc_t)xdr_remote_domain_list_lifecycle_args,
+   sizeof(remote_domain_list_lifecycle_ret),
+   (xdrproc_t)xdr_remote_domain_list_lifecycle_ret,
+   true,
+   0
+},
+{ /* Method ConnectOpenSharedRing => 405 */
+   remoteDispatchConnectOpenSharedRingHelper,
+   sizeof(remote_connect_open_shared_ring_args),
+   (xdrproc_t)xdr_remote_connect_open_shared_ring_args,
+   0,
+   (xdrproc_t)xdr_void,
+   true,
+   0
+},
 };
 size_t remoteNProcs = ARRAY_CARDINALITY(remoteProcs);
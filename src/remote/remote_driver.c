@@ -26,6 +26,7 @@
 #include "virnetclient.h"
 #include "virnetclientprogram.h"
 #include "virnetclientstream.h"
+#include "virnetsharedring.h"
 #include "virerror.h"
 #include "virlog.h"
 #include "datatypes.h"
@@ -659,6 +660,7 @@ enum virDrvOpenRemoteFlags {
     VIR_DRV_OPEN_REMOTE_RO = (1 << 0),
     VIR_DRV_OPEN_REMOTE_USER      = (1 << 1), /* Use the per-user socket path */
     VIR_DRV_OPEN_REMOTE_AUTOSTART = (1 << 2), /* Autostart a per-user daemon */
+    VIR_DRV_OPEN_REMOTE_COALESCE_EVENTS = REMOTE_CONNECT_OPEN_COALESCE_EVENTS,
 };
 
 
@@ -687,6 +689,56 @@ remoteConnectSupportsFeatureUnlocked(virConnectPtr conn,
     return rc != -1 && ret.supported;
 }
 
+/*
+ * Failure to get a ring from the server is not fatal, but once the
+ * server has handed one over it puts large replies there, so failing
+ * to map it leaves the connection unusable.
+ */
+static int
+remoteConnectOpenSharedRing(virConnectPtr conn,
+                            struct private_data *priv)
+{
+    remote_connect_open_shared_ring_args args = { 0 };
+    virNetSharedRingPtr ring = NULL;
+    int *fdout = NULL;
+    size_t fdoutlen = 0;
+    int ret = -1;
+
+    if (callFull(conn, priv, 0,
+                 NULL, 0,
+                 &fdout, &fdoutlen,
+                 REMOTE_PROC_CONNECT_OPEN_SHARED_RING,
+                 (xdrproc_t) xdr_remote_connect_open_shared_ring_args, (char *) &args,
+                 (xdrproc_t) xdr_void, NULL) == -1) {
+        VIR_INFO("Unable to set up shared memory ring: %s",
+                 virGetLastErrorMessage());
+        virResetLastError();
+        ret = 0;
+        goto cleanup;
+    }
+
+    if (fdoutlen != 1) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       fdoutlen ? _("too many file descriptors received") :
+                                  _("no file descriptor received"));
+        goto cleanup;
+    }
+
+    if (!(ring = virNetSharedRingOpen(fdout[0])))
+        goto cleanup;
+    fdoutlen = 0;
+
+    virNetClientSetSharedRing(priv->client, ring);
+    ret = 0;
+
+ cleanup:
+    while (fdoutlen)
+        VIR_FORCE_CLOSE(fdout[--fdoutlen]);
+    VIR_FREE(fdout);
+    virObjectUnref(ring);
+    return ret;
+}
+
 /* helper macro to ease extraction of arguments from the URI */
 #define EXTRACT_URI_ARG_STR(ARG_NAME, ARG_VAR) \
     if (STRCASEEQ(var->name, ARG_NAME)) { \
@@ -1251,6 +1303,14 @@ doRemoteOpen(virConnectPtr conn,
                  "by the remote side.");
     }
 
+    /* The ring must be in place before any call is made concurrently */
+    if (transport == trans_unix &&
+        virNetSharedRingIsSupported() &&
+        remoteConnectSupportsFeatureUnlocked(conn, priv,
+                                             VIR_DRV_FEATURE_REMOTE_SHARED_RING) &&
+        remoteConnectOpenSharedRing(conn, priv) < 0)
+        goto failed;
+
     /* Successful. */
     retcode = VIR_DRV_OPEN_SUCCESS;
 
@@ -1341,6 +1401,8 @@ remoteConnectOpen(virConnectPtr conn,
 
     if (flags & VIR_CONNECT_RO)
         rflags |= VIR_DRV_OPEN_REMOTE_RO;
+    if (conn->flags & VIR_CONNECT_COALESCE_EVENTS)
+        rflags |= VIR_DRV_OPEN_REMOTE_COALESCE_EVENTS;
 
     /*
      * If no servername is given, and no +XXX
@@ -6706,6 +6768,152 @@ call(virConnectPtr conn,
 }
 
 
+/*
+ * Like call(), but returns as soon as the call was queued. @func is
+ * run with the decoded reply, or NULL on failure, from the event loop.
+ *
+ * Returns 0 if the call was queued, in which case @func is guaranteed
+ * to be called, -1 on error.
+ */
+static int
+callAsync(virConnectPtr conn ATTRIBUTE_UNUSED,
+          struct private_data *priv,
+          unsigned int flags,
+          int proc_nr,
+          xdrproc_t args_filter, char *args,
+          xdrproc_t ret_filter, size_t ret_size,
+          virNetClientProgramCallFunc func,
+          void *opaque)
+{
+    int rv;
+    virNetClientProgramPtr prog;
+    int counter = priv->counter++;
+    virNetClientPtr client = priv->client;
+    priv->localUses++;
+
+    if (flags & REMOTE_CALL_QEMU)
+        prog = priv->qemuProgram;
+    else if (flags & REMOTE_CALL_LXC)
+        prog = priv->lxcProgram;
+    else
+        prog = priv->remoteProgram;
+
+    remoteDriverUnlock(priv);
+    rv = virNetClientProgramCallAsync(prog,
+                                      client,
+                                      counter,
+                                      proc_nr,
+                                      args_filter, args,
+                                      ret_filter, ret_size,
+                                      func, opaque);
+    remoteDriverLock(priv);
+    priv->localUses--;
+
+    return rv;
+}
+
+
+struct remoteAsyncCallData {
+    virConnectPtr conn;
+    union {
+        virDomainLookupCallback lookup;
+        virDomainStatsCallback stats;
+    } cb;
+    void *opaque;
+    virFreeCallback freecb;
+};
+
+
+static struct remoteAsyncCallData *
+remoteAsyncCallDataNew(virConnectPtr conn,
+                       void *opaque,
+                       virFreeCallback freecb)
+{
+    struct remoteAsyncCallData *data;
+
+    if (VIR_ALLOC(data) < 0)
+        return NULL;
+
+    data->conn = virObjectRef(conn);
+    data->opaque = opaque;
+    data->freecb = freecb;
+
+    return data;
+}
+
+
+static void
+remoteAsyncCallDataFree(struct remoteAsyncCallData *data,
+                        bool done)
+{
+    if (!data)
+        return;
+
+    /* Drop the reference first, so that when @freecb tells the caller
+     * the call is over, closing the connection really closes it. */
+    virObjectUnref(data->conn);
+    if (done && data->freecb)
+        data->freecb(data->opaque);
+    VIR_FREE(data);
+}
+
+
+static void
+remoteDomainLookupByUUIDAsyncDone(virNetClientProgramPtr prog ATTRIBUTE_UNUSED,
+                                  virNetClientPtr client ATTRIBUTE_UNUSED,
+                                  void *opaque_ret,
+                                  void *opaque)
+{
+    struct remoteAsyncCallData *data = opaque;
+    remote_domain_lookup_by_uuid_ret *ret = opaque_ret;
+    virDomainPtr dom = NULL;
+
+    if (ret)
+        dom = get_nonnull_domain(data->conn, ret->dom);
+
+    data->cb.lookup(data->conn, dom, data->opaque);
+
+    virObjectUnref(dom);
+    remoteAsyncCallDataFree(data, true);
+}
+
+
+static int
+remoteDomainLookupByUUIDAsync(virConnectPtr conn,
+                              const unsigned char *uuid,
+                              virDomainLookupCallback cb,
+                              void *opaque,
+                              virFreeCallback freecb,
+                              unsigned int flags)
+{
+    struct private_data *priv = conn->privateData;
+    remote_domain_lookup_by_uuid_args args;
+    struct remoteAsyncCallData *data;
+    int rv = -1;
+
+    /* REMOTE_PROC_DOMAIN_LOOKUP_BY_UUID has no flags to pass them in */
+    virCheckFlags(0, -1);
+
+    if (!(data = remoteAsyncCallDataNew(conn, opaque, freecb)))
+        return -1;
+    data->cb.lookup = cb;
+
+    memcpy(args.uuid, uuid, VIR_UUID_BUFLEN);
+
+    remoteDriverLock(priv);
+    rv = callAsync(conn, priv, 0, REMOTE_PROC_DOMAIN_LOOKUP_BY_UUID,
+                   (xdrproc_t)xdr_remote_domain_lookup_by_uuid_args, (char *)&args,
+                   (xdrproc_t)xdr_remote_domain_lookup_by_uuid_ret,
+                   sizeof(remote_domain_lookup_by_uuid_ret),
+                   remoteDomainLookupByUUIDAsyncDone, data);
+    remoteDriverUnlock(priv);
+
+    if (rv < 0)
+        remoteAsyncCallDataFree(data, false);
+    return rv;
+}
+
+
 static int
 remoteDomainGetInterfaceParameters(virDomainPtr domain,
                                    const char *device,
@@ -7681,6 +7889,63 @@ remoteNetworkGetDHCPLeases(virNetworkPtr net,
 }
 
 
+static int
+remoteConnectGetAllDomainStatsDecode(virConnectPtr conn,
+                                     remote_connect_get_all_domain_stats_ret *ret,
+                                     virDomainStatsRecordPtr **retStats)
+{
+    int rv = -1;
+    size_t i;
+    virDomainStatsRecordPtr elem = NULL;
+    virDomainStatsRecordPtr *tmpret = NULL;
+
+    if (ret->retStats.retStats_len > REMOTE_DOMAIN_LIST_MAX) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Number of stats entries is %d, which exceeds max limit: %d"),
+                       ret->retStats.retStats_len, REMOTE_DOMAIN_LIST_MAX);
+        goto cleanup;
+    }
+
+    *retStats = NULL;
+
+    if (VIR_ALLOC_N(tmpret, ret->retStats.retStats_len + 1) < 0)
+        goto cleanup;
+
+    for (i = 0; i < ret->retStats.retStats_len; i++) {
+        remote_domain_stats_record *rec = ret->retStats.retStats_val + i;
+
+        if (VIR_ALLOC(elem) < 0)
+            goto cleanup;
+
+        if (!(elem->dom = get_nonnull_domain(conn, rec->dom)))
+            goto cleanup;
+
+        if (virTypedParamsDeserialize((virTypedParameterRemotePtr) rec->params.params_val,
+                                      rec->params.params_len,
+                                      REMOTE_CONNECT_GET_ALL_DOMAIN_STATS_MAX,
+                                      &elem->params,
+                                      &elem->nparams))
+            goto cleanup;
+
+        tmpret[i] = elem;
+        elem = NULL;
+    }
+
+    *retStats = tmpret;
+    tmpret = NULL;
+    rv = ret->retStats.retStats_len;
+
+ cleanup:
+    if (elem) {
+        virObjectUnref(elem->dom);
+        VIR_FREE(elem);
+    }
+    virDomainStatsRecordListFree(tmpret);
+
+    return rv;
+}
+
+
 static int
 remoteConnectGetAllDomainStats(virConnectPtr conn,
                                virDomainPtr *doms,
@@ -7694,8 +7959,6 @@ remoteConnectGetAllDomainStats(virConnectPtr conn,
     size_t i;
     remote_connect_get_all_domain_stats_args args;
     remote_connect_get_all_domain_stats_ret ret;
-    virDomainStatsRecordPtr elem = NULL;
-    virDomainStatsRecordPtr *tmpret = NULL;
 
     memset(&args, 0, sizeof(args));
 
@@ -7722,52 +7985,233 @@ remoteConnectGetAllDomainStats(virConnectPtr conn,
     }
     remoteDriverUnlock(priv);
 
-    if (ret.retStats.retStats_len > REMOTE_DOMAIN_LIST_MAX) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Number of stats entries is %d, which exceeds max limit: %d"),
-                       ret.retStats.retStats_len, REMOTE_DOMAIN_LIST_MAX);
-        goto cleanup;
+    rv = remoteConnectGetAllDomainStatsDecode(conn, &ret, retStats);
+
+ cleanup:
+    VIR_FREE(args.doms.doms_val);
+    xdr_free((xdrproc_t)xdr_remote_connect_get_all_domain_stats_ret,
+             (char *) &ret);
+
+    return rv;
+}
+
+
+static void
+remoteConnectGetAllDomainStatsAsyncDone(virNetClientProgramPtr prog ATTRIBUTE_UNUSED,
+                                        virNetClientPtr client ATTRIBUTE_UNUSED,
+                                        void *opaque_ret,
+                                        void *opaque)
+{
+    struct remoteAsyncCallData *data = opaque;
+    remote_connect_get_all_domain_stats_ret *ret = opaque_ret;
+    virDomainStatsRecordPtr *retStats = NULL;
+    int nstats = -1;
+
+    if (ret)
+        nstats = remoteConnectGetAllDomainStatsDecode(data->conn, ret, &retStats);
+
+    data->cb.stats(data->conn, retStats, nstats, data->opaque);
+
+    virDomainStatsRecordListFree(retStats);
+    remoteAsyncCallDataFree(data, true);
+}
+
+
+static int
+remoteConnectGetAllDomainStatsAsync(virConnectPtr conn,
+                                    virDomainPtr *doms,
+                                    unsigned int ndoms,
+                                    unsigned int stats,
+                                    unsigned int flags,
+                                    virDomainStatsCallback cb,
+                                    void *opaque,
+                                    virFreeCallback freecb)
+{
+    struct private_data *priv = conn->privateData;
+    int rv = -1;
+    size_t i;
+    remote_connect_get_all_domain_stats_args args;
+    struct remoteAsyncCallData *data;
+
+    if (!(data = remoteAsyncCallDataNew(conn, opaque, freecb)))
+        return -1;
+    data->cb.stats = cb;
+
+    memset(&args, 0, sizeof(args));
+
+    if (ndoms) {
+        if (VIR_ALLOC_N(args.doms.doms_val, ndoms) < 0)
+            goto cleanup;
+
+        for (i = 0; i < ndoms; i++)
+            make_nonnull_domain(args.doms.doms_val + i, doms[i]);
     }
+    args.doms.doms_len = ndoms;
 
-    *retStats = NULL;
+    args.stats = stats;
+    args.flags = flags;
+
+    remoteDriverLock(priv);
+    rv = callAsync(conn, priv, 0, REMOTE_PROC_CONNECT_GET_ALL_DOMAIN_STATS,
+                   (xdrproc_t)xdr_remote_connect_get_all_domain_stats_args, (char *)&args,
+                   (xdrproc_t)xdr_remote_connect_get_all_domain_stats_ret,
+                   sizeof(remote_connect_get_all_domain_stats_ret),
+                   remoteConnectGetAllDomainStatsAsyncDone, data);
+    remoteDriverUnlock(priv);
+
+ cleanup:
+    if (rv < 0)
+        remoteAsyncCallDataFree(data, false);
+    VIR_FREE(args.doms.doms_val);
+    return rv;
+}
+
+
+static int
+remoteConnectLookupDomainsByUUID(virConnectPtr conn,
+                                 const unsigned char *uuids,
+                                 unsigned int nuuids,
+                                 virDomainPtr **domains,
+                                 int **states,
+                                 unsigned int flags)
+{
+    struct private_data *priv = conn->privateData;
+    int rv = -1;
+    size_t i;
+    remote_connect_lookup_domains_by_uuid_args args;
+    remote_connect_lookup_domains_by_uuid_ret ret;
+    virDomainPtr *doms = NULL;
+    int nfound = 0;
+
+    if (nuuids > REMOTE_DOMAIN_LIST_MAX) {
+        virReportError(VIR_ERR_RPC,
+                       _("too many UUIDs '%u' for limit '%d'"),
+                       nuuids, REMOTE_DOMAIN_LIST_MAX);
+        return -1;
+    }
+
+    args.uuids.uuids_val = (remote_uuid *) uuids;
+    args.uuids.uuids_len = nuuids;
+    args.need_states = !!states;
+    args.flags = flags;
 
-    if (VIR_ALLOC_N(tmpret, ret.retStats.retStats_len + 1) < 0)
+    memset(&ret, 0, sizeof(ret));
+
+    remoteDriverLock(priv);
+    if (call(conn, priv, 0, REMOTE_PROC_CONNECT_LOOKUP_DOMAINS_BY_UUID,
+             (xdrproc_t)xdr_remote_connect_lookup_domains_by_uuid_args, (char *)&args,
+             (xdrproc_t)xdr_remote_connect_lookup_domains_by_uuid_ret, (char *)&ret) == -1) {
+        remoteDriverUnlock(priv);
+        return -1;
+    }
+    remoteDriverUnlock(priv);
+
+    if (ret.doms.doms_len != nuuids ||
+        (states && ret.states.states_len != nuuids)) {
+        virReportError(VIR_ERR_RPC, "%s",
+                       _("unexpected number of domains in reply"));
         goto cleanup;
+    }
 
-    for (i = 0; i < ret.retStats.retStats_len; i++) {
-        remote_domain_stats_record *rec = ret.retStats.retStats_val + i;
+    if (VIR_ALLOC_N(doms, nuuids) < 0)
+        goto cleanup;
 
-        if (VIR_ALLOC(elem) < 0)
-            goto cleanup;
+    for (i = 0; i < nuuids; i++) {
+        if (!ret.doms.doms_val[i])
+            continue;
 
-        if (!(elem->dom = get_nonnull_domain(conn, rec->dom)))
+        if (!(doms[i] = get_nonnull_domain(conn, *ret.doms.doms_val[i])))
             goto cleanup;
+        nfound++;
+    }
 
-        if (virTypedParamsDeserialize((virTypedParameterRemotePtr) rec->params.params_val,
-                                      rec->params.params_len,
-                                      REMOTE_CONNECT_GET_ALL_DOMAIN_STATS_MAX,
-                                      &elem->params,
-                                      &elem->nparams))
-            goto cleanup;
+    *domains = doms;
+    doms = NULL;
+    if (states) {
+        *states = ret.states.states_val;
+        ret.states.states_val = NULL;
+        ret.states.states_len = 0;
+    }
+    rv = nfound;
 
-        tmpret[i] = elem;
-        elem = NULL;
+ cleanup:
+    if (doms) {
+        for (i = 0; i < nuuids; i++)
+            virObjectUnref(doms[i]);
+        VIR_FREE(doms);
     }
+    xdr_free((xdrproc_t)xdr_remote_connect_lookup_domains_by_uuid_ret,
+             (char *) &ret);
 
-    *retStats = tmpret;
-    tmpret = NULL;
-    rv = ret.retStats.retStats_len;
+    return rv;
+}
 
- cleanup:
-    if (elem) {
-        virObjectUnref(elem->dom);
-        VIR_FREE(elem);
+
+static int
+remoteDomainListLifecycle(virConnectPtr conn,
+                          virDomainPtr *doms,
+                          unsigned int ndoms,
+                          int action,
+                          int **errors,
+                          unsigned int flags)
+{
+    struct private_data *priv = conn->privateData;
+    int rv = -1;
+    size_t i;
+    remote_domain_list_lifecycle_args args;
+    remote_domain_list_lifecycle_ret ret;
+
+    if (ndoms > REMOTE_DOMAIN_LIST_MAX) {
+        virReportError(VIR_ERR_RPC,
+                       _("too many domains '%u' for limit '%d'"),
+                       ndoms, REMOTE_DOMAIN_LIST_MAX);
+        return -1;
     }
-    virDomainStatsRecordListFree(tmpret);
+
+    memset(&args, 0, sizeof(args));
+    memset(&ret, 0, sizeof(ret));
+
+    if (VIR_ALLOC_N(args.doms.doms_val, ndoms) < 0)
+        goto cleanup;
+
+    for (i = 0; i < ndoms; i++)
+        make_nonnull_domain(args.doms.doms_val + i, doms[i]);
+    args.doms.doms_len = ndoms;
+
+    args.action = action;
+    args.flags = flags;
+
+    remoteDriverLock(priv);
+    if (call(conn, priv, 0, REMOTE_PROC_DOMAIN_LIST_LIFECYCLE,
+             (xdrproc_t)xdr_remote_domain_list_lifecycle_args, (char *)&args,
+             (xdrproc_t)xdr_remote_domain_list_lifecycle_ret, (char *)&ret) == -1) {
+        remoteDriverUnlock(priv);
+        goto cleanup;
+    }
+    remoteDriverUnlock(priv);
+
+    if (ret.errors.errors_len != ndoms) {
+        virReportError(VIR_ERR_RPC, "%s",
+                       _("unexpected number of results in reply"));
+        goto cleanup;
+    }
+
+    rv = 0;
+    for (i = 0; i < ndoms; i++) {
+        if (ret.errors.errors_val[i] == VIR_ERR_OK)
+            rv++;
+    }
+
+    if (errors) {
+        *errors = ret.errors.errors_val;
+        ret.errors.errors_val = NULL;
+        ret.errors.errors_len = 0;
+    }
+
+ cleanup:
     VIR_FREE(args.doms.doms_val);
-    xdr_free((xdrproc_t)xdr_remote_connect_get_all_domain_stats_ret,
+    xdr_free((xdrproc_t)xdr_remote_domain_list_lifecycle_ret,
              (char *) &ret);
-
     return rv;
 }
 
@@ -8535,7 +8979,11 @@ static virHypervisorDriver hypervisor_driver = {
     .connectCompareHypervisorCPU = remoteConnectCompareHypervisorCPU, /* 4.4.0 */
     .connectBaselineHypervisorCPU = remoteConnectBaselineHypervisorCPU, /* 4.4.0 */
     .nodeGetSEVInfo = remoteNodeGetSEVInfo, /* 4.5.0 */
-    .domainGetLaunchSecurityInfo = remoteDomainGetLaunchSecurityInfo /* 4.5.0 */
+    .domainGetLaunchSecurityInfo = remoteDomainGetLaunchSecurityInfo, /* 4.5.0 */
+    .connectLookupDomainsByUUID = remoteConnectLookupDomainsByUUID, /* 5.1.0 */
+    .domainListLifecycle = remoteDomainListLifecycle, /* 5.1.0 */
+    .domainLookupByUUIDAsync = remoteDomainLookupByUUIDAsync, /* 5.1.0 */
+    .connectGetAllDomainStatsAsync = remoteConnectGetAllDomainStatsAsync, /* 5.1.0 */
 };
 
 static virNetworkDriver network_driver = {
@@ -7510,6 +7510,71 @@ xdr_remote_connect_list_all_nwfilter_bindings_ret (XDR *xdrs, remote_connect_lis
         return TRUE;
 }
 
+bool_t
+xdr_remote_connect_lookup_domains_by_uuid_args (XDR *xdrs, remote_connect_lookup_domains_by_uuid_args *objp)
+{
+        char **objp_cpp0 = (char **) (void *) &objp->uuids.uuids_val;
+
+         if (!xdr_array (xdrs, objp_cpp0, (u_int *) &objp->uuids.uuids_len, REMOTE_DOMAIN_LIST_MAX,
+                sizeof (remote_uuid), (xdrproc_t) xdr_remote_uuid))
+                 return FALSE;
+         if (!xdr_int (xdrs, &objp->need_states))
+                 return FALSE;
+         if (!xdr_u_int (xdrs, &objp->flags))
+                 return FALSE;
+        return TRUE;
+}
+
+bool_t
+xdr_remote_connect_lookup_domains_by_uuid_ret (XDR *xdrs, remote_connect_lookup_domains_by_uuid_ret *objp)
+{
+        char **objp_cpp1 = (char **) (void *) &objp->states.states_val;
+        char **objp_cpp0 = (char **) (void *) &objp->doms.doms_val;
+
+         if (!xdr_array (xdrs, objp_cpp0, (u_int *) &objp->doms.doms_len, REMOTE_DOMAIN_LIST_MAX,
+                sizeof (remote_domain), (xdrproc_t) xdr_remote_domain))
+                 return FALSE;
+         if (!xdr_array (xdrs, objp_cpp1, (u_int *) &objp->states.states_len, REMOTE_DOMAIN_LIST_MAX,
+                sizeof (int), (xdrproc_t) xdr_int))
+                 return FALSE;
+        return TRUE;
+}
+
+bool_t
+xdr_remote_domain_list_lifecycle_args (XDR *xdrs, remote_domain_list_lifecycle_args *objp)
+{
+        char **objp_cpp0 = (char **) (void *) &objp->doms.doms_val;
+
+         if (!xdr_array (xdrs, objp_cpp0, (u_int *) &objp->doms.doms_len, REMOTE_DOMAIN_LIST_MAX,
+                sizeof (remote_nonnull_domain), (xdrproc_t) xdr_remote_nonnull_domain))
+                 return FALSE;
+         if (!xdr_int (xdrs, &objp->action))
+                 return FALSE;
+         if (!xdr_u_int (xdrs, &objp->flags))
+                 return FALSE;
+        return TRUE;
+}
+
+bool_t
+xdr_remote_domain_list_lifecycle_ret (XDR *xdrs, remote_domain_list_lifecycle_ret *objp)
+{
+        char **objp_cpp0 = (char **) (void *) &objp->errors.errors_val;
+
+         if (!xdr_array (xdrs, objp_cpp0, (u_int *) &objp->errors.errors_len, REMOTE_DOMAIN_LIST_MAX,
+                sizeof (int), (xdrproc_t) xdr_int))
+                 return FALSE;
+        return TRUE;
+}
+
+bool_t
+xdr_remote_connect_open_shared_ring_args (XDR *xdrs, remote_connect_open_shared_ring_args *objp)
+{
+
+         if (!xdr_u_int (xdrs, &objp->flags))
+                 return FALSE;
+        return TRUE;
+}
+
 bool_t
 xdr_remote_procedure (XDR *xdrs, remote_procedure *objp)
 {
@@ -229,6 +229,7 @@ struct remote_domain_disk_error {
         int error;
 };
 typedef struct remote_domain_disk_error remote_domain_disk_error;
+#define REMOTE_CONNECT_OPEN_COALESCE_EVENTS 8
 
 struct remote_connect_open_args {
         remote_string name;
@@ -4315,6 +4316,51 @@ struct remote_connect_list_all_nwfilter_bindings_ret {
         u_int ret;
 };
 typedef struct remote_connect_list_all_nwfilter_bindings_ret remote_connect_list_all_nwfilter_bindings_ret;
+
+struct remote_connect_lookup_domains_by_uuid_args {
+        struct {
+                u_int uuids_len;
+                remote_uuid *uuids_val;
+        } uuids;
+        int need_states;
+        u_int flags;
+};
+typedef struct remote_connect_lookup_domains_by_uuid_args remote_connect_lookup_domains_by_uuid_args;
+
+struct remote_connect_lookup_domains_by_uuid_ret {
+        struct {
+                u_int doms_len;
+                remote_domain *doms_val;
+        } doms;
+        struct {
+                u_int states_len;
+                int *states_val;
+        } states;
+};
+typedef struct remote_connect_lookup_domains_by_uuid_ret remote_connect_lookup_domains_by_uuid_ret;
+
+struct remote_domain_list_lifecycle_args {
+        struct {
+                u_int doms_len;
+                remote_nonnull_domain *doms_val;
+        } doms;
+        int action;
+        u_int flags;
+};
+typedef struct remote_domain_list_lifecycle_args remote_domain_list_lifecycle_args;
+
+struct remote_domain_list_lifecycle_ret {
+        struct {
+                u_int errors_len;
+                int *errors_val;
+        } errors;
+};
+typedef struct remote_domain_list_lifecycle_ret remote_domain_list_lifecycle_ret;
+
+struct remote_connect_open_shared_ring_args {
+        u_int flags;
+};
+typedef struct remote_connect_open_shared_ring_args remote_connect_open_shared_ring_args;
 #define REMOTE_PROGRAM 0x20008086
 #define REMOTE_PROTOCOL_VERSION 1
 
@@ -4721,6 +4767,9 @@ enum remote_procedure {
         REMOTE_PROC_NWFILTER_BINDING_DELETE = 400,
         REMOTE_PROC_CONNECT_LIST_ALL_NWFILTER_BINDINGS = 401,
         REMOTE_PROC_DOMAIN_SET_IOTHREAD_PARAMS = 402,
+        REMOTE_PROC_CONNECT_LOOKUP_DOMAINS_BY_UUID = 403,
+        REMOTE_PROC_DOMAIN_LIST_LIFECYCLE = 404,
+        REMOTE_PROC_CONNECT_OPEN_SHARED_RING = 405,
 };
 typedef enum remote_procedure remote_procedure;
 
@@ -5362,6 +5411,11 @@ extern  bool_t xdr_remote_nwfilter_binding_get_xml_desc_args (XDR *, remote_nwfi
 extern  bool_t xdr_remote_nwfilter_binding_get_xml_desc_ret (XDR *, remote_nwfilter_binding_get_xml_desc_ret*);
 extern  bool_t xdr_remote_connect_list_all_nwfilter_bindings_args (XDR *, remote_connect_list_all_nwfilter_bindings_args*);
 extern  bool_t xdr_remote_connect_list_all_nwfilter_bindings_ret (XDR *, remote_connect_list_all_nwfilter_bindings_ret*);
+extern  bool_t xdr_remote_connect_lookup_domains_by_uuid_args (XDR *, remote_connect_lookup_domains_by_uuid_args*);
+extern  bool_t xdr_remote_connect_lookup_domains_by_uuid_ret (XDR *, remote_connect_lookup_domains_by_uuid_ret*);
+extern  bool_t xdr_remote_domain_list_lifecycle_args (XDR *, remote_domain_list_lifecycle_args*);
+extern  bool_t xdr_remote_domain_list_lifecycle_ret (XDR *, remote_domain_list_lifecycle_ret*);
+extern  bool_t xdr_remote_connect_open_shared_ring_args (XDR *, remote_connect_open_shared_ring_args*);
 extern  bool_t xdr_remote_procedure (XDR *, remote_procedure*);
 
 #else /* K&R C */
@@ -6000,6 +6054,11 @@ extern bool_t xdr_remote_nwfilter_binding_get_xml_desc_args ();
 extern bool_t xdr_remote_nwfilter_binding_get_xml_desc_ret ();
 extern bool_t xdr_remote_connect_list_all_nwfilter_bindings_args ();
 extern bool_t xdr_remote_connect_list_all_nwfilter_bindings_ret ();
+extern bool_t xdr_remote_connect_lookup_domains_by_uuid_args ();
+extern bool_t xdr_remote_connect_lookup_domains_by_uuid_ret ();
+extern bool_t xdr_remote_domain_list_lifecycle_args ();
+extern bool_t xdr_remote_domain_list_lifecycle_ret ();
+extern bool_t xdr_remote_connect_open_shared_ring_args ();
 extern bool_t xdr_remote_procedure ();
 
 #endif /* K&R C */
@@ -443,6 +443,12 @@ struct remote_domain_disk_error {
  * Dynamic opaque and remote_nonnull_string arrays can be annotated with an
  * optional typecast */
 
+/* Flag of remote_connect_open_args telling the server to open its
+ * connection with VIR_CONNECT_COALESCE_EVENTS. The client uses the
+ * bits following VIR_CONNECT_RO for its own purposes, so this can't
+ * be the value of the public flag. */
+const REMOTE_CONNECT_OPEN_COALESCE_EVENTS = 8;
+
 struct remote_connect_open_args {
     /* NB. "name" might be NULL although in practice you can't
      * yet do that using the remote_internal driver.
@@ -3565,6 +3571,31 @@ struct remote_connect_list_all_nwfilter_bindings_ret { /* insert@1 */
     unsigned int ret;
 };
 
+struct remote_connect_lookup_domains_by_uuid_args {
+    remote_uuid uuids<REMOTE_DOMAIN_LIST_MAX>;
+    int need_states;
+    unsigned int flags;
+};
+
+struct remote_connect_lookup_domains_by_uuid_ret {
+    remote_domain doms<REMOTE_DOMAIN_LIST_MAX>;
+    int states<REMOTE_DOMAIN_LIST_MAX>;
+};
+
+struct remote_domain_list_lifecycle_args {
+    remote_nonnull_domain doms<REMOTE_DOMAIN_LIST_MAX>;
+    int action;
+    unsigned int flags;
+};
+
+struct remote_domain_list_lifecycle_ret {
+    int errors<REMOTE_DOMAIN_LIST_MAX>;
+};
+
+struct remote_connect_open_shared_ring_args {
+    unsigned int flags;
+};
+
 /*----- Protocol. -----*/
 
 /* Define the program number, protocol version and procedure numbers here. */
@@ -6328,6 +6359,27 @@ enum remote_procedure {
      * @acl: domain:save:!VIR_DOMAIN_AFFECT_CONFIG|VIR_DOMAIN_AFFECT_LIVE
      * @acl: domain:save:VIR_DOMAIN_AFFECT_CONFIG
      */
-    REMOTE_PROC_DOMAIN_SET_IOTHREAD_PARAMS = 402
+    REMOTE_PROC_DOMAIN_SET_IOTHREAD_PARAMS = 402,
+
+    /**
+     * @generate: none
+     * @acl: connect:search_domains
+     * @aclfilter: domain:getattr
+     */
+    REMOTE_PROC_CONNECT_LOOKUP_DOMAINS_BY_UUID = 403,
+
+    /**
+     * @generate: none
+     * @acl: domain:start:!VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN|VIR_DOMAIN_LIST_LIFECYCLE_DESTROY
+     * @acl: domain:init_control:VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN
+     * @acl: domain:stop:VIR_DOMAIN_LIST_LIFECYCLE_DESTROY
+     */
+    REMOTE_PROC_DOMAIN_LIST_LIFECYCLE = 404,
+
+    /**
+     * @generate: none
+     * @acl: none
+     */
+    REMOTE_PROC_CONNECT_OPEN_SHARED_RING = 405
 
 };
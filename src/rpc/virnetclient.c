@@ -58,6 +58,10 @@ struct _virNetClientCall {
     bool nonBlock;
     bool haveThread;
 
+    /* Set for asynchronous calls, which never have a thread */
+    virNetClientCallCompleteFunc completeCb;
+    void *completeOpaque;
+
     virCond cond;
 
     virNetClientCallPtr next;
@@ -80,6 +84,8 @@ struct _virNetClient {
 
     /* For incoming message packets */
     virNetMessage msg;
+    /* Where the server puts large replies, if set up */
+    virNetSharedRingPtr ring;
 
 #if WITH_SASL
     virNetSASLSessionPtr sasl;
@@ -99,6 +105,11 @@ struct _virNetClient {
     /* True if a thread holds the buck */
     bool haveTheBuck;
 
+    /* Asynchronous calls which are finished, but whose callbacks
+     * are yet to be run from the event loop */
+    virNetClientCallPtr asyncDone;
+    int asyncTimer;
+
     size_t nstreams;
     virNetClientStreamPtr *streams;
 
@@ -311,6 +322,7 @@ static virNetClientPtr virNetClientNew(virNetSocketPtr sock,
         goto error;
 
     client->sock = sock;
+    client->asyncTimer = -1;
     client->wakeupReadFD = wakeupFD[0];
     client->wakeupSendFD = wakeupFD[1];
     wakeupFD[0] = wakeupFD[1] = -1;
@@ -759,6 +771,7 @@ void virNetClientDispose(void *obj)
 #if WITH_SASL
     virObjectUnref(client->sasl);
 #endif
+    virObjectUnref(client->ring);
 
     virNetMessageClear(&client->msg);
 }
@@ -807,6 +820,10 @@ virNetClientCloseLocked(virNetClientPtr client)
     client->keepalive = NULL;
     client->wantClose = false;
 
+    /* Let the timer deliver what is left and remove itself */
+    if (client->asyncTimer >= 0)
+        virEventUpdateTimeout(client->asyncTimer, 0);
+
     virFreeError(client->error);
     client->error = NULL;
 
@@ -882,6 +899,25 @@ void virNetClientSetSASLSession(virNetClientPtr client,
 #endif
 
 
+/**
+ * virNetClientSetSharedRing:
+ * @client: the client
+ * @ring: the client side of the ring set up by the server
+ *
+ * Lets @client accept replies passed through @ring. The server may
+ * start using the ring as soon as it has handed it over, so this must
+ * be called before any other call is made.
+ */
+void virNetClientSetSharedRing(virNetClientPtr client,
+                               virNetSharedRingPtr ring)
+{
+    virObjectLock(client);
+    virObjectUnref(client->ring);
+    client->ring = virObjectRef(ring);
+    virObjectUnlock(client);
+}
+
+
 #if WITH_GNUTLS
 int virNetClientSetTLSSession(virNetClientPtr client,
                               virNetTLSContextPtr tls)
@@ -1098,6 +1134,57 @@ int virNetClientGetTLSKeySize(virNetClientPtr client)
 }
 #endif
 
+/*
+ * The reply was put into the shared memory ring, copy it from there
+ * straight into the buffer of the call it belongs to.
+ */
+static int
+virNetClientCallDispatchSharedReply(virNetClientPtr client,
+                                    virNetClientCallPtr thecall)
+{
+    virNetMessageShared shared;
+
+    if (!client->ring) {
+        virReportError(VIR_ERR_RPC, "%s",
+                       _("got shared reply without a shared memory ring"));
+        return -1;
+    }
+
+    memset(&shared, 0, sizeof(shared));
+    if (virNetMessageDecodePayload(&client->msg,
+                                   (xdrproc_t)xdr_virNetMessageShared,
+                                   &shared) < 0)
+        return -1;
+
+    if (shared.length < VIR_NET_MESSAGE_LEN_MAX + VIR_NET_MESSAGE_HEADER_MAX ||
+        shared.length > VIR_NET_MESSAGE_MAX + VIR_NET_MESSAGE_LEN_MAX) {
+        virReportError(VIR_ERR_RPC,
+                       _("invalid shared reply length %u"), shared.length);
+        return -1;
+    }
+
+    if (VIR_REALLOC_N(thecall->msg->buffer, shared.length) < 0 ||
+        virNetSharedRingTake(client->ring, shared.pos, shared.length,
+                             thecall->msg->buffer) < 0)
+        return -1;
+
+    thecall->msg->bufferLength = shared.length;
+    if (virNetMessageDecodeHeader(thecall->msg) < 0)
+        return -1;
+
+    if (thecall->msg->header.type != VIR_NET_REPLY ||
+        thecall->msg->header.serial != client->msg.header.serial) {
+        virReportError(VIR_ERR_RPC, "%s",
+                       _("shared reply does not match its call"));
+        return -1;
+    }
+
+    thecall->mode = VIR_NET_CLIENT_MODE_COMPLETE;
+
+    return 0;
+}
+
+
 static int
 virNetClientCallDispatchReply(virNetClientPtr client)
 {
@@ -1119,6 +1206,9 @@ virNetClientCallDispatchReply(virNetClientPtr client)
         return -1;
     }
 
+    if (client->msg.header.type == VIR_NET_REPLY_SHARED)
+        return virNetClientCallDispatchSharedReply(client, thecall);
+
     if (VIR_REALLOC_N(thecall->msg->buffer, client->msg.bufferLength) < 0)
         return -1;
 
@@ -1273,6 +1363,7 @@ virNetClientCallDispatch(virNetClientPtr client)
     switch (client->msg.header.type) {
     case VIR_NET_REPLY: /* Normal RPC replies */
     case VIR_NET_REPLY_WITH_FDS: /* Normal RPC replies with FDs */
+    case VIR_NET_REPLY_SHARED: /* Large RPC replies in the shared ring */
         return virNetClientCallDispatchReply(client);
 
     case VIR_NET_MESSAGE: /* Async notifications */
@@ -1551,6 +1642,95 @@ virNetClientIOEventLoopRemoveAll(virNetClientCallPtr call,
 }
 
 
+/*
+ * Move a finished asynchronous call to the list of calls whose
+ * callbacks are to be run from the event loop. With @opaque->wantClose
+ * set, unfinished calls are moved too, they are going to fail.
+ */
+static bool
+virNetClientIOEventLoopRemoveAsync(virNetClientCallPtr call,
+                                   void *opaque)
+{
+    virNetClientPtr client = opaque;
+
+    if (!call->completeCb)
+        return false;
+
+    if (call->mode != VIR_NET_CLIENT_MODE_COMPLETE &&
+        !client->wantClose)
+        return false;
+
+    VIR_DEBUG("Async call %p done, mode=%d", call, call->mode);
+    virNetClientCallQueue(&client->asyncDone, call);
+    return true;
+}
+
+
+static void
+virNetClientCollectAsync(virNetClientPtr client)
+{
+    virNetClientCallRemovePredicate(&client->waitDispatch,
+                                    virNetClientIOEventLoopRemoveAsync,
+                                    client);
+
+    if (client->asyncDone && client->asyncTimer >= 0)
+        virEventUpdateTimeout(client->asyncTimer, 0);
+}
+
+
+/*
+ * Run the callbacks of finished asynchronous calls. The client lock
+ * is dropped around each callback so that it can issue more calls.
+ */
+static void
+virNetClientAsyncDeliver(virNetClientPtr client)
+{
+    while (client->asyncDone) {
+        virNetClientCallPtr call = client->asyncDone;
+        int status = 0;
+
+        client->asyncDone = call->next;
+        call->next = NULL;
+
+        virObjectUnlock(client);
+
+        if (call->mode != VIR_NET_CLIENT_MODE_COMPLETE) {
+            virReportError(VIR_ERR_RPC, "%s",
+                           _("connection closed before the reply was received"));
+            status = -1;
+        }
+        call->completeCb(client, call->msg, status, call->completeOpaque);
+        virResetLastError();
+
+        virObjectLock(client);
+
+        virCondDestroy(&call->cond);
+        VIR_FREE(call);
+    }
+}
+
+
+static void
+virNetClientAsyncTimer(int timer,
+                       void *opaque)
+{
+    virNetClientPtr client = opaque;
+
+    virObjectLock(client);
+
+    virEventUpdateTimeout(timer, -1);
+    virNetClientAsyncDeliver(client);
+
+    /* No more calls can be made once the socket is gone */
+    if (!client->sock && !client->asyncDone) {
+        virEventRemoveTimeout(timer);
+        client->asyncTimer = -1;
+    }
+
+    virObjectUnlock(client);
+}
+
+
 static void
 virNetClientIOEventLoopPassTheBuck(virNetClientPtr client,
                                    virNetClientCallPtr thiscall)
@@ -1571,6 +1751,7 @@ virNetClientIOEventLoopPassTheBuck(virNetClientPtr client,
 
     VIR_DEBUG("No thread to pass the buck to");
     if (client->wantClose) {
+        virNetClientCollectAsync(client);
         virNetClientCloseLocked(client);
         virNetClientCallRemovePredicate(&client->waitDispatch,
                                         virNetClientIOEventLoopRemoveAll,
@@ -1725,6 +1906,7 @@ static int virNetClientIOEventLoop(virNetClientPtr client,
         /* Iterate through waiting calls and if any are
          * complete, remove them from the dispatch list.
          */
+        virNetClientCollectAsync(client);
         virNetClientCallRemovePredicate(&client->waitDispatch,
                                         virNetClientIOEventLoopRemoveDone,
                                         thiscall);
@@ -2008,6 +2190,7 @@ void virNetClientIncomingEvent(virNetSocketPtr sock,
     }
 
     /* Remove completed calls or signal their threads. */
+    virNetClientCollectAsync(client);
     virNetClientCallRemovePredicate(&client->waitDispatch,
                                     virNetClientIOEventLoopRemoveDone,
                                     NULL);
@@ -2015,11 +2198,14 @@ void virNetClientIncomingEvent(virNetSocketPtr sock,
 
  done:
     if (client->wantClose && !client->haveTheBuck) {
+        virNetClientCollectAsync(client);
         virNetClientCloseLocked(client);
         virNetClientCallRemovePredicate(&client->waitDispatch,
                                         virNetClientIOEventLoopRemoveAll,
                                         NULL);
     }
+    if (!client->haveTheBuck)
+        virNetClientAsyncDeliver(client);
     virObjectUnlock(client);
 }
 
@@ -2204,6 +2390,95 @@ int virNetClientSendNonBlock(virNetClientPtr client,
     return ret;
 }
 
+/*
+ * @msg: a message allocated on the heap
+ * @cb: callback to run once the reply arrived
+ * @opaque: data for @cb
+ *
+ * Send a message asynchronously, and have @cb called with the reply
+ * from the event loop. Several such calls can be in flight at once,
+ * as well as calls made by other threads with virNetClientSendWithReply.
+ * The client must have been set up with virNetClientRegisterAsyncIO.
+ *
+ * If this returns 0, @cb is always called exactly once, with @status
+ * set to 0 and the reply in @msg, or -1 and an error reported if the
+ * connection was closed first. From then on @msg belongs to @cb.
+ *
+ * Returns 0 if the message was queued, -1 on failure
+ */
+int virNetClientSendWithReplyAsync(virNetClientPtr client,
+                                   virNetMessagePtr msg,
+                                   virNetClientCallCompleteFunc cb,
+                                   void *opaque)
+{
+    virNetClientCallPtr call;
+    int ret = -1;
+
+    PROBE(RPC_CLIENT_MSG_TX_QUEUE,
+          "client=%p len=%zu prog=%u vers=%u proc=%u type=%u status=%u serial=%u",
+          client, msg->bufferLength,
+          msg->header.prog, msg->header.vers, msg->header.proc,
+          msg->header.type, msg->header.status, msg->header.serial);
+
+    virObjectLock(client);
+
+    if (!client->sock || client->wantClose) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("client socket is closed"));
+        goto cleanup;
+    }
+
+    if (!client->asyncIO) {
+        virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                       _("asynchronous calls require an event loop"));
+        goto cleanup;
+    }
+
+    if (client->asyncTimer < 0) {
+        virObjectRef(client);
+        if ((client->asyncTimer = virEventAddTimeout(-1,
+                                                     virNetClientAsyncTimer,
+                                                     client,
+                                                     virObjectFreeCallback)) < 0) {
+            virObjectUnref(client);
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("Unable to register async call timer"));
+            goto cleanup;
+        }
+    }
+
+    if (!(call = virNetClientCallNew(msg, true, false)))
+        goto cleanup;
+
+    call->completeCb = cb;
+    call->completeOpaque = opaque;
+
+    virNetClientCallQueue(&client->waitDispatch, call);
+
+    if (client->haveTheBuck) {
+        char ignore = 1;
+
+        /* The thread polling the socket will send it along with its own */
+        if (safewrite(client->wakeupSendFD, &ignore, sizeof(ignore)) != sizeof(ignore)) {
+            virNetClientCallRemove(&client->waitDispatch, call);
+            virCondDestroy(&call->cond);
+            VIR_FREE(call);
+            virReportSystemError(errno, "%s",
+                                 _("failed to wake up polling thread"));
+            goto cleanup;
+        }
+    } else {
+        virNetClientIOUpdateCallback(client, true);
+    }
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnlock(client);
+    return ret;
+}
+
+
 /*
  * @msg: a message allocated on heap or stack
  *
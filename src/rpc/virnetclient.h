@@ -25,6 +25,7 @@
 #  include "virnettlscontext.h"
 # endif
 # include "virnetmessage.h"
+# include "virnetsharedring.h"
 # ifdef WITH_SASL
 #  include "virnetsaslcontext.h"
 # endif
@@ -119,6 +120,16 @@ int virNetClientSendWithReplyStream(virNetClientPtr client,
                                     virNetMessagePtr msg,
                                     virNetClientStreamPtr st);
 
+typedef void (*virNetClientCallCompleteFunc)(virNetClientPtr client,
+                                             virNetMessagePtr msg,
+                                             int status,
+                                             void *opaque);
+
+int virNetClientSendWithReplyAsync(virNetClientPtr client,
+                                   virNetMessagePtr msg,
+                                   virNetClientCallCompleteFunc cb,
+                                   void *opaque);
+
 # ifdef WITH_SASL
 void virNetClientSetSASLSession(virNetClientPtr client,
                                 virNetSASLSessionPtr sasl);
@@ -129,6 +140,9 @@ int virNetClientSetTLSSession(virNetClientPtr client,
                               virNetTLSContextPtr tls);
 # endif
 
+void virNetClientSetSharedRing(virNetClientPtr client,
+                               virNetSharedRingPtr ring);
+
 bool virNetClientIsEncrypted(virNetClientPtr client);
 bool virNetClientIsOpen(virNetClientPtr client);
 
@@ -263,6 +263,56 @@ int virNetClientProgramDispatch(virNetClientProgramPtr prog,
 }
 
 
+/*
+ * Validate a reply to call @proc with @serial. A reply carrying an
+ * error is reported as such.
+ */
+static int
+virNetClientProgramCheckReply(virNetClientProgramPtr prog,
+                              virNetMessagePtr msg,
+                              int proc,
+                              unsigned serial)
+{
+    /* None of these 3 should ever happen here, because
+     * virNetClientSend should have validated the reply,
+     * but it doesn't hurt to check again.
+     */
+    if (msg->header.type != VIR_NET_REPLY &&
+        msg->header.type != VIR_NET_REPLY_WITH_FDS) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Unexpected message type %d"), msg->header.type);
+        return -1;
+    }
+    if (msg->header.proc != proc) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Unexpected message proc %d != %d"),
+                       msg->header.proc, proc);
+        return -1;
+    }
+    if (msg->header.serial != serial) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Unexpected message serial %d != %d"),
+                       msg->header.serial, serial);
+        return -1;
+    }
+
+    switch (msg->header.status) {
+    case VIR_NET_OK:
+        return 0;
+
+    case VIR_NET_ERROR:
+        virNetClientProgramDispatchError(prog, msg);
+        return -1;
+
+    case VIR_NET_CONTINUE:
+    default:
+        virReportError(VIR_ERR_RPC,
+                       _("Unexpected message status %d"), msg->header.status);
+        return -1;
+    }
+}
+
+
 int virNetClientProgramCall(virNetClientProgramPtr prog,
                             virNetClientPtr client,
                             unsigned serial,
@@ -324,67 +374,33 @@ int virNetClientProgramCall(virNetClientProgramPtr prog,
     if (virNetClientSendWithReply(client, msg) < 0)
         goto error;
 
-    /* None of these 3 should ever happen here, because
-     * virNetClientSend should have validated the reply,
-     * but it doesn't hurt to check again.
-     */
-    if (msg->header.type != VIR_NET_REPLY &&
-        msg->header.type != VIR_NET_REPLY_WITH_FDS) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Unexpected message type %d"), msg->header.type);
-        goto error;
-    }
-    if (msg->header.proc != proc) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Unexpected message proc %d != %d"),
-                       msg->header.proc, proc);
+    if (virNetClientProgramCheckReply(prog, msg, proc, serial) < 0)
         goto error;
-    }
-    if (msg->header.serial != serial) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Unexpected message serial %d != %d"),
-                       msg->header.serial, serial);
-        goto error;
-    }
 
-    switch (msg->header.status) {
-    case VIR_NET_OK:
-        if (infds && ninfds) {
-            *ninfds = msg->nfds;
-            if (VIR_ALLOC_N(*infds, *ninfds) < 0)
+    if (infds && ninfds) {
+        *ninfds = msg->nfds;
+        if (VIR_ALLOC_N(*infds, *ninfds) < 0)
+            goto error;
+        for (i = 0; i < *ninfds; i++)
+            (*infds)[i] = -1;
+        for (i = 0; i < *ninfds; i++) {
+            if (((*infds)[i] = dup(msg->fds[i])) < 0) {
+                virReportSystemError(errno,
+                                     _("Cannot duplicate FD %d"),
+                                     msg->fds[i]);
+                goto error;
+            }
+            if (virSetInherit((*infds)[i], false) < 0) {
+                virReportSystemError(errno,
+                                     _("Cannot set close-on-exec %d"),
+                                     (*infds)[i]);
                 goto error;
-            for (i = 0; i < *ninfds; i++)
-                (*infds)[i] = -1;
-            for (i = 0; i < *ninfds; i++) {
-                if (((*infds)[i] = dup(msg->fds[i])) < 0) {
-                    virReportSystemError(errno,
-                                         _("Cannot duplicate FD %d"),
-                                         msg->fds[i]);
-                    goto error;
-                }
-                if (virSetInherit((*infds)[i], false) < 0) {
-                    virReportSystemError(errno,
-                                         _("Cannot set close-on-exec %d"),
-                                         (*infds)[i]);
-                    goto error;
-                }
             }
-
         }
-        if (virNetMessageDecodePayload(msg, ret_filter, ret) < 0)
-            goto error;
-        break;
 
-    case VIR_NET_ERROR:
-        virNetClientProgramDispatchError(prog, msg);
-        goto error;
-
-    case VIR_NET_CONTINUE:
-    default:
-        virReportError(VIR_ERR_RPC,
-                       _("Unexpected message status %d"), msg->header.status);
-        goto error;
     }
+    if (virNetMessageDecodePayload(msg, ret_filter, ret) < 0)
+        goto error;
 
     virNetMessageFree(msg);
 
@@ -398,3 +414,115 @@ int virNetClientProgramCall(virNetClientProgramPtr prog,
     }
     return -1;
 }
+
+
+typedef struct _virNetClientProgramAsyncCall virNetClientProgramAsyncCall;
+typedef virNetClientProgramAsyncCall *virNetClientProgramAsyncCallPtr;
+struct _virNetClientProgramAsyncCall {
+    virNetClientProgramPtr prog;
+    int proc;
+    unsigned serial;
+    xdrproc_t ret_filter;
+    size_t ret_size;
+    virNetClientProgramCallFunc func;
+    void *opaque;
+};
+
+
+static void
+virNetClientProgramCallAsyncComplete(virNetClientPtr client,
+                                     virNetMessagePtr msg,
+                                     int status,
+                                     void *opaque)
+{
+    virNetClientProgramAsyncCallPtr data = opaque;
+    char *ret = NULL;
+
+    if (status < 0 ||
+        virNetClientProgramCheckReply(data->prog, msg,
+                                      data->proc, data->serial) < 0)
+        goto done;
+
+    if (VIR_ALLOC_N(ret, data->ret_size) < 0)
+        goto done;
+
+    if (virNetMessageDecodePayload(msg, data->ret_filter, ret) < 0) {
+        VIR_FREE(ret);
+        goto done;
+    }
+
+ done:
+    data->func(data->prog, client, ret, data->opaque);
+
+    if (ret) {
+        xdr_free(data->ret_filter, ret);
+        VIR_FREE(ret);
+    }
+    virNetMessageFree(msg);
+    virObjectUnref(data->prog);
+    VIR_FREE(data);
+}
+
+
+/*
+ * Like virNetClientProgramCall, but returns as soon as the call was
+ * queued. Once the reply arrived, @func is called from the event loop
+ * with the decoded @ret_size bytes large reply, or with NULL and an
+ * error reported if the call failed. The reply is freed once @func
+ * returns.
+ *
+ * Returns 0 if the call was queued, in which case @func is guaranteed
+ * to be called, -1 on error.
+ */
+int virNetClientProgramCallAsync(virNetClientProgramPtr prog,
+                                 virNetClientPtr client,
+                                 unsigned serial,
+                                 int proc,
+                                 xdrproc_t args_filter, void *args,
+                                 xdrproc_t ret_filter, size_t ret_size,
+                                 virNetClientProgramCallFunc func,
+                                 void *opaque)
+{
+    virNetMessagePtr msg;
+    virNetClientProgramAsyncCallPtr data = NULL;
+
+    if (!(msg = virNetMessageNew(false)))
+        return -1;
+
+    msg->header.prog = prog->program;
+    msg->header.vers = prog->version;
+    msg->header.status = VIR_NET_OK;
+    msg->header.type = VIR_NET_CALL;
+    msg->header.serial = serial;
+    msg->header.proc = proc;
+
+    if (virNetMessageEncodeHeader(msg) < 0 ||
+        virNetMessageEncodePayload(msg, args_filter, args) < 0)
+        goto error;
+
+    if (VIR_ALLOC(data) < 0)
+        goto error;
+
+    data->prog = virObjectRef(prog);
+    data->proc = proc;
+    data->serial = serial;
+    data->ret_filter = ret_filter;
+    data->ret_size = ret_size;
+    data->func = func;
+    data->opaque = opaque;
+
+    if (virNetClientSendWithReplyAsync(client, msg,
+                                       virNetClientProgramCallAsyncComplete,
+                                       data) < 0)
+        goto error;
+
+    return 0;
+
+ error:
+    if (data) {
+        virObjectUnref(data->prog);
+        VIR_FREE(data);
+    }
+    virNetMessageFree(msg);
+    return -1;
+}
@@ -79,6 +79,20 @@ int virNetClientProgramCall(virNetClientProgramPtr prog,
                             xdrproc_t args_filter, void *args,
                             xdrproc_t ret_filter, void *ret);
 
+typedef void (*virNetClientProgramCallFunc)(virNetClientProgramPtr prog,
+                                            virNetClientPtr client,
+                                            void *ret,
+                                            void *opaque);
+
+int virNetClientProgramCallAsync(virNetClientProgramPtr prog,
+                                 virNetClientPtr client,
+                                 unsigned serial,
+                                 int proc,
+                                 xdrproc_t args_filter, void *args,
+                                 xdrproc_t ret_filter, size_t ret_size,
+                                 virNetClientProgramCallFunc func,
+                                 void *opaque);
+
 
 
 #endif /* LIBVIRT_VIRNETCLIENTPROGRAM_H */
@@ -69,12 +69,14 @@ virNetMessageClearPayload(virNetMessagePtr msg)
 void virNetMessageClear(virNetMessagePtr msg)
 {
     bool tracked = msg->tracked;
+    bool priority = msg->priority;
 
     VIR_DEBUG("msg=%p nfds=%zu", msg, msg->nfds);
 
     virNetMessageClearPayload(msg);
     memset(msg, 0, sizeof(*msg));
     msg->tracked = tracked;
+    msg->priority = priority;
 }
 
 
@@ -357,27 +359,42 @@ int virNetMessageEncodePayload(virNetMessagePtr msg,
     xdrmem_create(&xdr, msg->buffer + msg->bufferOffset,
                   msg->bufferLength - msg->bufferOffset, XDR_ENCODE);
 
-    /* Try to encode the payload. If the buffer is too small increase it. */
-    while (!(*filter)(&xdr, data, 0)) {
-        unsigned int newlen = msg->bufferLength - VIR_NET_MESSAGE_LEN_MAX;
-        newlen *= 2;
+    /* Try to encode the payload. If the buffer is too small, work out
+     * the exact size the payload needs and grow the buffer just once,
+     * rather than repeatedly doubling it and starting over. */
+    if (!(*filter)(&xdr, data, 0)) {
+        unsigned long payloadlen;
+        size_t newlen;
+
+        xdr_destroy(&xdr);
 
-        if (newlen > VIR_NET_MESSAGE_MAX) {
+        if ((payloadlen = xdr_sizeof(filter, data)) == 0) {
             virReportError(VIR_ERR_RPC, "%s", _("Unable to encode message payload"));
             goto error;
         }
 
-        xdr_destroy(&xdr);
+        newlen = msg->bufferOffset + payloadlen;
 
-        msg->bufferLength = newlen + VIR_NET_MESSAGE_LEN_MAX;
-
-        if (VIR_REALLOC_N(msg->buffer, msg->bufferLength) < 0)
+        if (payloadlen > VIR_NET_MESSAGE_MAX ||
+            newlen - VIR_NET_MESSAGE_LEN_MAX > VIR_NET_MESSAGE_MAX) {
+            virReportError(VIR_ERR_RPC, "%s", _("Unable to encode message payload"));
             goto error;
+        }
+
+        if (newlen > msg->bufferLength) {
+            if (VIR_REALLOC_N(msg->buffer, newlen) < 0)
+                goto error;
+            msg->bufferLength = newlen;
+            VIR_DEBUG("Increased message buffer length = %zu", msg->bufferLength);
+        }
 
         xdrmem_create(&xdr, msg->buffer + msg->bufferOffset,
                       msg->bufferLength - msg->bufferOffset, XDR_ENCODE);
 
-        VIR_DEBUG("Increased message buffer length = %zu", msg->bufferLength);
+        if (!(*filter)(&xdr, data, 0)) {
+            virReportError(VIR_ERR_RPC, "%s", _("Unable to encode message payload"));
+            goto error;
+        }
     }
 
     /* Get the length stored in buffer. */
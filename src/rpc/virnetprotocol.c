@@ -202,3 +202,14 @@ xdr_virNetStreamHole (XDR *xdrs, virNetStreamHole *objp)
                  return FALSE;
         return TRUE;
 }
+
+bool_t
+xdr_virNetMessageShared (XDR *xdrs, virNetMessageShared *objp)
+{
+
+         if (!xdr_u_int (xdrs, &objp->pos))
+                 return FALSE;
+         if (!xdr_u_int (xdrs, &objp->length))
+                 return FALSE;
+        return TRUE;
+}
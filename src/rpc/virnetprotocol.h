@@ -33,6 +33,7 @@ enum virNetMessageType {
         VIR_NET_CALL_WITH_FDS = 4,
         VIR_NET_REPLY_WITH_FDS = 5,
         VIR_NET_STREAM_HOLE = 6,
+        VIR_NET_REPLY_SHARED = 7,
 };
 typedef enum virNetMessageType virNetMessageType;
 
@@ -98,6 +99,12 @@ struct virNetStreamHole {
 };
 typedef struct virNetStreamHole virNetStreamHole;
 
+struct virNetMessageShared {
+        u_int pos;
+        u_int length;
+};
+typedef struct virNetMessageShared virNetMessageShared;
+
 /* the xdr functions */
 
 #if defined(__STDC__) || defined(__cplusplus)
@@ -113,6 +120,7 @@ extern  bool_t xdr_virNetMessageDomain (XDR *, virNetMessageDomain*);
 extern  bool_t xdr_virNetMessageNetwork (XDR *, virNetMessageNetwork*);
 extern  bool_t xdr_virNetMessageError (XDR *, virNetMessageError*);
 extern  bool_t xdr_virNetStreamHole (XDR *, virNetStreamHole*);
+extern  bool_t xdr_virNetMessageShared (XDR *, virNetMessageShared*);
 
 #else /* K&R C */
 extern bool_t xdr_virNetMessageType ();
@@ -127,6 +135,7 @@ extern bool_t xdr_virNetMessageDomain ();
 extern bool_t xdr_virNetMessageNetwork ();
 extern bool_t xdr_virNetMessageError ();
 extern bool_t xdr_virNetStreamHole ();
+extern bool_t xdr_virNetMessageShared ();
 
 #endif /* K&R C */
 
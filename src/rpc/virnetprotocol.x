@@ -149,6 +149,10 @@ const VIR_NET_MESSAGE_NUM_FDS_MAX = 32;
  *     * status == VIR_NET_OK
  *          <empty>
  *
+ *  - type == VIR_NET_REPLY_SHARED
+ *          virNetMessageShared  location of the complete VIR_NET_REPLY
+ *                               message in the shared memory ring
+ *
  */
 enum virNetMessageType {
     /* client -> server. args from a method call */
@@ -164,7 +168,10 @@ enum virNetMessageType {
     /* server -> client. reply/error from a method call, with passed FDs */
     VIR_NET_REPLY_WITH_FDS = 5,
     /* either direction, stream hole data packet */
-    VIR_NET_STREAM_HOLE = 6
+    VIR_NET_STREAM_HOLE = 6,
+    /* server -> client. reply from a method call, passed in the
+     * shared memory ring set up by the client */
+    VIR_NET_REPLY_SHARED = 7
 };
 
 enum virNetMessageStatus {
@@ -249,3 +256,8 @@ struct virNetStreamHole {
     hyper length;
     unsigned int flags;
 };
+
+struct virNetMessageShared {
+    unsigned int pos;
+    unsigned int length;
+};
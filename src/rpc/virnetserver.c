@@ -177,6 +177,38 @@ static void virNetServerHandleJob(void *jobOpaque, void *opaque)
 }
 
 
+/*
+ * Calls to procedures annotated as high priority are known not to
+ * block, so they are allowed to bypass the client's ordinary limit
+ * on requests in progress.
+ */
+static bool
+virNetServerIsPriorityMessage(virNetServerClientPtr client ATTRIBUTE_UNUSED,
+                              virNetMessagePtr msg,
+                              void *opaque)
+{
+    virNetServerPtr srv = opaque;
+    bool ret = false;
+    size_t i;
+
+    if (msg->header.type != VIR_NET_CALL &&
+        msg->header.type != VIR_NET_CALL_WITH_FDS)
+        return false;
+
+    virObjectLock(srv);
+    for (i = 0; i < srv->nprograms; i++) {
+        if (virNetServerProgramMatches(srv->programs[i], msg)) {
+            ret = virNetServerProgramGetPriority(srv->programs[i],
+                                                 msg->header.proc) != 0;
+            break;
+        }
+    }
+    virObjectUnlock(srv);
+
+    return ret;
+}
+
+
 static void
 virNetServerDispatchNewMessage(virNetServerClientPtr client,
                                virNetMessagePtr msg,
@@ -300,6 +332,7 @@ int virNetServerAddClient(virNetServerPtr srv,
 
     virNetServerClientSetDispatcher(client,
                                     virNetServerDispatchNewMessage,
+                                    virNetServerIsPriorityMessage,
                                     srv);
 
     virNetServerClientInitKeepAlive(client, srv->keepaliveInterval,
@@ -930,7 +963,9 @@ virNetServerGetThreadPoolParameters(virNetServerPtr srv,
                                     size_t *nWorkers,
                                     size_t *freeWorkers,
                                     size_t *nPrioWorkers,
-                                    size_t *jobQueueDepth)
+                                    size_t *jobQueueDepth,
+                                    size_t *prioJobQueueDepth,
+                                    unsigned long long *jobQueueAge)
 {
     virObjectLock(srv);
 
@@ -940,6 +975,8 @@ virNetServerGetThreadPoolParameters(virNetServerPtr srv,
     *nWorkers = virThreadPoolGetCurrentWorkers(srv->workers);
     *nPrioWorkers = virThreadPoolGetPriorityWorkers(srv->workers);
     *jobQueueDepth = virThreadPoolGetJobQueueDepth(srv->workers);
+    *prioJobQueueDepth = virThreadPoolGetPrioJobQueueDepth(srv->workers);
+    *jobQueueAge = virThreadPoolGetJobQueueAge(srv->workers);
 
     virObjectUnlock(srv);
     return 0;
@@ -78,6 +78,9 @@ struct _virNetServerClient
 #endif
     int sockTimer; /* Timer to be fired upon cached data,
                     * so we jump out from poll() immediately */
+    /* Large replies are passed through this ring
+     * rather than written to the socket */
+    virNetSharedRingPtr ring;
 
 
     virIdentityPtr identity;
@@ -96,9 +99,18 @@ struct _virNetServerClient
      * throttling calculations */
     size_t nrequests;
     size_t nrequests_max;
+    /* Count of high priority RPC calls in progress.
+     * They get an allowance of nrequests_max of their
+     * own so that cheap calls are not throttled behind
+     * slow ones */
+    size_t nprio_requests;
     /* Zero or one messages being received. Zero if
-     * nrequests >= max_clients and throttling */
+     * both allowances are used up and throttling */
     virNetMessagePtr rx;
+    /* Zero or many ordinary calls which were received
+     * through the high priority allowance and wait for
+     * an ordinary slot to become free */
+    virNetMessagePtr deferred;
     /* Zero or many messages waiting for transmit
      * back to client, including async events */
     virNetMessagePtr tx;
@@ -109,6 +121,7 @@ struct _virNetServerClient
     int nextFilterID;
 
     virNetServerClientDispatchFunc dispatchFunc;
+    virNetServerClientPriorityFunc priorityFunc;
     void *dispatchOpaque;
 
     void *privateData;
@@ -324,8 +337,80 @@ virNetServerClientCheckAccess(virNetServerClientPtr client)
 }
 
 
-static void virNetServerClientDispatchMessage(virNetServerClientPtr client,
-                                              virNetMessagePtr msg)
+/*
+ * @client: a locked client object
+ * @msg: message to reuse as receive buffer, or NULL
+ *
+ * Arm client->rx for the next call if there is room for it in
+ * either of the allowances. Consumes @msg.
+ */
+static void
+virNetServerClientPrepareRx(virNetServerClientPtr client,
+                            virNetMessagePtr msg)
+{
+    bool priority;
+
+    if (client->rx)
+        goto cleanup;
+
+    if (client->nrequests < client->nrequests_max) {
+        priority = false;
+    } else if (client->priorityFunc &&
+               client->nprio_requests < client->nrequests_max) {
+        /* We can't know in advance what the next call is going to
+         * be. If it turns out to be an ordinary one, it'll be kept
+         * in client->deferred until an ordinary slot is free, still
+         * holding the high priority slot. */
+        priority = true;
+    } else {
+        goto cleanup;
+    }
+
+    if (msg) {
+        virNetMessageClear(msg);
+    } else if (!(msg = virNetMessageNew(true))) {
+        client->wantClose = true;
+        return;
+    }
+
+    msg->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
+    if (VIR_ALLOC_N(msg->buffer, msg->bufferLength) < 0) {
+        client->wantClose = true;
+        goto cleanup;
+    }
+
+    msg->priority = priority;
+    if (priority)
+        client->nprio_requests++;
+    else
+        client->nrequests++;
+    client->rx = msg;
+    return;
+
+ cleanup:
+    virNetMessageFree(msg);
+}
+
+
+/*
+ * @client: a locked client object
+ * @msg: a tracked message
+ *
+ * Release the slot @msg was holding in one of the allowances.
+ */
+static void
+virNetServerClientRequestDone(virNetServerClientPtr client,
+                              virNetMessagePtr msg)
+{
+    if (msg->priority)
+        client->nprio_requests--;
+    else
+        client->nrequests--;
+}
+
+
+static void virNetServerClientDispatchCall(virNetServerClientPtr client,
+                                           virNetMessagePtr msg)
 {
     virObjectLock(client);
     if (!client->dispatchFunc) {
@@ -343,6 +428,49 @@ static void virNetServerClientDispatchMessage(virNetServerClientPtr client,
 }
 
 
+static void virNetServerClientDispatchMessage(virNetServerClientPtr client,
+                                              virNetMessagePtr msg)
+{
+    bool priority;
+
+    /* Same as for 'dispatchFunc', 'priorityFunc' never changes
+     * once set. It is called without the client lock held so
+     * that it is free to look at server state. */
+    if (!client->priorityFunc) {
+        virNetServerClientDispatchCall(client, msg);
+        return;
+    }
+
+    priority = client->priorityFunc(client, msg, client->dispatchOpaque);
+
+    virObjectLock(client);
+    if (priority && !msg->priority &&
+        client->nprio_requests < client->nrequests_max) {
+        /* Make room for one more ordinary call */
+        client->nrequests--;
+        client->nprio_requests++;
+        msg->priority = true;
+    } else if (!priority && msg->priority) {
+        if (client->nrequests < client->nrequests_max) {
+            client->nprio_requests--;
+            client->nrequests++;
+            msg->priority = false;
+        } else {
+            VIR_DEBUG("Deferring msg=%p proc=%d until a request finishes",
+                      msg, msg->header.proc);
+            virNetMessageQueuePush(&client->deferred, msg);
+            msg = NULL;
+        }
+    }
+    virNetServerClientPrepareRx(client, NULL);
+    virNetServerClientUpdateEvent(client);
+    virObjectUnlock(client);
+
+    if (msg)
+        virNetServerClientDispatchCall(client, msg);
+}
+
+
 static void virNetServerClientSockTimerFunc(int timer,
                                             void *opaque)
 {
@@ -680,6 +808,39 @@ virNetServerClientSetReadonly(virNetServerClientPtr client,
 }
 
 
+/**
+ * virNetServerClientSetSharedRing:
+ * @client: the client
+ * @ring: shared memory ring mapped by the client
+ *
+ * Makes all large replies queued from now on go through @ring. The
+ * ring can't be replaced, as the client may still have to take
+ * replies out of the previous one.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int
+virNetServerClientSetSharedRing(virNetServerClientPtr client,
+                                virNetSharedRingPtr ring)
+{
+    int ret = -1;
+
+    virObjectLock(client);
+    if (client->ring) {
+        virReportError(VIR_ERR_OPERATION_INVALID, "%s",
+                       _("shared memory ring is already set up"));
+        goto cleanup;
+    }
+
+    client->ring = virObjectRef(ring);
+    ret = 0;
+
+ cleanup:
+    virObjectUnlock(client);
+    return ret;
+}
+
+
 unsigned long long virNetServerClientGetID(virNetServerClientPtr client)
 {
     return client->id;
@@ -930,6 +1091,7 @@ void virNetServerClientSetCloseHook(virNetServerClientPtr client,
 
 void virNetServerClientSetDispatcher(virNetServerClientPtr client,
                                      virNetServerClientDispatchFunc func,
+                                     virNetServerClientPriorityFunc prioFunc,
                                      void *opaque)
 {
     virObjectLock(client);
@@ -938,6 +1100,7 @@ void virNetServerClientSetDispatcher(virNetServerClientPtr client,
      */
     if (!client->dispatchFunc) {
         client->dispatchFunc = func;
+        client->priorityFunc = prioFunc;
         client->dispatchOpaque = opaque;
     }
     virObjectUnlock(client);
@@ -986,6 +1149,7 @@ void virNetServerClientDispose(void *obj)
     virObjectUnref(client->tls);
     virObjectUnref(client->tlsCtxt);
     virObjectUnref(client->sock);
+    virObjectUnref(client->ring);
 }
 
 
@@ -1049,6 +1213,11 @@ virNetServerClientCloseLocked(virNetServerClientPtr client)
             = virNetMessageQueueServe(&client->tx);
         virNetMessageFree(msg);
     }
+    while (client->deferred) {
+        virNetMessagePtr msg
+            = virNetMessageQueueServe(&client->deferred);
+        virNetMessageFree(msg);
+    }
 
     if (client->sock) {
         virObjectUnref(client->sock);
@@ -1269,8 +1438,8 @@ static virNetMessagePtr virNetServerClientDispatchRead(virNetServerClientPtr cli
               msg->header.type, msg->header.status, msg->header.serial);
 
         if (virKeepAliveCheckMessage(client->keepalive, msg, &response)) {
+            virNetServerClientRequestDone(client, msg);
             virNetMessageFree(msg);
-            client->nrequests--;
             msg = NULL;
 
             if (response &&
@@ -1299,19 +1468,7 @@ static virNetMessagePtr virNetServerClientDispatchRead(virNetServerClientPtr cli
         }
 
         /* Possibly need to create another receive buffer */
-        if (client->nrequests < client->nrequests_max) {
-            if (!(client->rx = virNetMessageNew(true))) {
-                client->wantClose = true;
-            } else {
-                client->rx->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-                if (VIR_ALLOC_N(client->rx->buffer,
-                                client->rx->bufferLength) < 0) {
-                    client->wantClose = true;
-                } else {
-                    client->nrequests++;
-                }
-            }
-        }
+        virNetServerClientPrepareRx(client, NULL);
         virNetServerClientUpdateEvent(client);
 
         return msg;
@@ -1356,20 +1513,26 @@ static ssize_t virNetServerClientWrite(virNetServerClientPtr client)
 /*
  * Process all queued client->tx messages until
  * we would block on I/O
+ *
+ * Returns a queue of deferred calls which got an
+ * ordinary slot and must be dispatched once the
+ * client is unlocked
  */
-static void
+static virNetMessagePtr
 virNetServerClientDispatchWrite(virNetServerClientPtr client)
 {
+    virNetMessagePtr ready = NULL;
+
     while (client->tx) {
         if (client->tx->bufferOffset < client->tx->bufferLength) {
             ssize_t ret;
             ret = virNetServerClientWrite(client);
             if (ret < 0) {
                 client->wantClose = true;
-                return;
+                return ready;
             }
             if (ret == 0)
-                return; /* Would block on write EAGAIN */
+                return ready; /* Would block on write EAGAIN */
         }
 
         if (client->tx->bufferOffset == client->tx->bufferLength) {
@@ -1380,10 +1543,10 @@ virNetServerClientDispatchWrite(virNetServerClientPtr client)
                 int rv;
                 if ((rv = virNetSocketSendFD(client->sock, client->tx->fds[i])) < 0) {
                     client->wantClose = true;
-                    return;
+                    return ready;
                 }
                 if (rv == 0) /* Blocking */
-                    return;
+                    return ready;
                 client->tx->donefds++;
             }
 
@@ -1402,24 +1565,24 @@ virNetServerClientDispatchWrite(virNetServerClientPtr client)
             msg = virNetMessageQueueServe(&client->tx);
 
             if (msg->tracked) {
-                client->nrequests--;
-                /* See if the recv queue is currently throttled */
-                if (!client->rx &&
+                virNetServerClientRequestDone(client, msg);
+
+                /* Hand the freed slot to the oldest deferred call */
+                if (client->deferred &&
                     client->nrequests < client->nrequests_max) {
-                    /* Ready to recv more messages */
-                    virNetMessageClear(msg);
-                    msg->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-                    if (VIR_ALLOC_N(msg->buffer, msg->bufferLength) < 0) {
-                        virNetMessageFree(msg);
-                        return;
-                    }
-                    client->rx = msg;
-                    msg = NULL;
+                    virNetMessagePtr call
+                        = virNetMessageQueueServe(&client->deferred);
+                    client->nprio_requests--;
                     client->nrequests++;
+                    call->priority = false;
+                    virNetMessageQueuePush(&ready, call);
                 }
-            }
 
-            virNetMessageFree(msg);
+                /* See if the recv queue is currently throttled */
+                virNetServerClientPrepareRx(client, msg);
+            } else {
+                virNetMessageFree(msg);
+            }
 
             virNetServerClientUpdateEvent(client);
 
@@ -1427,6 +1590,8 @@ virNetServerClientDispatchWrite(virNetServerClientPtr client)
                 client->wantClose = true;
          }
     }
+
+    return ready;
 }
 
 
@@ -1459,6 +1624,7 @@ virNetServerClientDispatchEvent(virNetSocketPtr sock, int events, void *opaque)
 {
     virNetServerClientPtr client = opaque;
     virNetMessagePtr msg = NULL;
+    virNetMessagePtr ready = NULL;
 
     virObjectLock(client);
 
@@ -1476,7 +1642,7 @@ virNetServerClientDispatchEvent(virNetSocketPtr sock, int events, void *opaque)
             virNetServerClientDispatchHandshake(client);
         } else {
             if (events & VIR_EVENT_HANDLE_WRITABLE)
-                virNetServerClientDispatchWrite(client);
+                ready = virNetServerClientDispatchWrite(client);
             if (events & VIR_EVENT_HANDLE_READABLE &&
                 client->rx)
                 msg = virNetServerClientDispatchRead(client);
@@ -1491,11 +1657,124 @@ virNetServerClientDispatchEvent(virNetSocketPtr sock, int events, void *opaque)
 
     virObjectUnlock(client);
 
+    while (ready)
+        virNetServerClientDispatchCall(client,
+                                       virNetMessageQueueServe(&ready));
+
     if (msg)
         virNetServerClientDispatchMessage(client, msg);
 }
 
 
+/* Upper bound on the size of a batch of asynchronous messages */
+#define VIR_NET_SERVER_CLIENT_BATCH_MAX VIR_NET_MESSAGE_INITIAL
+
+static bool
+virNetServerClientCanBatch(virNetMessagePtr msg)
+{
+    return !msg->tracked &&
+        !msg->cb &&
+        msg->nfds == 0 &&
+        msg->header.type == VIR_NET_MESSAGE &&
+        msg->bufferOffset == 0;
+}
+
+
+/*
+ * @client: a locked client object
+ * @msg: an encoded message
+ *
+ * Asynchronous messages, such as events, are often queued in a burst.
+ * Rather than writing each of them separately, append @msg to the
+ * previous message if that's an asynchronous message which is still
+ * waiting. Since every message carries its own length word, what
+ * goes on the wire is the same as if they were sent one by one.
+ *
+ * Returns true if @msg was consumed.
+ */
+static bool
+virNetServerClientBatchMessage(virNetServerClientPtr client,
+                               virNetMessagePtr msg)
+{
+    virNetMessagePtr tail = client->tx;
+
+    /* The head of the queue may be in the middle of being written */
+    if (!tail || !tail->next)
+        return false;
+
+    while (tail->next)
+        tail = tail->next;
+
+    if (!virNetServerClientCanBatch(tail) ||
+        !virNetServerClientCanBatch(msg) ||
+        tail->bufferLength + msg->bufferLength > VIR_NET_SERVER_CLIENT_BATCH_MAX)
+        return false;
+
+    if (VIR_REALLOC_N_QUIET(tail->buffer,
+                            tail->bufferLength + msg->bufferLength) < 0)
+        return false;
+
+    memcpy(tail->buffer + tail->bufferLength, msg->buffer, msg->bufferLength);
+    tail->bufferLength += msg->bufferLength;
+    virNetMessageFree(msg);
+    return true;
+}
+
+
+/*
+ * @client: a locked client object with a shared memory ring
+ * @msg: an encoded message
+ *
+ * Copies a large reply into the shared memory ring and turns @msg
+ * into a short VIR_NET_REPLY_SHARED message telling the client where
+ * to find it. If the client has not consumed enough of the ring yet,
+ * @msg is left alone and goes over the socket.
+ */
+static void
+virNetServerClientShareMessage(virNetServerClientPtr client,
+                               virNetMessagePtr msg)
+{
+    virNetMessageShared shared;
+    char *buffer = msg->buffer;
+    size_t length = msg->bufferLength;
+
+    if (msg->header.type != VIR_NET_REPLY ||
+        msg->nfds != 0 ||
+        msg->bufferOffset != 0 ||
+        length < VIR_NET_SHARED_RING_MIN_MESSAGE)
+        return;
+
+    msg->buffer = NULL;
+    msg->bufferLength = 0;
+    msg->header.type = VIR_NET_REPLY_SHARED;
+
+    if (virNetMessageEncodeHeader(msg) < 0)
+        goto error;
+
+    if (!virNetSharedRingPut(client->ring, buffer, length, &shared.pos))
+        goto restore;
+
+    shared.length = length;
+    /* The client skips the space in the ring should this fail */
+    if (virNetMessageEncodePayload(msg, (xdrproc_t)xdr_virNetMessageShared,
+                                   &shared) < 0)
+        goto error;
+
+    VIR_FREE(buffer);
+    return;
+
+ error:
+    VIR_WARN("Unable to pass message through shared memory ring: %s",
+             virGetLastErrorMessage());
+ restore:
+    VIR_FREE(msg->buffer);
+    msg->buffer = buffer;
+    msg->bufferLength = length;
+    msg->bufferOffset = 0;
+    msg->header.type = VIR_NET_REPLY;
+}
+
+
 static int
 virNetServerClientSendMessageLocked(virNetServerClientPtr client,
                                     virNetMessagePtr msg)
@@ -1512,7 +1791,10 @@ virNetServerClientSendMessageLocked(virNetServerClientPtr client,
               client, msg->bufferLength,
               msg->header.prog, msg->header.vers, msg->header.proc,
               msg->header.type, msg->header.status, msg->header.serial);
-        virNetMessageQueuePush(&client->tx, msg);
+        if (client->ring)
+            virNetServerClientShareMessage(client, msg);
+        if (!virNetServerClientBatchMessage(client, msg))
+            virNetMessageQueuePush(&client->tx, msg);
 
         virNetServerClientUpdateEvent(client);
         ret = 0;
@@ -25,6 +25,7 @@
 # include "viridentity.h"
 # include "virnetsocket.h"
 # include "virnetmessage.h"
+# include "virnetsharedring.h"
 # include "virobject.h"
 # include "virjson.h"
 
@@ -41,6 +42,13 @@ typedef void (*virNetServerClientDispatchFunc)(virNetServerClientPtr client,
                                                virNetMessagePtr msg,
                                                void *opaque);
 
+/* Decides whether "msg" is a cheap call which may use the client's
+ * allowance of high priority requests. Must not take the client lock
+ */
+typedef bool (*virNetServerClientPriorityFunc)(virNetServerClientPtr client,
+                                               virNetMessagePtr msg,
+                                               void *opaque);
+
 typedef int (*virNetServerClientFilterFunc)(virNetServerClientPtr client,
                                             virNetMessagePtr msg,
                                             void *opaque);
@@ -96,6 +104,8 @@ int virNetServerClientGetAuth(virNetServerClientPtr client);
 void virNetServerClientSetAuthLocked(virNetServerClientPtr client, int auth);
 bool virNetServerClientGetReadonly(virNetServerClientPtr client);
 void virNetServerClientSetReadonly(virNetServerClientPtr client, bool readonly);
+int virNetServerClientSetSharedRing(virNetServerClientPtr client,
+                                    virNetSharedRingPtr ring);
 unsigned long long virNetServerClientGetID(virNetServerClientPtr client);
 long long virNetServerClientGetTimestamp(virNetServerClientPtr client);
 
@@ -134,6 +144,7 @@ void virNetServerClientSetCloseHook(virNetServerClientPtr client,
 
 void virNetServerClientSetDispatcher(virNetServerClientPtr client,
                                      virNetServerClientDispatchFunc func,
+                                     virNetServerClientPriorityFunc prioFunc,
                                      void *opaque);
 void virNetServerClientClose(virNetServerClientPtr client);
 void virNetServerClientCloseLocked(virNetServerClientPtr client);
@@ -321,6 +321,7 @@ int virNetServerProgramDispatch(virNetServerProgramPtr prog,
 
     case VIR_NET_REPLY:
     case VIR_NET_REPLY_WITH_FDS:
+    case VIR_NET_REPLY_SHARED:
     case VIR_NET_MESSAGE:
     case VIR_NET_STREAM_HOLE:
     default:
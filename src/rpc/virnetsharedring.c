@@ -0,0 +1,369 @@
+/*
+ * virnetsharedring.c: shared memory ring for passing RPC messages
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef __linux__
+# include <sys/mman.h>
+# if defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+#  define WITH_SHARED_RING 1
+# endif
+#endif
+
+#include "virnetsharedring.h"
+#include "viralloc.h"
+#include "viratomic.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virlog.h"
+
+#define VIR_FROM_THIS VIR_FROM_RPC
+
+VIR_LOG_INIT("rpc.netsharedring");
+
+#define VIR_NET_SHARED_RING_MAGIC 0x4c565252 /* "LVRR" */
+
+/* The control block occupies the first page of the memfd */
+#define VIR_NET_SHARED_RING_HEADER 4096
+
+#define VIR_NET_SHARED_RING_SIZE_MIN (64 * 1024)
+#define VIR_NET_SHARED_RING_SIZE_MAX (1024 * 1024 * 1024)
+
+typedef struct _virNetSharedRingHeader virNetSharedRingHeader;
+struct _virNetSharedRingHeader {
+    unsigned int magic;
+    unsigned int size;
+    /* Number of bytes the client has consumed, modulo 2^32.
+     * The only field the client writes to */
+    int tail;
+};
+
+struct _virNetSharedRing {
+    virObject parent;
+
+    int fd;
+    char *map;
+    size_t mapLength;
+
+    virNetSharedRingHeader *header;
+    char *data;
+    size_t size; /* Always a power of two */
+
+    /* Number of bytes put into the ring by the daemon, or taken out
+     * of it by the client, modulo 2^32. The daemon keeps its own
+     * count since it must not trust the shared header */
+    unsigned int head;
+};
+
+
+bool
+virNetSharedRingIsSupported(void)
+{
+#if WITH_SHARED_RING
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+#if WITH_SHARED_RING
+static virClassPtr virNetSharedRingClass;
+static void virNetSharedRingDispose(void *obj);
+
+static int virNetSharedRingOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(virNetSharedRing, virClassForObject()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virNetSharedRing)
+
+
+static virNetSharedRingPtr
+virNetSharedRingMap(int fd,
+                    size_t size)
+{
+    virNetSharedRingPtr ring;
+    void *map;
+
+    if (virNetSharedRingInitialize() < 0)
+        return NULL;
+
+    if ((map = mmap(NULL, VIR_NET_SHARED_RING_HEADER + size,
+                    PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0)) == MAP_FAILED) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to map shared memory ring"));
+        return NULL;
+    }
+
+    if (!(ring = virObjectNew(virNetSharedRingClass))) {
+        munmap(map, VIR_NET_SHARED_RING_HEADER + size);
+        return NULL;
+    }
+
+    ring->fd = fd;
+    ring->map = map;
+    ring->mapLength = VIR_NET_SHARED_RING_HEADER + size;
+    ring->header = map;
+    ring->data = ring->map + VIR_NET_SHARED_RING_HEADER;
+    ring->size = size;
+
+    return ring;
+}
+
+
+/**
+ * virNetSharedRingNew:
+ * @size: number of bytes the ring can hold
+ *
+ * Creates a ring on the daemon side. @size is rounded up to a power
+ * of two. The memfd is sealed against resizing, so the client cannot
+ * make accesses to the mapping fault.
+ *
+ * Returns the new ring, or NULL on error
+ */
+virNetSharedRingPtr
+virNetSharedRingNew(size_t size)
+{
+    virNetSharedRingPtr ring;
+    size_t ringSize = VIR_NET_SHARED_RING_SIZE_MIN;
+    int fd;
+
+    if (size > VIR_NET_SHARED_RING_SIZE_MAX) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("shared memory ring size %zu is too large"), size);
+        return NULL;
+    }
+
+    while (ringSize < size)
+        ringSize *= 2;
+
+    if ((fd = memfd_create("libvirt-rpc-ring",
+                           MFD_CLOEXEC | MFD_ALLOW_SEALING)) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create shared memory ring"));
+        return NULL;
+    }
+
+    if (ftruncate(fd, VIR_NET_SHARED_RING_HEADER + ringSize) < 0 ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to set up shared memory ring"));
+        VIR_FORCE_CLOSE(fd);
+        return NULL;
+    }
+
+    if (!(ring = virNetSharedRingMap(fd, ringSize))) {
+        VIR_FORCE_CLOSE(fd);
+        return NULL;
+    }
+
+    ring->header->magic = VIR_NET_SHARED_RING_MAGIC;
+    ring->header->size = ringSize;
+    virAtomicIntSet(&ring->header->tail, 0);
+
+    VIR_DEBUG("ring=%p fd=%d size=%zu", ring, fd, ringSize);
+
+    return ring;
+}
+
+
+/**
+ * virNetSharedRingOpen:
+ * @fd: the memfd received from the daemon
+ *
+ * Maps a ring on the client side. On success the ring takes
+ * ownership of @fd.
+ *
+ * Returns the ring, or NULL on error
+ */
+virNetSharedRingPtr
+virNetSharedRingOpen(int fd)
+{
+    virNetSharedRingPtr ring;
+    struct stat sb;
+    size_t size;
+
+    if (fstat(fd, &sb) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to query shared memory ring"));
+        return NULL;
+    }
+
+    if (sb.st_size <= VIR_NET_SHARED_RING_HEADER ||
+        sb.st_size - VIR_NET_SHARED_RING_HEADER > VIR_NET_SHARED_RING_SIZE_MAX) {
+        virReportError(VIR_ERR_RPC,
+                       _("unexpected shared memory ring size %lld"),
+                       (long long) sb.st_size);
+        return NULL;
+    }
+    size = sb.st_size - VIR_NET_SHARED_RING_HEADER;
+
+    if (!(ring = virNetSharedRingMap(fd, size)))
+        return NULL;
+
+    if (ring->header->magic != VIR_NET_SHARED_RING_MAGIC ||
+        ring->header->size != size ||
+        (size & (size - 1)) != 0) {
+        virReportError(VIR_ERR_RPC, "%s",
+                       _("malformed shared memory ring"));
+        ring->fd = -1;
+        virObjectUnref(ring);
+        return NULL;
+    }
+
+    ring->head = virAtomicIntGet(&ring->header->tail);
+
+    VIR_DEBUG("ring=%p fd=%d size=%zu", ring, fd, size);
+
+    return ring;
+}
+
+
+static void
+virNetSharedRingDispose(void *obj)
+{
+    virNetSharedRingPtr ring = obj;
+
+    munmap(ring->map, ring->mapLength);
+    VIR_FORCE_CLOSE(ring->fd);
+}
+
+#else /* !WITH_SHARED_RING */
+
+virNetSharedRingPtr
+virNetSharedRingNew(size_t size ATTRIBUTE_UNUSED)
+{
+    virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                   _("shared memory rings are not supported on this platform"));
+    return NULL;
+}
+
+
+virNetSharedRingPtr
+virNetSharedRingOpen(int fd ATTRIBUTE_UNUSED)
+{
+    virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                   _("shared memory rings are not supported on this platform"));
+    return NULL;
+}
+
+#endif /* !WITH_SHARED_RING */
+
+
+int
+virNetSharedRingGetFD(virNetSharedRingPtr ring)
+{
+    return ring->fd;
+}
+
+
+size_t
+virNetSharedRingGetSize(virNetSharedRingPtr ring)
+{
+    return ring->size;
+}
+
+
+/**
+ * virNetSharedRingPut:
+ * @ring: the daemon side of a ring
+ * @data: the data to copy into the ring
+ * @len: length of @data
+ * @pos: filled with the position of the data
+ *
+ * Copies @data into the ring, unless the client has not yet consumed
+ * enough of it. The data is never split, if it doesn't fit before the
+ * end of the ring the rest of the ring is skipped.
+ *
+ * Returns true if @data was copied, false if there's no room
+ */
+bool
+virNetSharedRingPut(virNetSharedRingPtr ring,
+                    const char *data,
+                    size_t len,
+                    unsigned int *pos)
+{
+    unsigned int tail = virAtomicIntGet(&ring->header->tail);
+    unsigned int used = ring->head - tail;
+    size_t offset = ring->head & (ring->size - 1);
+    size_t pad = 0;
+
+    /* A tail ahead of what was put into the ring means the client
+     * scribbled over the control block, so stop using the ring */
+    if (len > ring->size || used > ring->size)
+        return false;
+
+    if (offset + len > ring->size)
+        pad = ring->size - offset;
+
+    if (used + pad + len > ring->size)
+        return false;
+
+    *pos = ring->head + pad;
+    memcpy(ring->data + (*pos & (ring->size - 1)), data, len);
+    ring->head = *pos + len;
+
+    return true;
+}
+
+
+/**
+ * virNetSharedRingTake:
+ * @ring: the client side of a ring
+ * @pos: position of the data, as returned by virNetSharedRingPut
+ * @len: length of the data
+ * @data: buffer to copy the data to
+ *
+ * Copies data out of the ring and hands the space it occupied, along
+ * with any data put before it, back to the daemon. Data must be taken
+ * in the order it was put.
+ *
+ * Returns 0 on success, -1 if @pos and @len don't describe data
+ * within the ring
+ */
+int
+virNetSharedRingTake(virNetSharedRingPtr ring,
+                     unsigned int pos,
+                     size_t len,
+                     char *data)
+{
+    size_t offset = pos & (ring->size - 1);
+
+    if (len > ring->size || offset + len > ring->size ||
+        pos - ring->head >= ring->size) {
+        virReportError(VIR_ERR_RPC,
+                       _("invalid shared memory ring data at %u length %zu"),
+                       pos, len);
+        return -1;
+    }
+
+    memcpy(data, ring->data + offset, len);
+
+    /* The copy must be complete before the daemon may reuse the space */
+    ring->head = pos + len;
+    virAtomicIntSet(&ring->header->tail, ring->head);
+
+    return 0;
+}
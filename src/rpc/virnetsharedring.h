@@ -0,0 +1,56 @@
+/*
+ * virnetsharedring.h: shared memory ring for passing RPC messages
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBVIRT_VIRNETSHAREDRING_H
+# define LIBVIRT_VIRNETSHAREDRING_H
+
+# include "internal.h"
+# include "virobject.h"
+
+/*
+ * A ring buffer in a sealed memfd, written by the daemon and read by
+ * a local client. The position and length of every message placed in
+ * it are sent over the socket, the ring only carries the data. The
+ * client hands space back by publishing how far it has read.
+ */
+typedef struct _virNetSharedRing virNetSharedRing;
+typedef virNetSharedRing *virNetSharedRingPtr;
+
+/* Messages shorter than this are cheaper to send over the socket */
+# define VIR_NET_SHARED_RING_MIN_MESSAGE (16 * 1024)
+
+bool virNetSharedRingIsSupported(void);
+
+virNetSharedRingPtr virNetSharedRingNew(size_t size);
+virNetSharedRingPtr virNetSharedRingOpen(int fd);
+
+int virNetSharedRingGetFD(virNetSharedRingPtr ring);
+size_t virNetSharedRingGetSize(virNetSharedRingPtr ring);
+
+bool virNetSharedRingPut(virNetSharedRingPtr ring,
+                         const char *data,
+                         size_t len,
+                         unsigned int *pos)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(4);
+int virNetSharedRingTake(virNetSharedRingPtr ring,
+                         unsigned int pos,
+                         size_t len,
+                         char *data)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(4) ATTRIBUTE_RETURN_CHECK;
+
+#endif /* LIBVIRT_VIRNETSHAREDRING_H */
@@ -1652,6 +1652,7 @@ void virNetSocketSetTLSSession(virNetSocketPtr sock,
                                    virNetSocketTLSSessionWrite,
                                    virNetSocketTLSSessionRead,
                                    sock);
+    virNetTLSSessionSetSocketFD(sess, sock->fd);
     virObjectUnlock(sock);
 }
 #endif
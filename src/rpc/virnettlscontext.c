@@ -27,6 +27,17 @@
 #include <gnutls/crypto.h>
 #include <gnutls/x509.h>
 
+/* Kernel TLS needs <linux/tls.h>, which only exists since Linux 4.13,
+ * and the session keys, which GnuTLS only hands out since 3.4.0 */
+#if defined(HAVE_LINUX_TLS_H) && defined(HAVE_GNUTLS_RECORD_GET_STATE)
+# include <sys/socket.h>
+# include <netinet/tcp.h>
+# include <linux/tls.h>
+# if defined(TCP_ULP) && defined(SOL_TLS)
+#  define WITH_KTLS 1
+# endif
+#endif
+
 #include "virnettlscontext.h"
 #include "virstring.h"
 
@@ -61,6 +72,7 @@ struct _virNetTLSContext {
 
     bool isServer;
     bool requireValidCert;
+    bool kernelOffload;
     const char *const*x509dnWhitelist;
     char *priority;
 };
@@ -77,6 +89,15 @@ struct _virNetTLSSession {
     virNetTLSSessionReadFunc readFunc;
     void *opaque;
     char *x509dname;
+
+    /* Kernel TLS offload of the transmit direction */
+    bool kernelOffload;
+    int fd;
+    bool kernelTX;
+    /* GnuTLS state of the transmit direction at the time it was
+     * handed over to the kernel. GnuTLS must not use it anymore. */
+    unsigned char kernelTXKey[32];
+    unsigned char kernelTXSeq[8];
 };
 
 static virClassPtr virNetTLSContextClass;
@@ -1105,6 +1126,26 @@ static int virNetTLSContextValidCertificate(virNetTLSContextPtr ctxt,
     return -1;
 }
 
+/**
+ * virNetTLSContextSetKernelOffload:
+ * @ctxt: the TLS context
+ * @enable: whether to use kernel TLS
+ *
+ * Sets whether sessions created from @ctxt should, once the handshake
+ * completes, hand the encryption of outgoing data over to the kernel.
+ * Sessions silently keep doing it in user space if that is not
+ * possible, e.g. because the kernel doesn't support TLS or the
+ * negotiated cipher.
+ */
+void virNetTLSContextSetKernelOffload(virNetTLSContextPtr ctxt,
+                                      bool enable)
+{
+    virObjectLock(ctxt);
+    ctxt->kernelOffload = enable;
+    virObjectUnlock(ctxt);
+}
+
+
 int virNetTLSContextCheckCertificate(virNetTLSContextPtr ctxt,
                                      virNetTLSSessionPtr sess)
 {
@@ -1235,6 +1276,10 @@ virNetTLSSessionPtr virNetTLSSessionNew(virNetTLSContextPtr ctxt,
                                        virNetTLSSessionPull);
 
     sess->isServer = ctxt->isServer;
+    sess->fd = -1;
+    virObjectLock(ctxt);
+    sess->kernelOffload = ctxt->kernelOffload;
+    virObjectUnlock(ctxt);
 
     PROBE(RPC_TLS_SESSION_NEW,
           "sess=%p ctxt=%p hostname=%s isServer=%d",
@@ -1261,12 +1306,211 @@ void virNetTLSSessionSetIOCallbacks(virNetTLSSessionPtr sess,
 }
 
 
+/**
+ * virNetTLSSessionSetSocketFD:
+ * @sess: the TLS session
+ * @fd: the socket the session runs over
+ *
+ * Tells @sess which socket to hand over to kernel TLS, if that was
+ * requested by virNetTLSContextSetKernelOffload().
+ */
+void virNetTLSSessionSetSocketFD(virNetTLSSessionPtr sess,
+                                 int fd)
+{
+    virObjectLock(sess);
+    sess->fd = fd;
+    virObjectUnlock(sess);
+}
+
+
+/**
+ * virNetTLSSessionGetKernelOffload:
+ * @sess: the TLS session
+ *
+ * Returns true if outgoing data of @sess is encrypted by the kernel.
+ */
+bool virNetTLSSessionGetKernelOffload(virNetTLSSessionPtr sess)
+{
+    bool ret;
+
+    virObjectLock(sess);
+    ret = sess->kernelTX;
+    virObjectUnlock(sess);
+
+    return ret;
+}
+
+
+#ifdef WITH_KTLS
+# define VIR_NET_TLS_KTLS_AES_GCM(ci, type, tls12) \
+    do { \
+        if (key.size != sizeof((ci)->key) || \
+            iv.size != sizeof((ci)->salt) + ((tls12) ? 0 : sizeof((ci)->iv))) \
+            goto unsupported; \
+        (ci)->info.cipher_type = type; \
+        memcpy((ci)->salt, iv.data, sizeof((ci)->salt)); \
+        /* With TLS 1.2 the explicit nonce is the sequence number */ \
+        if (tls12) \
+            memcpy((ci)->iv, seq, sizeof((ci)->iv)); \
+        else \
+            memcpy((ci)->iv, iv.data + sizeof((ci)->salt), sizeof((ci)->iv)); \
+        memcpy((ci)->key, key.data, sizeof((ci)->key)); \
+        memcpy((ci)->rec_seq, seq, sizeof((ci)->rec_seq)); \
+        infolen = sizeof(*(ci)); \
+    } while (0)
+
+/*
+ * Hand the transmit direction of the session over to the kernel.
+ * Receiving stays with GnuTLS, so that alerts and post-handshake
+ * messages are processed as usual.
+ *
+ * Returns true on success, false if it's not possible, in which
+ * case the session is left untouched.
+ */
+static bool
+virNetTLSSessionSetupKernelTX(virNetTLSSessionPtr sess)
+{
+    gnutls_protocol_t version = gnutls_protocol_get_version(sess->session);
+    gnutls_cipher_algorithm_t cipher = gnutls_cipher_get(sess->session);
+    gnutls_datum_t iv;
+    gnutls_datum_t key;
+    unsigned char seq[8];
+    union {
+        struct tls_crypto_info info;
+        struct tls12_crypto_info_aes_gcm_128 aes128;
+# ifdef TLS_CIPHER_AES_GCM_256
+        struct tls12_crypto_info_aes_gcm_256 aes256;
+# endif
+# ifdef TLS_CIPHER_CHACHA20_POLY1305
+        struct tls12_crypto_info_chacha20_poly1305 chacha;
+# endif
+    } crypto;
+    size_t infolen = 0;
+    bool tls12 = version == GNUTLS_TLS1_2;
+    char ebuf[1024];
+    int err;
+
+    memset(&crypto, 0, sizeof(crypto));
+
+    if (tls12) {
+        crypto.info.version = TLS_1_2_VERSION;
+# if defined(TLS_1_3_VERSION) && HAVE_DECL_GNUTLS_TLS1_3
+    } else if (version == GNUTLS_TLS1_3) {
+        crypto.info.version = TLS_1_3_VERSION;
+# endif
+    } else {
+        VIR_DEBUG("Kernel TLS is not supported with %s",
+                  NULLSTR(gnutls_protocol_get_name(version)));
+        return false;
+    }
+
+    if ((err = gnutls_record_get_state(sess->session, 0, NULL,
+                                       &iv, &key, seq)) < 0) {
+        VIR_DEBUG("Unable to get TLS session state: %s",
+                  gnutls_strerror(err));
+        return false;
+    }
+
+    if (cipher == GNUTLS_CIPHER_AES_128_GCM) {
+        VIR_NET_TLS_KTLS_AES_GCM(&crypto.aes128, TLS_CIPHER_AES_GCM_128, tls12);
+# ifdef TLS_CIPHER_AES_GCM_256
+    } else if (cipher == GNUTLS_CIPHER_AES_256_GCM) {
+        VIR_NET_TLS_KTLS_AES_GCM(&crypto.aes256, TLS_CIPHER_AES_GCM_256, tls12);
+# endif
+# ifdef TLS_CIPHER_CHACHA20_POLY1305
+    } else if (cipher == GNUTLS_CIPHER_CHACHA20_POLY1305) {
+        if (key.size != sizeof(crypto.chacha.key) ||
+            iv.size != sizeof(crypto.chacha.iv))
+            goto unsupported;
+        crypto.chacha.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+        memcpy(crypto.chacha.iv, iv.data, sizeof(crypto.chacha.iv));
+        memcpy(crypto.chacha.key, key.data, sizeof(crypto.chacha.key));
+        memcpy(crypto.chacha.rec_seq, seq, sizeof(crypto.chacha.rec_seq));
+        infolen = sizeof(crypto.chacha);
+# endif
+    } else {
+        goto unsupported;
+    }
+
+    if (setsockopt(sess->fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0) {
+        VIR_DEBUG("Kernel TLS is not available: %s",
+                  virStrerror(errno, ebuf, sizeof(ebuf)));
+        goto cleanup;
+    }
+
+    /* Without any key set, the socket keeps working as before */
+    if (setsockopt(sess->fd, SOL_TLS, TLS_TX, &crypto, infolen) < 0) {
+        VIR_DEBUG("Kernel TLS refused the session keys: %s",
+                  virStrerror(errno, ebuf, sizeof(ebuf)));
+        goto cleanup;
+    }
+
+    memcpy(sess->kernelTXKey, key.data, MIN(key.size, sizeof(sess->kernelTXKey)));
+    memcpy(sess->kernelTXSeq, seq, sizeof(sess->kernelTXSeq));
+    sess->kernelTX = true;
+    VIR_DEBUG("Offloaded TLS transmit to the kernel, sess=%p fd=%d",
+              sess, sess->fd);
+
+ cleanup:
+    memset(&crypto, 0, sizeof(crypto));
+    return sess->kernelTX;
+
+ unsupported:
+    VIR_DEBUG("Kernel TLS is not supported with %s",
+              NULLSTR(gnutls_cipher_get_name(cipher)));
+    goto cleanup;
+}
+# undef VIR_NET_TLS_KTLS_AES_GCM
+
+
+/*
+ * GnuTLS may need to send records on its own while receiving, for
+ * instance in reply to a TLS 1.3 key update. Those would be encrypted
+ * with its stale copy of the transmit state and corrupt the stream,
+ * so detect that and fail the session instead.
+ */
+static bool
+virNetTLSSessionKernelTXIsStale(virNetTLSSessionPtr sess)
+{
+    gnutls_datum_t key;
+    unsigned char seq[8];
+
+    if (gnutls_record_get_state(sess->session, 0, NULL, NULL, &key, seq) < 0)
+        return true;
+
+    return memcmp(seq, sess->kernelTXSeq, sizeof(seq)) != 0 ||
+        memcmp(key.data, sess->kernelTXKey,
+               MIN(key.size, sizeof(sess->kernelTXKey))) != 0;
+}
+#else /* !WITH_KTLS */
+static bool
+virNetTLSSessionSetupKernelTX(virNetTLSSessionPtr sess ATTRIBUTE_UNUSED)
+{
+    VIR_DEBUG("Kernel TLS is not supported on this platform");
+    return false;
+}
+
+
+static bool
+virNetTLSSessionKernelTXIsStale(virNetTLSSessionPtr sess ATTRIBUTE_UNUSED)
+{
+    return false;
+}
+#endif /* !WITH_KTLS */
+
+
 ssize_t virNetTLSSessionWrite(virNetTLSSessionPtr sess,
                               const char *buf, size_t len)
 {
     ssize_t ret;
 
     virObjectLock(sess);
+    if (sess->kernelTX) {
+        /* The kernel does the encryption, errno is set already */
+        ret = sess->writeFunc(buf, len, sess->opaque);
+        goto cleanup;
+    }
+
     ret = gnutls_record_send(sess->session, buf, len);
 
     if (ret >= 0)
@@ -1302,6 +1546,15 @@ ssize_t virNetTLSSessionRead(virNetTLSSessionPtr sess,
     virObjectLock(sess);
     ret = gnutls_record_recv(sess->session, buf, len);
 
+    if (sess->kernelTX &&
+        virNetTLSSessionKernelTXIsStale(sess)) {
+        VIR_WARN("TLS session changed its transmit state after it was "
+                 "offloaded to the kernel");
+        errno = EIO;
+        ret = -1;
+        goto cleanup;
+    }
+
     if (ret >= 0)
         goto cleanup;
 
@@ -1334,6 +1587,10 @@ int virNetTLSSessionHandshake(virNetTLSSessionPtr sess)
     if (ret == 0) {
         sess->handshakeComplete = true;
         VIR_DEBUG("Handshake is complete");
+        /* No application data was sent yet, so this is the point
+         * where the kernel can take over */
+        if (sess->kernelOffload && sess->fd != -1 && sess->writeFunc)
+            ignore_value(virNetTLSSessionSetupKernelTX(sess));
         goto cleanup;
     }
     if (ret == GNUTLS_E_INTERRUPTED || ret == GNUTLS_E_AGAIN) {
@@ -1411,6 +1668,7 @@ void virNetTLSSessionDispose(void *obj)
 
     VIR_FREE(sess->x509dname);
     VIR_FREE(sess->hostname);
+    memset(sess->kernelTXKey, 0, sizeof(sess->kernelTXKey));
     gnutls_deinit(sess->session);
 }
 
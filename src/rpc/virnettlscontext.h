@@ -63,6 +63,9 @@ virNetTLSContextPtr virNetTLSContextNewClient(const char *cacert,
                                               bool sanityCheckCert,
                                               bool requireValidCert);
 
+void virNetTLSContextSetKernelOffload(virNetTLSContextPtr ctxt,
+                                      bool enable);
+
 int virNetTLSContextCheckCertificate(virNetTLSContextPtr ctxt,
                                      virNetTLSSessionPtr sess);
 
@@ -80,6 +83,10 @@ void virNetTLSSessionSetIOCallbacks(virNetTLSSessionPtr sess,
                                     virNetTLSSessionReadFunc readFunc,
                                     void *opaque);
 
+void virNetTLSSessionSetSocketFD(virNetTLSSessionPtr sess,
+                                 int fd);
+bool virNetTLSSessionGetKernelOffload(virNetTLSSessionPtr sess);
+
 ssize_t virNetTLSSessionWrite(virNetTLSSessionPtr sess,
                               const char *buf, size_t len);
 ssize_t virNetTLSSessionRead(virNetTLSSessionPtr sess,
@@ -88,6 +88,7 @@ struct _virSecurityDACChownList {
     virSecurityDACChownItemPtr *items;
     size_t nItems;
     bool lock;
+    bool threaded; /* not run in a forked child */
 };
 
 
@@ -190,6 +191,79 @@ static int virSecurityDACRestoreFileLabelInternal(virSecurityManagerPtr mgr,
                                                   const virStorageSource *src,
                                                   const char *path,
                                                   bool recall);
+static int
+virSecurityDACTransactionApply(size_t idx,
+                               void *opaque)
+{
+    virSecurityDACChownListPtr list = opaque;
+    virSecurityDACChownItemPtr item = list->items[idx];
+
+    if (!item->restore) {
+        return virSecurityDACSetOwnership(list->manager,
+                                          item->src,
+                                          item->path,
+                                          item->uid,
+                                          item->gid,
+                                          list->lock);
+    } else {
+        return virSecurityDACRestoreFileLabelInternal(list->manager,
+                                                      item->src,
+                                                      item->path,
+                                                      list->lock);
+    }
+}
+
+
+static int
+virSecurityDACTransactionRollback(size_t idx,
+                                  void *opaque)
+{
+    virSecurityDACChownListPtr list = opaque;
+    virSecurityDACChownItemPtr item = list->items[idx];
+
+    if (!item->restore) {
+        return virSecurityDACRestoreFileLabelInternal(list->manager,
+                                                      item->src,
+                                                      item->path,
+                                                      list->lock);
+    } else {
+        VIR_WARN("Ignoring failed restore attempt on %s",
+                 NULLSTR(item->src ? item->src->path : item->path));
+        return 0;
+    }
+}
+
+
+static bool
+virSecurityDACTransactionSame(size_t a,
+                              size_t b,
+                              void *opaque)
+{
+    virSecurityDACChownListPtr list = opaque;
+    virSecurityDACChownItemPtr itemA = list->items[a];
+    virSecurityDACChownItemPtr itemB = list->items[b];
+
+    return itemA->src == itemB->src &&
+        itemA->uid == itemB->uid &&
+        itemA->gid == itemB->gid &&
+        itemA->restore == itemB->restore;
+}
+
+
+static bool
+virSecurityDACTransactionPinned(size_t idx,
+                                void *opaque)
+{
+    virSecurityDACChownListPtr list = opaque;
+    virSecurityDACDataPtr priv;
+
+    priv = virSecurityManagerGetPrivateData(list->manager);
+
+    /* The chown callback isn't known to be thread safe */
+    return list->items[idx]->src && priv->chownCallback;
+}
+
+
 /**
  * virSecurityDACTransactionRun:
  * @pid: process pid
@@ -200,6 +274,11 @@ static int virSecurityDACRestoreFileLabelInternal(virSecurityManagerPtr mgr,
  * the list. Depending on security manager configuration it might lock paths
  * we will relabel.
  *
+ * Unless run in a forked child, different paths are relabelled in parallel,
+ * though only the calling thread calls the chown callback. Unless labels are
+ * remembered, which counts every relabel of a path, repeated relabels of a
+ * path to the same owner are done only once.
+ *
  * Returns: 0 on success
  *         -1 otherwise.
  */
@@ -212,57 +291,28 @@ virSecurityDACTransactionRun(pid_t pid ATTRIBUTE_UNUSED,
     const char **paths = NULL;
     size_t npaths = 0;
     size_t i;
-    int rv = 0;
+    int rv;
     int ret = -1;
 
-    if (list->lock) {
-        if (VIR_ALLOC_N(paths, list->nItems) < 0)
-            return -1;
-
-        for (i = 0; i < list->nItems; i++) {
-            const char *p = list->items[i]->path;
-
-            VIR_APPEND_ELEMENT_COPY_INPLACE(paths, npaths, p);
-        }
-
-        if (!(state = virSecurityManagerMetadataLock(list->manager, paths, npaths)))
-            goto cleanup;
-    }
+    if (VIR_ALLOC_N(paths, list->nItems) < 0)
+        return -1;
 
     for (i = 0; i < list->nItems; i++) {
-        virSecurityDACChownItemPtr item = list->items[i];
-
-        if (!item->restore) {
-            rv = virSecurityDACSetOwnership(list->manager,
-                                            item->src,
-                                            item->path,
-                                            item->uid,
-                                            item->gid,
-                                            list->lock);
-        } else {
-            rv = virSecurityDACRestoreFileLabelInternal(list->manager,
-                                                        item->src,
-                                                        item->path,
-                                                        list->lock);
-        }
+        const char *p = list->items[i]->path;
 
-        if (rv < 0)
-            break;
+        VIR_APPEND_ELEMENT_COPY_INPLACE(paths, npaths, p);
     }
 
-    for (; rv < 0 && i > 0; i--) {
-        virSecurityDACChownItemPtr item = list->items[i - 1];
+    if (list->lock &&
+        !(state = virSecurityManagerMetadataLock(list->manager, paths, npaths)))
+        goto cleanup;
 
-        if (!item->restore) {
-            virSecurityDACRestoreFileLabelInternal(list->manager,
-                                                   item->src,
-                                                   item->path,
-                                                   list->lock);
-        } else {
-            VIR_WARN("Ignoring failed restore attempt on %s",
-                     NULLSTR(item->src ? item->src->path : item->path));
-        }
-    }
+    rv = virSecurityRelabelItems(paths, npaths, list->threaded,
+                                 list->lock ? NULL : virSecurityDACTransactionSame,
+                                 virSecurityDACTransactionPinned,
+                                 virSecurityDACTransactionApply,
+                                 virSecurityDACTransactionRollback,
+                                 list);
 
     if (list->lock)
         virSecurityManagerMetadataUnlock(list->manager, &state);
@@ -614,6 +664,7 @@ virSecurityDACTransactionCommit(virSecurityManagerPtr mgr ATTRIBUTE_UNUSED,
     }
 
     list->lock = lock;
+    list->threaded = pid == -1 && !lock;
 
     if (pid == -1) {
         if (lock)
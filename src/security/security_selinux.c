@@ -92,6 +92,11 @@ struct _virSecuritySELinuxContextList {
     virSecuritySELinuxContextItemPtr *items;
     size_t nItems;
     bool lock;
+    bool threaded; /* not run in a forked child */
+
+    /* Serializes restores while the transaction runs, the label
+     * handle they look up default contexts in isn't thread safe */
+    virMutex restoreLock;
 };
 
 #define SECURITY_SELINUX_VOID_DOI       "0"
@@ -230,6 +235,64 @@ static int virSecuritySELinuxRestoreFileLabel(virSecurityManagerPtr mgr,
                                               bool recall);
 
 
+static int
+virSecuritySELinuxTransactionApply(size_t idx,
+                                   void *opaque)
+{
+    virSecuritySELinuxContextListPtr list = opaque;
+    virSecuritySELinuxContextItemPtr item = list->items[idx];
+    int rv;
+
+    if (!item->restore) {
+        return virSecuritySELinuxSetFileconHelper(list->manager,
+                                                  item->path,
+                                                  item->tcon,
+                                                  item->optional,
+                                                  list->lock);
+    }
+
+    virMutexLock(&list->restoreLock);
+    rv = virSecuritySELinuxRestoreFileLabel(list->manager,
+                                            item->path,
+                                            list->lock);
+    virMutexUnlock(&list->restoreLock);
+    return rv;
+}
+
+
+static int
+virSecuritySELinuxTransactionRollback(size_t idx,
+                                      void *opaque)
+{
+    virSecuritySELinuxContextListPtr list = opaque;
+    virSecuritySELinuxContextItemPtr item = list->items[idx];
+
+    if (!item->restore) {
+        return virSecuritySELinuxRestoreFileLabel(list->manager,
+                                                  item->path,
+                                                  list->lock);
+    } else {
+        VIR_WARN("Ignoring failed restore attempt on %s", item->path);
+        return 0;
+    }
+}
+
+
+static bool
+virSecuritySELinuxTransactionSame(size_t a,
+                                  size_t b,
+                                  void *opaque)
+{
+    virSecuritySELinuxContextListPtr list = opaque;
+    virSecuritySELinuxContextItemPtr itemA = list->items[a];
+    virSecuritySELinuxContextItemPtr itemB = list->items[b];
+
+    return STREQ_NULLABLE(itemA->tcon, itemB->tcon) &&
+        itemA->optional == itemB->optional &&
+        itemA->restore == itemB->restore;
+}
+
+
 /**
  * virSecuritySELinuxTransactionRun:
  * @pid: process pid
@@ -239,6 +302,10 @@ static int virSecuritySELinuxRestoreFileLabel(virSecurityManagerPtr mgr,
  * relabelling. For given transaction (@opaque) it relabels all the paths on
  * the list.
  *
+ * Unless run in a forked child, different paths are relabelled in parallel.
+ * Unless labels are remembered, which counts every relabel of a path,
+ * repeated relabels of a path to the same context are done only once.
+ *
  * Returns: 0 on success
  *         -1 otherwise.
  */
@@ -254,51 +321,31 @@ virSecuritySELinuxTransactionRun(pid_t pid ATTRIBUTE_UNUSED,
     int rv;
     int ret = -1;
 
-    if (list->lock) {
-        if (VIR_ALLOC_N(paths, list->nItems) < 0)
-            return -1;
-
-        for (i = 0; i < list->nItems; i++) {
-            const char *p = list->items[i]->path;
-
-            VIR_APPEND_ELEMENT_COPY_INPLACE(paths, npaths, p);
-        }
-
-        if (!(state = virSecurityManagerMetadataLock(list->manager, paths, npaths)))
-            goto cleanup;
+    if (virMutexInit(&list->restoreLock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to initialize mutex"));
+        return -1;
     }
 
-    rv = 0;
+    if (VIR_ALLOC_N(paths, list->nItems) < 0)
+        goto cleanup;
+
     for (i = 0; i < list->nItems; i++) {
-        virSecuritySELinuxContextItemPtr item = list->items[i];
-
-        if (!item->restore) {
-            rv = virSecuritySELinuxSetFileconHelper(list->manager,
-                                                    item->path,
-                                                    item->tcon,
-                                                    item->optional,
-                                                    list->lock);
-        } else {
-            rv = virSecuritySELinuxRestoreFileLabel(list->manager,
-                                                    item->path,
-                                                    list->lock);
-        }
+        const char *p = list->items[i]->path;
 
-        if (rv < 0)
-            break;
+        VIR_APPEND_ELEMENT_COPY_INPLACE(paths, npaths, p);
     }
 
-    for (; rv < 0 && i > 0; i--) {
-        virSecuritySELinuxContextItemPtr item = list->items[i - 1];
+    if (list->lock &&
+        !(state = virSecurityManagerMetadataLock(list->manager, paths, npaths)))
+        goto cleanup;
 
-        if (!item->restore) {
-            virSecuritySELinuxRestoreFileLabel(list->manager,
-                                               item->path,
-                                               list->lock);
-        } else {
-            VIR_WARN("Ignoring failed restore attempt on %s", item->path);
-        }
-    }
+    rv = virSecurityRelabelItems(paths, npaths, list->threaded,
+                                 list->lock ? NULL : virSecuritySELinuxTransactionSame,
+                                 NULL,
+                                 virSecuritySELinuxTransactionApply,
+                                 virSecuritySELinuxTransactionRollback,
+                                 list);
 
     if (list->lock)
         virSecurityManagerMetadataUnlock(list->manager, &state);
@@ -309,6 +356,7 @@ virSecuritySELinuxTransactionRun(pid_t pid ATTRIBUTE_UNUSED,
     ret = 0;
  cleanup:
     VIR_FREE(paths);
+    virMutexDestroy(&list->restoreLock);
     return ret;
 }
 
@@ -1163,6 +1211,7 @@ virSecuritySELinuxTransactionCommit(virSecurityManagerPtr mgr ATTRIBUTE_UNUSED,
     }
 
     list->lock = lock;
+    list->threaded = pid == -1 && !lock;
 
     if (pid == -1) {
         if (lock)
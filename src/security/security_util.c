@@ -19,14 +19,26 @@
 #include <config.h>
 
 #include "viralloc.h"
+#include "viratomic.h"
 #include "virfile.h"
+#include "virhash.h"
+#include "virlog.h"
 #include "virstring.h"
 #include "virerror.h"
+#include "virthread.h"
 
 #include "security_util.h"
 
 #define VIR_FROM_THIS VIR_FROM_SECURITY
 
+VIR_LOG_INIT("security.security_util");
+
+/* Most relabels are a single syscall, unless the storage is remote,
+ * so a thread is only worth starting for this many paths, and there's
+ * little point in more threads than this */
+#define VIR_SECURITY_RELABEL_THREAD_PATHS 16
+#define VIR_SECURITY_RELABEL_THREADS 8
+
 /* There are four namespaces available on Linux (xattr(7)):
  *
  *  user - can be modified by anybody,
@@ -254,3 +266,223 @@ virSecuritySetRememberedLabel(const char *name,
     VIR_FREE(ref_name);
     return ret;
 }
+
+
+typedef struct _virSecurityRelabelData virSecurityRelabelData;
+typedef virSecurityRelabelData *virSecurityRelabelDataPtr;
+struct _virSecurityRelabelData {
+    /* First item of each group, and the item following each item
+     * within its group (or nitems at its end) */
+    size_t *groups;
+    size_t ngroups;
+    size_t *next;
+    size_t nitems;
+
+    /* Groups only the calling thread may relabel */
+    bool *pinned;
+
+    /* Which items were relabelled, and why each group stopped */
+    bool *done;
+    virErrorPtr *errors;
+
+    int nextGroup;
+    int failed;
+
+    virSecurityRelabelFunc apply;
+    void *opaque;
+};
+
+
+static void
+virSecurityRelabelGroup(virSecurityRelabelDataPtr data,
+                        size_t group)
+{
+    size_t i;
+
+    for (i = data->groups[group]; i < data->nitems; i = data->next[i]) {
+        if (data->apply(i, data->opaque) < 0) {
+            data->errors[group] = virSaveLastError();
+            virAtomicIntSet(&data->failed, 1);
+            break;
+        }
+        data->done[i] = true;
+    }
+}
+
+
+static void
+virSecurityRelabelWorker(void *opaque)
+{
+    virSecurityRelabelDataPtr data = opaque;
+
+    while (!virAtomicIntGet(&data->failed)) {
+        size_t group = virAtomicIntInc(&data->nextGroup) - 1;
+
+        if (group >= data->ngroups)
+            break;
+
+        if (!data->pinned[group])
+            virSecurityRelabelGroup(data, group);
+    }
+}
+
+
+/**
+ * virSecurityRelabelItems:
+ * @paths: path of each item, NULL ones are never grouped
+ * @nitems: number of items
+ * @threaded: whether other threads may be started
+ * @same: callback telling whether two items do the same, or NULL
+ * @pinned: callback telling whether an item must be relabelled by
+ *          the calling thread, or NULL
+ * @apply: callback relabelling an item
+ * @rollback: callback undoing @apply
+ * @opaque: opaque data to the callbacks
+ *
+ * Relabels items of a transaction. Items on the same path are
+ * relabelled in the order given. If @threaded is true, items on
+ * different paths are relabelled concurrently by a few threads, but
+ * paths with an item @pinned returns true for are all relabelled by
+ * the calling thread. A forked child must pass false for @threaded.
+ * If @same is given an item doing the same as the one preceding it
+ * on the same path is skipped, which must only be done if relabelling
+ * a path twice isn't meant to take two references on its remembered
+ * label.
+ *
+ * If an item fails to be relabelled no further ones are started and
+ * @rollback is called for each item relabelled successfully, in
+ * reverse order.
+ *
+ * Returns: 0 on success,
+ *         -1 otherwise (with error reported)
+ */
+int
+virSecurityRelabelItems(const char *const *paths,
+                        size_t nitems,
+                        bool threaded,
+                        virSecurityRelabelSameFunc same,
+                        virSecurityRelabelPinnedFunc pinned,
+                        virSecurityRelabelFunc apply,
+                        virSecurityRelabelFunc rollback,
+                        void *opaque)
+{
+    virSecurityRelabelData data = { .nitems = nitems,
+                                    .apply = apply,
+                                    .opaque = opaque };
+    virHashTablePtr last = NULL;
+    virThreadPtr threads = NULL;
+    size_t nthreads = 0;
+    size_t nskipped = 0;
+    size_t npinned = 0;
+    size_t i;
+    int ret = -1;
+
+    if (nitems == 0)
+        return 0;
+
+    if (VIR_ALLOC_N(data.groups, nitems) < 0 ||
+        VIR_ALLOC_N(data.next, nitems) < 0 ||
+        VIR_ALLOC_N(data.pinned, nitems) < 0 ||
+        VIR_ALLOC_N(data.done, nitems) < 0 ||
+        VIR_ALLOC_N(data.errors, nitems) < 0 ||
+        !(last = virHashCreate(nitems, NULL)))
+        goto cleanup;
+
+    /* The table holds the last item on every path plus one */
+    for (i = 0; i < nitems; i++) {
+        void *val = paths[i] ? virHashLookup(last, paths[i]) : NULL;
+        size_t prev = (size_t) val;
+
+        data.next[i] = nitems;
+
+        if (!prev) {
+            data.groups[data.ngroups++] = i;
+        } else if (same && same(prev - 1, i, opaque)) {
+            nskipped++;
+            continue;
+        } else {
+            data.next[prev - 1] = i;
+        }
+
+        if (paths[i] &&
+            virHashUpdateEntry(last, paths[i], (void *) (i + 1)) < 0)
+            goto cleanup;
+    }
+
+    for (i = 0; i < data.ngroups; i++) {
+        size_t j;
+
+        for (j = data.groups[i]; pinned && j < nitems; j = data.next[j]) {
+            if (pinned(j, opaque)) {
+                data.pinned[i] = true;
+                npinned++;
+                break;
+            }
+        }
+    }
+
+    VIR_DEBUG("Relabelling %zu items on %zu paths (%zu pinned), "
+              "skipping %zu duplicates",
+              nitems, data.ngroups, npinned, nskipped);
+
+    /* The calling thread is a worker too */
+    if (threaded &&
+        data.ngroups - npinned >= 2 * VIR_SECURITY_RELABEL_THREAD_PATHS) {
+        size_t want = MIN((data.ngroups - npinned) /
+                          VIR_SECURITY_RELABEL_THREAD_PATHS,
+                          VIR_SECURITY_RELABEL_THREADS) - 1;
+
+        if (VIR_ALLOC_N(threads, want) < 0)
+            goto cleanup;
+
+        for (nthreads = 0; nthreads < want; nthreads++) {
+            if (virThreadCreate(&threads[nthreads], true,
+                                virSecurityRelabelWorker, &data) < 0) {
+                VIR_DEBUG("Unable to create relabel thread, continuing with %zu",
+                          nthreads);
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < data.ngroups && !virAtomicIntGet(&data.failed); i++) {
+        if (data.pinned[i])
+            virSecurityRelabelGroup(&data, i);
+    }
+
+    virSecurityRelabelWorker(&data);
+
+    for (i = 0; i < nthreads; i++)
+        virThreadJoin(&threads[i]);
+
+    if (!data.failed) {
+        ret = 0;
+        goto cleanup;
+    }
+
+    for (i = nitems; i > 0; i--) {
+        if (data.done[i - 1])
+            ignore_value(rollback(i - 1, opaque));
+    }
+
+    for (i = 0; i < data.ngroups; i++) {
+        if (data.errors[i]) {
+            virSetError(data.errors[i]);
+            break;
+        }
+    }
+
+ cleanup:
+    if (data.errors) {
+        for (i = 0; i < data.ngroups; i++)
+            virFreeError(data.errors[i]);
+    }
+    virHashFree(last);
+    VIR_FREE(threads);
+    VIR_FREE(data.groups);
+    VIR_FREE(data.next);
+    VIR_FREE(data.pinned);
+    VIR_FREE(data.done);
+    VIR_FREE(data.errors);
+    return ret;
+}
@@ -29,4 +29,22 @@ virSecuritySetRememberedLabel(const char *name,
                               const char *path,
                               const char *label);
 
+typedef int (*virSecurityRelabelFunc)(size_t item,
+                                      void *opaque);
+typedef bool (*virSecurityRelabelSameFunc)(size_t a,
+                                           size_t b,
+                                           void *opaque);
+typedef bool (*virSecurityRelabelPinnedFunc)(size_t item,
+                                             void *opaque);
+
+int
+virSecurityRelabelItems(const char *const *paths,
+                        size_t nitems,
+                        bool threaded,
+                        virSecurityRelabelSameFunc same,
+                        virSecurityRelabelPinnedFunc pinned,
+                        virSecurityRelabelFunc apply,
+                        virSecurityRelabelFunc rollback,
+                        void *opaque);
+
 #endif /* LIBVIRT_SECURITY_UTIL_H */
@@ -6794,6 +6794,153 @@ testDomainRevertToSnapshot(virDomainSnapshotPtr snapshot,
 }
 
 
+static int
+testConnectLookupDomainsByUUID(virConnectPtr conn,
+                               const unsigned char *uuids,
+                               unsigned int nuuids,
+                               virDomainPtr **domains,
+                               int **states,
+                               unsigned int flags)
+{
+    testDriverPtr privconn = conn->privateData;
+
+    virCheckFlags(0, -1);
+
+    return virDomainObjListLookupUUIDs(privconn->domains, conn, uuids, nuuids,
+                                       domains, states, NULL);
+}
+
+
+static int
+testDomainGetStats(virConnectPtr conn,
+                   virDomainObjPtr dom,
+                   unsigned int stats,
+                   virDomainStatsRecordPtr *record)
+{
+    VIR_AUTOPTR(virTypedParamList) params = NULL;
+    virDomainStatsRecordPtr tmp;
+    int ret = -1;
+
+    if (VIR_ALLOC(params) < 0)
+        return -1;
+
+    if (stats & VIR_DOMAIN_STATS_STATE) {
+        if (virTypedParamListAddInt(params, dom->state.state,
+                                    "state.state") < 0 ||
+            virTypedParamListAddInt(params, dom->state.reason,
+                                    "state.reason") < 0)
+            return -1;
+    }
+
+    if (VIR_ALLOC(tmp) < 0)
+        return -1;
+
+    if (!(tmp->dom = virGetDomain(conn, dom->def->name,
+                                  dom->def->uuid, dom->def->id)))
+        goto cleanup;
+
+    tmp->nparams = virTypedParamListStealParams(params, &tmp->params);
+    VIR_STEAL_PTR(*record, tmp);
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(tmp);
+    return ret;
+}
+
+
+static int
+testConnectGetAllDomainStats(virConnectPtr conn,
+                             virDomainPtr *doms,
+                             unsigned int ndoms,
+                             unsigned int stats,
+                             virDomainStatsRecordPtr **retStats,
+                             unsigned int flags)
+{
+    testDriverPtr privconn = conn->privateData;
+    virDomainObjPtr *vms = NULL;
+    size_t nvms;
+    virDomainStatsRecordPtr *tmpstats = NULL;
+    int nstats = 0;
+    size_t i;
+    int ret = -1;
+    unsigned int lflags = flags & (VIR_CONNECT_LIST_DOMAINS_FILTERS_ACTIVE |
+                                   VIR_CONNECT_LIST_DOMAINS_FILTERS_PERSISTENT |
+                                   VIR_CONNECT_LIST_DOMAINS_FILTERS_STATE);
+
+    virCheckFlags(VIR_CONNECT_LIST_DOMAINS_FILTERS_ACTIVE |
+                  VIR_CONNECT_LIST_DOMAINS_FILTERS_PERSISTENT |
+                  VIR_CONNECT_LIST_DOMAINS_FILTERS_STATE |
+                  VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT |
+                  VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS, -1);
+
+    /* Only the state group is provided by the test driver */
+    if (stats == 0) {
+        stats = VIR_DOMAIN_STATS_STATE;
+    } else if (stats & ~VIR_DOMAIN_STATS_STATE) {
+        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS) {
+            virReportError(VIR_ERR_ARGUMENT_UNSUPPORTED,
+                           _("Stats types bits 0x%x are not supported by this daemon"),
+                           stats & ~VIR_DOMAIN_STATS_STATE);
+            return -1;
+        }
+        stats &= VIR_DOMAIN_STATS_STATE;
+    }
+
+    if (ndoms) {
+        if (virDomainObjListConvert(privconn->domains, conn, doms, ndoms,
+                                    &vms, &nvms, NULL, lflags, true) < 0)
+            return -1;
+    } else {
+        if (virDomainObjListCollect(privconn->domains, conn, &vms, &nvms,
+                                    NULL, lflags) < 0)
+            return -1;
+    }
+
+    if (VIR_ALLOC_N(tmpstats, nvms + 1) < 0)
+        goto cleanup;
+
+    for (i = 0; i < nvms; i++) {
+        int rc;
+
+        virObjectLock(vms[i]);
+        rc = testDomainGetStats(conn, vms[i], stats, &tmpstats[nstats]);
+        virObjectUnlock(vms[i]);
+
+        if (rc < 0)
+            goto cleanup;
+        nstats++;
+    }
+
+    VIR_STEAL_PTR(*retStats, tmpstats);
+    ret = nstats;
+
+ cleanup:
+    virDomainStatsRecordListFree(tmpstats);
+    virObjectListFreeCount(vms, nvms);
+    return ret;
+}
+
+
+static int
+testDomainListLifecycle(virConnectPtr conn,
+                        virDomainPtr *doms,
+                        unsigned int ndoms,
+                        int action,
+                        int **errors,
+                        unsigned int flags)
+{
+    testDriverPtr privconn = conn->privateData;
+
+    return virDomainObjListLifecycle(privconn->domains, conn, doms, ndoms,
+                                     action, errors, flags,
+                                     NULL,
+                                     testDomainCreateWithFlags,
+                                     testDomainShutdownFlags,
+                                     testDomainDestroyFlags);
+}
+
+
 static virHypervisorDriver testHypervisorDriver = {
     .name = "Test",
     .connectOpen = testConnectOpen, /* 0.1.1 */
@@ -6898,6 +7045,9 @@ static virHypervisorDriver testHypervisorDriver = {
     .domainSnapshotDelete = testDomainSnapshotDelete, /* 1.1.4 */
 
     .connectBaselineCPU = testConnectBaselineCPU, /* 1.2.0 */
+    .connectGetAllDomainStats = testConnectGetAllDomainStats, /* 5.1.0 */
+    .connectLookupDomainsByUUID = testConnectLookupDomainsByUUID, /* 5.1.0 */
+    .domainListLifecycle = testDomainListLifecycle, /* 5.1.0 */
 };
 
 static virNetworkDriver testNetworkDriver = {
@@ -27,6 +27,7 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 
 #include "virutil.h"
 #include "virthread.h"
@@ -52,6 +53,15 @@ runIO(const char *path, int fd, int oflags)
     unsigned long long total = 0;
     bool direct = O_DIRECT && ((oflags & O_DIRECT) != 0);
     off_t end = 0;
+    struct stat sb;
+    bool sparse = false; /* whether @fd is a regular file we can seek in */
+    off_t pos = 0; /* current position in @fd if @sparse */
+    off_t initialEnd = 0; /* size of @fd when we started */
+    long long hole = 0; /* bytes left in the current hole of input @fd */
+    bool holeAtEnd = false; /* whether we've skipped the last write */
+#ifdef SPLICE_F_MOVE
+    bool zerocopy = false; /* whether to move data by splice() */
+#endif
 
 #if HAVE_POSIX_MEMALIGN
     if (posix_memalign(&base, alignMask + 1, buflen)) {
@@ -102,16 +112,85 @@ runIO(const char *path, int fd, int oflags)
         goto cleanup;
     }
 
+    /* Long runs of zeros (unused guest memory, unallocated parts of disk
+     * images) don't have to travel through the disk. When reading, holes
+     * in @fd are not read at all. When writing, blocks of zeros past the
+     * original end of @fd are seeked over instead of written, which
+     * leaves holes in the file. */
+    if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) &&
+        (pos = lseek(fd, 0, SEEK_CUR)) != (off_t) -1) {
+        sparse = true;
+        initialEnd = sb.st_size;
+    }
+
+#ifdef SPLICE_F_MOVE
+    /* The other end is usually a pipe from or to QEMU, so the data can
+     * be moved by the kernel without copying it through our buffer.
+     * Writing a sparse file needs to look at the data to find blocks
+     * of zeros, and O_DIRECT needs aligned writes which splice() can't
+     * guarantee, so both keep using the copy loop. If neither end is a
+     * pipe, splice() fails with EINVAL and we fall back to it too. */
+    if (!direct && (fdout != fd || !sparse)) {
+        zerocopy = true;
+# ifdef F_SETPIPE_SZ
+        /* Best effort, a bigger pipe means fewer context switches */
+        ignore_value(fcntl(fd == fdin ? fdout : fdin, F_SETPIPE_SZ, buflen));
+# endif
+    }
+#endif
+
     while (1) {
         ssize_t got;
 
+        if (fdin == fd && sparse && !direct && hole == 0) {
+            int inData;
+
+            if (virFileInData(fd, &inData, &hole) < 0) {
+                /* Not fatal, just read everything from now on */
+                virResetLastError();
+                sparse = false;
+                hole = 0;
+            } else if (inData) {
+                hole = 0;
+            }
+        }
+
         /* If we read with O_DIRECT from file we can't use saferead as
          * it can lead to unaligned read after reading last bytes.
          * If we write with O_DIRECT use should use saferead so that
          * writes will be aligned.
          * In other cases using saferead reduces number of syscalls.
          */
-        if (fdin == fd && direct) {
+        if (hole > 0) {
+            got = MIN(hole, (long long) buflen);
+            memset(buf, 0, got);
+            if (lseek(fdin, got, SEEK_CUR) == (off_t) -1) {
+                virReportSystemError(errno, _("Unable to seek %s"), fdinname);
+                goto cleanup;
+            }
+            hole -= got;
+#ifdef SPLICE_F_MOVE
+        } else if (zerocopy) {
+            got = splice(fdin, NULL, fdout, NULL, buflen,
+                         SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (got < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EINVAL || errno == ENOSYS) {
+                    zerocopy = false;
+                    continue;
+                }
+                virReportSystemError(errno, _("Unable to splice %s to %s"),
+                                     fdinname, fdoutname);
+                goto cleanup;
+            }
+            if (got == 0)
+                break;
+
+            total += got;
+            continue;
+#endif
+        } else if (fdin == fd && direct) {
             if ((got = read(fdin, buf, buflen)) < 0 &&
                 errno == EINTR)
                 continue;
@@ -128,6 +207,21 @@ runIO(const char *path, int fd, int oflags)
 
         total += got;
 
+        if (fdout == fd && sparse) {
+            if (pos >= initialEnd && virFileDataIsZero(buf, got)) {
+                if (lseek(fdout, got, SEEK_CUR) == (off_t) -1) {
+                    virReportSystemError(errno, _("Unable to seek %s"),
+                                         fdoutname);
+                    goto cleanup;
+                }
+                pos += got;
+                holeAtEnd = true;
+                continue;
+            }
+            pos += got;
+            holeAtEnd = false;
+        }
+
         /* handle last write size align in direct case */
         if (got < buflen && direct && fdout == fd) {
             ssize_t aligned_got = (got + alignMask) & ~alignMask;
@@ -153,6 +247,13 @@ runIO(const char *path, int fd, int oflags)
         }
     }
 
+    /* Seeking past the end doesn't make the file any bigger, so if the
+     * trailing data were zeros the file size has to be fixed up. */
+    if (holeAtEnd && ftruncate(fdout, pos) < 0) {
+        virReportSystemError(errno, _("Unable to truncate %s"), fdoutname);
+        goto cleanup;
+    }
+
     /* Ensure all data is written */
     if (fdatasync(fdout) < 0) {
         if (errno != EINVAL && errno != EROFS) {
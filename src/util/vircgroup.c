@@ -24,7 +24,9 @@
 # include <mntent.h>
 # include <sys/mount.h>
 # include <fcntl.h>
+# include <poll.h>
 # include <sys/stat.h>
+# include <sys/statfs.h>
 
 # ifdef MAJOR_IN_MKDEV
 #  include <sys/mkdev.h>
@@ -214,32 +216,129 @@ virCgroupPartitionEscape(char **path)
 }
 
 
+# ifndef PROC_SUPER_MAGIC
+#  define PROC_SUPER_MAGIC 0x9fa0
+# endif
+
+typedef struct _virCgroupMount virCgroupMount;
+typedef virCgroupMount *virCgroupMountPtr;
+struct _virCgroupMount {
+    char *type;
+    char *opts;
+    char *dir;
+};
+
+/* The cgroup mounts are the same for every group, so /proc/mounts is
+ * parsed once and kept open. The kernel flags it with POLLPRI when
+ * the mount table changes, which is when it gets parsed again. */
+static virMutex virCgroupMountsLock = VIR_MUTEX_INITIALIZER;
+static FILE *virCgroupMountsFile;
+static virCgroupMountPtr virCgroupMounts;
+static size_t virCgroupNMounts;
+
+
+static void
+virCgroupMountsClear(void)
+{
+    size_t i;
+
+    for (i = 0; i < virCgroupNMounts; i++) {
+        VIR_FREE(virCgroupMounts[i].type);
+        VIR_FREE(virCgroupMounts[i].opts);
+        VIR_FREE(virCgroupMounts[i].dir);
+    }
+    VIR_FREE(virCgroupMounts);
+    virCgroupNMounts = 0;
+}
+
+
 /*
- * Process /proc/mounts figuring out what controllers are
- * mounted and where
+ * Refreshes the list of cgroup mounts unless /proc/mounts hasn't
+ * changed since it was last parsed. Must be called with
+ * virCgroupMountsLock held.
  */
 static int
-virCgroupDetectMounts(virCgroupPtr group)
+virCgroupMountsLoad(void)
 {
-    FILE *mounts = NULL;
+    FILE *mounts = virCgroupMountsFile;
     struct mntent entry;
+    struct statfs sb;
     char buf[CGROUP_MAX_VAL];
-    int ret = -1;
-    size_t i;
 
-    mounts = fopen("/proc/mounts", "r");
-    if (mounts == NULL) {
+    if (mounts) {
+        struct pollfd fds = { .fd = fileno(mounts), .events = POLLPRI };
+
+        if (poll(&fds, 1, 0) == 0)
+            return 0;
+
+        rewind(mounts);
+    } else if (!(mounts = fopen("/proc/mounts", "r"))) {
         virReportSystemError(errno, "%s", _("Unable to open /proc/mounts"));
         return -1;
     }
 
+    virCgroupMountsClear();
+
     while (getmntent_r(mounts, &entry, buf, sizeof(buf)) != NULL) {
-        for (i = 0; i < VIR_CGROUP_BACKEND_TYPE_LAST; i++) {
-            if (group->backends[i] &&
-                group->backends[i]->detectMounts(group,
-                                                 entry.mnt_type,
-                                                 entry.mnt_opts,
-                                                 entry.mnt_dir) < 0) {
+        virCgroupMountPtr mnt;
+
+        /* Both "cgroup" and "cgroup2" */
+        if (!STRPREFIX(entry.mnt_type, "cgroup"))
+            continue;
+
+        if (VIR_EXPAND_N(virCgroupMounts, virCgroupNMounts, 1) < 0)
+            goto error;
+
+        mnt = &virCgroupMounts[virCgroupNMounts - 1];
+        if (VIR_STRDUP(mnt->type, entry.mnt_type) < 0 ||
+            VIR_STRDUP(mnt->opts, entry.mnt_opts) < 0 ||
+            VIR_STRDUP(mnt->dir, entry.mnt_dir) < 0)
+            goto error;
+    }
+
+    /* Without a real /proc there is nothing telling us when the
+     * mounts change, so parse them every time */
+    if (fstatfs(fileno(mounts), &sb) == 0 && sb.f_type == PROC_SUPER_MAGIC &&
+        virSetCloseExec(fileno(mounts)) == 0) {
+        virCgroupMountsFile = mounts;
+    } else {
+        VIR_FORCE_FCLOSE(mounts);
+        virCgroupMountsFile = NULL;
+    }
+
+    return 0;
+
+ error:
+    virCgroupMountsClear();
+    VIR_FORCE_FCLOSE(mounts);
+    virCgroupMountsFile = NULL;
+    return -1;
+}
+
+
+/*
+ * Process /proc/mounts figuring out what controllers are
+ * mounted and where
+ */
+static int
+virCgroupDetectMounts(virCgroupPtr group)
+{
+    int ret = -1;
+    size_t i;
+    size_t j;
+
+    virMutexLock(&virCgroupMountsLock);
+
+    if (virCgroupMountsLoad() < 0)
+        goto cleanup;
+
+    for (i = 0; i < virCgroupNMounts; i++) {
+        for (j = 0; j < VIR_CGROUP_BACKEND_TYPE_LAST; j++) {
+            if (group->backends[j] &&
+                group->backends[j]->detectMounts(group,
+                                                 virCgroupMounts[i].type,
+                                                 virCgroupMounts[i].opts,
+                                                 virCgroupMounts[i].dir) < 0) {
                 goto cleanup;
             }
         }
@@ -247,7 +346,7 @@ virCgroupDetectMounts(virCgroupPtr group)
 
     ret = 0;
  cleanup:
-    VIR_FORCE_FCLOSE(mounts);
+    virMutexUnlock(&virCgroupMountsLock);
     return ret;
 }
 
@@ -482,28 +581,168 @@ virCgroupSetValueStr(virCgroupPtr group,
 }
 
 
-int
-virCgroupGetValueStr(virCgroupPtr group,
-                     int controller,
-                     const char *key,
-                     char **value)
+typedef struct _virCgroupFile virCgroupFile;
+typedef virCgroupFile *virCgroupFilePtr;
+struct _virCgroupFile {
+    int fd;
+};
+
+static void
+virCgroupFileFree(void *payload,
+                  const void *name ATTRIBUTE_UNUSED)
+{
+    virCgroupFilePtr file = payload;
+
+    VIR_FORCE_CLOSE(file->fd);
+    VIR_FREE(file);
+    virFileCachedFDRelease();
+}
+
+
+/*
+ * Closes the files kept open for @group
+ */
+static void
+virCgroupFilesClose(virCgroupPtr group)
+{
+    size_t i;
+
+    virMutexLock(&group->filesLock);
+    for (i = 0; i < VIR_CGROUP_CONTROLLER_LAST; i++) {
+        virHashFree(group->files[i]);
+        group->files[i] = NULL;
+    }
+    virMutexUnlock(&group->filesLock);
+}
+
+
+/*
+ * Reads all of @fd from its start into a newly allocated buffer. The
+ * whole file is read with a single pread() so that it's a consistent
+ * snapshot, the buffer is grown and the read retried if it's too small.
+ *
+ * Returns the length read, or -1 with errno set
+ */
+static ssize_t
+virCgroupFileRead(int fd,
+                  char **value)
+{
+    size_t size = 4096;
+    ssize_t len;
+
+    for (;;) {
+        if (VIR_ALLOC_N_QUIET(*value, size + 1) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+
+        if ((len = pread(fd, *value, size, 0)) < 0) {
+            VIR_FREE(*value);
+            return -1;
+        }
+
+        if ((size_t)len < size)
+            break;
+
+        VIR_FREE(*value);
+        if (size >= 1024 * 1024) {
+            errno = EFBIG;
+            return -1;
+        }
+        size *= 2;
+    }
+
+    (*value)[len] = '\0';
+    return len;
+}
+
+
+/*
+ * Reads @key of @controller, keeping the file open for the next time
+ * as long as the limit on open files allows it. A file which can't be
+ * read any more, for example because the group was removed and made
+ * again, is opened afresh.
+ *
+ * Returns the length read, or -1 on error
+ */
+static ssize_t
+virCgroupReadFile(virCgroupPtr group,
+                  int controller,
+                  const char *key,
+                  char **value)
 {
     VIR_AUTOFREE(char *) keypath = NULL;
-    int rc;
+    virCgroupFilePtr file = NULL;
+    ssize_t len = -1;
+    int fd = -1;
 
-    *value = NULL;
+    virMutexLock(&group->filesLock);
+
+    if (controller >= 0 && controller < VIR_CGROUP_CONTROLLER_LAST &&
+        group->files[controller] &&
+        (file = virHashLookup(group->files[controller], key))) {
+        if ((len = virCgroupFileRead(file->fd, value)) >= 0)
+            goto cleanup;
+
+        virHashRemoveEntry(group->files[controller], key);
+    }
 
     if (virCgroupPathOfController(group, controller, key, &keypath) < 0)
-        return -1;
+        goto cleanup;
 
     VIR_DEBUG("Get value %s", keypath);
 
-    if ((rc = virFileReadAll(keypath, 1024*1024, value)) < 0) {
+    if ((fd = open(keypath, O_RDONLY | O_CLOEXEC)) < 0 ||
+        (len = virCgroupFileRead(fd, value)) < 0) {
         virReportSystemError(errno,
                              _("Unable to read from '%s'"), keypath);
-        return -1;
+        goto cleanup;
     }
 
+    if (controller < 0 || controller >= VIR_CGROUP_CONTROLLER_LAST)
+        goto cleanup;
+
+    if (!virFileCachedFDReserve())
+        goto cleanup;
+
+    if ((!group->files[controller] &&
+         !(group->files[controller] = virHashCreate(8, virCgroupFileFree))) ||
+        VIR_ALLOC(file) < 0) {
+        virFileCachedFDRelease();
+        virResetLastError();
+        goto cleanup;
+    }
+
+    file->fd = fd;
+    if (virHashAddEntry(group->files[controller], key, file) < 0) {
+        /* Frees @file and undoes the count, but leaves @fd alone */
+        file->fd = -1;
+        virCgroupFileFree(file, NULL);
+        virResetLastError();
+        goto cleanup;
+    }
+    fd = -1;
+
+ cleanup:
+    virMutexUnlock(&group->filesLock);
+    VIR_FORCE_CLOSE(fd);
+    return len;
+}
+
+
+int
+virCgroupGetValueStr(virCgroupPtr group,
+                     int controller,
+                     const char *key,
+                     char **value)
+{
+    ssize_t rc;
+
+    *value = NULL;
+
+    if ((rc = virCgroupReadFile(group, controller, key, value)) < 0)
+        return -1;
+
     /* Terminated with '\n' has sometimes harmful effects to the caller */
     if (rc > 0 && (*value)[rc - 1] == '\n')
         (*value)[rc - 1] = '\0';
@@ -665,7 +904,14 @@ virCgroupNew(pid_t pid,
     *group = NULL;
 
     if (VIR_ALLOC((*group)) < 0)
-        goto error;
+        return -1;
+
+    if (virMutexInit(&(*group)->filesLock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to initialize mutex"));
+        VIR_FREE(*group);
+        return -1;
+    }
 
     if (path[0] == '/' || !parent) {
         if (VIR_STRDUP((*group)->path, path) < 0)
@@ -1299,6 +1545,9 @@ virCgroupFree(virCgroupPtr *group)
     VIR_FREE((*group)->unified.mountPoint);
     VIR_FREE((*group)->unified.placement);
 
+    virCgroupFilesClose(*group);
+    virMutexDestroy(&(*group)->filesLock);
+
     VIR_FREE((*group)->path);
     VIR_FREE(*group);
 }
@@ -2413,6 +2662,8 @@ virCgroupRemove(virCgroupPtr group)
 {
     size_t i;
 
+    virCgroupFilesClose(group);
+
     for (i = 0; i < VIR_CGROUP_BACKEND_TYPE_LAST; i++) {
         if (group->backends[i] &&
             group->backends[i]->remove(group) < 0) {
@@ -28,6 +28,8 @@
 
 # include "vircgroup.h"
 # include "vircgroupbackend.h"
+# include "virhash.h"
+# include "virthread.h"
 
 struct _virCgroupV1Controller {
     int type;
@@ -57,6 +59,11 @@ struct _virCgroup {
 
     virCgroupV1Controller legacy[VIR_CGROUP_CONTROLLER_LAST];
     virCgroupV2Controller unified;
+
+    /* Files read from before, keyed by file name, kept open so that
+     * reading them again only costs a pread() */
+    virMutex filesLock;
+    virHashTablePtr files[VIR_CGROUP_CONTROLLER_LAST];
 };
 
 int virCgroupSetValueStr(virCgroupPtr group,
@@ -22,9 +22,11 @@
 #include <config.h>
 
 #include "virevent.h"
+#include "vireventepoll.h"
 #include "vireventpoll.h"
 #include "virlog.h"
 #include "virerror.h"
+#include "virutil.h"
 
 
 VIR_LOG_INIT("util.event");
@@ -36,6 +38,9 @@ static virEventAddTimeoutFunc addTimeoutImpl;
 static virEventUpdateTimeoutFunc updateTimeoutImpl;
 static virEventRemoveTimeoutFunc removeTimeoutImpl;
 
+/* Whether the default implementation uses epoll rather than poll */
+static bool defaultImplEpoll;
+
 
 /*****************************************************
  *
@@ -270,14 +275,40 @@ void virEventRegisterImpl(virEventAddHandleFunc addHandle,
  * wakes up on events registered by libvirt API calls such as
  * virEventAddHandle() or virConnectDomainEventRegisterAny().
  *
+ * Setting the LIBVIRT_EVENT_LOOP environment variable to "epoll"
+ * selects an implementation based on epoll instead, whose iterations
+ * don't get slower with the number of registered handles and timers.
+ * It is only available on Linux, elsewhere the poll() based one is
+ * used.
+ *
  * Returns 0 on success, -1 on failure.
  */
 int virEventRegisterDefaultImpl(void)
 {
-    VIR_DEBUG("registering default event implementation");
+    const char *impl = virGetEnvBlockSUID("LIBVIRT_EVENT_LOOP");
+
+    VIR_DEBUG("registering default event implementation impl=%s",
+              NULLSTR(impl));
 
     virResetLastError();
 
+    if (STREQ_NULLABLE(impl, "epoll")) {
+        if (virEventEpollInit() == 0) {
+            defaultImplEpoll = true;
+            virEventRegisterImpl(virEventEpollAddHandle,
+                                 virEventEpollUpdateHandle,
+                                 virEventEpollRemoveHandle,
+                                 virEventEpollAddTimeout,
+                                 virEventEpollUpdateTimeout,
+                                 virEventEpollRemoveTimeout);
+            return 0;
+        }
+
+        VIR_WARN("Falling back to poll based event loop: %s",
+                 virGetLastErrorMessage());
+        virResetLastError();
+    }
+
     if (virEventPollInit() < 0) {
         virDispatchError(NULL);
         return -1;
@@ -319,7 +350,8 @@ int virEventRunDefaultImpl(void)
     VIR_DEBUG("running default event implementation");
     virResetLastError();
 
-    if (virEventPollRunOnce() < 0) {
+    if ((defaultImplEpoll ? virEventEpollRunOnce() :
+         virEventPollRunOnce()) < 0) {
         virDispatchError(NULL);
         return -1;
     }
@@ -0,0 +1,1050 @@
+/*
+ * vireventepoll.c: epoll based event loop for monitoring file handles
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#ifdef __linux__
+# include <sys/epoll.h>
+#endif
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "virthread.h"
+#include "virlog.h"
+#include "vireventepoll.h"
+#include "viralloc.h"
+#include "virhash.h"
+#include "virhashcode.h"
+#include "virutil.h"
+#include "virfile.h"
+#include "virerror.h"
+#include "virtime.h"
+
+#define EVENT_DEBUG(fmt, ...) VIR_DEBUG(fmt, __VA_ARGS__)
+
+#define VIR_FROM_THIS VIR_FROM_EVENT
+
+VIR_LOG_INIT("util.eventepoll");
+
+#ifdef __linux__
+
+/* Maximum number of ready file handles fetched by one epoll_wait() */
+# define EVENT_EPOLL_MAX_EVENTS 128
+
+static int virEventEpollInterruptLocked(void);
+
+typedef struct _virEventEpollHandle virEventEpollHandle;
+typedef virEventEpollHandle *virEventEpollHandlePtr;
+
+typedef struct _virEventEpollFD virEventEpollFD;
+typedef virEventEpollFD *virEventEpollFDPtr;
+
+typedef struct _virEventEpollTimeout virEventEpollTimeout;
+typedef virEventEpollTimeout *virEventEpollTimeoutPtr;
+
+/* State for a single file handle being monitored */
+struct _virEventEpollHandle {
+    int watch;
+    int fd;
+    int events; /* VIR_EVENT_HANDLE_* */
+    virEventHandleCallback cb;
+    virFreeCallback ff;
+    void *opaque;
+    bool deleted;
+    virEventEpollHandlePtr nextDeleted;
+};
+
+/* State for all file handles watching the same file descriptor */
+struct _virEventEpollFD {
+    int fd;
+    int events; /* EPOLL* events the kernel watches for */
+    bool registered; /* whether @fd is in the epoll set */
+    bool always; /* epoll refused @fd, treat it as always ready */
+    size_t nhandles;
+    virEventEpollHandlePtr *handles;
+};
+
+/* State for a single timer being generated */
+struct _virEventEpollTimeout {
+    int timer;
+    int frequency;
+    unsigned long long expiresAt;
+    virEventTimeoutCallback cb;
+    virFreeCallback ff;
+    void *opaque;
+    bool deleted;
+    ssize_t heapIndex; /* position in the timer heap, -1 if disabled */
+    virEventEpollTimeoutPtr nextDeleted;
+};
+
+/* State for the main event loop */
+struct virEventEpollLoop {
+    virMutex lock;
+    int running;
+    virThread leader;
+    int epollfd;
+    int wakeupfd[2];
+
+    /* Indexed by file descriptor */
+    size_t nfds;
+    virEventEpollFDPtr *fds;
+    size_t nalways; /* always ready fds with some events enabled */
+
+    virHashTablePtr handles; /* watch -> virEventEpollHandlePtr */
+    virHashTablePtr timeouts; /* timer -> virEventEpollTimeoutPtr */
+
+    /* Enabled timers, ordered by their expiry time. There's a slot
+     * reserved for each existing timer so that enabling one never
+     * needs to allocate memory. */
+    size_t ntimeouts;
+    size_t nheap;
+    size_t heapAlloc;
+    virEventEpollTimeoutPtr *heap;
+
+    /* Removed records waiting for their free callbacks to be run
+     * out-of-band, which is needed to make dispatch re-entrant safe */
+    virEventEpollHandlePtr deletedHandles;
+    virEventEpollTimeoutPtr deletedTimeouts;
+};
+
+/* Only have one event loop */
+static struct virEventEpollLoop eventLoop;
+
+/* Unique ID for the next FD watch to be registered */
+static int nextWatch = 1;
+
+/* Unique ID for the next timer to be registered */
+static int nextTimer = 1;
+
+
+static uint32_t
+virEventEpollKeyCode(const void *name, uint32_t seed)
+{
+    int key = (int)(intptr_t)name;
+    return virHashCodeGen(&key, sizeof(key), seed);
+}
+
+
+static bool
+virEventEpollKeyEqual(const void *namea, const void *nameb)
+{
+    return namea == nameb;
+}
+
+
+static void *
+virEventEpollKeyCopy(const void *name)
+{
+    return (void *)name;
+}
+
+
+static int
+virEventEpollToNativeEvents(int events)
+{
+    int ret = 0;
+    if (events & VIR_EVENT_HANDLE_READABLE)
+        ret |= EPOLLIN;
+    if (events & VIR_EVENT_HANDLE_WRITABLE)
+        ret |= EPOLLOUT;
+    if (events & VIR_EVENT_HANDLE_ERROR)
+        ret |= EPOLLERR;
+    if (events & VIR_EVENT_HANDLE_HANGUP)
+        ret |= EPOLLHUP;
+    return ret;
+}
+
+
+static int
+virEventEpollFromNativeEvents(int events)
+{
+    int ret = 0;
+    if (events & EPOLLIN)
+        ret |= VIR_EVENT_HANDLE_READABLE;
+    if (events & EPOLLOUT)
+        ret |= VIR_EVENT_HANDLE_WRITABLE;
+    if (events & EPOLLERR)
+        ret |= VIR_EVENT_HANDLE_ERROR;
+    if (events & EPOLLHUP)
+        ret |= VIR_EVENT_HANDLE_HANGUP;
+    return ret;
+}
+
+
+/*
+ * Set the events of an fd epoll refused. Only those with some events
+ * enabled make the loop skip sleeping, so keep count of them and wake
+ * up a sleeping loop when one becomes ready.
+ */
+static void
+virEventEpollSetAlwaysEvents(virEventEpollFDPtr info, int events)
+{
+    if (info->events == 0 && events != 0) {
+        eventLoop.nalways++;
+        virEventEpollInterruptLocked();
+    } else if (info->events != 0 && events == 0) {
+        eventLoop.nalways--;
+    }
+    info->events = events;
+}
+
+
+/*
+ * Tell the kernel about the union of events the handles of @info are
+ * interested in. With @force the registration is refreshed even if
+ * the events didn't change, which is needed when a handle is added as
+ * the file descriptor might have been closed and reused meanwhile.
+ *
+ * Returns 0 on success, -1 on error
+ */
+static int
+virEventEpollUpdateFD(virEventEpollFDPtr info, bool force)
+{
+    struct epoll_event ev;
+    int events = 0;
+    int op;
+    size_t i;
+
+    for (i = 0; i < info->nhandles; i++) {
+        if (!info->handles[i]->deleted)
+            events |= virEventEpollToNativeEvents(info->handles[i]->events);
+    }
+
+    if (info->always) {
+        virEventEpollSetAlwaysEvents(info, events);
+        return 0;
+    }
+
+    /* Unlike poll(), epoll reports errors and hangups even if we ask
+     * for no events at all, so don't watch the fd in such case. */
+    if (events == 0) {
+        if (info->registered)
+            ignore_value(epoll_ctl(eventLoop.epollfd, EPOLL_CTL_DEL,
+                                   info->fd, NULL));
+        info->registered = false;
+        info->events = 0;
+        return 0;
+    }
+
+    if (!force && info->registered && info->events == events)
+        return 0;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = info->fd;
+
+    op = info->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(eventLoop.epollfd, op, info->fd, &ev) < 0) {
+        if (op == EPOLL_CTL_MOD && errno == ENOENT)
+            op = EPOLL_CTL_ADD;
+        else if (op == EPOLL_CTL_ADD && errno == EEXIST)
+            op = EPOLL_CTL_MOD;
+        else
+            op = -1;
+
+        if (op < 0 || epoll_ctl(eventLoop.epollfd, op, info->fd, &ev) < 0) {
+            /* Regular files can't be watched by epoll, but poll()
+             * always reports them as ready so do the same. */
+            if (errno == EPERM) {
+                EVENT_DEBUG("Treating fd %d as always ready", info->fd);
+                info->always = true;
+                info->registered = false;
+                info->events = 0;
+                virEventEpollSetAlwaysEvents(info, events);
+                return 0;
+            }
+
+            virReportSystemError(errno,
+                                 _("Unable to watch file handle %d"),
+                                 info->fd);
+            return -1;
+        }
+    }
+
+    info->registered = true;
+    info->events = events;
+    return 0;
+}
+
+
+static void
+virEventEpollFDFree(virEventEpollFDPtr info)
+{
+    if (!info)
+        return;
+
+    if (info->always && info->events != 0)
+        eventLoop.nalways--;
+    eventLoop.fds[info->fd] = NULL;
+    VIR_FREE(info->handles);
+    VIR_FREE(info);
+}
+
+
+/*
+ * Register a callback for monitoring file handle events.
+ * NB, it *must* be safe to call this from within a callback
+ */
+int virEventEpollAddHandle(int fd, int events,
+                           virEventHandleCallback cb,
+                           void *opaque,
+                           virFreeCallback ff)
+{
+    virEventEpollHandlePtr handle = NULL;
+    virEventEpollFDPtr info = NULL;
+    int watch = -1;
+
+    if (fd < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Invalid file handle %d"), fd);
+        return -1;
+    }
+
+    virMutexLock(&eventLoop.lock);
+
+    if (fd >= eventLoop.nfds &&
+        VIR_RESIZE_N(eventLoop.fds, eventLoop.nfds, fd, 1) < 0)
+        goto cleanup;
+
+    if (!(info = eventLoop.fds[fd])) {
+        if (VIR_ALLOC(info) < 0)
+            goto cleanup;
+        info->fd = fd;
+        eventLoop.fds[fd] = info;
+    }
+
+    if (VIR_ALLOC(handle) < 0)
+        goto cleanup;
+
+    handle->watch = nextWatch;
+    handle->fd = fd;
+    handle->events = events;
+    handle->cb = cb;
+    handle->ff = ff;
+    handle->opaque = opaque;
+
+    if (VIR_APPEND_ELEMENT_COPY(info->handles, info->nhandles, handle) < 0)
+        goto cleanup;
+
+    if (virHashAddEntry(eventLoop.handles,
+                        (void *)(intptr_t)handle->watch, handle) < 0) {
+        VIR_DELETE_ELEMENT(info->handles, info->nhandles - 1, info->nhandles);
+        goto cleanup;
+    }
+
+    if (virEventEpollUpdateFD(info, true) < 0) {
+        virHashRemoveEntry(eventLoop.handles, (void *)(intptr_t)handle->watch);
+        VIR_DELETE_ELEMENT(info->handles, info->nhandles - 1, info->nhandles);
+        goto cleanup;
+    }
+
+    /* A running epoll_wait() notices changes of the epoll set on its
+     * own, fds epoll refused wake it up in virEventEpollUpdateFD() */
+    watch = nextWatch++;
+    EVENT_DEBUG("Added watch=%d fd=%d events=%d cb=%p opaque=%p ff=%p",
+                watch, fd, events, cb, opaque, ff);
+
+ cleanup:
+    if (watch < 0) {
+        VIR_FREE(handle);
+        if (info && info->nhandles == 0)
+            virEventEpollFDFree(info);
+    }
+    virMutexUnlock(&eventLoop.lock);
+    return watch;
+}
+
+void virEventEpollUpdateHandle(int watch, int events)
+{
+    virEventEpollHandlePtr handle;
+
+    EVENT_DEBUG("Update watch=%d events=%d", watch, events);
+
+    if (watch <= 0) {
+        VIR_WARN("Ignoring invalid update watch %d", watch);
+        return;
+    }
+
+    virMutexLock(&eventLoop.lock);
+    if (!(handle = virHashLookup(eventLoop.handles,
+                                 (void *)(intptr_t)watch))) {
+        virMutexUnlock(&eventLoop.lock);
+        VIR_WARN("Got update for non-existent handle watch %d", watch);
+        return;
+    }
+
+    handle->events = events;
+    if (virEventEpollUpdateFD(eventLoop.fds[handle->fd], false) < 0) {
+        VIR_WARN("Unable to update watch %d: %s",
+                 watch, virGetLastErrorMessage());
+        virResetLastError();
+    }
+    virMutexUnlock(&eventLoop.lock);
+}
+
+/*
+ * Unregister a callback from a file handle
+ * NB, it *must* be safe to call this from within a callback
+ * For this reason we only remove the handle from the epoll set
+ * and set a flag. Actual deletion will be done out-of-band
+ */
+int virEventEpollRemoveHandle(int watch)
+{
+    virEventEpollHandlePtr handle;
+
+    EVENT_DEBUG("Remove watch=%d", watch);
+
+    if (watch <= 0) {
+        VIR_WARN("Ignoring invalid remove watch %d", watch);
+        return -1;
+    }
+
+    virMutexLock(&eventLoop.lock);
+    if (!(handle = virHashSteal(eventLoop.handles,
+                                (void *)(intptr_t)watch))) {
+        virMutexUnlock(&eventLoop.lock);
+        return -1;
+    }
+
+    EVENT_DEBUG("mark delete %d %d", handle->watch, handle->fd);
+    handle->deleted = true;
+    handle->nextDeleted = eventLoop.deletedHandles;
+    eventLoop.deletedHandles = handle;
+
+    /* Removing events never fails */
+    ignore_value(virEventEpollUpdateFD(eventLoop.fds[handle->fd], false));
+
+    virEventEpollInterruptLocked();
+    virMutexUnlock(&eventLoop.lock);
+    return 0;
+}
+
+
+static void
+virEventEpollHeapSwap(size_t a, size_t b)
+{
+    virEventEpollTimeoutPtr tmp = eventLoop.heap[a];
+
+    eventLoop.heap[a] = eventLoop.heap[b];
+    eventLoop.heap[b] = tmp;
+    eventLoop.heap[a]->heapIndex = a;
+    eventLoop.heap[b]->heapIndex = b;
+}
+
+
+/* Timers expiring at the same time fire in the order they were added */
+static bool
+virEventEpollHeapLess(size_t a, size_t b)
+{
+    virEventEpollTimeoutPtr ta = eventLoop.heap[a];
+    virEventEpollTimeoutPtr tb = eventLoop.heap[b];
+
+    if (ta->expiresAt != tb->expiresAt)
+        return ta->expiresAt < tb->expiresAt;
+    return ta->timer < tb->timer;
+}
+
+
+static void
+virEventEpollHeapFix(size_t idx)
+{
+    while (idx > 0 && virEventEpollHeapLess(idx, (idx - 1) / 2)) {
+        virEventEpollHeapSwap(idx, (idx - 1) / 2);
+        idx = (idx - 1) / 2;
+    }
+
+    while (1) {
+        size_t child = 2 * idx + 1;
+
+        if (child >= eventLoop.nheap)
+            break;
+        if (child + 1 < eventLoop.nheap &&
+            virEventEpollHeapLess(child + 1, child))
+            child++;
+        if (!virEventEpollHeapLess(child, idx))
+            break;
+
+        virEventEpollHeapSwap(idx, child);
+        idx = child;
+    }
+}
+
+
+static void
+virEventEpollHeapRemove(virEventEpollTimeoutPtr timeout)
+{
+    size_t idx = timeout->heapIndex;
+
+    if (timeout->heapIndex < 0)
+        return;
+
+    timeout->heapIndex = -1;
+    if (idx == --eventLoop.nheap)
+        return;
+
+    eventLoop.heap[idx] = eventLoop.heap[eventLoop.nheap];
+    eventLoop.heap[idx]->heapIndex = idx;
+    virEventEpollHeapFix(idx);
+}
+
+
+/*
+ * Set new @frequency of @timeout, (re)inserting it into the heap of
+ * enabled timers or removing it from there.
+ */
+static void
+virEventEpollTimeoutSchedule(virEventEpollTimeoutPtr timeout,
+                             int frequency,
+                             unsigned long long now)
+{
+    timeout->frequency = frequency;
+
+    if (frequency < 0) {
+        timeout->expiresAt = 0;
+        virEventEpollHeapRemove(timeout);
+        return;
+    }
+
+    timeout->expiresAt = frequency + now;
+    if (timeout->heapIndex < 0) {
+        timeout->heapIndex = eventLoop.nheap++;
+        eventLoop.heap[timeout->heapIndex] = timeout;
+    }
+    virEventEpollHeapFix(timeout->heapIndex);
+}
+
+
+/*
+ * Register a callback for a timer event
+ * NB, it *must* be safe to call this from within a callback
+ */
+int virEventEpollAddTimeout(int frequency,
+                            virEventTimeoutCallback cb,
+                            void *opaque,
+                            virFreeCallback ff)
+{
+    virEventEpollTimeoutPtr timeout = NULL;
+    unsigned long long now;
+    int ret = -1;
+
+    if (virTimeMillisNow(&now) < 0)
+        return -1;
+
+    virMutexLock(&eventLoop.lock);
+    if (VIR_RESIZE_N(eventLoop.heap, eventLoop.heapAlloc,
+                     eventLoop.ntimeouts, 1) < 0)
+        goto cleanup;
+
+    if (VIR_ALLOC(timeout) < 0)
+        goto cleanup;
+
+    timeout->timer = nextTimer;
+    timeout->cb = cb;
+    timeout->ff = ff;
+    timeout->opaque = opaque;
+    timeout->heapIndex = -1;
+
+    if (virHashAddEntry(eventLoop.timeouts,
+                        (void *)(intptr_t)timeout->timer, timeout) < 0)
+        goto cleanup;
+
+    eventLoop.ntimeouts++;
+    virEventEpollTimeoutSchedule(timeout, frequency, now);
+    ret = nextTimer++;
+    timeout = NULL;
+    virEventEpollInterruptLocked();
+
+    EVENT_DEBUG("Added timer=%d frequency=%d cb=%p opaque=%p ff=%p",
+                ret, frequency, cb, opaque, ff);
+
+ cleanup:
+    VIR_FREE(timeout);
+    virMutexUnlock(&eventLoop.lock);
+    return ret;
+}
+
+void virEventEpollUpdateTimeout(int timer, int frequency)
+{
+    virEventEpollTimeoutPtr timeout;
+    unsigned long long now;
+
+    EVENT_DEBUG("Update timer=%d frequency=%d", timer, frequency);
+
+    if (timer <= 0) {
+        VIR_WARN("Ignoring invalid update timer %d", timer);
+        return;
+    }
+
+    if (virTimeMillisNow(&now) < 0)
+        return;
+
+    virMutexLock(&eventLoop.lock);
+    if (!(timeout = virHashLookup(eventLoop.timeouts,
+                                  (void *)(intptr_t)timer))) {
+        virMutexUnlock(&eventLoop.lock);
+        VIR_WARN("Got update for non-existent timer %d", timer);
+        return;
+    }
+
+    virEventEpollTimeoutSchedule(timeout, frequency, now);
+    VIR_DEBUG("Set timer freq=%d expires=%llu", frequency,
+              timeout->expiresAt);
+    virEventEpollInterruptLocked();
+    virMutexUnlock(&eventLoop.lock);
+}
+
+/*
+ * Unregister a callback for a timer
+ * NB, it *must* be safe to call this from within a callback
+ * For this reason we only disable the timer and set a flag.
+ * Actual deletion will be done out-of-band
+ */
+int virEventEpollRemoveTimeout(int timer)
+{
+    virEventEpollTimeoutPtr timeout;
+
+    EVENT_DEBUG("Remove timer=%d", timer);
+
+    if (timer <= 0) {
+        VIR_WARN("Ignoring invalid remove timer %d", timer);
+        return -1;
+    }
+
+    virMutexLock(&eventLoop.lock);
+    if (!(timeout = virHashSteal(eventLoop.timeouts,
+                                 (void *)(intptr_t)timer))) {
+        virMutexUnlock(&eventLoop.lock);
+        return -1;
+    }
+
+    virEventEpollHeapRemove(timeout);
+    timeout->deleted = true;
+    timeout->nextDeleted = eventLoop.deletedTimeouts;
+    eventLoop.deletedTimeouts = timeout;
+
+    virEventEpollInterruptLocked();
+    virMutexUnlock(&eventLoop.lock);
+    return 0;
+}
+
+/* Determine when the first timer expires.
+ * @timeout: filled with expiry time of soonest timer, or -1 if
+ *           no timeout is pending
+ * returns: 0 on success, -1 on error
+ */
+static int virEventEpollCalculateTimeout(int *timeout)
+{
+    unsigned long long then;
+    unsigned long long now;
+
+    if (eventLoop.nalways > 0) {
+        *timeout = 0;
+        return 0;
+    }
+
+    if (eventLoop.nheap == 0) {
+        EVENT_DEBUG("%s", "No timeout is pending");
+        *timeout = -1;
+        return 0;
+    }
+
+    then = eventLoop.heap[0]->expiresAt;
+
+    if (virTimeMillisNow(&now) < 0)
+        return -1;
+
+    if (then <= now)
+        *timeout = 0;
+    else
+        *timeout = ((then - now) > INT_MAX) ? INT_MAX : (then - now);
+
+    EVENT_DEBUG("Timeout at %llu due in %d ms", then, *timeout);
+    return 0;
+}
+
+
+/*
+ * Invoke the user supplied callback for each timer whose expiry
+ * time is met, and schedule the next timeout. Does not try to
+ * 'catch up' on time if the actual expiry time was later than the
+ * requested time.
+ *
+ * This method must cope with timers being registered, updated and
+ * removed by a callback.
+ *
+ * Returns 0 upon success, -1 if an error occurred
+ */
+static int virEventEpollDispatchTimeouts(void)
+{
+    VIR_AUTOFREE(virEventEpollTimeoutPtr *) expired = NULL;
+    size_t nexpired = 0;
+    unsigned long long now;
+    size_t i;
+
+    if (eventLoop.nheap == 0)
+        return 0;
+
+    if (virTimeMillisNow(&now) < 0)
+        return -1;
+
+    /* Add 20ms fuzz so we don't pointlessly spin doing
+     * <10ms sleeps, particularly on kernels with low HZ
+     * it is fine that a timer expires 20ms earlier than
+     * requested
+     */
+    if (eventLoop.heap[0]->expiresAt > now + 20)
+        return 0;
+
+    /* Take all expired timers off the heap before running any of them
+     * so that rescheduled timers with zero frequency fire only once. */
+    if (VIR_ALLOC_N(expired, eventLoop.nheap) < 0)
+        return -1;
+
+    while (eventLoop.nheap > 0 &&
+           eventLoop.heap[0]->expiresAt <= now + 20) {
+        expired[nexpired] = eventLoop.heap[0];
+        virEventEpollHeapRemove(expired[nexpired]);
+        nexpired++;
+    }
+
+    VIR_DEBUG("Dispatch %zu", nexpired);
+
+    for (i = 0; i < nexpired; i++) {
+        virEventEpollTimeoutPtr timeout = expired[i];
+        virEventTimeoutCallback cb = timeout->cb;
+        int timer = timeout->timer;
+        void *opaque = timeout->opaque;
+
+        /* Removed, disabled or rescheduled by an earlier callback */
+        if (timeout->deleted ||
+            timeout->frequency < 0 ||
+            timeout->heapIndex >= 0)
+            continue;
+
+        virEventEpollTimeoutSchedule(timeout, timeout->frequency, now);
+
+        virMutexUnlock(&eventLoop.lock);
+        (cb)(timer, opaque);
+        virMutexLock(&eventLoop.lock);
+    }
+
+    return 0;
+}
+
+
+/* Dispatch @revents of @fd to all handles watching it.
+ *
+ * This method must cope with new handles being registered by a
+ * callback, which are skipped by means of @lastWatch, and must skip
+ * any handles marked as deleted.
+ */
+static void virEventEpollDispatchFD(int fd, int revents, int lastWatch)
+{
+    virEventEpollFDPtr info;
+    size_t i;
+
+    /* Stale event of a file descriptor closed without removing its
+     * handles first */
+    if (fd >= eventLoop.nfds || !(info = eventLoop.fds[fd])) {
+        ignore_value(epoll_ctl(eventLoop.epollfd, EPOLL_CTL_DEL, fd, NULL));
+        return;
+    }
+
+    for (i = 0; i < info->nhandles; i++) {
+        virEventEpollHandlePtr handle = info->handles[i];
+        virEventHandleCallback cb = handle->cb;
+        int watch = handle->watch;
+        void *opaque = handle->opaque;
+        int hEvents = virEventEpollFromNativeEvents(revents);
+
+        if (handle->deleted || handle->events == 0 || watch >= lastWatch)
+            continue;
+
+        hEvents &= handle->events |
+            VIR_EVENT_HANDLE_ERROR | VIR_EVENT_HANDLE_HANGUP;
+        if (!hEvents)
+            continue;
+
+        EVENT_DEBUG("Dispatch watch=%d events=%d", watch, hEvents);
+        virMutexUnlock(&eventLoop.lock);
+        (cb)(watch, fd, hEvents, opaque);
+        virMutexLock(&eventLoop.lock);
+    }
+}
+
+
+static void virEventEpollDispatchHandles(struct epoll_event *events,
+                                         int nevents)
+{
+    int lastWatch = nextWatch;
+    size_t i;
+
+    VIR_DEBUG("Dispatch %d", nevents);
+
+    for (i = 0; i < nevents; i++)
+        virEventEpollDispatchFD(events[i].data.fd, events[i].events,
+                                lastWatch);
+
+    if (eventLoop.nalways == 0)
+        return;
+
+    /* NB, callbacks may grow eventLoop.fds */
+    for (i = 0; i < eventLoop.nfds; i++) {
+        if (eventLoop.fds[i] && eventLoop.fds[i]->always)
+            virEventEpollDispatchFD(i, eventLoop.fds[i]->events, lastWatch);
+    }
+}
+
+
+/* Used post dispatch to actually free any timers and handles that
+ * were previously marked as deleted. This asynchronous cleanup is
+ * needed to make dispatch re-entrant safe.
+ */
+static void virEventEpollCleanup(void)
+{
+    while (eventLoop.deletedTimeouts) {
+        virEventEpollTimeoutPtr timeout = eventLoop.deletedTimeouts;
+
+        eventLoop.deletedTimeouts = timeout->nextDeleted;
+        eventLoop.ntimeouts--;
+
+        if (timeout->ff) {
+            virMutexUnlock(&eventLoop.lock);
+            timeout->ff(timeout->opaque);
+            virMutexLock(&eventLoop.lock);
+        }
+        VIR_FREE(timeout);
+    }
+
+    while (eventLoop.deletedHandles) {
+        virEventEpollHandlePtr handle = eventLoop.deletedHandles;
+        virEventEpollFDPtr info = eventLoop.fds[handle->fd];
+        size_t i;
+
+        eventLoop.deletedHandles = handle->nextDeleted;
+
+        for (i = 0; i < info->nhandles; i++) {
+            if (info->handles[i] == handle) {
+                VIR_DELETE_ELEMENT(info->handles, i, info->nhandles);
+                break;
+            }
+        }
+        if (info->nhandles == 0)
+            virEventEpollFDFree(info);
+
+        if (handle->ff) {
+            virMutexUnlock(&eventLoop.lock);
+            handle->ff(handle->opaque);
+            virMutexLock(&eventLoop.lock);
+        }
+        VIR_FREE(handle);
+    }
+}
+
+/*
+ * Run a single iteration of the event loop, blocking until
+ * at least one file handle has an event, or a timer expires
+ */
+int virEventEpollRunOnce(void)
+{
+    struct epoll_event events[EVENT_EPOLL_MAX_EVENTS];
+    int nevents, timeout;
+
+    virMutexLock(&eventLoop.lock);
+    eventLoop.running = 1;
+    virThreadSelf(&eventLoop.leader);
+
+    virEventEpollCleanup();
+
+    if (virEventEpollCalculateTimeout(&timeout) < 0)
+        goto error;
+
+    virMutexUnlock(&eventLoop.lock);
+
+ retry:
+    EVENT_DEBUG("Waiting with timeout=%d", timeout);
+    nevents = epoll_wait(eventLoop.epollfd, events,
+                         ARRAY_CARDINALITY(events), timeout);
+    if (nevents < 0) {
+        EVENT_DEBUG("epoll_wait got error event %d", errno);
+        if (errno == EINTR || errno == EAGAIN)
+            goto retry;
+        virReportSystemError(errno, "%s",
+                             _("Unable to poll on file handles"));
+        return -1;
+    }
+    EVENT_DEBUG("epoll_wait got %d event(s)", nevents);
+
+    virMutexLock(&eventLoop.lock);
+    if (virEventEpollDispatchTimeouts() < 0)
+        goto error;
+
+    virEventEpollDispatchHandles(events, nevents);
+
+    virEventEpollCleanup();
+
+    eventLoop.running = 0;
+    virMutexUnlock(&eventLoop.lock);
+    return 0;
+
+ error:
+    virMutexUnlock(&eventLoop.lock);
+    return -1;
+}
+
+
+static void virEventEpollHandleWakeup(int watch ATTRIBUTE_UNUSED,
+                                      int fd,
+                                      int events ATTRIBUTE_UNUSED,
+                                      void *opaque ATTRIBUTE_UNUSED)
+{
+    char c;
+    virMutexLock(&eventLoop.lock);
+    ignore_value(saferead(fd, &c, sizeof(c)));
+    virMutexUnlock(&eventLoop.lock);
+}
+
+int virEventEpollInit(void)
+{
+    if (virMutexInit(&eventLoop.lock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to initialize mutex"));
+        return -1;
+    }
+
+    if ((eventLoop.epollfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create epoll instance"));
+        goto error;
+    }
+
+    if (!(eventLoop.handles = virHashCreateFull(64, NULL,
+                                                virEventEpollKeyCode,
+                                                virEventEpollKeyEqual,
+                                                virEventEpollKeyCopy,
+                                                NULL)) ||
+        !(eventLoop.timeouts = virHashCreateFull(64, NULL,
+                                                 virEventEpollKeyCode,
+                                                 virEventEpollKeyEqual,
+                                                 virEventEpollKeyCopy,
+                                                 NULL)))
+        goto error;
+
+    if (pipe2(eventLoop.wakeupfd, O_CLOEXEC | O_NONBLOCK) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to setup wakeup pipe"));
+        goto error;
+    }
+
+    if (virEventEpollAddHandle(eventLoop.wakeupfd[0],
+                               VIR_EVENT_HANDLE_READABLE,
+                               virEventEpollHandleWakeup, NULL, NULL) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Unable to add handle %d to event loop"),
+                       eventLoop.wakeupfd[0]);
+        VIR_FORCE_CLOSE(eventLoop.wakeupfd[0]);
+        VIR_FORCE_CLOSE(eventLoop.wakeupfd[1]);
+        goto error;
+    }
+
+    return 0;
+
+ error:
+    virHashFree(eventLoop.handles);
+    virHashFree(eventLoop.timeouts);
+    eventLoop.handles = eventLoop.timeouts = NULL;
+    VIR_FORCE_CLOSE(eventLoop.epollfd);
+    virMutexDestroy(&eventLoop.lock);
+    return -1;
+}
+
+static int virEventEpollInterruptLocked(void)
+{
+    char c = '\0';
+
+    if (!eventLoop.running ||
+        virThreadIsSelf(&eventLoop.leader)) {
+        VIR_DEBUG("Skip interrupt, %d %llu", eventLoop.running,
+                  virThreadID(&eventLoop.leader));
+        return 0;
+    }
+
+    VIR_DEBUG("Interrupting");
+    if (safewrite(eventLoop.wakeupfd[1], &c, sizeof(c)) != sizeof(c))
+        return -1;
+    return 0;
+}
+
+#else /* !__linux__ */
+
+int virEventEpollAddHandle(int fd ATTRIBUTE_UNUSED,
+                           int events ATTRIBUTE_UNUSED,
+                           virEventHandleCallback cb ATTRIBUTE_UNUSED,
+                           void *opaque ATTRIBUTE_UNUSED,
+                           virFreeCallback ff ATTRIBUTE_UNUSED)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("epoll is not supported on this platform"));
+    return -1;
+}
+
+void virEventEpollUpdateHandle(int watch ATTRIBUTE_UNUSED,
+                               int events ATTRIBUTE_UNUSED)
+{
+}
+
+int virEventEpollRemoveHandle(int watch ATTRIBUTE_UNUSED)
+{
+    return -1;
+}
+
+int virEventEpollAddTimeout(int frequency ATTRIBUTE_UNUSED,
+                            virEventTimeoutCallback cb ATTRIBUTE_UNUSED,
+                            void *opaque ATTRIBUTE_UNUSED,
+                            virFreeCallback ff ATTRIBUTE_UNUSED)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("epoll is not supported on this platform"));
+    return -1;
+}
+
+void virEventEpollUpdateTimeout(int timer ATTRIBUTE_UNUSED,
+                                int frequency ATTRIBUTE_UNUSED)
+{
+}
+
+int virEventEpollRemoveTimeout(int timer ATTRIBUTE_UNUSED)
+{
+    return -1;
+}
+
+int virEventEpollInit(void)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("epoll is not supported on this platform"));
+    return -1;
+}
+
+int virEventEpollRunOnce(void)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("epoll is not supported on this platform"));
+    return -1;
+}
+
+#endif /* !__linux__ */
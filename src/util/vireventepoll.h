@@ -0,0 +1,66 @@
+/*
+ * vireventepoll.h: epoll based event loop for monitoring file handles
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBVIRT_VIREVENTEPOLL_H
+# define LIBVIRT_VIREVENTEPOLL_H
+
+# include "internal.h"
+
+/*
+ * The functions below have the same semantics as their virEventPoll
+ * counterparts, but the cost of an iteration of the loop doesn't grow
+ * with the number of registered handles and timers.
+ */
+
+int virEventEpollAddHandle(int fd, int events,
+                           virEventHandleCallback cb,
+                           void *opaque,
+                           virFreeCallback ff);
+
+void virEventEpollUpdateHandle(int watch, int events);
+
+int virEventEpollRemoveHandle(int watch);
+
+int virEventEpollAddTimeout(int frequency,
+                            virEventTimeoutCallback cb,
+                            void *opaque,
+                            virFreeCallback ff);
+
+void virEventEpollUpdateTimeout(int timer, int frequency);
+
+int virEventEpollRemoveTimeout(int timer);
+
+/**
+ * virEventEpollInit: Initialize the event loop
+ *
+ * returns -1 if initialization failed, e.g. because epoll is not
+ * supported on this platform
+ */
+int virEventEpollInit(void);
+
+/**
+ * virEventEpollRunOnce: run a single iteration of the event loop.
+ *
+ * Blocks the caller until at least one file handle has an
+ * event or the first timer expires.
+ *
+ * returns -1 if the event monitoring failed
+ */
+int virEventEpollRunOnce(void);
+
+#endif /* LIBVIRT_VIREVENTEPOLL_H */
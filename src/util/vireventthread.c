@@ -0,0 +1,515 @@
+/*
+ * vireventthread.c: event loop for file handles running in its own thread
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "vireventthread.h"
+#include "vireventpoll.h"
+#include "viralloc.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virlog.h"
+#include "virstring.h"
+#include "virthread.h"
+
+#define VIR_FROM_THIS VIR_FROM_EVENT
+
+VIR_LOG_INIT("util.eventthread");
+
+/* How often the loop latency is logged, in milliseconds */
+#define VIR_EVENT_THREAD_REPORT_INTERVAL (60 * 1000)
+
+#ifdef CLOCK_MONOTONIC
+# define VIR_EVENT_THREAD_CLOCK CLOCK_MONOTONIC
+#else
+# define VIR_EVENT_THREAD_CLOCK CLOCK_REALTIME
+#endif
+
+typedef struct _virEventThreadStats virEventThreadStats;
+typedef virEventThreadStats *virEventThreadStatsPtr;
+struct _virEventThreadStats {
+    /* Number of loop iterations which dispatched a handle */
+    unsigned long long iterations;
+    /* Time spent dispatching handles, in microseconds. A handle which
+     * gets ready while the loop is dispatching waits this long at most */
+    unsigned long long busyTotal;
+    unsigned long long busyMax;
+};
+
+typedef struct _virEventThreadHandle virEventThreadHandle;
+typedef virEventThreadHandle *virEventThreadHandlePtr;
+struct _virEventThreadHandle {
+    int watch;
+    int fd;
+    int events;
+    virEventHandleCallback cb;
+    void *opaque;
+    virFreeCallback ff;
+    bool deleted;
+};
+
+struct _virEventThread {
+    virObjectLockable parent;
+
+    char *name;
+    virThread thread;
+    bool running;
+    bool quit;
+    int wakeupfd[2];
+
+    virEventThreadHandlePtr handles;
+    size_t nhandles;
+    int nextWatch;
+
+    /* Statistics since the last time they were logged */
+    unsigned long long lastReport;
+    virEventThreadStats reportStats;
+};
+
+static virClassPtr virEventThreadClass;
+
+static void
+virEventThreadDispose(void *obj)
+{
+    virEventThreadPtr evt = obj;
+    size_t i;
+
+    /* The thread is gone, nothing can be dispatched anymore */
+    for (i = 0; i < evt->nhandles; i++) {
+        if (evt->handles[i].ff)
+            evt->handles[i].ff(evt->handles[i].opaque);
+    }
+    VIR_FREE(evt->handles);
+
+    VIR_FORCE_CLOSE(evt->wakeupfd[0]);
+    VIR_FORCE_CLOSE(evt->wakeupfd[1]);
+    VIR_FREE(evt->name);
+}
+
+static int
+virEventThreadOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(virEventThread, virClassForObjectLockable()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virEventThread)
+
+
+/* Returns the current time in microseconds */
+static unsigned long long
+virEventThreadNow(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(VIR_EVENT_THREAD_CLOCK, &ts) < 0)
+        return 0;
+
+    return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+
+/* Wakes up the thread if it is waiting in poll(), needs to be called
+ * with @evt locked */
+static void
+virEventThreadInterruptLocked(virEventThreadPtr evt)
+{
+    char c = '\0';
+
+    if (!evt->running ||
+        virThreadIsSelf(&evt->thread))
+        return;
+
+    /* A full pipe wakes the thread up just as well */
+    ignore_value(safewrite(evt->wakeupfd[1], &c, sizeof(c)));
+}
+
+
+static virEventThreadHandlePtr
+virEventThreadFindHandle(virEventThreadPtr evt,
+                         int watch)
+{
+    size_t i;
+
+    for (i = 0; i < evt->nhandles; i++) {
+        if (evt->handles[i].watch == watch &&
+            !evt->handles[i].deleted)
+            return &evt->handles[i];
+    }
+
+    return NULL;
+}
+
+
+/* Frees the handles removed since the last iteration. The free
+ * callbacks are invoked with @evt unlocked as they may release the last
+ * reference to an object whose disposal removes other handles. */
+static void
+virEventThreadCleanupHandles(virEventThreadPtr evt)
+{
+    size_t i = 0;
+
+    while (i < evt->nhandles) {
+        virFreeCallback ff = evt->handles[i].ff;
+        void *opaque = evt->handles[i].opaque;
+
+        if (!evt->handles[i].deleted) {
+            i++;
+            continue;
+        }
+
+        VIR_DELETE_ELEMENT(evt->handles, i, evt->nhandles);
+
+        if (ff) {
+            virObjectUnlock(evt);
+            ff(opaque);
+            virObjectLock(evt);
+            /* the handles might have changed meanwhile */
+            i = 0;
+        }
+    }
+}
+
+
+static void
+virEventThreadReport(virEventThreadPtr evt,
+                     unsigned long long now)
+{
+    virEventThreadStatsPtr stats = &evt->reportStats;
+
+    if (stats->iterations) {
+        VIR_INFO("Event thread %s dispatched handles %llu times in "
+                 "%llu ms, busy for %llu us on average and %llu us at most",
+                 evt->name, stats->iterations, now - evt->lastReport,
+                 stats->busyTotal / stats->iterations, stats->busyMax);
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    evt->lastReport = now;
+}
+
+
+static void
+virEventThreadWorker(void *opaque)
+{
+    virEventThreadPtr evt = opaque;
+    struct pollfd *fds = NULL;
+    int *watches = NULL;
+    size_t nfds;
+    size_t i;
+
+    virObjectLock(evt);
+    evt->lastReport = virEventThreadNow() / 1000;
+
+    while (!evt->quit) {
+        unsigned long long start;
+        unsigned long long busy;
+        unsigned long long now;
+        int timeout = -1;
+        bool dispatched = false;
+        int nready;
+
+        virEventThreadCleanupHandles(evt);
+
+        if (VIR_REALLOC_N(fds, evt->nhandles + 1) < 0 ||
+            VIR_REALLOC_N(watches, evt->nhandles + 1) < 0) {
+            VIR_ERROR(_("Event thread %s failed to allocate poll data"),
+                      evt->name);
+            break;
+        }
+
+        fds[0].fd = evt->wakeupfd[0];
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        nfds = 1;
+
+        for (i = 0; i < evt->nhandles; i++) {
+            if (evt->handles[i].deleted || !evt->handles[i].events)
+                continue;
+
+            fds[nfds].fd = evt->handles[i].fd;
+            fds[nfds].events = virEventPollToNativeEvents(evt->handles[i].events);
+            fds[nfds].revents = 0;
+            watches[nfds] = evt->handles[i].watch;
+            nfds++;
+        }
+
+        /* Only wake up for the report if there is something to report */
+        if (evt->reportStats.iterations) {
+            unsigned long long due = evt->lastReport +
+                VIR_EVENT_THREAD_REPORT_INTERVAL;
+
+            now = virEventThreadNow() / 1000;
+            timeout = due > now ? due - now : 0;
+        }
+
+        virObjectUnlock(evt);
+        nready = poll(fds, nfds, timeout);
+        virObjectLock(evt);
+
+        if (nready < 0) {
+            char ebuf[1024];
+
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+
+            VIR_ERROR(_("Event thread %s unable to poll on file handles: %s"),
+                      evt->name, virStrerror(errno, ebuf, sizeof(ebuf)));
+            break;
+        }
+
+        start = virEventThreadNow();
+
+        if (fds[0].revents) {
+            char buf[64];
+
+            ignore_value(read(evt->wakeupfd[0], buf, sizeof(buf)));
+        }
+
+        for (i = 1; i < nfds; i++) {
+            virEventThreadHandlePtr handle;
+            virEventHandleCallback cb;
+            void *cbopaque;
+            int fd;
+            int events;
+
+            if (!fds[i].revents ||
+                !(handle = virEventThreadFindHandle(evt, watches[i])))
+                continue;
+
+            cb = handle->cb;
+            cbopaque = handle->opaque;
+            fd = handle->fd;
+            events = virEventPollFromNativeEvents(fds[i].revents);
+
+            virObjectUnlock(evt);
+            cb(watches[i], fd, events, cbopaque);
+            virObjectLock(evt);
+            dispatched = true;
+        }
+
+        if (dispatched) {
+            busy = virEventThreadNow() - start;
+
+            evt->reportStats.iterations++;
+            evt->reportStats.busyTotal += busy;
+            evt->reportStats.busyMax = MAX(evt->reportStats.busyMax, busy);
+        }
+
+        now = virEventThreadNow() / 1000;
+        if (now >= evt->lastReport + VIR_EVENT_THREAD_REPORT_INTERVAL)
+            virEventThreadReport(evt, now);
+    }
+
+    virObjectUnlock(evt);
+    VIR_FREE(fds);
+    VIR_FREE(watches);
+    virObjectUnref(evt);
+}
+
+
+/**
+ * virEventThreadNew:
+ * @name: name of the thread
+ *
+ * Creates a new event loop and starts the thread running it. The
+ * thread has to be stopped with virEventThreadStop before the last
+ * reference to the loop is released by its owner.
+ *
+ * Returns the new event loop, or NULL on error
+ */
+virEventThreadPtr
+virEventThreadNew(const char *name)
+{
+    virEventThreadPtr evt;
+
+    if (virEventThreadInitialize() < 0)
+        return NULL;
+
+    if (!(evt = virObjectLockableNew(virEventThreadClass)))
+        return NULL;
+
+    evt->wakeupfd[0] = evt->wakeupfd[1] = -1;
+    evt->nextWatch = 1;
+
+    if (VIR_STRDUP(evt->name, name) < 0)
+        goto error;
+
+    if (pipe2(evt->wakeupfd, O_CLOEXEC | O_NONBLOCK) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to setup wakeup pipe"));
+        goto error;
+    }
+
+    /* The thread holds a reference of its own */
+    virObjectRef(evt);
+    if (virThreadCreateFull(&evt->thread, true, virEventThreadWorker,
+                            evt->name, false, evt) < 0) {
+        virReportSystemError(errno,
+                             _("Unable to create event thread %s"), name);
+        virObjectUnref(evt);
+        goto error;
+    }
+    evt->running = true;
+
+    return evt;
+
+ error:
+    virObjectUnref(evt);
+    return NULL;
+}
+
+
+/**
+ * virEventThreadStop:
+ * @evt: the event loop
+ *
+ * Stops the thread running @evt and waits for it to finish. The
+ * handles still registered are removed and their free callbacks invoked,
+ * since their owners commonly hold a reference to @evt which would never
+ * be released otherwise. Adding handles fails from now on. Must not be
+ * called from a handle callback.
+ */
+void
+virEventThreadStop(virEventThreadPtr evt)
+{
+    size_t i;
+
+    if (!evt)
+        return;
+
+    virObjectLock(evt);
+    if (!evt->running) {
+        virObjectUnlock(evt);
+        return;
+    }
+    evt->quit = true;
+    virEventThreadInterruptLocked(evt);
+    virObjectUnlock(evt);
+
+    virThreadJoin(&evt->thread);
+
+    virObjectLock(evt);
+    evt->running = false;
+    for (i = 0; i < evt->nhandles; i++)
+        evt->handles[i].deleted = true;
+    virEventThreadCleanupHandles(evt);
+    virObjectUnlock(evt);
+}
+
+
+int
+virEventThreadAddHandle(virEventThreadPtr evt,
+                        int fd,
+                        int events,
+                        virEventHandleCallback cb,
+                        void *opaque,
+                        virFreeCallback ff)
+{
+    virEventThreadHandle handle = {
+        .fd = fd,
+        .events = events,
+        .cb = cb,
+        .opaque = opaque,
+        .ff = ff,
+    };
+    int ret = -1;
+
+    virObjectLock(evt);
+
+    if (evt->quit) {
+        virReportError(VIR_ERR_OPERATION_INVALID,
+                       _("event thread %s is stopped"), evt->name);
+        goto cleanup;
+    }
+
+    handle.watch = evt->nextWatch;
+    if (VIR_APPEND_ELEMENT(evt->handles, evt->nhandles, handle) < 0)
+        goto cleanup;
+
+    ret = evt->nextWatch++;
+    VIR_DEBUG("Added handle watch=%d fd=%d events=%d to event thread %s",
+              ret, fd, events, evt->name);
+
+    virEventThreadInterruptLocked(evt);
+
+ cleanup:
+    virObjectUnlock(evt);
+    return ret;
+}
+
+
+void
+virEventThreadUpdateHandle(virEventThreadPtr evt,
+                           int watch,
+                           int events)
+{
+    virEventThreadHandlePtr handle;
+
+    if (watch <= 0) {
+        VIR_WARN("Ignoring invalid update watch %d", watch);
+        return;
+    }
+
+    virObjectLock(evt);
+
+    if ((handle = virEventThreadFindHandle(evt, watch)) &&
+        handle->events != events) {
+        handle->events = events;
+        virEventThreadInterruptLocked(evt);
+    }
+
+    virObjectUnlock(evt);
+}
+
+
+int
+virEventThreadRemoveHandle(virEventThreadPtr evt,
+                           int watch)
+{
+    virEventThreadHandlePtr handle;
+    int ret = -1;
+
+    if (watch <= 0) {
+        VIR_WARN("Ignoring invalid remove watch %d", watch);
+        return -1;
+    }
+
+    virObjectLock(evt);
+
+    if (!(handle = virEventThreadFindHandle(evt, watch)))
+        goto cleanup;
+
+    VIR_DEBUG("Removed handle watch=%d fd=%d from event thread %s",
+              watch, handle->fd, evt->name);
+    handle->deleted = true;
+    virEventThreadInterruptLocked(evt);
+    ret = 0;
+
+ cleanup:
+    virObjectUnlock(evt);
+    return ret;
+}
+
@@ -0,0 +1,56 @@
+/*
+ * vireventthread.h: event loop for file handles running in its own thread
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBVIRT_VIREVENTTHREAD_H
+# define LIBVIRT_VIREVENTTHREAD_H
+
+# include "internal.h"
+# include "virobject.h"
+
+/*
+ * A private event loop watching file handles only, so that busy
+ * handles don't delay the ones served by the main event loop and
+ * vice versa. The handle functions have the same semantics as
+ * virEventAddHandle and friends, the callbacks are invoked in the
+ * thread of the loop.
+ */
+typedef struct _virEventThread virEventThread;
+typedef virEventThread *virEventThreadPtr;
+
+virEventThreadPtr virEventThreadNew(const char *name);
+
+void virEventThreadStop(virEventThreadPtr evt);
+
+int virEventThreadAddHandle(virEventThreadPtr evt,
+                            int fd,
+                            int events,
+                            virEventHandleCallback cb,
+                            void *opaque,
+                            virFreeCallback ff)
+    ATTRIBUTE_NONNULL(1);
+
+void virEventThreadUpdateHandle(virEventThreadPtr evt,
+                                int watch,
+                                int events)
+    ATTRIBUTE_NONNULL(1);
+
+int virEventThreadRemoveHandle(virEventThreadPtr evt,
+                               int watch)
+    ATTRIBUTE_NONNULL(1);
+
+#endif /* LIBVIRT_VIREVENTTHREAD_H */
@@ -482,12 +482,22 @@ virFDStreamThreadDoRead(virFDStreamDataPtr fdst,
             goto error;
         }
 
-        msg->type = VIR_FDSTREAM_MSG_TYPE_DATA;
-        msg->stream.data.buf = buf;
-        msg->stream.data.len = got;
-        buf = NULL;
         if (sparse)
             *dataLen -= got;
+
+        if (sparse && got > 0 && virFileDataIsZero(buf, got)) {
+            /* Data sections of sparse files often contain long runs of
+             * zeroes too. Send them as holes so that the other side
+             * doesn't have to transfer nor write them. */
+            msg->type = VIR_FDSTREAM_MSG_TYPE_HOLE;
+            msg->stream.hole.len = got;
+            VIR_FREE(buf);
+        } else {
+            msg->type = VIR_FDSTREAM_MSG_TYPE_DATA;
+            msg->stream.data.buf = buf;
+            msg->stream.data.len = got;
+            buf = NULL;
+        }
     }
 
     virFDStreamMsgQueuePush(fdst, msg, fdout, fdoutname);
@@ -502,6 +512,56 @@ virFDStreamThreadDoRead(virFDStreamDataPtr fdst,
 }
 
 
+/**
+ * virFDStreamThreadSkipZeroes:
+ * @fd: file to write to
+ * @fdname: name of @fd
+ * @buf: data to be written
+ * @len: length of @buf
+ *
+ * Checks whether writing @buf can be replaced by seeking, which is the
+ * case when @buf contains only zeroes and the current position in @fd
+ * is at or past the end of a regular file. In that case the position
+ * in @fd is moved past the would be written data and the file is
+ * extended accordingly, leaving a hole in it.
+ *
+ * Returns 1 if the data was skipped,
+ *         0 if it has to be written,
+ *        -1 on error.
+ */
+static int
+virFDStreamThreadSkipZeroes(int fd,
+                            const char *fdname,
+                            const char *buf,
+                            size_t len)
+{
+    struct stat sb;
+    off_t cur;
+
+    if (!virFileDataIsZero(buf, len))
+        return 0;
+
+    if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode))
+        return 0;
+
+    if ((cur = lseek(fd, 0, SEEK_CUR)) == (off_t) -1 ||
+        cur < sb.st_size)
+        return 0;
+
+    if (lseek(fd, len, SEEK_CUR) == (off_t) -1) {
+        virReportSystemError(errno, _("unable to seek in %s"), fdname);
+        return -1;
+    }
+
+    if (ftruncate(fd, cur + len) < 0) {
+        virReportSystemError(errno, _("unable to truncate %s"), fdname);
+        return -1;
+    }
+
+    return 1;
+}
+
+
 static ssize_t
 virFDStreamThreadDoWrite(virFDStreamDataPtr fdst,
                          bool sparse,
@@ -517,6 +577,20 @@ virFDStreamThreadDoWrite(virFDStreamDataPtr fdst,
 
     switch (msg->type) {
     case VIR_FDSTREAM_MSG_TYPE_DATA:
+        if (sparse && msg->stream.data.offset == 0) {
+            int rc = virFDStreamThreadSkipZeroes(fdout, fdoutname,
+                                                 msg->stream.data.buf,
+                                                 msg->stream.data.len);
+            if (rc < 0)
+                return -1;
+
+            if (rc > 0) {
+                got = msg->stream.data.len;
+                pop = true;
+                break;
+            }
+        }
+
         got = safewrite(fdout,
                         msg->stream.data.buf + msg->stream.data.offset,
                         msg->stream.data.len - msg->stream.data.offset);
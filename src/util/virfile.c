@@ -70,6 +70,7 @@
 
 #include "configmake.h"
 #include "intprops.h"
+#include "viratomic.h"
 #include "vircommand.h"
 #include "virerror.h"
 #include "virfile.h"
@@ -77,6 +78,7 @@
 #include "virlog.h"
 #include "virprocess.h"
 #include "virstring.h"
+#include "virthread.h"
 #include "virutil.h"
 
 #include "c-ctype.h"
@@ -4119,6 +4121,94 @@ virFileInData(int fd ATTRIBUTE_UNUSED,
 #endif /* !HAVE_DECL_SEEK_HOLE */
 
 
+/**
+ * virFileDataIsZero:
+ * @buf: data to check
+ * @len: length of @buf
+ *
+ * Checks whether @buf consists of zero bytes only, e.g. to find out
+ * whether a block of data needs to be written into a sparse file at
+ * all.
+ *
+ * Returns true if all bytes in @buf are zero, false otherwise.
+ */
+bool
+virFileDataIsZero(const char *buf,
+                  size_t len)
+{
+    const size_t probe = 16;
+    size_t i;
+
+    /* Most blocks containing data are rejected by looking at the first
+     * few bytes. */
+    for (i = 0; i < len && i < probe; i++) {
+        if (buf[i])
+            return false;
+    }
+
+    if (len <= probe)
+        return true;
+
+    /* The first @probe bytes are zero, so if every byte is equal to
+     * the one @probe bytes before it, all of them are zero. This lets
+     * memcmp() do the scanning with whatever vector instructions the
+     * C library can use. */
+    return memcmp(buf, buf + probe, len - probe) == 0;
+}
+
+
+/* Files kept open by all the caches together, limited to a quarter
+ * of the file descriptors the process may have */
+static int virFileCachedFDs;
+static long virFileCachedFDsMax;
+static virOnceControl virFileCachedFDsOnce = VIR_ONCE_CONTROL_INITIALIZER;
+
+static void
+virFileCachedFDsOnceInit(void)
+{
+    virFileCachedFDsMax = MAX(sysconf(_SC_OPEN_MAX), 0) / 4;
+}
+
+
+/**
+ * virFileCachedFDReserve:
+ *
+ * Reserves room for a file which is going to be kept open between
+ * reads, e.g. a cgroup or /proc file which is polled over and over.
+ * All such files share a single budget so that together they never
+ * take up more than a quarter of the file descriptors the process may
+ * have. Once the file is closed, the room has to be given back by
+ * virFileCachedFDRelease().
+ *
+ * Returns true if the file may be kept open, false otherwise.
+ */
+bool
+virFileCachedFDReserve(void)
+{
+    if (virOnce(&virFileCachedFDsOnce, virFileCachedFDsOnceInit) < 0)
+        return false;
+
+    if (virAtomicIntInc(&virFileCachedFDs) > virFileCachedFDsMax) {
+        ignore_value(virAtomicIntDecAndTest(&virFileCachedFDs));
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * virFileCachedFDRelease:
+ *
+ * Gives back the room reserved by virFileCachedFDReserve().
+ */
+void
+virFileCachedFDRelease(void)
+{
+    ignore_value(virAtomicIntDecAndTest(&virFileCachedFDs));
+}
+
+
 /**
  * virFileReadValueInt:
  * @value: pointer to int to be filled in with the value
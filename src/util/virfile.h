@@ -382,6 +382,12 @@ int virFileInData(int fd,
                   int *inData,
                   long long *length);
 
+bool virFileDataIsZero(const char *buf,
+                       size_t len);
+
+bool virFileCachedFDReserve(void);
+void virFileCachedFDRelease(void);
+
 VIR_DEFINE_AUTOPTR_FUNC(virFileWrapperFd, virFileWrapperFdFree)
 
 int virFileGetXAttr(const char *path,
@@ -34,6 +34,7 @@
 #include "virlog.h"
 #include "virobject.h"
 #include "virstring.h"
+#include "virthread.h"
 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -49,6 +50,10 @@ struct _virFileCache {
 
     virHashTablePtr table;
 
+    /* Names whose data is being created with the cache unlocked */
+    virHashTablePtr creating;
+    virCond creatingCond;
+
     char *dir;
     char *suffix;
 
@@ -78,6 +83,8 @@ virFileCacheDispose(void *obj)
     VIR_FREE(cache->suffix);
 
     virHashFree(cache->table);
+    virHashFree(cache->creating);
+    virCondDestroy(&cache->creatingCond);
 
     virFileCachePrivFree(cache);
 }
@@ -239,12 +246,21 @@ virFileCacheNew(const char *dir,
     if (virFileCacheInitialize() < 0)
         return NULL;
 
-    if (!(cache = virObjectNew(virFileCacheClass)))
+    if (!(cache = virObjectLockableNew(virFileCacheClass)))
         return NULL;
 
+    if (virCondInit(&cache->creatingCond) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("cannot initialize condition variable"));
+        goto cleanup;
+    }
+
     if (!(cache->table = virHashCreate(10, virObjectFreeHashData)))
         goto cleanup;
 
+    if (!(cache->creating = virHashCreate(10, NULL)))
+        goto cleanup;
+
     if (VIR_STRDUP(cache->dir, dir) < 0)
         goto cleanup;
 
@@ -275,8 +291,34 @@ virFileCacheValidate(virFileCachePtr cache,
     }
 
     if (!*data && name) {
+        /* Creating data may take long, for example when it means probing
+         * a QEMU binary, so it is done with the cache unlocked. Lookups of
+         * other names can proceed meanwhile, while those of the same name
+         * wait for the data being created rather than creating it again. */
+        while (virHashLookup(cache->creating, name)) {
+            if (virCondWait(&cache->creatingCond, &cache->parent.lock) < 0) {
+                virReportSystemError(errno, "%s",
+                                     _("failed to wait on condition"));
+                return;
+            }
+
+            if ((*data = virHashLookup(cache->table, name)))
+                return;
+        }
+
+        if (virHashAddEntry(cache->creating, name, cache) < 0)
+            return;
+
+        virObjectUnlock(cache);
+
         VIR_DEBUG("Creating data for '%s'", name);
         *data = virFileCacheNewData(cache, name);
+
+        virObjectLock(cache);
+
+        virHashRemoveEntry(cache->creating, name);
+        virCondBroadcast(&cache->creatingCond);
+
         if (*data) {
             VIR_DEBUG("Caching data '%p' for '%s'", *data, name);
             if (virHashAddEntry(cache->table, name, *data) < 0) {
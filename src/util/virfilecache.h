@@ -98,6 +98,11 @@ typedef int
 typedef void
 (*virFileCachePrivFreePtr)(void *priv);
 
+/*
+ * Data is created, loaded and saved with the cache unlocked, so the
+ * handlers may be called from several threads at once for different
+ * names and must be careful about modifying @priv.
+ */
 typedef struct _virFileCacheHandlers virFileCacheHandlers;
 typedef virFileCacheHandlers *virFileCacheHandlersPtr;
 struct _virFileCacheHandlers {
@@ -67,11 +67,13 @@ struct _virJSONObjectPair {
 
 struct _virJSONObject {
     size_t npairs;
+    size_t npairs_max;
     virJSONObjectPairPtr pairs;
 };
 
 struct _virJSONArray {
     size_t nvalues;
+    size_t nvalues_max;
     virJSONValuePtr *values;
 };
 
@@ -101,6 +103,7 @@ struct _virJSONParser {
     virJSONValuePtr head;
     virJSONParserStatePtr state;
     size_t nstate;
+    size_t nstate_max;
     int wrap;
 };
 
@@ -489,7 +492,8 @@ virJSONValueNewStringLen(const char *data,
 
 
 static virJSONValuePtr
-virJSONValueNewNumber(const char *data)
+virJSONValueNewNumberLen(const char *data,
+                         size_t length)
 {
     virJSONValuePtr val;
 
@@ -497,7 +501,7 @@ virJSONValueNewNumber(const char *data)
         return NULL;
 
     val->type = VIR_JSON_TYPE_NUMBER;
-    if (VIR_STRDUP(val->data.number, data) < 0) {
+    if (VIR_STRNDUP(val->data.number, data, length) < 0) {
         VIR_FREE(val);
         return NULL;
     }
@@ -506,6 +510,13 @@ virJSONValueNewNumber(const char *data)
 }
 
 
+static virJSONValuePtr
+virJSONValueNewNumber(const char *data)
+{
+    return virJSONValueNewNumberLen(data, strlen(data));
+}
+
+
 virJSONValuePtr
 virJSONValueNewNumberInt(int data)
 {
@@ -613,29 +624,26 @@ virJSONValueNewObject(void)
 }
 
 
-int
-virJSONValueObjectAppend(virJSONValuePtr object,
-                         const char *key,
-                         virJSONValuePtr value)
+/* Appends @value under @key to @object taking ownership of @key on
+ * success. */
+static int
+virJSONValueObjectAppendSteal(virJSONValuePtr object,
+                              char **key,
+                              virJSONValuePtr value)
 {
-    char *newkey;
-
     if (object->type != VIR_JSON_TYPE_OBJECT)
         return -1;
 
-    if (virJSONValueObjectHasKey(object, key))
+    if (virJSONValueObjectHasKey(object, *key))
         return -1;
 
-    if (VIR_STRDUP(newkey, key) < 0)
-        return -1;
-
-    if (VIR_REALLOC_N(object->data.object.pairs,
-                      object->data.object.npairs + 1) < 0) {
-        VIR_FREE(newkey);
+    if (VIR_RESIZE_N(object->data.object.pairs,
+                     object->data.object.npairs_max,
+                     object->data.object.npairs, 1) < 0)
         return -1;
-    }
 
-    object->data.object.pairs[object->data.object.npairs].key = newkey;
+    VIR_STEAL_PTR(object->data.object.pairs[object->data.object.npairs].key,
+                  *key);
     object->data.object.pairs[object->data.object.npairs].value = value;
     object->data.object.npairs++;
 
@@ -643,6 +651,20 @@ virJSONValueObjectAppend(virJSONValuePtr object,
 }
 
 
+int
+virJSONValueObjectAppend(virJSONValuePtr object,
+                         const char *key,
+                         virJSONValuePtr value)
+{
+    VIR_AUTOFREE(char *) newkey = NULL;
+
+    if (VIR_STRDUP(newkey, key) < 0)
+        return -1;
+
+    return virJSONValueObjectAppendSteal(object, &newkey, value);
+}
+
+
 int
 virJSONValueObjectAppendString(virJSONValuePtr object,
                                const char *key,
@@ -777,8 +799,9 @@ virJSONValueArrayAppend(virJSONValuePtr array,
     if (array->type != VIR_JSON_TYPE_ARRAY)
         return -1;
 
-    if (VIR_REALLOC_N(array->data.array.values,
-                      array->data.array.nvalues + 1) < 0)
+    if (VIR_RESIZE_N(array->data.array.values,
+                     array->data.array.nvalues_max,
+                     array->data.array.nvalues, 1) < 0)
         return -1;
 
     array->data.array.values[array->data.array.nvalues] = value;
@@ -838,8 +861,8 @@ virJSONValueObjectSteal(virJSONValuePtr object,
         if (STREQ(object->data.object.pairs[i].key, key)) {
             VIR_STEAL_PTR(obj, object->data.object.pairs[i].value);
             VIR_FREE(object->data.object.pairs[i].key);
-            VIR_DELETE_ELEMENT(object->data.object.pairs, i,
-                               object->data.object.npairs);
+            VIR_DELETE_ELEMENT_INPLACE(object->data.object.pairs, i,
+                                       object->data.object.npairs);
             break;
         }
     }
@@ -926,8 +949,8 @@ virJSONValueObjectRemoveKey(virJSONValuePtr object,
             }
             VIR_FREE(object->data.object.pairs[i].key);
             virJSONValueFree(object->data.object.pairs[i].value);
-            VIR_DELETE_ELEMENT(object->data.object.pairs, i,
-                               object->data.object.npairs);
+            VIR_DELETE_ELEMENT_INPLACE(object->data.object.pairs, i,
+                                       object->data.object.npairs);
             return 1;
         }
     }
@@ -1002,9 +1025,9 @@ virJSONValueArraySteal(virJSONValuePtr array,
 
     ret = array->data.array.values[element];
 
-    VIR_DELETE_ELEMENT(array->data.array.values,
-                       element,
-                       array->data.array.nvalues);
+    VIR_DELETE_ELEMENT_INPLACE(array->data.array.values,
+                               element,
+                               array->data.array.nvalues);
 
     return ret;
 }
@@ -1527,12 +1550,10 @@ virJSONParserInsertValue(virJSONParserPtr parser,
                 return -1;
             }
 
-            if (virJSONValueObjectAppend(state->value,
-                                         state->key,
-                                         value) < 0)
+            if (virJSONValueObjectAppendSteal(state->value,
+                                              &state->key,
+                                              value) < 0)
                 return -1;
-
-            VIR_FREE(state->key);
         }   break;
 
         case VIR_JSON_TYPE_ARRAY: {
@@ -1603,15 +1624,9 @@ virJSONParserHandleNumber(void *ctx,
                           yajl_size_t l)
 {
     virJSONParserPtr parser = ctx;
-    char *str;
-    virJSONValuePtr value;
-
-    if (VIR_STRNDUP(str, s, l) < 0)
-        return -1;
-    value = virJSONValueNewNumber(str);
-    VIR_FREE(str);
+    virJSONValuePtr value = virJSONValueNewNumberLen(s, l);
 
-    VIR_DEBUG("parser=%p str=%s", parser, str);
+    VIR_DEBUG("parser=%p str=%p", parser, s);
 
     if (!value)
         return 0;
@@ -1686,10 +1701,9 @@ virJSONParserHandleStartMap(void *ctx)
         return 0;
     }
 
-    if (VIR_REALLOC_N(parser->state,
-                      parser->nstate + 1) < 0) {
+    if (VIR_RESIZE_N(parser->state, parser->nstate_max,
+                     parser->nstate, 1) < 0)
         return 0;
-    }
 
     parser->state[parser->nstate].value = value;
     parser->state[parser->nstate].key = NULL;
@@ -1716,7 +1730,7 @@ virJSONParserHandleEndMap(void *ctx)
         return 0;
     }
 
-    VIR_DELETE_ELEMENT(parser->state, parser->nstate - 1, parser->nstate);
+    parser->nstate--;
 
     return 1;
 }
@@ -1738,8 +1752,8 @@ virJSONParserHandleStartArray(void *ctx)
         return 0;
     }
 
-    if (VIR_REALLOC_N(parser->state,
-                      parser->nstate + 1) < 0)
+    if (VIR_RESIZE_N(parser->state, parser->nstate_max,
+                     parser->nstate, 1) < 0)
         return 0;
 
     parser->state[parser->nstate].value = value;
@@ -1767,7 +1781,7 @@ virJSONParserHandleEndArray(void *ctx)
         return 0;
     }
 
-    VIR_DELETE_ELEMENT(parser->state, parser->nstate - 1, parser->nstate);
+    parser->nstate--;
 
     return 1;
 }
@@ -1793,7 +1807,7 @@ virJSONValuePtr
 virJSONValueFromString(const char *jsonstring)
 {
     yajl_handle hand;
-    virJSONParser parser = { NULL, NULL, 0, 0 };
+    virJSONParser parser = { NULL, NULL, 0, 0, 0 };
     virJSONValuePtr ret = NULL;
     int rc;
     size_t len = strlen(jsonstring);
@@ -1873,8 +1887,8 @@ virJSONValueFromString(const char *jsonstring)
         size_t i;
         for (i = 0; i < parser.nstate; i++)
             VIR_FREE(parser.state[i].key);
-        VIR_FREE(parser.state);
     }
+    VIR_FREE(parser.state);
 
     VIR_DEBUG("result=%p", ret);
 
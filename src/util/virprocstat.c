@@ -0,0 +1,420 @@
+/*
+ * virprocstat.c: per thread statistics from /proc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "virprocstat.h"
+#include "viralloc.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virhash.h"
+#include "virlog.h"
+#include "virstring.h"
+#include "virutil.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+VIR_LOG_INIT("util.procstat");
+
+/* Large enough for the sched file, which is the bigger one */
+#define VIR_PROC_STAT_BUFSIZE (16 * 1024)
+
+/* A file kept open, referenced by the collector and any readers */
+typedef struct _virProcStatFile virProcStatFile;
+typedef virProcStatFile *virProcStatFilePtr;
+struct _virProcStatFile {
+    virObject parent;
+
+    pid_t pid;
+    int fd;
+};
+
+struct _virProcStatCollector {
+    virObjectLockable parent;
+
+    /* Open files keyed by their path, the lock only guards the table
+     * and the files are read without holding it */
+    virHashTablePtr files;
+    bool keepOpen;
+};
+
+static virClassPtr virProcStatFileClass;
+static virClassPtr virProcStatCollectorClass;
+
+static void
+virProcStatFileDispose(void *obj)
+{
+    virProcStatFilePtr file = obj;
+
+    VIR_FORCE_CLOSE(file->fd);
+    virFileCachedFDRelease();
+}
+
+static void
+virProcStatCollectorDispose(void *obj)
+{
+    virProcStatCollectorPtr stats = obj;
+
+    virHashFree(stats->files);
+}
+
+static int
+virProcStatOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(virProcStatFile, virClassForObject()))
+        return -1;
+
+    if (!VIR_CLASS_NEW(virProcStatCollector, virClassForObjectLockable()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virProcStat)
+
+
+/**
+ * virProcStatCollectorNew:
+ * @keepOpen: whether to keep files open between reads
+ *
+ * Creates a collector which keeps the files it reads open if
+ * @keepOpen is true, as long as the budget of open files shared with
+ * other such caches allows it. Files which don't fit are opened and
+ * closed on every read, which is what the collector always does if
+ * @keepOpen is false.
+ *
+ * Returns the new collector, or NULL on error
+ */
+virProcStatCollectorPtr
+virProcStatCollectorNew(bool keepOpen)
+{
+    virProcStatCollectorPtr stats;
+
+    if (virProcStatInitialize() < 0)
+        return NULL;
+
+    if (!(stats = virObjectLockableNew(virProcStatCollectorClass)))
+        return NULL;
+
+    if (!(stats->files = virHashCreate(64, virObjectFreeHashData))) {
+        virObjectUnref(stats);
+        return NULL;
+    }
+    stats->keepOpen = keepOpen;
+
+    return stats;
+}
+
+
+#ifdef __linux__
+/*
+ * Reads /proc/@pid/task/@tid/@name, or /proc/@pid/@name if @tid is 0,
+ * into @buf of @buflen bytes. A file opened before is read again from
+ * the start. If that fails the thread has gone away and its ID may
+ * have been reused, so the file is opened afresh.
+ *
+ * Returns the length of the data, or -1 with errno set
+ */
+static ssize_t
+virProcStatCollectorRead(virProcStatCollectorPtr stats,
+                         pid_t pid,
+                         pid_t tid,
+                         const char *name,
+                         char *buf,
+                         size_t buflen)
+{
+    virProcStatFilePtr file;
+    char *path = NULL;
+    ssize_t len = -1;
+    int fd = -1;
+    int rc;
+
+    /* In general, we cannot assume pid_t fits in int; but /proc parsing
+     * is specific to Linux where int works fine.  */
+    if (tid)
+        rc = virAsprintfQuiet(&path, "/proc/%d/task/%d/%s",
+                              (int)pid, (int)tid, name);
+    else
+        rc = virAsprintfQuiet(&path, "/proc/%d/%s", (int)pid, name);
+    if (rc < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    virObjectLock(stats);
+    file = virObjectRef(virHashLookup(stats->files, path));
+    virObjectUnlock(stats);
+
+    if (file) {
+        if ((len = pread(file->fd, buf, buflen - 1, 0)) >= 0)
+            goto done;
+
+        virObjectLock(stats);
+        if (virHashLookup(stats->files, path) == file)
+            virHashRemoveEntry(stats->files, path);
+        virObjectUnlock(stats);
+        virObjectUnref(file);
+        file = NULL;
+    }
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+        goto cleanup;
+
+    if ((len = pread(fd, buf, buflen - 1, 0)) < 0)
+        goto cleanup;
+
+    if (stats->keepOpen && virFileCachedFDReserve()) {
+        if (!(file = virObjectNew(virProcStatFileClass))) {
+            virFileCachedFDRelease();
+            virResetLastError();
+            goto done;
+        }
+        file->pid = pid;
+        file->fd = fd;
+        fd = -1;
+
+        /* Another thread may have opened the same file meanwhile */
+        virObjectLock(stats);
+        if (virHashLookup(stats->files, path) ||
+            virHashAddEntry(stats->files, path, file) < 0) {
+            virResetLastError();
+        } else {
+            file = NULL;
+        }
+        virObjectUnlock(stats);
+    }
+
+ done:
+    buf[len] = '\0';
+
+ cleanup:
+    virObjectUnref(file);
+    VIR_FORCE_CLOSE(fd);
+    VIR_FREE(path);
+    return len;
+}
+
+
+/**
+ * virProcStatCollectorGetStat:
+ * @stats: the collector
+ * @pid: the process
+ * @tid: a thread of @pid, or 0 for the process as a whole
+ * @cpuTime: filled with the user and system time in nanoseconds
+ * @lastCpu: filled with the CPU the thread last ran on
+ * @rss: filled with the resident set size in KiB
+ *
+ * Reads the stat file of a process or thread. Any of @cpuTime,
+ * @lastCpu and @rss may be NULL.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int
+virProcStatCollectorGetStat(virProcStatCollectorPtr stats,
+                            pid_t pid,
+                            pid_t tid,
+                            unsigned long long *cpuTime,
+                            int *lastCpu,
+                            long *rss)
+{
+    VIR_AUTOFREE(char *) buf = NULL;
+    unsigned long long usertime = 0, systime = 0;
+    long pages = 0;
+    int cpu = 0;
+    const char *fields;
+
+    if (VIR_ALLOC_N(buf, VIR_PROC_STAT_BUFSIZE) < 0)
+        return -1;
+
+    if (virProcStatCollectorRead(stats, pid, tid, "stat",
+                                 buf, VIR_PROC_STAT_BUFSIZE) < 0) {
+        virReportSystemError(errno,
+                             _("cannot read status of thread %d/%d"),
+                             (int)pid, (int)tid);
+        return -1;
+    }
+
+    /* The command name may contain anything, including spaces and
+     * parentheses, the fields we want all come after it */
+    if (!(fields = strrchr(buf, ')')) ||
+        sscanf(fields + 1,
+               /* state -> stime */
+               " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu"
+               /* cutime -> endcode */
+               "%*d %*d %*d %*d %*d %*d %*u %*u %ld %*u %*u %*u"
+               /* startstack -> processor */
+               "%*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*d %d",
+               &usertime, &systime, &pages, &cpu) != 4) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("cannot parse status of thread %d/%d"),
+                       (int)pid, (int)tid);
+        return -1;
+    }
+
+    /* We got jiffies
+     * We want nanoseconds
+     * _SC_CLK_TCK is jiffies per second
+     * So calculate thus....
+     */
+    if (cpuTime)
+        *cpuTime = 1000ull * 1000ull * 1000ull * (usertime + systime)
+            / (unsigned long long)sysconf(_SC_CLK_TCK);
+    if (lastCpu)
+        *lastCpu = cpu;
+    if (rss)
+        *rss = pages * virGetSystemPageSizeKB();
+
+    VIR_DEBUG("Got status for %d/%d user=%llu sys=%llu cpu=%d rss=%ld",
+              (int)pid, (int)tid, usertime, systime, cpu, pages);
+
+    return 0;
+}
+
+
+/**
+ * virProcStatCollectorGetSchedWait:
+ * @stats: the collector
+ * @pid: the process
+ * @tid: a thread of @pid, or 0 for the process as a whole
+ * @cpuWait: filled with the time spent waiting for a CPU in nanoseconds
+ *
+ * Reads the sched file of a process or thread. The file needs
+ * CONFIG_SCHED_DEBUG and the value CONFIG_SCHEDSTATS, @cpuWait is set
+ * to 0 if either is missing.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int
+virProcStatCollectorGetSchedWait(virProcStatCollectorPtr stats,
+                                 pid_t pid,
+                                 pid_t tid,
+                                 unsigned long long *cpuWait)
+{
+    VIR_AUTOFREE(char *) buf = NULL;
+    char *line;
+    char *next;
+    double val;
+
+    *cpuWait = 0;
+
+    if (VIR_ALLOC_N(buf, VIR_PROC_STAT_BUFSIZE) < 0)
+        return -1;
+
+    if (virProcStatCollectorRead(stats, pid, tid, "sched",
+                                 buf, VIR_PROC_STAT_BUFSIZE) < 0) {
+        if (errno == ENOENT)
+            return 0;
+
+        virReportSystemError(errno,
+                             _("cannot read scheduler info of thread %d/%d"),
+                             (int)pid, (int)tid);
+        return -1;
+    }
+
+    for (line = buf; line; line = next) {
+        if ((next = strchr(line, '\n')))
+            *next++ = '\0';
+
+        /* The second check is the old name the kernel used in past */
+        if (!STRPREFIX(line, "se.statistics.wait_sum") &&
+            !STRPREFIX(line, "se.wait_sum"))
+            continue;
+
+        if (!(line = strchr(line, ':'))) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("Missing separator in sched info of thread %d/%d"),
+                           (int)pid, (int)tid);
+            return -1;
+        }
+        line++;
+        while (*line == ' ')
+            line++;
+
+        if (virStrToDouble(line, NULL, &val) < 0) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("Unable to parse sched info value '%s'"),
+                           line);
+            return -1;
+        }
+
+        *cpuWait = (unsigned long long)(val * 1000000);
+        break;
+    }
+
+    return 0;
+}
+
+#else /* !__linux__ */
+
+int
+virProcStatCollectorGetStat(virProcStatCollectorPtr stats ATTRIBUTE_UNUSED,
+                            pid_t pid ATTRIBUTE_UNUSED,
+                            pid_t tid ATTRIBUTE_UNUSED,
+                            unsigned long long *cpuTime ATTRIBUTE_UNUSED,
+                            int *lastCpu ATTRIBUTE_UNUSED,
+                            long *rss ATTRIBUTE_UNUSED)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("thread statistics are not supported on this platform"));
+    return -1;
+}
+
+
+int
+virProcStatCollectorGetSchedWait(virProcStatCollectorPtr stats ATTRIBUTE_UNUSED,
+                                 pid_t pid ATTRIBUTE_UNUSED,
+                                 pid_t tid ATTRIBUTE_UNUSED,
+                                 unsigned long long *cpuWait)
+{
+    *cpuWait = 0;
+    return 0;
+}
+
+#endif /* !__linux__ */
+
+
+static int
+virProcStatFileMatchPid(const void *payload,
+                        const void *name ATTRIBUTE_UNUSED,
+                        const void *data)
+{
+    const virProcStatFile *file = payload;
+    const pid_t *pid = data;
+
+    return file->pid == *pid;
+}
+
+
+/**
+ * virProcStatCollectorForgetProcess:
+ * @stats: the collector
+ * @pid: a process which has exited
+ *
+ * Closes all files kept open for @pid and its threads.
+ */
+void
+virProcStatCollectorForgetProcess(virProcStatCollectorPtr stats,
+                                  pid_t pid)
+{
+    virObjectLock(stats);
+    virHashRemoveSet(stats->files, virProcStatFileMatchPid, &pid);
+    virObjectUnlock(stats);
+}
@@ -0,0 +1,53 @@
+/*
+ * virprocstat.h: per thread statistics from /proc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBVIRT_VIRPROCSTAT_H
+# define LIBVIRT_VIRPROCSTAT_H
+
+# include "internal.h"
+# include "virobject.h"
+
+/*
+ * Reads the stat and sched files of processes and threads, keeping
+ * them open between calls so that polling the same threads over and
+ * over only costs a pread() each.
+ */
+typedef struct _virProcStatCollector virProcStatCollector;
+typedef virProcStatCollector *virProcStatCollectorPtr;
+
+virProcStatCollectorPtr virProcStatCollectorNew(bool keepOpen);
+
+int virProcStatCollectorGetStat(virProcStatCollectorPtr stats,
+                                pid_t pid,
+                                pid_t tid,
+                                unsigned long long *cpuTime,
+                                int *lastCpu,
+                                long *rss)
+    ATTRIBUTE_NONNULL(1);
+
+int virProcStatCollectorGetSchedWait(virProcStatCollectorPtr stats,
+                                     pid_t pid,
+                                     pid_t tid,
+                                     unsigned long long *cpuWait)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(4);
+
+void virProcStatCollectorForgetProcess(virProcStatCollectorPtr stats,
+                                       pid_t pid)
+    ATTRIBUTE_NONNULL(1);
+
+#endif /* LIBVIRT_VIRPROCSTAT_H */
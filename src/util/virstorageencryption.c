@@ -87,7 +87,12 @@ virStorageEncryptionSecretCopy(const virStorageEncryptionSecret *src)
     if (VIR_ALLOC(ret) < 0)
         return NULL;
 
-    memcpy(ret, src, sizeof(*src));
+    ret->type = src->type;
+
+    if (virSecretLookupDefCopy(&ret->seclookupdef, &src->seclookupdef) < 0) {
+        virStorageEncryptionSecretFree(ret);
+        return NULL;
+    }
 
     return ret;
 }
@@ -123,6 +128,7 @@ virStorageEncryptionCopy(const virStorageEncryption *src)
 
     ret->nsecrets = src->nsecrets;
     ret->format = src->format;
+    ret->payload_offset = src->payload_offset;
 
     for (i = 0; i < src->nsecrets; i++) {
         if (!(ret->secrets[i] = virStorageEncryptionSecretCopy(src->secrets[i])))
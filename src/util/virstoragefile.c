@@ -2199,6 +2199,8 @@ virStorageSourceCopy(const virStorageSource *src,
     ret->physical = src->physical;
     ret->readonly = src->readonly;
     ret->shared = src->shared;
+    ret->authInherited = src->authInherited;
+    ret->encryptionInherited = src->encryptionInherited;
     ret->haveTLS = src->haveTLS;
     ret->tlsFromConfig = src->tlsFromConfig;
     ret->detected = src->detected;
@@ -26,6 +26,7 @@
 #include "viralloc.h"
 #include "virthread.h"
 #include "virerror.h"
+#include "virtime.h"
 
 #define VIR_FROM_THIS VIR_FROM_NONE
 
@@ -36,6 +37,7 @@ struct _virThreadPoolJob {
     virThreadPoolJobPtr prev;
     virThreadPoolJobPtr next;
     unsigned int priority;
+    unsigned long long queued; /* when the job was sent, in ms */
 
     void *data;
 };
@@ -58,6 +60,7 @@ struct _virThreadPool {
     void *jobOpaque;
     virThreadPoolJobList jobList;
     size_t jobQueueDepth;
+    size_t prioJobQueueDepth;
 
     virMutex mutex;
     virCond cond;
@@ -158,6 +161,8 @@ static void virThreadPoolWorker(void *opaque)
             pool->jobList.tail = job->prev;
 
         pool->jobQueueDepth--;
+        if (job->priority)
+            pool->prioJobQueueDepth--;
 
         virMutexUnlock(&pool->mutex);
         (pool->jobFunc)(job->data, pool->jobOpaque);
@@ -369,6 +374,38 @@ size_t virThreadPoolGetJobQueueDepth(virThreadPoolPtr pool)
     return ret;
 }
 
+size_t virThreadPoolGetPrioJobQueueDepth(virThreadPoolPtr pool)
+{
+    size_t ret;
+
+    virMutexLock(&pool->mutex);
+    ret = pool->prioJobQueueDepth;
+    virMutexUnlock(&pool->mutex);
+
+    return ret;
+}
+
+/*
+ * Return: how long, in milliseconds, the oldest job in the queue
+ * has been waiting for a worker, or 0 if the queue is empty
+ */
+unsigned long long virThreadPoolGetJobQueueAge(virThreadPoolPtr pool)
+{
+    unsigned long long now;
+    unsigned long long ret = 0;
+
+    if (virTimeMillisNowRaw(&now) < 0)
+        return 0;
+
+    virMutexLock(&pool->mutex);
+    /* Jobs are appended at the tail, so the head is the oldest one */
+    if (pool->jobList.head && now > pool->jobList.head->queued)
+        ret = now - pool->jobList.head->queued;
+    virMutexUnlock(&pool->mutex);
+
+    return ret;
+}
+
 /*
  * @priority - job priority
  * Return: 0 on success, -1 otherwise
@@ -393,6 +430,7 @@ int virThreadPoolSendJob(virThreadPoolPtr pool,
 
     job->data = jobData;
     job->priority = priority;
+    ignore_value(virTimeMillisNowRaw(&job->queued));
 
     job->prev = pool->jobList.tail;
     if (pool->jobList.tail)
@@ -406,6 +444,8 @@ int virThreadPoolSendJob(virThreadPoolPtr pool,
         pool->jobList.firstPrio = job;
 
     pool->jobQueueDepth++;
+    if (priority)
+        pool->prioJobQueueDepth++;
 
     virCondSignal(&pool->cond);
     if (priority)
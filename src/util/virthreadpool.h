@@ -45,6 +45,8 @@ size_t virThreadPoolGetPriorityWorkers(virThreadPoolPtr pool);
 size_t virThreadPoolGetCurrentWorkers(virThreadPoolPtr pool);
 size_t virThreadPoolGetFreeWorkers(virThreadPoolPtr pool);
 size_t virThreadPoolGetJobQueueDepth(virThreadPoolPtr pool);
+size_t virThreadPoolGetPrioJobQueueDepth(virThreadPoolPtr pool);
+unsigned long long virThreadPoolGetJobQueueAge(virThreadPoolPtr pool);
 
 void virThreadPoolFree(virThreadPoolPtr pool);
 
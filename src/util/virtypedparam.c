@@ -1565,3 +1565,252 @@ virTypedParamsSerialize(virTypedParameterPtr params,
     virTypedParamsRemoteFree(params_val, nparams);
     return rv;
 }
+
+
+/**
+ * virTypedParamListFree:
+ * @list: list of typed parameters
+ *
+ * Frees @list together with all the parameters it holds.
+ */
+void
+virTypedParamListFree(virTypedParamListPtr list)
+{
+    if (!list)
+        return;
+
+    virTypedParamsFree(list->par, list->npar);
+    VIR_FREE(list);
+}
+
+
+/**
+ * virTypedParamListReserve:
+ * @list: list of typed parameters
+ * @count: number of parameters about to be added
+ *
+ * Makes sure @list has room for at least @count more parameters, so that
+ * callers which know (or can estimate) the size of the final list upfront
+ * avoid growing the array repeatedly.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virTypedParamListReserve(virTypedParamListPtr list,
+                         size_t count)
+{
+    return VIR_RESIZE_N(list->par, list->par_alloc, list->npar, count);
+}
+
+
+/**
+ * virTypedParamListStealParams:
+ * @list: list of typed parameters
+ * @params: filled with the array of parameters
+ *
+ * Transfers the ownership of the array of parameters held by @list to the
+ * caller and empties @list.
+ *
+ * Returns the number of parameters in @params.
+ */
+size_t
+virTypedParamListStealParams(virTypedParamListPtr list,
+                             virTypedParameterPtr *params)
+{
+    size_t ret = list->npar;
+
+    VIR_STEAL_PTR(*params, list->par);
+    list->npar = 0;
+    list->par_alloc = 0;
+
+    return ret;
+}
+
+
+static virTypedParameterPtr
+virTypedParamListExtend(virTypedParamListPtr list)
+{
+    if (VIR_RESIZE_N(list->par, list->par_alloc, list->npar, 1) < 0)
+        return NULL;
+
+    return list->par + list->npar;
+}
+
+
+/* Formats the name of the parameter which was filled in at the end of
+ * @list by one of the virTypedParamListAdd* functions directly into its
+ * field and adds it to @list. The parameter is cleared on failure. */
+ATTRIBUTE_FMT_PRINTF(2, 0)
+static int
+virTypedParamListAddCommit(virTypedParamListPtr list,
+                           const char *namefmt,
+                           va_list ap)
+{
+    virTypedParameterPtr par = list->par + list->npar;
+    int rc;
+
+    rc = vsnprintf(par->field, VIR_TYPED_PARAM_FIELD_LENGTH, namefmt, ap);
+
+    if (rc < 0 || rc >= VIR_TYPED_PARAM_FIELD_LENGTH) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Field name '%s' too long"), par->field);
+        goto error;
+    }
+
+    list->npar++;
+    return 0;
+
+ error:
+    virTypedParamsClear(par, 1);
+    memset(par, 0, sizeof(*par));
+    return -1;
+}
+
+
+#define VIR_TYPED_PARAM_LIST_ADD(list, typ, member, val, namefmt) \
+    do { \
+        virTypedParameterPtr _par; \
+        va_list ap; \
+        int rc; \
+ \
+        if (!(_par = virTypedParamListExtend(list))) \
+            return -1; \
+ \
+        _par->type = typ; \
+        _par->value.member = val; \
+ \
+        va_start(ap, namefmt); \
+        rc = virTypedParamListAddCommit(list, namefmt, ap); \
+        va_end(ap); \
+ \
+        return rc; \
+    } while (0)
+
+
+/**
+ * virTypedParamListAddInt:
+ * @list: list of typed parameters
+ * @value: the value of the new parameter
+ * @namefmt: printf-style format string of the name of the new parameter
+ *
+ * Appends a parameter of int type to @list. The name is formatted straight
+ * into the parameter. Unlike virTypedParamsAddInt, no check for an already
+ * existing parameter of the same name is done.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virTypedParamListAddInt(virTypedParamListPtr list,
+                        int value,
+                        const char *namefmt,
+                        ...)
+{
+    VIR_TYPED_PARAM_LIST_ADD(list, VIR_TYPED_PARAM_INT, i, value, namefmt);
+}
+
+
+/**
+ * virTypedParamListAddUInt:
+ *
+ * Same as virTypedParamListAddInt, but for unsigned int type.
+ */
+int
+virTypedParamListAddUInt(virTypedParamListPtr list,
+                         unsigned int value,
+                         const char *namefmt,
+                         ...)
+{
+    VIR_TYPED_PARAM_LIST_ADD(list, VIR_TYPED_PARAM_UINT, ui, value, namefmt);
+}
+
+
+/**
+ * virTypedParamListAddLLong:
+ *
+ * Same as virTypedParamListAddInt, but for long long type.
+ */
+int
+virTypedParamListAddLLong(virTypedParamListPtr list,
+                          long long value,
+                          const char *namefmt,
+                          ...)
+{
+    VIR_TYPED_PARAM_LIST_ADD(list, VIR_TYPED_PARAM_LLONG, l, value, namefmt);
+}
+
+
+/**
+ * virTypedParamListAddULLong:
+ *
+ * Same as virTypedParamListAddInt, but for unsigned long long type.
+ */
+int
+virTypedParamListAddULLong(virTypedParamListPtr list,
+                           unsigned long long value,
+                           const char *namefmt,
+                           ...)
+{
+    VIR_TYPED_PARAM_LIST_ADD(list, VIR_TYPED_PARAM_ULLONG, ul, value, namefmt);
+}
+
+
+/**
+ * virTypedParamListAddString:
+ *
+ * Same as virTypedParamListAddInt, but for string type. @value is copied,
+ * NULL is stored as an empty string.
+ */
+int
+virTypedParamListAddString(virTypedParamListPtr list,
+                           const char *value,
+                           const char *namefmt,
+                           ...)
+{
+    virTypedParameterPtr par;
+    va_list ap;
+    int rc;
+
+    if (!(par = virTypedParamListExtend(list)) ||
+        VIR_STRDUP(par->value.s, value ? value : "") < 0)
+        return -1;
+
+    par->type = VIR_TYPED_PARAM_STRING;
+
+    va_start(ap, namefmt);
+    rc = virTypedParamListAddCommit(list, namefmt, ap);
+    va_end(ap);
+
+    return rc;
+}
+
+
+/**
+ * virTypedParamListAddBoolean:
+ *
+ * Same as virTypedParamListAddInt, but for boolean type.
+ */
+int
+virTypedParamListAddBoolean(virTypedParamListPtr list,
+                            bool value,
+                            const char *namefmt,
+                            ...)
+{
+    VIR_TYPED_PARAM_LIST_ADD(list, VIR_TYPED_PARAM_BOOLEAN, b, value, namefmt);
+}
+
+
+/**
+ * virTypedParamListAddDouble:
+ *
+ * Same as virTypedParamListAddInt, but for double type.
+ */
+int
+virTypedParamListAddDouble(virTypedParamListPtr list,
+                           double value,
+                           const char *namefmt,
+                           ...)
+{
+    VIR_TYPED_PARAM_LIST_ADD(list, VIR_TYPED_PARAM_DOUBLE, d, value, namefmt);
+}
+
+#undef VIR_TYPED_PARAM_LIST_ADD
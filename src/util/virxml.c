@@ -30,10 +30,17 @@
 #include "virutil.h"
 #include "viralloc.h"
 #include "virfile.h"
+#include "virhash.h"
 #include "virstring.h"
+#include "virthread.h"
 
 #define VIR_FROM_THIS VIR_FROM_XML
 
+/* Upper bound of the number of compiled XPath expressions kept around.
+ * Almost all expressions are string literals, so this is only reached
+ * if callers construct lots of different expressions at runtime. */
+#define VIR_XPATH_CACHE_MAX 4096
+
 #define virGenericReportError(from, code, ...) \
         virReportErrorHelper(from, code, __FILE__, \
                              __FUNCTION__, __LINE__, __VA_ARGS__)
@@ -44,6 +51,87 @@ struct virParserData {
 };
 
 
+static virMutex virXPathCacheLock = VIR_MUTEX_INITIALIZER;
+static virHashTablePtr virXPathCache;
+
+
+static void
+virXPathCacheDataFree(void *payload,
+                      const void *name ATTRIBUTE_UNUSED)
+{
+    xmlXPathFreeCompExpr(payload);
+}
+
+
+static int
+virXPathCacheOnceInit(void)
+{
+    if (!(virXPathCache = virHashCreate(512, virXPathCacheDataFree)))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virXPathCache)
+
+
+/**
+ * virXPathEval:
+ * @xpath: the XPath string to evaluate
+ * @ctxt: an XPath context
+ *
+ * Same as xmlXPathEval, but @xpath is compiled only the first time it
+ * is seen. Parsing a domain evaluates hundreds of expressions and
+ * compiling them used to take most of the time spent in libxml2.
+ * Compiled expressions are not bound to any context and are never
+ * modified by the evaluation so they can be shared between threads.
+ *
+ * Returns the resulting object or NULL on error.
+ */
+static xmlXPathObjectPtr
+virXPathEval(const char *xpath,
+             xmlXPathContextPtr ctxt)
+{
+    xmlXPathCompExprPtr comp;
+    xmlXPathCompExprPtr cached;
+    xmlXPathObjectPtr obj;
+
+    if (virXPathCacheInitialize() < 0)
+        return xmlXPathEval(BAD_CAST xpath, ctxt);
+
+    virMutexLock(&virXPathCacheLock);
+    comp = virHashLookup(virXPathCache, xpath);
+    virMutexUnlock(&virXPathCacheLock);
+
+    if (comp)
+        return xmlXPathCompiledEval(comp, ctxt);
+
+    if (!(comp = xmlXPathCompile(BAD_CAST xpath)))
+        return NULL;
+
+    virMutexLock(&virXPathCacheLock);
+    if ((cached = virHashLookup(virXPathCache, xpath))) {
+        /* Another thread was faster */
+        xmlXPathFreeCompExpr(comp);
+        comp = cached;
+    } else if (virHashSize(virXPathCache) >= VIR_XPATH_CACHE_MAX ||
+               virHashAddEntry(virXPathCache, xpath, comp) < 0) {
+        virResetLastError();
+        cached = NULL;
+    } else {
+        cached = comp;
+    }
+    virMutexUnlock(&virXPathCacheLock);
+
+    obj = xmlXPathCompiledEval(comp, ctxt);
+
+    if (!cached)
+        xmlXPathFreeCompExpr(comp);
+
+    return obj;
+}
+
+
 /**
  * virXPathString:
  * @xpath: the XPath string to evaluate
@@ -68,7 +156,7 @@ virXPathString(const char *xpath,
         return NULL;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj == NULL) || (obj->type != XPATH_STRING) ||
         (obj->stringval == NULL) || (obj->stringval[0] == 0)) {
@@ -145,7 +233,7 @@ virXPathNumber(const char *xpath,
         return -1;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj == NULL) || (obj->type != XPATH_NUMBER) ||
         (isnan(obj->floatval))) {
@@ -174,7 +262,7 @@ virXPathLongBase(const char *xpath,
         return -1;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj != NULL) && (obj->type == XPATH_STRING) &&
         (obj->stringval != NULL) && (obj->stringval[0] != 0)) {
@@ -279,7 +367,7 @@ virXPathULongBase(const char *xpath,
         return -1;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj != NULL) && (obj->type == XPATH_STRING) &&
         (obj->stringval != NULL) && (obj->stringval[0] != 0)) {
@@ -395,7 +483,7 @@ virXPathULongLong(const char *xpath,
         return -1;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj != NULL) && (obj->type == XPATH_STRING) &&
         (obj->stringval != NULL) && (obj->stringval[0] != 0)) {
@@ -441,7 +529,7 @@ virXPathLongLong(const char *xpath,
         return -1;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj != NULL) && (obj->type == XPATH_STRING) &&
         (obj->stringval != NULL) && (obj->stringval[0] != 0)) {
@@ -567,7 +655,7 @@ virXPathBoolean(const char *xpath,
         return -1;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj == NULL) || (obj->type != XPATH_BOOLEAN) ||
         (obj->boolval < 0) || (obj->boolval > 1)) {
@@ -604,7 +692,7 @@ virXPathNode(const char *xpath,
         return NULL;
     }
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if ((obj == NULL) || (obj->type != XPATH_NODESET) ||
         (obj->nodesetval == NULL) || (obj->nodesetval->nodeNr <= 0) ||
@@ -648,7 +736,7 @@ virXPathNodeSet(const char *xpath,
         *list = NULL;
 
     relnode = ctxt->node;
-    obj = xmlXPathEval(BAD_CAST xpath, ctxt);
+    obj = virXPathEval(xpath, ctxt);
     ctxt->node = relnode;
     if (obj == NULL)
         return 0;
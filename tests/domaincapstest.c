@@ -201,6 +201,42 @@ fillQemuCaps(virDomainCapsPtr domCaps,
     VIR_FREE(path);
     return ret;
 }
+
+
+# define NUM_BENCH_ROUNDS 200
+
+static int
+testQemuCapsLoadBench(const void *opaque ATTRIBUTE_UNUSED)
+{
+    VIR_AUTOFREE(char *) path = NULL;
+    struct timespec start, end;
+    unsigned long long elapsed;
+    size_t i;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    if (virAsprintf(&path, "%s/qemucapabilitiesdata/caps_3.1.0.x86_64.xml",
+                    abs_srcdir) < 0)
+        return -1;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NUM_BENCH_ROUNDS; i++) {
+        virQEMUCapsPtr qemuCaps;
+
+        if (!(qemuCaps = qemuTestParseCapabilitiesArch(VIR_ARCH_X86_64, path)))
+            return -1;
+        virObjectUnref(qemuCaps);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+    VIR_TEST_VERBOSE("%llu us to load the capabilities cache\n",
+                     elapsed / NUM_BENCH_ROUNDS / 1000);
+
+    return 0;
+}
 #endif /* WITH_QEMU */
 
 
@@ -502,6 +538,10 @@ mymain(void)
                  "/usr/bin/qemu-system-s390x", NULL,
                  "s390x", VIR_DOMAIN_VIRT_KVM);
 
+    if (virTestRun("load capabilities cache benchmark",
+                   testQemuCapsLoadBench, NULL) < 0)
+        ret = -1;
+
     virObjectUnref(cfg);
 
 #endif /* WITH_QEMU */
@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#include "viralloc.h"
+#include "virerror.h"
+#include "viruuid.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+/* "test" is defined and running in test:///default */
+static const char runningUUID[] = "6695eb01-f6a4-8304-79aa-97f2502e193f";
+static const char inactiveUUID[] = "77a6fc12-07b5-9415-8abb-a803613f2a40";
+static const char missingUUID[] = "b5d4c1d0-7e0f-4a46-a1b5-2b4ba1fd1e41";
+
+static const char domainDef[] =
+"<domain type='test'>"
+"  <name>test-domain</name>"
+"  <uuid>77a6fc12-07b5-9415-8abb-a803613f2a40</uuid>"
+"  <memory>8388608</memory>"
+"  <currentMemory>2097152</currentMemory>"
+"  <vcpu>2</vcpu>"
+"  <os>"
+"    <type>hvm</type>"
+"  </os>"
+"</domain>";
+
+struct domainListTest {
+    virConnectPtr conn;
+    virDomainPtr running;  /* "test" */
+    virDomainPtr inactive; /* "test-domain", defined by mymain */
+};
+
+
+static int
+testCheckState(virDomainPtr dom,
+               int expected)
+{
+    int state;
+
+    if (virDomainGetState(dom, &state, NULL, 0) < 0)
+        return -1;
+
+    if (state != expected) {
+        fprintf(stderr, "domain %s: expected state %d, got %d\n",
+                virDomainGetName(dom), expected, state);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testCheckErrors(const int *errors,
+                const int *expected,
+                size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        if (errors[i] != expected[i]) {
+            fprintf(stderr, "domain %zu: expected error %d, got %d\n",
+                    i, expected[i], errors[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+testLookupDomainsByUUID(const void *data)
+{
+    const struct domainListTest *test = data;
+    const char *uuidstrs[] = { runningUUID, missingUUID, inactiveUUID };
+    const char *names[] = { "test", NULL, "test-domain" };
+    const int expectStates[] = {
+        VIR_DOMAIN_RUNNING, VIR_DOMAIN_NOSTATE, VIR_DOMAIN_SHUTOFF,
+    };
+    unsigned char uuids[ARRAY_CARDINALITY(uuidstrs) * VIR_UUID_BUFLEN];
+    virDomainPtr *doms = NULL;
+    int *states = NULL;
+    size_t n = ARRAY_CARDINALITY(uuidstrs);
+    size_t i;
+    int rc;
+    int ret = -1;
+
+    for (i = 0; i < n; i++) {
+        if (virUUIDParse(uuidstrs[i], uuids + i * VIR_UUID_BUFLEN) < 0)
+            return -1;
+    }
+
+    if ((rc = virConnectLookupDomainsByUUID(test->conn, uuids, n,
+                                            &doms, &states, 0)) != 2) {
+        fprintf(stderr, "expected 2 domains, got %d\n", rc);
+        goto cleanup;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (!names[i] != !doms[i] ||
+            (doms[i] && STRNEQ(virDomainGetName(doms[i]), names[i]))) {
+            fprintf(stderr, "entry %zu: expected domain %s, got %s\n",
+                    i, NULLSTR(names[i]),
+                    doms[i] ? virDomainGetName(doms[i]) : "(null)");
+            goto cleanup;
+        }
+
+        if (states[i] != expectStates[i]) {
+            fprintf(stderr, "entry %zu: expected state %d, got %d\n",
+                    i, expectStates[i], states[i]);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+
+ cleanup:
+    if (doms) {
+        for (i = 0; i < n; i++) {
+            if (doms[i])
+                virDomainFree(doms[i]);
+        }
+    }
+    VIR_FREE(doms);
+    VIR_FREE(states);
+    return ret;
+}
+
+
+static int
+testLookupDomainsByUUIDStatesOptional(const void *data)
+{
+    const struct domainListTest *test = data;
+    unsigned char uuid[VIR_UUID_BUFLEN];
+    virDomainPtr *doms = NULL;
+    int ret = -1;
+
+    if (virUUIDParse(runningUUID, uuid) < 0)
+        return -1;
+
+    if (virConnectLookupDomainsByUUID(test->conn, uuid, 1,
+                                      &doms, NULL, 0) != 1)
+        goto cleanup;
+
+    if (virDomainGetID(doms[0]) != virDomainGetID(test->running))
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    if (doms && doms[0])
+        virDomainFree(doms[0]);
+    VIR_FREE(doms);
+    return ret;
+}
+
+
+static int
+testLookupDomainsByUUIDFlags(const void *data)
+{
+    const struct domainListTest *test = data;
+    unsigned char uuid[VIR_UUID_BUFLEN];
+    virDomainPtr *doms = NULL;
+
+    if (virUUIDParse(runningUUID, uuid) < 0)
+        return -1;
+
+    if (virConnectLookupDomainsByUUID(test->conn, uuid, 1,
+                                      &doms, NULL, 1) != -1 ||
+        doms) {
+        fprintf(stderr, "unknown flags were accepted\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testListLifecycleStart(const void *data)
+{
+    const struct domainListTest *test = data;
+    virDomainPtr doms[] = { test->running, test->inactive, NULL };
+    const int expected[] = { VIR_ERR_INTERNAL_ERROR, VIR_ERR_OK };
+    int *errors = NULL;
+    int rc;
+    int ret = -1;
+
+    /* the domain which is running already fails alone, with the error
+     * the test driver reports for it */
+    if ((rc = virDomainListLifecycle(doms, VIR_DOMAIN_LIST_LIFECYCLE_START,
+                                     &errors, 0)) != 1) {
+        fprintf(stderr, "expected 1 domain started, got %d\n", rc);
+        goto cleanup;
+    }
+
+    if (testCheckErrors(errors, expected, ARRAY_CARDINALITY(expected)) < 0 ||
+        testCheckState(test->running, VIR_DOMAIN_RUNNING) < 0 ||
+        testCheckState(test->inactive, VIR_DOMAIN_RUNNING) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(errors);
+    return ret;
+}
+
+
+static int
+testListLifecycleDestroy(const void *data)
+{
+    const struct domainListTest *test = data;
+    virDomainPtr doms[] = { test->inactive, NULL };
+    int rc;
+
+    /* @errors is optional */
+    if ((rc = virDomainListLifecycle(doms, VIR_DOMAIN_LIST_LIFECYCLE_DESTROY,
+                                     NULL, 0)) != 1) {
+        fprintf(stderr, "expected 1 domain destroyed, got %d\n", rc);
+        return -1;
+    }
+
+    return testCheckState(test->inactive, VIR_DOMAIN_SHUTOFF);
+}
+
+
+static int
+testListLifecycleShutdown(const void *data)
+{
+    const struct domainListTest *test = data;
+    virDomainPtr doms[] = { test->inactive, test->running, NULL };
+    const int expected[] = { VIR_ERR_INTERNAL_ERROR, VIR_ERR_OK };
+    int *errors = NULL;
+    int rc;
+    int ret = -1;
+
+    if ((rc = virDomainListLifecycle(doms, VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN,
+                                     &errors, 0)) != 1) {
+        fprintf(stderr, "expected 1 domain shut down, got %d\n", rc);
+        goto cleanup;
+    }
+
+    if (testCheckErrors(errors, expected, ARRAY_CARDINALITY(expected)) < 0 ||
+        testCheckState(test->inactive, VIR_DOMAIN_SHUTOFF) < 0 ||
+        testCheckState(test->running, VIR_DOMAIN_SHUTOFF) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(errors);
+    return ret;
+}
+
+
+struct lifecycleFlagsTest {
+    const struct domainListTest *test;
+    int action;
+    unsigned int flags;
+};
+
+static int
+testListLifecycleFlags(const void *data)
+{
+    const struct lifecycleFlagsTest *info = data;
+    virDomainPtr doms[] = { info->test->inactive, NULL };
+    int *errors = NULL;
+
+    if (virDomainListLifecycle(doms, info->action, &errors, info->flags) != -1) {
+        fprintf(stderr, "action %d accepted flags 0x%x\n",
+                info->action, info->flags);
+        VIR_FREE(errors);
+        return -1;
+    }
+
+    if (errors) {
+        fprintf(stderr, "errors filled in for a failed request\n");
+        VIR_FREE(errors);
+        return -1;
+    }
+
+    return testCheckState(info->test->inactive, VIR_DOMAIN_SHUTOFF);
+}
+
+
+static int
+mymain(void)
+{
+    struct domainListTest test = { 0 };
+    int ret = EXIT_SUCCESS;
+
+    if (!(test.conn = virConnectOpen("test:///default")))
+        return EXIT_FAILURE;
+
+    if (!(test.running = virDomainLookupByName(test.conn, "test")) ||
+        !(test.inactive = virDomainDefineXML(test.conn, domainDef))) {
+        ret = EXIT_FAILURE;
+        goto cleanup;
+    }
+
+    virTestQuiesceLibvirtErrors(false);
+
+    if (virTestRun("Lookup domains by UUID ",
+                   testLookupDomainsByUUID, &test) < 0)
+        ret = EXIT_FAILURE;
+    if (virTestRun("Lookup domains by UUID without states ",
+                   testLookupDomainsByUUIDStatesOptional, &test) < 0)
+        ret = EXIT_FAILURE;
+    if (virTestRun("Lookup domains by UUID with flags ",
+                   testLookupDomainsByUUIDFlags, &test) < 0)
+        ret = EXIT_FAILURE;
+
+    if (virTestRun("List lifecycle start ",
+                   testListLifecycleStart, &test) < 0)
+        ret = EXIT_FAILURE;
+    if (virTestRun("List lifecycle destroy ",
+                   testListLifecycleDestroy, &test) < 0)
+        ret = EXIT_FAILURE;
+    if (virTestRun("List lifecycle shutdown ",
+                   testListLifecycleShutdown, &test) < 0)
+        ret = EXIT_FAILURE;
+
+#define TEST_LIFECYCLE_FLAGS(ACTION, FLAGS) \
+    do { \
+        struct lifecycleFlagsTest info = { &test, ACTION, FLAGS }; \
+        if (virTestRun("List lifecycle flags " #ACTION " " #FLAGS " ", \
+                       testListLifecycleFlags, &info) < 0) \
+            ret = EXIT_FAILURE; \
+    } while (0)
+
+    /* flags the action doesn't know are rejected before any domain
+     * is touched */
+    TEST_LIFECYCLE_FLAGS(VIR_DOMAIN_LIST_LIFECYCLE_START,
+                         VIR_DOMAIN_START_VALIDATE << 1);
+    TEST_LIFECYCLE_FLAGS(VIR_DOMAIN_LIST_LIFECYCLE_SHUTDOWN,
+                         VIR_DOMAIN_SHUTDOWN_PARAVIRT << 1);
+    TEST_LIFECYCLE_FLAGS(VIR_DOMAIN_LIST_LIFECYCLE_DESTROY,
+                         VIR_DOMAIN_START_AUTODESTROY);
+    TEST_LIFECYCLE_FLAGS(VIR_DOMAIN_LIST_LIFECYCLE_LAST, 0);
+
+#undef TEST_LIFECYCLE_FLAGS
+
+ cleanup:
+    if (test.running)
+        virDomainFree(test.running);
+    if (test.inactive)
+        virDomainFree(test.inactive);
+    virConnectClose(test.conn);
+
+    return ret;
+}
+
+VIR_TEST_MAIN(mymain)
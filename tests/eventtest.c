@@ -21,7 +21,9 @@
 #include <config.h>
 
 #include <signal.h>
+#include <fcntl.h>
 #include <time.h>
+#include <sys/resource.h>
 
 #if HAVE_MACH_CLOCK_ROUTINES
 # include <mach/clock.h>
@@ -34,13 +36,49 @@
 #include "virthread.h"
 #include "virlog.h"
 #include "virutil.h"
+#include "vireventepoll.h"
 #include "vireventpoll.h"
+#include "vireventthread.h"
+#include "virtime.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
 
 VIR_LOG_INIT("tests.eventtest");
 
 #define NUM_FDS 31
 #define NUM_TIME 31
 
+#define NUM_BENCH_HANDLES 10000
+#define NUM_BENCH_ROUNDS 1000
+
+struct testEventImpl {
+    const char *name;
+    int (*init)(void);
+    int (*runOnce)(void);
+    virEventAddHandleFunc addHandle;
+    virEventUpdateHandleFunc updateHandle;
+    virEventRemoveHandleFunc removeHandle;
+    virEventAddTimeoutFunc addTimeout;
+    virEventUpdateTimeoutFunc updateTimeout;
+    virEventRemoveTimeoutFunc removeTimeout;
+};
+
+static const struct testEventImpl testEventImpls[] = {
+    { "poll", virEventPollInit, virEventPollRunOnce,
+      virEventPollAddHandle, virEventPollUpdateHandle,
+      virEventPollRemoveHandle, virEventPollAddTimeout,
+      virEventPollUpdateTimeout, virEventPollRemoveTimeout },
+#ifdef __linux__
+    { "epoll", virEventEpollInit, virEventEpollRunOnce,
+      virEventEpollAddHandle, virEventEpollUpdateHandle,
+      virEventEpollRemoveHandle, virEventEpollAddTimeout,
+      virEventEpollUpdateTimeout, virEventEpollRemoveTimeout },
+#endif
+};
+
+/* The implementation being tested */
+static const struct testEventImpl *impl;
+
 static struct handleInfo {
     int pipeFD[2];
     int fired;
@@ -87,6 +125,7 @@ testEventReport(const char *name, bool failed, const char *msg, ...)
     va_list vargs;
     va_start(vargs, msg);
     char *str = NULL;
+    char *testName = NULL;
     struct testEventResultData data;
 
     if (msg && virVasprintfQuiet(&str, msg, vargs) != 0)
@@ -94,10 +133,14 @@ testEventReport(const char *name, bool failed, const char *msg, ...)
 
     data.failed = failed;
     data.msg = str;
-    ignore_value(virTestRun(name, testEventResultCallback, &data));
+    if (virAsprintfQuiet(&testName, "%s: %s", impl->name, name) < 0)
+        data.failed = true;
+    ignore_value(virTestRun(testName ? testName : name,
+                            testEventResultCallback, &data));
 
     va_end(vargs);
     VIR_FREE(str);
+    VIR_FREE(testName);
 }
 
 static void
@@ -129,7 +172,7 @@ testPipeReader(int watch, int fd, int events, void *data)
     info->error = EV_ERROR_NONE;
 
     if (info->delete != -1)
-        virEventPollRemoveHandle(info->delete);
+        impl->removeHandle(info->delete);
 }
 
 
@@ -148,7 +191,7 @@ testTimer(int timer, void *data)
     info->error = EV_ERROR_NONE;
 
     if (info->delete != -1)
-        virEventPollRemoveTimeout(info->delete);
+        impl->removeTimeout(info->delete);
 }
 
 static pthread_mutex_t eventThreadMutex = PTHREAD_MUTEX_INITIALIZER;
@@ -166,7 +209,7 @@ ATTRIBUTE_NORETURN static void *eventThreadLoop(void *data ATTRIBUTE_UNUSED) {
         eventThreadRunOnce = 0;
         pthread_mutex_unlock(&eventThreadMutex);
 
-        virEventPollRunOnce();
+        impl->runOnce();
 
         pthread_mutex_lock(&eventThreadMutex);
         eventThreadJobDone = 1;
@@ -307,11 +350,12 @@ resetAll(void)
     }
 }
 
+/* Runs all the tests against @impl, the caller must hold
+ * eventThreadMutex */
 static int
-mymain(void)
+testEventRun(void)
 {
     size_t i;
-    pthread_t eventThread;
     char one = '1';
 
     for (i = 0; i < NUM_FDS; i++) {
@@ -321,38 +365,28 @@ mymain(void)
         }
     }
 
-    if (virThreadInitialize() < 0)
+    if (impl->init() < 0)
         return EXIT_FAILURE;
-    char *debugEnv = getenv("LIBVIRT_DEBUG");
-    if (debugEnv && *debugEnv &&
-        (virLogSetDefaultPriority(virLogParseDefaultPriority(debugEnv)) < 0)) {
-        fprintf(stderr, "Invalid log level setting.\n");
-        return EXIT_FAILURE;
-    }
-
-    virEventPollInit();
 
     for (i = 0; i < NUM_FDS; i++) {
         handles[i].delete = -1;
         handles[i].watch =
-            virEventPollAddHandle(handles[i].pipeFD[0],
-                                  VIR_EVENT_HANDLE_READABLE,
-                                  testPipeReader,
-                                  &handles[i], NULL);
+            impl->addHandle(handles[i].pipeFD[0],
+                            VIR_EVENT_HANDLE_READABLE,
+                            testPipeReader,
+                            &handles[i], NULL);
     }
 
     for (i = 0; i < NUM_TIME; i++) {
         timers[i].delete = -1;
         timers[i].timeout = -1;
         timers[i].timer =
-            virEventPollAddTimeout(timers[i].timeout,
-                                   testTimer,
-                                   &timers[i], NULL);
+            impl->addTimeout(timers[i].timeout,
+                             testTimer,
+                             &timers[i], NULL);
     }
 
-    pthread_create(&eventThread, NULL, eventThreadLoop, NULL);
-
-    pthread_mutex_lock(&eventThreadMutex);
+    resetAll();
 
     /* First time, is easy - just try triggering one of our
      * registered handles */
@@ -366,7 +400,7 @@ mymain(void)
 
     /* Now lets delete one before starting poll(), and
      * try triggering another handle */
-    virEventPollRemoveHandle(handles[0].watch);
+    impl->removeHandle(handles[0].watch);
     startJob();
     if (safewrite(handles[1].pipeFD[1], &one, 1) != 1)
         return EXIT_FAILURE;
@@ -386,7 +420,7 @@ mymain(void)
     sched_yield();
     usleep(100 * 1000);
     pthread_mutex_lock(&eventThreadMutex);
-    virEventPollRemoveHandle(handles[1].watch);
+    impl->removeHandle(handles[1].watch);
     if (finishJob("Interrupted during poll", -1, -1) != EXIT_SUCCESS)
         return EXIT_FAILURE;
 
@@ -422,22 +456,22 @@ mymain(void)
 
 
     /* Run a timer on its own */
-    virEventPollUpdateTimeout(timers[1].timer, 100);
+    impl->updateTimeout(timers[1].timer, 100);
     startJob();
     if (finishJob("Firing a timer", -1, 1) != EXIT_SUCCESS)
         return EXIT_FAILURE;
-    virEventPollUpdateTimeout(timers[1].timer, -1);
+    impl->updateTimeout(timers[1].timer, -1);
 
     resetAll();
 
     /* Now lets delete one before starting poll(), and
      * try triggering another timer */
-    virEventPollUpdateTimeout(timers[1].timer, 100);
-    virEventPollRemoveTimeout(timers[0].timer);
+    impl->updateTimeout(timers[1].timer, 100);
+    impl->removeTimeout(timers[0].timer);
     startJob();
     if (finishJob("Deleted before poll", -1, 1) != EXIT_SUCCESS)
         return EXIT_FAILURE;
-    virEventPollUpdateTimeout(timers[1].timer, -1);
+    impl->updateTimeout(timers[1].timer, -1);
 
     resetAll();
 
@@ -452,7 +486,7 @@ mymain(void)
     sched_yield();
     usleep(100 * 1000);
     pthread_mutex_lock(&eventThreadMutex);
-    virEventPollRemoveTimeout(timers[1].timer);
+    impl->removeTimeout(timers[1].timer);
     if (finishJob("Interrupted during poll", -1, -1) != EXIT_SUCCESS)
         return EXIT_FAILURE;
 
@@ -465,27 +499,27 @@ mymain(void)
      * before poll() exits for the first safewrite(). We don't
      * see a hard failure in other cases, so nothing to worry
      * about */
-    virEventPollUpdateTimeout(timers[2].timer, 100);
-    virEventPollUpdateTimeout(timers[3].timer, 100);
+    impl->updateTimeout(timers[2].timer, 100);
+    impl->updateTimeout(timers[3].timer, 100);
     startJob();
     timers[2].delete = timers[3].timer;
     if (finishJob("Deleted during dispatch", -1, 2) != EXIT_SUCCESS)
         return EXIT_FAILURE;
-    virEventPollUpdateTimeout(timers[2].timer, -1);
+    impl->updateTimeout(timers[2].timer, -1);
 
     resetAll();
 
     /* Extreme fun, lets delete ourselves during dispatch */
-    virEventPollUpdateTimeout(timers[2].timer, 100);
+    impl->updateTimeout(timers[2].timer, 100);
     startJob();
     timers[2].delete = timers[2].timer;
     if (finishJob("Deleted during dispatch", -1, 2) != EXIT_SUCCESS)
         return EXIT_FAILURE;
 
     for (i = 0; i < NUM_FDS - 1; i++)
-        virEventPollRemoveHandle(handles[i].watch);
+        impl->removeHandle(handles[i].watch);
     for (i = 0; i < NUM_TIME - 1; i++)
-        virEventPollRemoveTimeout(timers[i].timer);
+        impl->removeTimeout(timers[i].timer);
 
     resetAll();
 
@@ -506,23 +540,399 @@ mymain(void)
     handles[0].pipeFD[0] = handles[1].pipeFD[0];
     handles[0].pipeFD[1] = handles[1].pipeFD[1];
 
-    handles[0].watch = virEventPollAddHandle(handles[0].pipeFD[0],
-                                             0,
-                                             testPipeReader,
-                                             &handles[0], NULL);
-    handles[1].watch = virEventPollAddHandle(handles[1].pipeFD[0],
-                                             VIR_EVENT_HANDLE_READABLE,
-                                             testPipeReader,
-                                             &handles[1], NULL);
+    handles[0].watch = impl->addHandle(handles[0].pipeFD[0],
+                                       0,
+                                       testPipeReader,
+                                       &handles[0], NULL);
+    handles[1].watch = impl->addHandle(handles[1].pipeFD[0],
+                                       VIR_EVENT_HANDLE_READABLE,
+                                       testPipeReader,
+                                       &handles[1], NULL);
     startJob();
     if (safewrite(handles[1].pipeFD[1], &one, 1) != 1)
         return EXIT_FAILURE;
     if (finishJob("Write duplicate", 1, -1) != EXIT_SUCCESS)
         return EXIT_FAILURE;
 
-    /* pthread_kill(eventThread, SIGTERM); */
+    resetAll();
+
+    /* A regular file is always ready, but once it is watched for no
+     * events it must not keep the loop from sleeping */
+    VIR_FORCE_CLOSE(handles[2].pipeFD[0]);
+    if ((handles[2].pipeFD[0] = open(abs_srcdir "/eventtest.c",
+                                     O_RDONLY)) < 0) {
+        fprintf(stderr, "Cannot open file: %d", errno);
+        return EXIT_FAILURE;
+    }
+    handles[2].delete = -1;
+    handles[2].watch = impl->addHandle(handles[2].pipeFD[0],
+                                       VIR_EVENT_HANDLE_READABLE,
+                                       testPipeReader,
+                                       &handles[2], NULL);
+    impl->updateHandle(handles[2].watch, 0);
+    startJob();
+    usleep(100 * 1000);
+    if (safewrite(handles[1].pipeFD[1], &one, 1) != 1)
+        return EXIT_FAILURE;
+    if (finishJob("Idle regular file", 1, -1) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    resetAll();
+
+    /* Enabling it has to wake up a sleeping loop and, with epoll, get
+     * dispatched right away. poll() rebuilds its fd set only in the
+     * next iteration. */
+    if (STREQ(impl->name, "epoll")) {
+        startJob();
+        impl->updateHandle(handles[2].watch, VIR_EVENT_HANDLE_READABLE);
+        if (finishJob("Enable regular file", 2, -1) != EXIT_SUCCESS)
+            return EXIT_FAILURE;
+    }
+
+    impl->removeHandle(handles[2].watch);
+    VIR_FORCE_CLOSE(handles[2].pipeFD[0]);
 
     return EXIT_SUCCESS;
 }
 
+
+static void
+testEventBenchReader(int watch ATTRIBUTE_UNUSED,
+                     int fd,
+                     int events ATTRIBUTE_UNUSED,
+                     void *opaque)
+{
+    size_t *fired = opaque;
+    char c;
+
+    if (read(fd, &c, 1) == 1)
+        (*fired)++;
+}
+
+
+static void
+testEventBenchIdle(int watch ATTRIBUTE_UNUSED,
+                   int fd ATTRIBUTE_UNUSED,
+                   int events ATTRIBUTE_UNUSED,
+                   void *opaque ATTRIBUTE_UNUSED)
+{
+}
+
+
+/* Measures how long it takes to dispatch an event of a single file
+ * handle among NUM_BENCH_HANDLES idle ones. It is run from the main
+ * thread while the event thread waits for its next job. */
+static int
+testEventBench(const void *opaque ATTRIBUTE_UNUSED)
+{
+    VIR_AUTOFREE(int *) idleFDs = NULL;
+    VIR_AUTOFREE(int *) idleWatches = NULL;
+    int idlePipe[2] = { -1, -1 };
+    int busyPipe[2] = { -1, -1 };
+    int busyWatch = -1;
+    size_t nidle = 0;
+    size_t fired = 0;
+    struct rlimit rlim;
+    struct timespec start, end;
+    unsigned long long elapsed;
+    char one = '1';
+    size_t i;
+    int ret = -1;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    /* Each handle needs its own file descriptor */
+    if (getrlimit(RLIMIT_NOFILE, &rlim) < 0)
+        return -1;
+    if (rlim.rlim_max != RLIM_INFINITY &&
+        rlim.rlim_max < NUM_BENCH_HANDLES + 100) {
+        VIR_TEST_VERBOSE("Not enough file descriptors allowed\n");
+        return EXIT_AM_SKIP;
+    }
+    if (rlim.rlim_cur < NUM_BENCH_HANDLES + 100) {
+        rlim.rlim_cur = NUM_BENCH_HANDLES + 100;
+        if (setrlimit(RLIMIT_NOFILE, &rlim) < 0)
+            return -1;
+    }
+
+    if (VIR_ALLOC_N(idleFDs, NUM_BENCH_HANDLES - 1) < 0 ||
+        VIR_ALLOC_N(idleWatches, NUM_BENCH_HANDLES - 1) < 0)
+        return -1;
+
+    if (pipe(idlePipe) < 0 || pipe(busyPipe) < 0)
+        goto cleanup;
+
+    for (nidle = 0; nidle < NUM_BENCH_HANDLES - 1; nidle++) {
+        if ((idleFDs[nidle] = dup(idlePipe[0])) < 0)
+            goto cleanup;
+        if ((idleWatches[nidle] = impl->addHandle(idleFDs[nidle],
+                                                  VIR_EVENT_HANDLE_READABLE,
+                                                  testEventBenchIdle,
+                                                  NULL, NULL)) < 0) {
+            VIR_FORCE_CLOSE(idleFDs[nidle]);
+            goto cleanup;
+        }
+    }
+
+    if ((busyWatch = impl->addHandle(busyPipe[0],
+                                     VIR_EVENT_HANDLE_READABLE,
+                                     testEventBenchReader,
+                                     &fired, NULL)) < 0)
+        goto cleanup;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NUM_BENCH_ROUNDS; i++) {
+        if (safewrite(busyPipe[1], &one, 1) != 1 ||
+            impl->runOnce() < 0)
+            goto cleanup;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (fired != NUM_BENCH_ROUNDS) {
+        fprintf(stderr, "Expected %d dispatches, got %zu\n",
+                NUM_BENCH_ROUNDS, fired);
+        goto cleanup;
+    }
+
+    elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+    VIR_TEST_VERBOSE("%s: %llu ns per dispatch with %d handles\n",
+                     impl->name, elapsed / NUM_BENCH_ROUNDS,
+                     NUM_BENCH_HANDLES);
+
+    ret = 0;
+
+ cleanup:
+    if (busyWatch > 0)
+        impl->removeHandle(busyWatch);
+    for (i = 0; i < nidle; i++)
+        impl->removeHandle(idleWatches[i]);
+    for (i = 0; i < nidle; i++)
+        VIR_FORCE_CLOSE(idleFDs[i]);
+    VIR_FORCE_CLOSE(idlePipe[0]);
+    VIR_FORCE_CLOSE(idlePipe[1]);
+    VIR_FORCE_CLOSE(busyPipe[0]);
+    VIR_FORCE_CLOSE(busyPipe[1]);
+    return ret;
+}
+
+
+struct testEventThreadData {
+    virMutex lock;
+    virCond cond;
+    virThread self;
+    bool foreign;
+    size_t fired;
+    bool freed;
+};
+
+
+static void
+testEventThreadReader(int watch ATTRIBUTE_UNUSED,
+                      int fd,
+                      int events ATTRIBUTE_UNUSED,
+                      void *opaque)
+{
+    struct testEventThreadData *data = opaque;
+    char c;
+
+    virMutexLock(&data->lock);
+    if (read(fd, &c, 1) == 1)
+        data->fired++;
+    if (virThreadIsSelf(&data->self))
+        data->foreign = false;
+    virCondSignal(&data->cond);
+    virMutexUnlock(&data->lock);
+}
+
+
+static void
+testEventThreadFree(void *opaque)
+{
+    struct testEventThreadData *data = opaque;
+
+    virMutexLock(&data->lock);
+    data->freed = true;
+    virCondSignal(&data->cond);
+    virMutexUnlock(&data->lock);
+}
+
+
+/* Waits until @var becomes true with @data locked */
+#define TEST_EVENT_THREAD_WAIT(data, var, deadline) \
+    do { \
+        while (!(var)) { \
+            if (virCondWaitUntil(&(data)->cond, &(data)->lock, deadline) < 0) { \
+                fprintf(stderr, "Timed out waiting for " #var "\n"); \
+                goto unlock; \
+            } \
+        } \
+    } while (0)
+
+/* Checks that handles of a virEventThread are dispatched in a thread
+ * of its own and freed after they are removed */
+static int
+testEventThread(const void *opaque ATTRIBUTE_UNUSED)
+{
+    struct testEventThreadData data = { .foreign = true };
+    virEventThreadPtr evt = NULL;
+    unsigned long long deadline;
+    int fds[2] = { -1, -1 };
+    int watch = -1;
+    char one = '1';
+    int ret = -1;
+
+    if (virMutexInit(&data.lock) < 0 ||
+        virCondInit(&data.cond) < 0)
+        return -1;
+    virThreadSelf(&data.self);
+
+    if (pipe(fds) < 0 ||
+        !(evt = virEventThreadNew("test-event-thread")))
+        goto cleanup;
+
+    if ((watch = virEventThreadAddHandle(evt, fds[0],
+                                         VIR_EVENT_HANDLE_READABLE,
+                                         testEventThreadReader, &data,
+                                         testEventThreadFree)) < 0)
+        goto cleanup;
+
+    if (virTimeMillisNow(&deadline) < 0)
+        goto cleanup;
+    deadline += 10 * 1000;
+
+    virMutexLock(&data.lock);
+    if (safewrite(fds[1], &one, 1) != 1) {
+        virMutexUnlock(&data.lock);
+        goto cleanup;
+    }
+    TEST_EVENT_THREAD_WAIT(&data, data.fired == 1, deadline);
+
+    if (!data.foreign) {
+        fprintf(stderr, "Handle dispatched in the main thread\n");
+        goto unlock;
+    }
+
+    virMutexUnlock(&data.lock);
+    virEventThreadRemoveHandle(evt, watch);
+    watch = -1;
+    virMutexLock(&data.lock);
+
+    TEST_EVENT_THREAD_WAIT(&data, data.freed, deadline);
+    virMutexUnlock(&data.lock);
+
+    ret = 0;
+    goto cleanup;
+
+ unlock:
+    virMutexUnlock(&data.lock);
+ cleanup:
+    if (evt && watch > 0)
+        virEventThreadRemoveHandle(evt, watch);
+    virEventThreadStop(evt);
+    virObjectUnref(evt);
+    VIR_FORCE_CLOSE(fds[0]);
+    VIR_FORCE_CLOSE(fds[1]);
+    virCondDestroy(&data.cond);
+    virMutexDestroy(&data.lock);
+    return ret;
+}
+
+
+/* Checks that stopping a virEventThread frees the handles still
+ * registered, whose owners typically hold a reference to the loop */
+static int
+testEventThreadStop(const void *opaque ATTRIBUTE_UNUSED)
+{
+    struct testEventThreadData data = { .foreign = true };
+    virEventThreadPtr evt = NULL;
+    int fds[2] = { -1, -1 };
+    int ret = -1;
+
+    if (virMutexInit(&data.lock) < 0 ||
+        virCondInit(&data.cond) < 0)
+        return -1;
+
+    if (pipe(fds) < 0 ||
+        !(evt = virEventThreadNew("test-event-thread")))
+        goto cleanup;
+
+    if (virEventThreadAddHandle(evt, fds[0], VIR_EVENT_HANDLE_READABLE,
+                                testEventThreadReader, &data,
+                                testEventThreadFree) < 0)
+        goto cleanup;
+
+    virEventThreadStop(evt);
+
+    if (!data.freed) {
+        fprintf(stderr, "Handle not freed by stopping the thread\n");
+        goto cleanup;
+    }
+
+    if (virEventThreadAddHandle(evt, fds[0], VIR_EVENT_HANDLE_READABLE,
+                                testEventThreadReader, &data, NULL) >= 0) {
+        fprintf(stderr, "Handle added to a stopped thread\n");
+        goto cleanup;
+    }
+    virResetLastError();
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnref(evt);
+    VIR_FORCE_CLOSE(fds[0]);
+    VIR_FORCE_CLOSE(fds[1]);
+    virCondDestroy(&data.cond);
+    virMutexDestroy(&data.lock);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    size_t i;
+    pthread_t eventThread;
+    int ret = EXIT_SUCCESS;
+
+    if (virThreadInitialize() < 0)
+        return EXIT_FAILURE;
+    char *debugEnv = getenv("LIBVIRT_DEBUG");
+    if (debugEnv && *debugEnv &&
+        (virLogSetDefaultPriority(virLogParseDefaultPriority(debugEnv)) < 0)) {
+        fprintf(stderr, "Invalid log level setting.\n");
+        return EXIT_FAILURE;
+    }
+
+    pthread_create(&eventThread, NULL, eventThreadLoop, NULL);
+
+    pthread_mutex_lock(&eventThreadMutex);
+
+    for (i = 0; i < ARRAY_CARDINALITY(testEventImpls); i++) {
+        impl = &testEventImpls[i];
+        if (testEventRun() != EXIT_SUCCESS)
+            return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < ARRAY_CARDINALITY(testEventImpls); i++) {
+        VIR_AUTOFREE(char *) name = NULL;
+
+        impl = &testEventImpls[i];
+        if (virAsprintf(&name, "%s: Dispatch among %d handles",
+                        impl->name, NUM_BENCH_HANDLES) < 0 ||
+            virTestRun(name, testEventBench, NULL) < 0)
+            ret = EXIT_FAILURE;
+    }
+
+    if (virTestRun("Dedicated event thread", testEventThread, NULL) < 0)
+        ret = EXIT_FAILURE;
+    if (virTestRun("Dedicated event thread stop", testEventThreadStop, NULL) < 0)
+        ret = EXIT_FAILURE;
+
+    /* pthread_kill(eventThread, SIGTERM); */
+
+    return ret;
+}
+
 VIR_TEST_MAIN(mymain)
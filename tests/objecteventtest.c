@@ -724,6 +724,74 @@ testStoragePoolStartStopEvent(const void *data)
     return ret;
 }
 
+static int
+testStoragePoolRefreshCoalesce(const void *data)
+{
+    const objecteventTest *test = data;
+    lifecycleEventCounter counter;
+    virConnectPtr conn2 = NULL;
+    virStoragePoolPtr pool2 = NULL;
+    int refreshCounter = 0;
+    int refreshCounter2 = 0;
+    int id1 = -1, id2 = -1, id3 = -1;
+    int ret = -1;
+
+    if (!test->pool)
+        return -1;
+
+    lifecycleEventCounter_reset(&counter);
+
+    /* Only the connection which asked for it gets the events merged */
+    if (!(conn2 = virConnectOpenAuth("test:///default", NULL,
+                                     VIR_CONNECT_COALESCE_EVENTS)) ||
+        !(pool2 = virStoragePoolLookupByName(conn2,
+                                             virStoragePoolGetName(test->pool))))
+        goto cleanup;
+
+    id1 = virConnectStoragePoolEventRegisterAny(test->conn, test->pool,
+                      VIR_STORAGE_POOL_EVENT_ID_LIFECYCLE,
+                      VIR_STORAGE_POOL_EVENT_CALLBACK(&storagePoolLifecycleCb),
+                      &counter, NULL);
+    id2 = virConnectStoragePoolEventRegisterAny(test->conn, test->pool,
+                      VIR_STORAGE_POOL_EVENT_ID_REFRESH,
+                      VIR_STORAGE_POOL_EVENT_CALLBACK(&storagePoolRefreshCb),
+                      &refreshCounter, NULL);
+    id3 = virConnectStoragePoolEventRegisterAny(conn2, pool2,
+                      VIR_STORAGE_POOL_EVENT_ID_REFRESH,
+                      VIR_STORAGE_POOL_EVENT_CALLBACK(&storagePoolRefreshCb),
+                      &refreshCounter2, NULL);
+    if (id1 < 0 || id2 < 0 || id3 < 0)
+        goto cleanup;
+
+    virStoragePoolCreate(test->pool, 0);
+    virStoragePoolRefresh(test->pool, 0);
+    virStoragePoolRefresh(test->pool, 0);
+    virStoragePoolRefresh(test->pool, 0);
+    virStoragePoolDestroy(test->pool);
+
+    if (virEventRunDefaultImpl() < 0)
+        goto cleanup;
+
+    if (counter.startEvents != 1 || counter.stopEvents != 1 ||
+        refreshCounter != 3 || refreshCounter2 != 1 ||
+        counter.unexpectedEvents > 0)
+        goto cleanup;
+
+    ret = 0;
+ cleanup:
+    if (id1 >= 0)
+        virConnectStoragePoolEventDeregisterAny(test->conn, id1);
+    if (id2 >= 0)
+        virConnectStoragePoolEventDeregisterAny(test->conn, id2);
+    if (id3 >= 0)
+        virConnectStoragePoolEventDeregisterAny(conn2, id3);
+    if (pool2)
+        virStoragePoolFree(pool2);
+    if (conn2)
+        virConnectClose(conn2);
+    return ret;
+}
+
 static int
 testStoragePoolBuild(const void *data)
 {
@@ -896,6 +964,9 @@ mymain(void)
     if (virTestRun("Storage pool start stop events ",
                    testStoragePoolStartStopEvent, &test) < 0)
         ret = EXIT_FAILURE;
+    if (virTestRun("Storage pool refresh events coalesced ",
+                   testStoragePoolRefreshCoalesce, &test) < 0)
+        ret = EXIT_FAILURE;
     /* Storage pool build and delete events */
     if (virTestRun("Storage pool build event ",
                    testStoragePoolBuild, &test) < 0)
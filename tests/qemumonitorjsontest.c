@@ -1859,6 +1859,149 @@ testQemuMonitorJSONqemuMonitorJSONGetAllBlockStatsInfo(const void *data)
 }
 
 
+/* With @reorder the replies to all but the last command are held back
+ * until the last command arrives and then sent in reverse order, which
+ * only works if the commands are all in flight at once and the replies
+ * are matched by their "id". */
+static int
+testQemuMonitorJSONGetAllBlockStatsAndCapacityCommon(virDomainXMLOptionPtr xmlopt,
+                                                     bool reorder,
+                                                     bool blockdev)
+{
+    qemuMonitorTestPtr test = qemuMonitorTestNewSimple(true, xmlopt);
+    virHashTablePtr blockstats = NULL;
+    virJSONValuePtr nodedata = NULL;
+    qemuBlockStatsPtr stats;
+    const char *name = blockdev ? "libvirt-1-format" : "virtio-disk0";
+    int ret = -1;
+
+    const char *blockstatsReply =
+        "{"
+        "    \"return\": ["
+        "        {"
+        "            \"device\": \"drive-virtio-disk0\","
+        "            \"stats\": {"
+        "                \"rd_bytes\": 28505088,"
+        "                \"wr_bytes\": 2048,"
+        "                \"rd_operations\": 1279,"
+        "                \"wr_operations\": 16"
+        "            }"
+        "        }"
+        "    ]"
+        "}";
+    const char *blockReply =
+        "{"
+        "    \"return\": ["
+        "        {"
+        "            \"device\": \"drive-virtio-disk0\","
+        "            \"inserted\": {"
+        "                \"image\": {"
+        "                    \"virtual-size\": 10737418240,"
+        "                    \"actual-size\": 1073741824"
+        "                }"
+        "            }"
+        "        }"
+        "    ]"
+        "}";
+    const char *namedNodesReply =
+        "{"
+        "    \"return\": ["
+        "        {"
+        "            \"node-name\": \"libvirt-1-format\","
+        "            \"image\": {"
+        "                \"virtual-size\": 10737418240,"
+        "                \"actual-size\": 1073741824"
+        "            }"
+        "        }"
+        "    ]"
+        "}";
+
+    if (!test)
+        return -1;
+
+    if (!(blockstats = virHashCreate(10, virHashValueFree)))
+        goto cleanup;
+
+    if ((reorder ?
+         qemuMonitorTestAddItemDeferred(test, "query-blockstats", blockstatsReply) :
+         qemuMonitorTestAddItem(test, "query-blockstats", blockstatsReply)) < 0)
+        goto cleanup;
+
+    /* with -blockdev query-named-block-nodes provides both the capacity
+     * and the node data and must not be sent twice */
+    if (!blockdev &&
+        (reorder ?
+         qemuMonitorTestAddItemDeferred(test, "query-block", blockReply) :
+         qemuMonitorTestAddItem(test, "query-block", blockReply)) < 0)
+        goto cleanup;
+
+    if (qemuMonitorTestAddItem(test, "query-named-block-nodes", namedNodesReply) < 0)
+        goto cleanup;
+
+    if (qemuMonitorJSONGetAllBlockStatsAndCapacity(qemuMonitorTestGetMonitor(test),
+                                                   blockstats, false, blockdev,
+                                                   &nodedata) < 0)
+        goto cleanup;
+
+    if (!(stats = virHashLookup(blockstats, "virtio-disk0"))) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       "block stats for device 'virtio-disk0' are missing");
+        goto cleanup;
+    }
+
+    if (stats->rd_req != 1279 || stats->rd_bytes != 28505088) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       "unexpected block stats for device 'virtio-disk0'");
+        goto cleanup;
+    }
+
+    if (!(stats = virHashLookup(blockstats, name)) ||
+        stats->capacity != 10737418240ULL || stats->physical != 1073741824ULL) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       "unexpected capacity for '%s'", name);
+        goto cleanup;
+    }
+
+    if (!nodedata || virJSONValueArraySize(nodedata) != 1) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       "query-named-block-nodes data is missing");
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    qemuMonitorTestFree(test);
+    virHashFree(blockstats);
+    virJSONValueFree(nodedata);
+    return ret;
+}
+
+
+static int
+testQemuMonitorJSONqemuMonitorJSONGetAllBlockStatsAndCapacity(const void *data)
+{
+    return testQemuMonitorJSONGetAllBlockStatsAndCapacityCommon((virDomainXMLOptionPtr)data,
+                                                                false, false);
+}
+
+
+static int
+testQemuMonitorJSONqemuMonitorJSONGetAllBlockStatsAndCapacityReorder(const void *data)
+{
+    return testQemuMonitorJSONGetAllBlockStatsAndCapacityCommon((virDomainXMLOptionPtr)data,
+                                                                true, false);
+}
+
+
+static int
+testQemuMonitorJSONqemuMonitorJSONGetAllBlockStatsAndCapacityBlockdev(const void *data)
+{
+    return testQemuMonitorJSONGetAllBlockStatsAndCapacityCommon((virDomainXMLOptionPtr)data,
+                                                                true, true);
+}
+
+
 static int
 testQemuMonitorJSONqemuMonitorJSONGetMigrationCacheSize(const void *data)
 {
@@ -3009,6 +3152,9 @@ mymain(void)
     DO_TEST(qemuMonitorJSONGetBalloonInfo);
     DO_TEST(qemuMonitorJSONGetBlockInfo);
     DO_TEST(qemuMonitorJSONGetAllBlockStatsInfo);
+    DO_TEST(qemuMonitorJSONGetAllBlockStatsAndCapacity);
+    DO_TEST(qemuMonitorJSONGetAllBlockStatsAndCapacityReorder);
+    DO_TEST(qemuMonitorJSONGetAllBlockStatsAndCapacityBlockdev);
     DO_TEST(qemuMonitorJSONGetMigrationCacheSize);
     DO_TEST(qemuMonitorJSONGetMigrationStats);
     DO_TEST(qemuMonitorJSONGetChardevInfo);
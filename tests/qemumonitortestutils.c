@@ -75,6 +75,10 @@ struct _qemuMonitorTest {
     size_t nitems;
     qemuMonitorTestItemPtr *items;
 
+    /* replies held back by qemuMonitorTestAddItemDeferred */
+    size_t ndeferred;
+    char **deferred;
+
     virDomainObjPtr vm;
     virHashTablePtr qapischema;
 };
@@ -451,6 +455,10 @@ qemuMonitorTestFree(qemuMonitorTestPtr test)
         qemuMonitorTestItemFree(test->items[i]);
     VIR_FREE(test->items);
 
+    for (i = 0; i < test->ndeferred; i++)
+        VIR_FREE(test->deferred[i]);
+    VIR_FREE(test->deferred);
+
     if (test->tmpdir && rmdir(test->tmpdir) < 0)
         VIR_WARN("Failed to remove tempdir: %s", strerror(errno));
 
@@ -514,6 +522,7 @@ struct qemuMonitorTestHandlerData {
     size_t nargs;
     qemuMonitorTestCommandArgsPtr args;
     char *expectArgs;
+    bool deferred;
 };
 
 static void
@@ -600,6 +609,58 @@ qemuMonitorTestProcessCommandDefaultValidate(qemuMonitorTestPtr test,
 }
 
 
+/* Holds back @response to the JSON command @cmd, tagged with the "id" of
+ * the command so that the monitor can still match it */
+static int
+qemuMonitorTestDeferResponse(qemuMonitorTestPtr test,
+                             virJSONValuePtr cmd,
+                             const char *response)
+{
+    virJSONValuePtr reply = NULL;
+    const char *id;
+    char *str = NULL;
+    int ret = -1;
+
+    if (!test->json ||
+        !(id = virJSONValueObjectGetString(cmd, "id")))
+        return qemuMonitorReportError(test, "deferred reply needs a command id");
+
+    if (!(reply = virJSONValueFromString(response)) ||
+        virJSONValueObjectAppendString(reply, "id", id) < 0 ||
+        !(str = virJSONValueToString(reply, false)) ||
+        VIR_APPEND_ELEMENT(test->deferred, test->ndeferred, str) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(str);
+    virJSONValueFree(reply);
+    return ret;
+}
+
+
+/* Sends the replies held back so far, newest first */
+static int
+qemuMonitorTestFlushDeferred(qemuMonitorTestPtr test)
+{
+    int ret = 0;
+
+    while (test->ndeferred > 0) {
+        char *response = test->deferred[test->ndeferred - 1];
+
+        if (ret == 0)
+            ret = qemuMonitorTestAddResponse(test, response);
+
+        VIR_FREE(response);
+        test->ndeferred--;
+    }
+
+    VIR_FREE(test->deferred);
+    return ret;
+}
+
+
 static int
 qemuMonitorTestProcessCommandDefault(qemuMonitorTestPtr test,
                                      qemuMonitorTestItemPtr item,
@@ -650,8 +711,13 @@ qemuMonitorTestProcessCommandDefault(qemuMonitorTestPtr test,
     if (data->command_name && STRNEQ(data->command_name, cmdname))
         ret = qemuMonitorTestAddInvalidCommandResponse(test, data->command_name,
                                                        cmdname);
-    else
+    else if (data->deferred)
+        ret = qemuMonitorTestDeferResponse(test, val, data->response);
+    else if (test->ndeferred == 0)
         ret = qemuMonitorTestAddResponse(test, data->response);
+    /* the reply overtakes the held back ones, so it needs an "id" too */
+    else if ((ret = qemuMonitorTestDeferResponse(test, val, data->response)) == 0)
+        ret = qemuMonitorTestFlushDeferred(test);
 
  cleanup:
     VIR_FREE(cmdcopy);
@@ -682,6 +748,42 @@ qemuMonitorTestAddItem(qemuMonitorTestPtr test,
 }
 
 
+/**
+ * qemuMonitorTestAddItemDeferred:
+ * @test: test monitor object
+ * @command_name: expected command name
+ * @response: reply to send
+ *
+ * Like qemuMonitorTestAddItem, but @response is held back until a later
+ * item added by qemuMonitorTestAddItem sends its reply. Held back replies
+ * are then sent newest first, each carrying the "id" of its command. This
+ * allows testing that several commands are in flight at once and that
+ * replies arriving out of order reach the right command.
+ */
+int
+qemuMonitorTestAddItemDeferred(qemuMonitorTestPtr test,
+                               const char *command_name,
+                               const char *response)
+{
+    struct qemuMonitorTestHandlerData *data;
+
+    if (VIR_ALLOC(data) < 0)
+        return -1;
+
+    if (VIR_STRDUP(data->command_name, command_name) < 0 ||
+        VIR_STRDUP(data->response, response) < 0) {
+        qemuMonitorTestHandlerDataFree(data);
+        return -1;
+    }
+
+    data->deferred = true;
+
+    return qemuMonitorTestAddHandler(test,
+                                     qemuMonitorTestProcessCommandDefault,
+                                     data, qemuMonitorTestHandlerDataFree);
+}
+
+
 static int
 qemuMonitorTestProcessCommandVerbatim(qemuMonitorTestPtr test,
                                       qemuMonitorTestItemPtr item,
@@ -1253,6 +1355,7 @@ qemuMonitorTestNew(bool json,
                                       json,
                                       true,
                                       0,
+                                      NULL,
                                       &qemuMonitorTestCallbacks,
                                       driver)))
         goto error;
@@ -1487,6 +1590,7 @@ qemuMonitorTestNewAgent(virDomainXMLOptionPtr xmlopt)
 
     if (!(test->agent = qemuAgentOpen(test->vm,
                                       &src,
+                                      NULL,
                                       &qemuMonitorTestAgentCallbacks)))
         goto error;
 
@@ -54,6 +54,10 @@ int qemuMonitorTestAddItem(qemuMonitorTestPtr test,
                            const char *command_name,
                            const char *response);
 
+int qemuMonitorTestAddItemDeferred(qemuMonitorTestPtr test,
+                                   const char *command_name,
+                                   const char *response);
+
 int qemuMonitorTestAddItemVerbatim(qemuMonitorTestPtr test,
                                    const char *command,
                                    const char *cmderr,
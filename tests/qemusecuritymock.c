@@ -248,8 +248,14 @@ mock_chown(const char *path,
            gid_t gid)
 {
     uint32_t *val = NULL;
+    const char *fail = getenv(FAIL_ENVVAR);
     int ret = -1;
 
+    if (fail && STREQ(path, fail)) {
+        errno = EIO;
+        return -1;
+    }
+
     if (gid >> 16 || uid >> 16) {
         fprintf(stderr, "Attempt to set too high UID or GID: %lld %lld",
                (unsigned long long) uid, (unsigned long long) gid);
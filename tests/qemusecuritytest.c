@@ -25,15 +25,34 @@
 #include "conf/domain_conf.h"
 #include "qemu/qemu_domain.h"
 #include "qemu/qemu_security.h"
+#include "viratomic.h"
+#include "virthread.h"
 
 #define VIR_FROM_THIS VIR_FROM_NONE
 
 struct testData {
     virQEMUDriverPtr driver;
     const char *file; /* file name to load VM def XML from; qemuxml2argvdata/ */
+    const char *fail; /* path whose relabel fails, if any */
+    bool chownCallback; /* use testChownCallback, without remembering */
 };
 
 
+static unsigned long long mainThread;
+static int wrongThread;
+
+static int
+testChownCallback(const virStorageSource *src ATTRIBUTE_UNUSED,
+                  uid_t uid ATTRIBUTE_UNUSED,
+                  gid_t gid ATTRIBUTE_UNUSED)
+{
+    if (virThreadSelfID() != mainThread)
+        virAtomicIntSet(&wrongThread, 1);
+
+    return 0;
+}
+
+
 static int
 prepareObjects(virQEMUDriverPtr driver,
                const char *xmlname,
@@ -112,17 +131,63 @@ testDomain(const void *opaque)
     if (setenv(ENVVAR, "1", 0) < 0)
         goto cleanup;
 
-    if (qemuSecuritySetAllLabel(data->driver, vm, NULL) < 0)
-        goto cleanup;
+    if (data->chownCallback) {
+        qemuDomainObjPrivatePtr priv = vm->privateData;
+        virSecurityManagerPtr tmp;
+
+        /* Without remembering owners, transactions run in this process
+         * and relabel paths in parallel, but the chown callback must be
+         * called from this thread only */
+        priv->rememberOwner = false;
+        if (!(securityManager = virSecurityManagerNewDAC("test", 1000, 1000,
+                                                         VIR_SECURITY_MANAGER_PRIVILEGED |
+                                                         VIR_SECURITY_MANAGER_DYNAMIC_OWNERSHIP,
+                                                         testChownCallback)))
+            goto cleanup;
+
+        tmp = data->driver->securityManager;
+        data->driver->securityManager = securityManager;
+        securityManager = tmp;
+        mainThread = virThreadSelfID();
+        virAtomicIntSet(&wrongThread, 0);
+    }
 
-    qemuSecurityRestoreAllLabel(data->driver, vm, false);
+    if (data->fail) {
+        if (setenv(FAIL_ENVVAR, data->fail, 1) < 0)
+            goto cleanup;
+
+        /* Everything relabelled before the failure must be undone */
+        if (qemuSecuritySetAllLabel(data->driver, vm, NULL) == 0) {
+            fprintf(stderr, "Relabelling %s unexpectedly succeeded\n",
+                    data->fail);
+            goto cleanup;
+        }
+        virResetLastError();
+    } else {
+        if (qemuSecuritySetAllLabel(data->driver, vm, NULL) < 0)
+            goto cleanup;
+
+        qemuSecurityRestoreAllLabel(data->driver, vm, false);
+    }
 
     if (checkPaths() < 0)
         goto cleanup;
 
+    if (virAtomicIntGet(&wrongThread)) {
+        fprintf(stderr, "Chown callback called from another thread\n");
+        goto cleanup;
+    }
+
     ret = 0;
  cleanup:
     unsetenv(ENVVAR);
+    unsetenv(FAIL_ENVVAR);
+    if (data->chownCallback && securityManager) {
+        virSecurityManagerPtr tmp = data->driver->securityManager;
+
+        data->driver->securityManager = securityManager;
+        securityManager = tmp;
+    }
     virObjectUnref(vm);
     virObjectUnref(securityManager);
     return ret;
@@ -150,18 +215,26 @@ mymain(void)
         goto cleanup;
     }
 
-#define DO_TEST_DOMAIN(f) \
+#define DO_TEST_DOMAIN_FULL(f, path, callback) \
     do { \
-        struct testData data = {.driver = &driver, .file = f}; \
+        struct testData data = {.driver = &driver, .file = f, .fail = path, \
+                                .chownCallback = callback}; \
         if (virTestRun(f, testDomain, &data) < 0) \
             ret = -1; \
     } while (0)
 
+#define DO_TEST_DOMAIN(f) DO_TEST_DOMAIN_FULL(f, NULL, false)
+#define DO_TEST_DOMAIN_FAIL(f, path) DO_TEST_DOMAIN_FULL(f, path, false)
+#define DO_TEST_DOMAIN_CALLBACK(f) DO_TEST_DOMAIN_FULL(f, NULL, true)
+
     DO_TEST_DOMAIN("disk-virtio");
     DO_TEST_DOMAIN("pci-bridge-many-disks");
     DO_TEST_DOMAIN("arm-virt-virtio");
     DO_TEST_DOMAIN("aarch64-virtio-pci-manual-addresses");
     DO_TEST_DOMAIN("acpi-table");
+    DO_TEST_DOMAIN_FAIL("pci-bridge-many-disks",
+                        "/var/lib/libvirt/images/disk-c-b.img");
+    DO_TEST_DOMAIN_CALLBACK("pci-bridge-many-disks");
 
  cleanup:
     qemuTestDriverFree(&driver);
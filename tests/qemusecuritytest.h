@@ -21,6 +21,9 @@
 
 # define ENVVAR "LIBVIRT_QEMU_SECURITY_TEST"
 
+/* chown() of the path this is set to fails */
+# define FAIL_ENVVAR "LIBVIRT_QEMU_SECURITY_TEST_FAIL"
+
 extern int checkPaths(void);
 
 #endif /* LIBVIRT_QEMUSECURITYTEST_H */
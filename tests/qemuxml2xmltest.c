@@ -12,7 +12,9 @@
 # include "internal.h"
 # include "qemu/qemu_domain_address.h"
 # include "qemu/qemu_domain.h"
+# include "qemu/qemu_migration.h"
 # include "testutilsqemu.h"
+# include "virfile.h"
 # include "virstring.h"
 
 # define VIR_FROM_THIS VIR_FROM_NONE
@@ -29,6 +31,7 @@ struct testInfo {
     char *inName;
     char *outActiveName;
     char *outInactiveName;
+    char *jobName;
 
     virBitmapPtr activeVcpus;
     bool blockjobs;
@@ -61,23 +64,29 @@ testXML2XMLInactive(const void *opaque)
 }
 
 
-static int
-testCompareStatusXMLToXMLFiles(const void *opaque)
+static virDomainObjPtr
+testStatusXMLParse(const char *path)
 {
-    const struct testInfo *data = opaque;
-    virDomainObjPtr obj = NULL;
-    char *actual = NULL;
-    int ret = -1;
+    virDomainObjPtr obj;
 
-    if (!(obj = virDomainObjParseFile(data->inName, driver.caps, driver.xmlopt,
+    if (!(obj = virDomainObjParseFile(path, driver.caps, driver.xmlopt,
                                       VIR_DOMAIN_DEF_PARSE_STATUS |
                                       VIR_DOMAIN_DEF_PARSE_ACTUAL_NET |
                                       VIR_DOMAIN_DEF_PARSE_PCI_ORIG_STATES |
                                       VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE |
-                                      VIR_DOMAIN_DEF_PARSE_ALLOW_POST_PARSE_FAIL))) {
-        VIR_TEST_DEBUG("\nfailed to parse '%s'\n", data->inName);
-        goto cleanup;
-    }
+                                      VIR_DOMAIN_DEF_PARSE_ALLOW_POST_PARSE_FAIL)))
+        VIR_TEST_DEBUG("\nfailed to parse '%s'\n", path);
+
+    return obj;
+}
+
+
+static int
+testStatusXMLCompare(virDomainObjPtr obj,
+                     const struct testInfo *data)
+{
+    char *actual = NULL;
+    int ret = -1;
 
     if (!(actual = virDomainObjFormat(driver.xmlopt, obj, NULL,
                                       VIR_DOMAIN_DEF_FORMAT_SECURE |
@@ -95,18 +104,127 @@ testCompareStatusXMLToXMLFiles(const void *opaque)
     ret = 0;
 
  cleanup:
-    virDomainObjEndAPI(&obj);
     VIR_FREE(actual);
     return ret;
 }
 
 
+static int
+testCompareStatusXMLToXMLFiles(const void *opaque)
+{
+    const struct testInfo *data = opaque;
+    virDomainObjPtr obj = NULL;
+    int ret = -1;
+
+    if (!(obj = testStatusXMLParse(data->inName)))
+        goto cleanup;
+
+    if (testStatusXMLCompare(obj, data) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    virDomainObjEndAPI(&obj);
+    return ret;
+}
+
+
+/* Puts the job file next to the status XML in the state directory and
+ * checks the job data the domain ends up with */
+static int
+testCompareStatusXMLJobToXMLFiles(const void *opaque)
+{
+    const struct testInfo *data = opaque;
+    virDomainObjPtr obj = NULL;
+    char *jobxml = NULL;
+    char *jobpath = NULL;
+    int ret = -1;
+
+    if (!(obj = testStatusXMLParse(data->inName)))
+        goto cleanup;
+
+    if (virFileReadAll(data->jobName, 1024 * 1024, &jobxml) < 0 ||
+        virAsprintf(&jobpath, "%s/%s.job",
+                    driver.config->stateDir, obj->def->name) < 0 ||
+        virFileWriteStr(jobpath, jobxml, S_IRUSR | S_IWUSR) < 0)
+        goto cleanup;
+
+    if (qemuDomainObjLoadJobStatus(&driver, obj) < 0) {
+        VIR_TEST_DEBUG("\nfailed to load '%s'\n", data->jobName);
+        goto cleanup;
+    }
+
+    if (testStatusXMLCompare(obj, data) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    if (jobpath)
+        unlink(jobpath);
+    virDomainObjEndAPI(&obj);
+    VIR_FREE(jobxml);
+    VIR_FREE(jobpath);
+    return ret;
+}
+
+
+/* A job phase change must only write the job file, not the status XML */
+static int
+testStatusXMLJobPhaseSave(const void *opaque)
+{
+    const struct testInfo *data = opaque;
+    virDomainObjPtr obj = NULL;
+    char *statuspath = NULL;
+    char *jobpath = NULL;
+    char *jobxml = NULL;
+    int ret = -1;
+
+    if (!(obj = testStatusXMLParse(data->inName)))
+        goto cleanup;
+
+    if (virAsprintf(&statuspath, "%s/%s.xml",
+                    driver.config->stateDir, obj->def->name) < 0 ||
+        virAsprintf(&jobpath, "%s/%s.job",
+                    driver.config->stateDir, obj->def->name) < 0)
+        goto cleanup;
+
+    qemuDomainObjSetJobPhase(&driver, obj, QEMU_MIGRATION_PHASE_PERFORM3);
+
+    if (virFileExists(statuspath)) {
+        VIR_TEST_DEBUG("\nstatus XML saved on job phase change\n");
+        goto cleanup;
+    }
+
+    if (virFileReadAll(jobpath, 1024 * 1024, &jobxml) < 0)
+        goto cleanup;
+
+    if (virTestCompareToFile(jobxml, data->jobName) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    if (statuspath)
+        unlink(statuspath);
+    if (jobpath)
+        unlink(jobpath);
+    virDomainObjEndAPI(&obj);
+    VIR_FREE(jobxml);
+    VIR_FREE(jobpath);
+    VIR_FREE(statuspath);
+    return ret;
+}
+
+
 static void
 testInfoClear(struct testInfo *info)
 {
     VIR_FREE(info->inName);
     VIR_FREE(info->outActiveName);
     VIR_FREE(info->outInactiveName);
+    VIR_FREE(info->jobName);
 
     virBitmapFree(info->activeVcpus);
     info->activeVcpus = NULL;
@@ -211,6 +329,141 @@ testInfoSetStatus(struct testInfo *info,
 }
 
 
+static int
+testInfoSetStatusJob(struct testInfo *info,
+                     const char *name,
+                     const char *job,
+                     const char *out)
+{
+    if (testInfoSetCommon(info, GIC_NONE) < 0)
+        return -1;
+
+    if (virAsprintf(&info->inName, "%s%s-in.xml", statusPath, name) < 0 ||
+        virAsprintf(&info->jobName, "%s%s", statusPath, job) < 0 ||
+        virAsprintf(&info->outActiveName, "%s%s", statusPath, out) < 0)
+        goto error;
+
+    return 0;
+
+ error:
+    testInfoClear(info);
+    return -1;
+}
+
+
+# define NUM_BENCH_ROUNDS 20
+
+/* Parses every domain from qemuxml2argvdata repeatedly and reports
+ * the average time needed to parse and free all of them, and the time
+ * needed to copy and free all of them. */
+static int
+testXML2XMLParseBench(const void *opaque ATTRIBUTE_UNUSED)
+{
+    const char *dirPath = abs_srcdir "/qemuxml2argvdata";
+    unsigned int parseFlags = VIR_DOMAIN_DEF_PARSE_INACTIVE;
+    DIR *dir = NULL;
+    struct dirent *ent;
+    char **docs = NULL;
+    virDomainDefPtr *defs = NULL;
+    size_t ndocs = 0;
+    size_t ndefs = 0;
+    struct timespec start, end;
+    unsigned long long elapsed;
+    size_t i, j;
+    int rc;
+    int ret = -1;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    if (virDirOpen(&dir, dirPath) < 0)
+        return -1;
+
+    while ((rc = virDirRead(dir, &ent, dirPath)) > 0) {
+        VIR_AUTOFREE(char *) path = NULL;
+        char *doc = NULL;
+        virDomainDefPtr def;
+
+        if (!virFileHasSuffix(ent->d_name, ".xml"))
+            continue;
+
+        if (virAsprintf(&path, "%s/%s", dirPath, ent->d_name) < 0 ||
+            virTestLoadFile(path, &doc) < 0)
+            goto cleanup;
+
+        /* Skip the files which are expected to fail */
+        if (!(def = virDomainDefParseString(doc, driver.caps, driver.xmlopt,
+                                            NULL, parseFlags))) {
+            virResetLastError();
+            VIR_FREE(doc);
+            continue;
+        }
+
+        if (VIR_APPEND_ELEMENT(defs, ndefs, def) < 0) {
+            virDomainDefFree(def);
+            VIR_FREE(doc);
+            goto cleanup;
+        }
+
+        if (VIR_APPEND_ELEMENT(docs, ndocs, doc) < 0) {
+            VIR_FREE(doc);
+            goto cleanup;
+        }
+    }
+    if (rc < 0)
+        goto cleanup;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NUM_BENCH_ROUNDS; i++) {
+        for (j = 0; j < ndocs; j++) {
+            virDomainDefPtr def;
+
+            if (!(def = virDomainDefParseString(docs[j], driver.caps,
+                                                driver.xmlopt, NULL,
+                                                parseFlags)))
+                goto cleanup;
+            virDomainDefFree(def);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+    VIR_TEST_VERBOSE("%llu us to parse and free %zu domains\n",
+                     elapsed / NUM_BENCH_ROUNDS / 1000, ndocs);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NUM_BENCH_ROUNDS; i++) {
+        for (j = 0; j < ndefs; j++) {
+            virDomainDefPtr def;
+
+            if (!(def = virDomainDefCopy(defs[j], driver.caps,
+                                         driver.xmlopt, NULL, false)))
+                goto cleanup;
+            virDomainDefFree(def);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+    VIR_TEST_VERBOSE("%llu us to copy and free %zu domains\n",
+                     elapsed / NUM_BENCH_ROUNDS / 1000, ndefs);
+
+    ret = 0;
+
+ cleanup:
+    for (i = 0; i < ndocs; i++)
+        VIR_FREE(docs[i]);
+    VIR_FREE(docs);
+    for (i = 0; i < ndefs; i++)
+        virDomainDefFree(defs[i]);
+    VIR_FREE(defs);
+    VIR_DIR_CLOSE(dir);
+    return ret;
+}
+
+
 # define FAKEROOTDIRTEMPLATE abs_builddir "/fakerootdir-XXXXXX"
 
 static int
@@ -1254,6 +1507,35 @@ mymain(void)
     DO_TEST_STATUS("migration-out-params");
     DO_TEST_STATUS("migration-out-nbd-tls");
     DO_TEST_STATUS("disk-secinfo-upgrade");
+    DO_TEST_STATUS("job-status");
+
+# define DO_TEST_STATUS_JOB(name, job, out) \
+    do { \
+        if (testInfoSetStatusJob(&info, name, job, out) < 0) { \
+            VIR_TEST_DEBUG("Failed to generate status test data for '%s'", name); \
+            return -1; \
+        } \
+\
+        if (virTestRun("QEMU status XML-2-XML " name " with " job, \
+                       testCompareStatusXMLJobToXMLFiles, &info) < 0) \
+            ret = -1; \
+\
+        testInfoClear(&info); \
+    } while (0)
+
+    /* the job file wins only if it is newer than the status XML */
+    DO_TEST_STATUS_JOB("job-status", "job-status-newer.job",
+                       "job-status-newer-out.xml");
+    DO_TEST_STATUS_JOB("job-status", "job-status-stale.job",
+                       "job-status-out.xml");
+
+    if (testInfoSetStatusJob(&info, "job-status", "job-status-newer.job",
+                             "job-status-newer-out.xml") < 0)
+        return -1;
+    if (virTestRun("QEMU status XML job phase save",
+                   testStatusXMLJobPhaseSave, &info) < 0)
+        ret = -1;
+    testInfoClear(&info);
 
     DO_TEST("vhost-vsock", QEMU_CAPS_DEVICE_VHOST_VSOCK);
     DO_TEST("vhost-vsock-auto", QEMU_CAPS_DEVICE_VHOST_VSOCK);
@@ -1265,6 +1547,10 @@ mymain(void)
     DO_TEST("riscv64-virt",
             QEMU_CAPS_DEVICE_VIRTIO_MMIO);
 
+    if (virTestRun("QEMU XML parse and copy benchmark",
+                   testXML2XMLParseBench, NULL) < 0)
+        ret = -1;
+
     if (getenv("LIBVIRT_SKIP_CLEANUP") == NULL)
         virFileDeleteTree(fakerootdir);
 
@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library;  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#ifdef WITH_TEST
+
+/* The daemon side of the connection runs the real dispatcher of
+ * libvirtd, in process, on top of the test driver. */
+# include "remote/remote_daemon_dispatch.c"
+
+# include "virtime.h"
+
+virNetServerProgramPtr remoteProgram;
+virNetServerProgramPtr qemuProgram;
+
+/* "test" is defined and running in test:///default */
+static const char testUUID[] = "6695eb01-f6a4-8304-79aa-97f2502e193f";
+static const char missingUUID[] = "b5d4c1d0-7e0f-4a46-a1b5-2b4ba1fd1e41";
+
+struct testAsyncData {
+    virMutex lock;
+    virCond cond;
+    size_t ndone;  /* callbacks called */
+    size_t nfreed; /* @freecb called */
+
+    /* result of the last callback */
+    char *name;
+    int nstats;
+    int state;
+    int error;
+};
+
+struct testAsyncInfo {
+    virConnectPtr conn;
+    virDomainPtr dom;
+    struct testAsyncData *data;
+};
+
+
+static void
+testAsyncDataReset(struct testAsyncData *data)
+{
+    data->ndone = data->nfreed = 0;
+    VIR_FREE(data->name);
+    data->nstats = -1;
+    data->state = -1;
+    data->error = VIR_ERR_OK;
+}
+
+
+static void
+testAsyncFree(void *opaque)
+{
+    struct testAsyncData *data = opaque;
+
+    virMutexLock(&data->lock);
+    data->nfreed++;
+    virCondSignal(&data->cond);
+    virMutexUnlock(&data->lock);
+}
+
+
+static void
+testAsyncLookupDone(virConnectPtr conn ATTRIBUTE_UNUSED,
+                    virDomainPtr dom,
+                    void *opaque)
+{
+    struct testAsyncData *data = opaque;
+
+    virMutexLock(&data->lock);
+    VIR_FREE(data->name);
+    if (dom)
+        ignore_value(VIR_STRDUP_QUIET(data->name, virDomainGetName(dom)));
+    else
+        data->error = virGetLastErrorCode();
+    data->ndone++;
+    virMutexUnlock(&data->lock);
+}
+
+
+static void
+testAsyncStatsDone(virConnectPtr conn ATTRIBUTE_UNUSED,
+                   virDomainStatsRecordPtr *stats,
+                   int nstats,
+                   void *opaque)
+{
+    struct testAsyncData *data = opaque;
+
+    virMutexLock(&data->lock);
+    VIR_FREE(data->name);
+    data->nstats = nstats;
+    if (nstats > 0) {
+        ignore_value(VIR_STRDUP_QUIET(data->name,
+                                      virDomainGetName(stats[0]->dom)));
+        ignore_value(virTypedParamsGetInt(stats[0]->params,
+                                          stats[0]->nparams,
+                                          "state.state", &data->state));
+    } else if (nstats < 0) {
+        data->error = virGetLastErrorCode();
+    }
+    data->ndone++;
+    virMutexUnlock(&data->lock);
+}
+
+
+/* Wait until @n calls completed and freed their opaque data */
+static int
+testAsyncWait(struct testAsyncData *data,
+              size_t n)
+{
+    unsigned long long deadline;
+    int ret = 0;
+
+    if (virTimeMillisNow(&deadline) < 0)
+        return -1;
+    deadline += 10 * 1000;
+
+    virMutexLock(&data->lock);
+    while (data->nfreed < n) {
+        if (virCondWaitUntil(&data->cond, &data->lock, deadline) < 0) {
+            VIR_TEST_DEBUG("Timed out after %zu of %zu calls", data->nfreed, n);
+            ret = -1;
+            break;
+        }
+    }
+    if (ret == 0 && data->ndone != n) {
+        VIR_TEST_DEBUG("Callback called %zu times, expected %zu",
+                       data->ndone, n);
+        ret = -1;
+    }
+    virMutexUnlock(&data->lock);
+
+    return ret;
+}
+
+
+static int
+testAsyncLookup(struct testAsyncData *data,
+                virConnectPtr conn,
+                const char *uuidstr,
+                const char *name,
+                int error)
+{
+    unsigned char uuid[VIR_UUID_BUFLEN];
+
+    testAsyncDataReset(data);
+
+    if (virUUIDParse(uuidstr, uuid) < 0 ||
+        virDomainLookupByUUIDAsync(conn, uuid, testAsyncLookupDone,
+                                   data, testAsyncFree, 0) < 0 ||
+        testAsyncWait(data, 1) < 0)
+        return -1;
+
+    if (STRNEQ_NULLABLE(data->name, name) || data->error != error) {
+        VIR_TEST_DEBUG("Expected domain '%s' error %d, got '%s' error %d",
+                       NULLSTR(name), error, NULLSTR(data->name), data->error);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testLookupByUUID(const void *opaque)
+{
+    const struct testAsyncInfo *info = opaque;
+    struct testAsyncData *data = info->data;
+
+    return testAsyncLookup(data, info->conn, testUUID, "test", VIR_ERR_OK);
+}
+
+
+static int
+testLookupByUUIDMissing(const void *opaque)
+{
+    const struct testAsyncInfo *info = opaque;
+    struct testAsyncData *data = info->data;
+
+    return testAsyncLookup(data, info->conn, missingUUID, NULL,
+                           VIR_ERR_NO_DOMAIN);
+}
+
+
+static int
+testLookupByUUIDFlags(const void *opaque)
+{
+    const struct testAsyncInfo *info = opaque;
+    struct testAsyncData *data = info->data;
+    unsigned char uuid[VIR_UUID_BUFLEN];
+
+    testAsyncDataReset(data);
+
+    if (virUUIDParse(testUUID, uuid) < 0)
+        return -1;
+
+    if (virDomainLookupByUUIDAsync(info->conn, uuid, testAsyncLookupDone,
+                                   data, testAsyncFree, 1) != -1) {
+        VIR_TEST_DEBUG("Unknown flags were accepted");
+        return -1;
+    }
+
+    /* neither callback may run for a call which failed to start */
+    if (data->ndone || data->nfreed)
+        return -1;
+
+    return 0;
+}
+
+
+/* Start several lookups before waiting for any of them */
+static int
+testLookupByUUIDPipelined(const void *opaque)
+{
+    const struct testAsyncInfo *info = opaque;
+    struct testAsyncData *data = info->data;
+    unsigned char uuid[VIR_UUID_BUFLEN];
+    size_t ncalls = 8;
+    size_t i;
+
+    testAsyncDataReset(data);
+
+    if (virUUIDParse(testUUID, uuid) < 0)
+        return -1;
+
+    for (i = 0; i < ncalls; i++) {
+        if (virDomainLookupByUUIDAsync(info->conn, uuid, testAsyncLookupDone,
+                                       data, testAsyncFree, 0) < 0)
+            return -1;
+    }
+
+    if (testAsyncWait(data, ncalls) < 0 ||
+        STRNEQ_NULLABLE(data->name, "test"))
+        return -1;
+
+    return 0;
+}
+
+
+static int
+testAsyncCheckStats(struct testAsyncData *data)
+{
+    if (testAsyncWait(data, 1) < 0)
+        return -1;
+
+    if (data->nstats != 1 || STRNEQ_NULLABLE(data->name, "test") ||
+        data->state != VIR_DOMAIN_RUNNING) {
+        VIR_TEST_DEBUG("Got %d records, domain '%s' in state %d",
+                       data->nstats, NULLSTR(data->name), data->state);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testGetAllDomainStats(const void *opaque)
+{
+    const struct testAsyncInfo *info = opaque;
+    struct testAsyncData *data = info->data;
+
+    testAsyncDataReset(data);
+
+    if (virConnectGetAllDomainStatsAsync(info->conn, VIR_DOMAIN_STATS_STATE,
+                                         0, testAsyncStatsDone,
+                                         data, testAsyncFree) < 0)
+        return -1;
+
+    return testAsyncCheckStats(data);
+}
+
+
+static int
+testGetAllDomainStatsError(const void *opaque)
+{
+    const struct testAsyncInfo *info = opaque;
+    struct testAsyncData *data = info->data;
+
+    testAsyncDataReset(data);
+
+    /* The test driver knows nothing but the state, an error raised by
+     * the daemon reaches the callback */
+    if (virConnectGetAllDomainStatsAsync(info->conn,
+                                         VIR_DOMAIN_STATS_CPU_TOTAL,
+                                         VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS,
+                                         testAsyncStatsDone,
+                                         data, testAsyncFree) < 0 ||
+        testAsyncWait(data, 1) < 0)
+        return -1;
+
+    if (data->nstats != -1 || data->error != VIR_ERR_ARGUMENT_UNSUPPORTED) {
+        VIR_TEST_DEBUG("Expected failure, got %d records, error %d",
+                       data->nstats, data->error);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testListGetStats(const void *opaque)
+{
+    const struct testAsyncInfo *info = opaque;
+    struct testAsyncData *data = info->data;
+    virDomainPtr doms[] = { info->dom, NULL };
+
+    testAsyncDataReset(data);
+
+    if (virDomainListGetStatsAsync(doms, VIR_DOMAIN_STATS_STATE, 0,
+                                   testAsyncStatsDone,
+                                   data, testAsyncFree) < 0)
+        return -1;
+
+    return testAsyncCheckStats(data);
+}
+
+
+static bool quit;
+
+static void
+testEventLoop(void *opaque ATTRIBUTE_UNUSED)
+{
+    while (!quit)
+        virEventRunDefaultImpl();
+}
+
+
+static void
+testEventLoopWakeup(int timer ATTRIBUTE_UNUSED,
+                    void *opaque ATTRIBUTE_UNUSED)
+{
+}
+
+
+static virNetServerPtr
+testServerNew(const char *path)
+{
+    virNetServerPtr srv;
+    virNetServerServicePtr svc = NULL;
+
+    if (!(srv = virNetServerNew("libvirtd", 1, 1, 2, 0, 10, 10, -1, 0,
+                                NULL, remoteClientNew, NULL,
+                                remoteClientFree, NULL)))
+        return NULL;
+
+    if (!(svc = virNetServerServiceNewUNIX(path, 0700, getegid(),
+                                           REMOTE_AUTH_NONE, NULL,
+                                           false, 5, 5)) ||
+        virNetServerAddService(srv, svc, NULL) < 0)
+        goto error;
+
+    if (!(remoteProgram = virNetServerProgramNew(REMOTE_PROGRAM,
+                                                 REMOTE_PROTOCOL_VERSION,
+                                                 remoteProcs,
+                                                 remoteNProcs)) ||
+        virNetServerAddProgram(srv, remoteProgram) < 0)
+        goto error;
+
+    virNetServerUpdateServices(srv, true);
+    virObjectUnref(svc);
+    return srv;
+
+ error:
+    virObjectUnref(svc);
+    virNetServerClose(srv);
+    virObjectUnref(srv);
+    return NULL;
+}
+
+
+static int
+mymain(void)
+{
+    struct testAsyncData data;
+    struct testAsyncInfo info = { NULL, NULL, &data };
+    virNetServerPtr srv = NULL;
+    virThread loop;
+    bool haveLoop = false;
+    int timer = -1;
+    char template[] = "/tmp/libvirt_XXXXXX";
+    char *tmpdir = NULL;
+    char *path = NULL;
+    char *uri = NULL;
+    int ret = EXIT_FAILURE;
+
+    memset(&data, 0, sizeof(data));
+    if (virMutexInit(&data.lock) < 0 || virCondInit(&data.cond) < 0)
+        return EXIT_FAILURE;
+
+    if (virEventRegisterDefaultImpl() < 0)
+        goto cleanup;
+
+    if (!(tmpdir = mkdtemp(template))) {
+        VIR_TEST_DEBUG("Failed to create temporary directory");
+        goto cleanup;
+    }
+
+    if (virAsprintf(&path, "%s/libvirt-sock", tmpdir) < 0 ||
+        virAsprintf(&uri, "test+unix:///default?socket=%s", path) < 0)
+        goto cleanup;
+
+    if (!(srv = testServerNew(path)))
+        goto cleanup;
+
+    if ((timer = virEventAddTimeout(-1, testEventLoopWakeup,
+                                    NULL, NULL)) < 0 ||
+        virThreadCreate(&loop, true, testEventLoop, NULL) < 0)
+        goto cleanup;
+    haveLoop = true;
+
+    if (!(info.conn = virConnectOpen(uri)) ||
+        !(info.dom = virDomainLookupByName(info.conn, "test")))
+        goto cleanup;
+
+    virTestQuiesceLibvirtErrors(false);
+
+    ret = EXIT_SUCCESS;
+
+# define DO_TEST(name, func) \
+    do { \
+        if (virTestRun(name, func, &info) < 0) \
+            ret = EXIT_FAILURE; \
+    } while (0)
+
+    DO_TEST("Lookup by UUID", testLookupByUUID);
+    DO_TEST("Lookup by UUID missing", testLookupByUUIDMissing);
+    DO_TEST("Lookup by UUID flags", testLookupByUUIDFlags);
+    DO_TEST("Lookup by UUID pipelined", testLookupByUUIDPipelined);
+    DO_TEST("Get all domain stats", testGetAllDomainStats);
+    DO_TEST("Get all domain stats error", testGetAllDomainStatsError);
+    DO_TEST("List get stats", testListGetStats);
+
+# undef DO_TEST
+
+ cleanup:
+    if (info.dom)
+        virDomainFree(info.dom);
+    if (info.conn)
+        virConnectClose(info.conn);
+    if (srv)
+        virNetServerClose(srv);
+    if (haveLoop) {
+        quit = true;
+        virEventUpdateTimeout(timer, 0);
+        virThreadJoin(&loop);
+    }
+    if (timer >= 0)
+        virEventRemoveTimeout(timer);
+    virObjectUnref(remoteProgram);
+    virObjectUnref(srv);
+    if (tmpdir)
+        virFileDeleteTree(tmpdir);
+    VIR_FREE(uri);
+    VIR_FREE(path);
+    testAsyncDataReset(&data);
+    virCondDestroy(&data.cond);
+    virMutexDestroy(&data.lock);
+    return ret;
+}
+
+#else
+
+static int
+mymain(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif
+
+VIR_TEST_MAIN(mymain)
@@ -291,10 +291,16 @@ testSELinuxCheckLabels(testSELinuxFile *files, size_t nfiles)
     return 0;
 }
 
+struct testSELinuxLabelingData {
+    const char *name;
+    bool transaction; /* relabel in a transaction, run in this process */
+};
+
 static int
 testSELinuxLabeling(const void *opaque)
 {
-    const char *testname = opaque;
+    const struct testSELinuxLabelingData *data = opaque;
+    const char *testname = data->name;
     int ret = -1;
     testSELinuxFile *files = NULL;
     size_t nfiles = 0;
@@ -310,15 +316,24 @@ testSELinuxLabeling(const void *opaque)
     if (!(def = testSELinuxLoadDef(testname)))
         goto cleanup;
 
+    if (data->transaction &&
+        virSecurityManagerTransactionStart(mgr) < 0)
+        goto cleanup;
+
     if (virSecurityManagerSetAllLabel(mgr, def, NULL, false) < 0)
         goto cleanup;
 
+    if (data->transaction &&
+        virSecurityManagerTransactionCommit(mgr, -1, false) < 0)
+        goto cleanup;
+
     if (testSELinuxCheckLabels(files, nfiles) < 0)
         goto cleanup;
 
     ret = 0;
 
  cleanup:
+    virSecurityManagerTransactionAbort(mgr);
     if (testSELinuxDeleteDisks(files, nfiles) < 0)
         VIR_WARN("unable to fully clean up");
 
@@ -357,9 +372,19 @@ mymain(void)
     if (qemuTestDriverInit(&driver) < 0)
         return EXIT_FAILURE;
 
+#define DO_TEST_LABELING_FULL(name, transaction) \
+    do { \
+        struct testSELinuxLabelingData data = { name, transaction }; \
+        if (virTestRun("Labelling " # name " " # transaction, \
+                       testSELinuxLabeling, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
 #define DO_TEST_LABELING(name) \
-    if (virTestRun("Labelling " # name, testSELinuxLabeling, name) < 0) \
-        ret = -1;
+    do { \
+        DO_TEST_LABELING_FULL(name, false); \
+        DO_TEST_LABELING_FULL(name, true); \
+    } while (0)
 
     setcon((security_context_t)"system_r:system_u:libvirtd_t:s0:c0.c1023");
 
@@ -367,6 +392,7 @@ mymain(void)
     DO_TEST_LABELING("kernel");
     DO_TEST_LABELING("chardev");
     DO_TEST_LABELING("nfs");
+    DO_TEST_LABELING("many-disks");
 
     qemuTestDriverFree(&driver);
 
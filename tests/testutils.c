@@ -1300,9 +1300,11 @@ testCompareDomXML2XMLFiles(virCapsPtr caps, virDomainXMLOptionPtr xmlopt,
                            testCompareDomXML2XMLResult expectResult)
 {
     char *actual = NULL;
+    char *copyActual = NULL;
     int ret = -1;
     testCompareDomXML2XMLResult result;
     virDomainDefPtr def = NULL;
+    virDomainDefPtr copy = NULL;
     unsigned int parse_flags = live ? 0 : VIR_DOMAIN_DEF_PARSE_INACTIVE;
     unsigned int format_flags = VIR_DOMAIN_DEF_FORMAT_SECURE;
 
@@ -1337,6 +1339,20 @@ testCompareDomXML2XMLFiles(virCapsPtr caps, virDomainXMLOptionPtr xmlopt,
         goto out;
     }
 
+    /* A copy of the definition has to format identically */
+    if (!(copy = virDomainDefCopy(def, caps, xmlopt, NULL, false)) ||
+        !(copyActual = virDomainDefFormat(copy, caps, format_flags))) {
+        result = TEST_COMPARE_DOM_XML2XML_RESULT_FAIL_COPY;
+        goto out;
+    }
+
+    if (STRNEQ(actual, copyActual)) {
+        virTestDifferenceFullNoRegenerate(stderr, actual, outfile,
+                                          copyActual, NULL);
+        result = TEST_COMPARE_DOM_XML2XML_RESULT_FAIL_COPY;
+        goto out;
+    }
+
     result = TEST_COMPARE_DOM_XML2XML_RESULT_SUCCESS;
 
  out:
@@ -1353,7 +1369,9 @@ testCompareDomXML2XMLFiles(virCapsPtr caps, virDomainXMLOptionPtr xmlopt,
     }
 
     VIR_FREE(actual);
+    VIR_FREE(copyActual);
     virDomainDefFree(def);
+    virDomainDefFree(copy);
     return ret;
 }
 
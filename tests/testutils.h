@@ -154,6 +154,7 @@ typedef enum {
     TEST_COMPARE_DOM_XML2XML_RESULT_FAIL_STABILITY,
     TEST_COMPARE_DOM_XML2XML_RESULT_FAIL_FORMAT,
     TEST_COMPARE_DOM_XML2XML_RESULT_FAIL_COMPARE,
+    TEST_COMPARE_DOM_XML2XML_RESULT_FAIL_COPY,
 } testCompareDomXML2XMLResult;
 
 int testCompareDomXML2XMLFiles(virCapsPtr caps,
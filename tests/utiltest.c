@@ -1,10 +1,15 @@
 #include <config.h>
 
+#include <time.h>
 #include <unistd.h>
 
 #include "internal.h"
 #include "viralloc.h"
+#include "viratomic.h"
 #include "testutils.h"
+#include "virfile.h"
+#include "virprocstat.h"
+#include "virthread.h"
 #include "virutil.h"
 
 static const char* diskNames[] = {
@@ -254,6 +259,179 @@ testOverflowCheckMacro(const void *data ATTRIBUTE_UNUSED)
 }
 
 
+#ifdef __linux__
+static int
+testProcStat(const void *data ATTRIBUTE_UNUSED)
+{
+    virProcStatCollectorPtr cached = NULL;
+    virProcStatCollectorPtr uncached = NULL;
+    pid_t pid = getpid();
+    pid_t tid = virThreadSelfID();
+    unsigned long long before, after, fresh, wait;
+    volatile unsigned long long spin;
+    size_t i;
+    int cpu = -1;
+    long rss = 0;
+    int ret = -1;
+
+    if (!(cached = virProcStatCollectorNew(true)) ||
+        !(uncached = virProcStatCollectorNew(false)))
+        goto cleanup;
+
+    if (virProcStatCollectorGetStat(cached, pid, tid, &before, &cpu, NULL) < 0 ||
+        virProcStatCollectorGetStat(cached, pid, 0, NULL, NULL, &rss) < 0 ||
+        virProcStatCollectorGetSchedWait(cached, pid, tid, &wait) < 0)
+        goto cleanup;
+
+    if (cpu < 0 || rss <= 0) {
+        fprintf(stderr, "unexpected cpu %d rss %ld\n", cpu, rss);
+        goto cleanup;
+    }
+
+    /* Burn enough CPU for a few clock ticks to show it */
+    for (i = 0; i < 1000; i++) {
+        for (spin = 0; spin < 1000 * 1000; spin++)
+            ;
+        if (virProcStatCollectorGetStat(uncached, pid, tid,
+                                        &fresh, NULL, NULL) < 0)
+            goto cleanup;
+        if (fresh >= before + 50 * 1000 * 1000)
+            break;
+    }
+
+    /* Data read through the open file must not be stale */
+    if (virProcStatCollectorGetStat(cached, pid, tid, &after, NULL, NULL) < 0 ||
+        virProcStatCollectorGetStat(uncached, pid, tid, &fresh, NULL, NULL) < 0)
+        goto cleanup;
+
+    if (after <= before || after > fresh) {
+        fprintf(stderr, "cpu time before %llu after %llu fresh %llu\n",
+                before, after, fresh);
+        goto cleanup;
+    }
+
+    virProcStatCollectorForgetProcess(cached, pid);
+
+    if (virProcStatCollectorGetStat(cached, pid, 1, NULL, NULL, NULL) == 0) {
+        fprintf(stderr, "read status of a thread which does not exist\n");
+        goto cleanup;
+    }
+    virResetLastError();
+
+    ret = 0;
+ cleanup:
+    virObjectUnref(cached);
+    virObjectUnref(uncached);
+    return ret;
+}
+
+
+# define NUM_PROC_STAT_THREADS 500
+# define NUM_PROC_STAT_ROUNDS 20
+
+struct testProcStatThread {
+    int fd;
+    pid_t tid;
+};
+
+static void
+testProcStatThreadFunc(void *opaque)
+{
+    struct testProcStatThread *data = opaque;
+    char c;
+
+    virAtomicIntSet(&data->tid, virThreadSelfID());
+
+    /* Stay around until the write end of the pipe is closed */
+    ignore_value(saferead(data->fd, &c, 1));
+}
+
+static int
+testProcStatBenchRun(virProcStatCollectorPtr stats,
+                     struct testProcStatThread *threads,
+                     unsigned long long *elapsed)
+{
+    struct timespec start, end;
+    unsigned long long val;
+    pid_t pid = getpid();
+    size_t i, j;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NUM_PROC_STAT_ROUNDS; i++) {
+        for (j = 0; j < NUM_PROC_STAT_THREADS; j++) {
+            if (virProcStatCollectorGetStat(stats, pid, threads[j].tid,
+                                            &val, NULL, NULL) < 0 ||
+                virProcStatCollectorGetSchedWait(stats, pid, threads[j].tid,
+                                                 &val) < 0)
+                return -1;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+    return 0;
+}
+
+static int
+testProcStatBench(const void *data ATTRIBUTE_UNUSED)
+{
+    struct testProcStatThread threads[NUM_PROC_STAT_THREADS];
+    virThread handles[NUM_PROC_STAT_THREADS];
+    virProcStatCollectorPtr cached = NULL;
+    virProcStatCollectorPtr uncached = NULL;
+    unsigned long long cachedTime, uncachedTime;
+    int fds[2] = { -1, -1 };
+    size_t nthreads = 0;
+    size_t i;
+    int ret = -1;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    if (pipe(fds) < 0)
+        return -1;
+
+    for (nthreads = 0; nthreads < NUM_PROC_STAT_THREADS; nthreads++) {
+        threads[nthreads].fd = fds[0];
+        threads[nthreads].tid = 0;
+        if (virThreadCreate(&handles[nthreads], true,
+                            testProcStatThreadFunc, &threads[nthreads]) < 0)
+            goto cleanup;
+    }
+
+    for (i = 0; i < nthreads; i++) {
+        while (virAtomicIntGet(&threads[i].tid) == 0)
+            usleep(1000);
+    }
+
+    if (!(cached = virProcStatCollectorNew(true)) ||
+        !(uncached = virProcStatCollectorNew(false)))
+        goto cleanup;
+
+    /* The first round opens the files */
+    if (testProcStatBenchRun(cached, threads, &cachedTime) < 0 ||
+        testProcStatBenchRun(cached, threads, &cachedTime) < 0 ||
+        testProcStatBenchRun(uncached, threads, &uncachedTime) < 0)
+        goto cleanup;
+
+    VIR_TEST_VERBOSE("%d threads: %llu us per poll with files kept open, "
+                     "%llu us reopening them\n",
+                     NUM_PROC_STAT_THREADS,
+                     cachedTime / NUM_PROC_STAT_ROUNDS / 1000,
+                     uncachedTime / NUM_PROC_STAT_ROUNDS / 1000);
+
+    ret = 0;
+ cleanup:
+    VIR_FORCE_CLOSE(fds[1]);
+    for (i = 0; i < nthreads; i++)
+        virThreadJoin(&handles[i]);
+    VIR_FORCE_CLOSE(fds[0]);
+    virObjectUnref(cached);
+    virObjectUnref(uncached);
+    return ret;
+}
+#endif /* __linux__ */
 
 
 static int
@@ -277,6 +455,10 @@ mymain(void)
     DO_TEST(ParseVersionString);
     DO_TEST(RoundValueToPowerOfTwo);
     DO_TEST(OverflowCheckMacro);
+#ifdef __linux__
+    DO_TEST(ProcStat);
+    DO_TEST(ProcStatBench);
+#endif
 
     return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -801,6 +801,52 @@ static int testCgroupGetMemoryUsage(const void *args ATTRIBUTE_UNUSED)
 }
 
 
+static int
+testCgroupGetValueCached(const void *args ATTRIBUTE_UNUSED)
+{
+    virCgroupPtr cgroup = NULL;
+    char *path = NULL;
+    int rv, ret = -1;
+    unsigned long kb;
+
+    if ((rv = virCgroupNewPartition("/virtualmachines", true,
+                                    (1 << VIR_CGROUP_CONTROLLER_MEMORY),
+                                    &cgroup)) < 0) {
+        fprintf(stderr, "Could not create /virtualmachines cgroup: %d\n", -rv);
+        goto cleanup;
+    }
+
+    if (virCgroupPathOfController(cgroup, VIR_CGROUP_CONTROLLER_MEMORY,
+                                  "memory.usage_in_bytes", &path) < 0)
+        goto cleanup;
+
+    /* The first read leaves the file open, the following ones must
+     * still see what is written to it in the meantime */
+    if (virCgroupGetMemoryUsage(cgroup, &kb) < 0 ||
+        virFileWriteStr(path, "2048\n", 0) < 0 ||
+        virCgroupGetMemoryUsage(cgroup, &kb) < 0) {
+        fprintf(stderr, "Could not read memory usage twice\n");
+        goto cleanup;
+    }
+
+    if (kb != 2UL) {
+        fprintf(stderr,
+                "Stale value from virCgroupGetMemoryUsage: %lu\n", kb);
+        goto cleanup;
+    }
+
+    if (virFileWriteStr(path, "1455321088\n", 0) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    VIR_FREE(path);
+    virCgroupFree(&cgroup);
+    return ret;
+}
+
+
 static int
 testCgroupGetMemoryStat(const void *args ATTRIBUTE_UNUSED)
 {
@@ -1097,6 +1143,9 @@ mymain(void)
     if (virTestRun("virCgroupGetMemoryStat works", testCgroupGetMemoryStat, NULL) < 0)
         ret = -1;
 
+    if (virTestRun("virCgroupGetValueStr rereads open files", testCgroupGetValueCached, NULL) < 0)
+        ret = -1;
+
     if (virTestRun("virCgroupGetPercpuStats works", testCgroupGetPercpuStats, NULL) < 0)
         ret = -1;
     cleanupFakeFS(fakerootdir);
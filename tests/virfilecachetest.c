@@ -23,6 +23,8 @@
 
 #include "virfile.h"
 #include "virfilecache.h"
+#include "virthread.h"
+#include "virtime.h"
 
 
 #define VIR_FROM_THIS VIR_FROM_NONE
@@ -86,6 +88,13 @@ struct _testFileCachePriv {
     bool dataSaved;
     const char *newData;
     const char *expectData;
+
+    /* Makes creating data wait until it was created this many times */
+    size_t waitCreated;
+    size_t created;
+    bool timedOut;
+    virMutex lock;
+    virCond cond;
 };
 typedef struct _testFileCachePriv testFileCachePriv;
 typedef testFileCachePriv *testFileCachePrivPtr;
@@ -107,6 +116,24 @@ testFileCacheNewData(const char *name ATTRIBUTE_UNUSED,
                      void *priv)
 {
     testFileCachePrivPtr testPriv = priv;
+    unsigned long long then;
+
+    if (testPriv->waitCreated) {
+        if (virTimeMillisNow(&then) < 0)
+            return NULL;
+        then += 10 * 1000;
+
+        virMutexLock(&testPriv->lock);
+        testPriv->created++;
+        virCondBroadcast(&testPriv->cond);
+        while (testPriv->created < testPriv->waitCreated) {
+            if (virCondWaitUntil(&testPriv->cond, &testPriv->lock, then) < 0) {
+                testPriv->timedOut = true;
+                break;
+            }
+        }
+        virMutexUnlock(&testPriv->lock);
+    }
 
     return testFileCacheObjNew(testPriv->newData);
 }
@@ -200,6 +227,89 @@ testFileCache(const void *opaque)
 }
 
 
+struct _testFileCacheThread {
+    virFileCachePtr cache;
+    const char *name;
+    testFileCacheObjPtr obj;
+    virThread thread;
+};
+typedef struct _testFileCacheThread testFileCacheThread;
+
+
+static void
+testFileCacheLookupThread(void *opaque)
+{
+    testFileCacheThread *data = opaque;
+
+    data->obj = virFileCacheLookup(data->cache, data->name);
+}
+
+
+static int
+testFileCacheConcurrent(const void *opaque)
+{
+    virFileCachePtr cache = (virFileCachePtr) opaque;
+    testFileCachePrivPtr testPriv = virFileCacheGetPriv(cache);
+    testFileCacheThread threads[] = {
+        { .name = "concurrent1" },
+        { .name = "concurrent2" },
+        { .name = "concurrent3" },
+        { .name = "concurrent1" },
+    };
+    size_t i;
+    int ret = -1;
+
+    testPriv->newData = "ddd\n";
+    testPriv->expectData = "ddd\n";
+    testPriv->created = 0;
+    testPriv->timedOut = false;
+    testPriv->waitCreated = 3;
+
+    for (i = 0; i < ARRAY_CARDINALITY(threads); i++) {
+        threads[i].cache = cache;
+        if (virThreadCreate(&threads[i].thread, true,
+                            testFileCacheLookupThread, &threads[i]) < 0) {
+            while (i-- > 0)
+                virThreadJoin(&threads[i].thread);
+            goto cleanup;
+        }
+    }
+
+    for (i = 0; i < ARRAY_CARDINALITY(threads); i++)
+        virThreadJoin(&threads[i].thread);
+
+    for (i = 0; i < ARRAY_CARDINALITY(threads); i++) {
+        if (!threads[i].obj) {
+            fprintf(stderr, "Getting cached data for '%s' failed.\n",
+                    threads[i].name);
+            goto cleanup;
+        }
+    }
+
+    /* Data for different names is created at the same time, the second
+     * lookup of the same name waits for the data created by the first */
+    if (testPriv->timedOut || testPriv->created != 3) {
+        fprintf(stderr, "Expected data created 3 times at once, "
+                "created %zu times%s.\n", testPriv->created,
+                testPriv->timedOut ? " one after another" : "");
+        goto cleanup;
+    }
+
+    if (threads[0].obj != threads[3].obj) {
+        fprintf(stderr, "Expected the same data for the same name.\n");
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    testPriv->waitCreated = 0;
+    for (i = 0; i < ARRAY_CARDINALITY(threads); i++)
+        virObjectUnref(threads[i].obj);
+    return ret;
+}
+
+
 static int
 mymain(void)
 {
@@ -207,6 +317,10 @@ mymain(void)
     testFileCachePriv testPriv = {0};
     virFileCachePtr cache = NULL;
 
+    if (virMutexInit(&testPriv.lock) < 0 ||
+        virCondInit(&testPriv.cond) < 0)
+        return EXIT_FAILURE;
+
     if (!(cache = virFileCacheNew(abs_srcdir "/virfilecachedata",
                                   "cache", &testFileCacheHandlers)))
         return EXIT_FAILURE;
@@ -228,7 +342,12 @@ mymain(void)
     TEST_RUN("cacheInvalid", "bbb\n", "bbb\n", true);
     TEST_RUN("cacheMissing", "ccc\n", "ccc\n", true);
 
+    if (virTestRun("cacheConcurrent", testFileCacheConcurrent, cache) < 0)
+        ret = -1;
+
     virObjectUnref(cache);
+    virMutexDestroy(&testPriv.lock);
+    virCondDestroy(&testPriv.cond);
 
     return ret != 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -308,6 +308,218 @@ testFileInData(const void *opaque)
 }
 
 
+struct testFileDataIsZero {
+    size_t len;     /* length of the buffer */
+    ssize_t nonzero; /* offset of a non-zero byte, or -1 */
+};
+
+
+static int
+testFileDataIsZero(const void *opaque)
+{
+    const struct testFileDataIsZero *data = opaque;
+    VIR_AUTOFREE(char *) buf = NULL;
+    bool expected = data->nonzero < 0;
+    bool actual;
+
+    /* one extra byte past the end must not be looked at */
+    if (VIR_ALLOC_N(buf, data->len + 1) < 0)
+        return -1;
+
+    if (data->nonzero >= 0)
+        buf[data->nonzero] = 0x42;
+    buf[data->len] = 0x42;
+
+    actual = virFileDataIsZero(buf, data->len);
+
+    if (actual != expected) {
+        fprintf(stderr, "Unexpected result for len=%zu nonzero=%zd: "
+                "expected %d got %d\n",
+                data->len, data->nonzero, expected, actual);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+#define IOHELPER_CHUNK (1024 * 1024)
+
+/* Creates an empty file and returns it opened with @oflags */
+static int
+testFileWrapperFdCreate(char *path, int oflags)
+{
+    int fd;
+
+    if ((fd = mkstemp(path)) < 0) {
+        fprintf(stderr, "unable to create %s (errno=%d)\n", path, errno);
+        return -1;
+    }
+    VIR_FORCE_CLOSE(fd);
+
+    if ((fd = open(path, oflags | O_CLOEXEC)) < 0) {
+        fprintf(stderr, "unable to open %s (errno=%d)\n", path, errno);
+        unlink(path);
+    }
+
+    return fd;
+}
+
+
+/* Saves chunks of data and zeros through iohelper and checks that
+ * the zeros didn't get written */
+static int
+testFileWrapperFdSparse(const void *opaque ATTRIBUTE_UNUSED)
+{
+    const bool zero[] = { false, true, true, false, true };
+    char path[] = abs_builddir "/fileWrapperFd.XXXXXX";
+    VIR_AUTOFREE(char *) buf = NULL;
+    virFileWrapperFdPtr wfd = NULL;
+    struct stat sb;
+    int fd = -1;
+    size_t i;
+    int ret = -1;
+
+    if (VIR_ALLOC_N(buf, IOHELPER_CHUNK) < 0)
+        return -1;
+
+    if ((fd = testFileWrapperFdCreate(path, O_WRONLY)) < 0)
+        return -1;
+
+    if (!(wfd = virFileWrapperFdNew(&fd, path,
+                                    VIR_FILE_WRAPPER_NON_BLOCKING)))
+        goto cleanup;
+
+    for (i = 0; i < ARRAY_CARDINALITY(zero); i++) {
+        memset(buf, zero[i] ? 0 : 'x', IOHELPER_CHUNK);
+        if (safewrite(fd, buf, IOHELPER_CHUNK) < 0) {
+            fprintf(stderr, "unable to write to iohelper (errno=%d)\n", errno);
+            goto cleanup;
+        }
+    }
+
+    VIR_FORCE_CLOSE(fd);
+    if (virFileWrapperFdClose(wfd) < 0)
+        goto cleanup;
+
+    if (stat(path, &sb) < 0) {
+        fprintf(stderr, "unable to stat %s (errno=%d)\n", path, errno);
+        goto cleanup;
+    }
+
+    if (sb.st_size != ARRAY_CARDINALITY(zero) * IOHELPER_CHUNK) {
+        fprintf(stderr, "Unexpected file size %lld\n",
+                (long long) sb.st_size);
+        goto cleanup;
+    }
+
+    /* Three of the chunks should be holes */
+    if (sb.st_blocks * 512 > 2 * IOHELPER_CHUNK) {
+        fprintf(stderr, "Expected at most %d bytes allocated, got %lld\n",
+                2 * IOHELPER_CHUNK, (long long) sb.st_blocks * 512);
+        goto cleanup;
+    }
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+        goto cleanup;
+
+    for (i = 0; i < ARRAY_CARDINALITY(zero); i++) {
+        if (saferead(fd, buf, IOHELPER_CHUNK) != IOHELPER_CHUNK) {
+            fprintf(stderr, "unable to read %s (errno=%d)\n", path, errno);
+            goto cleanup;
+        }
+        if (zero[i] ? !virFileDataIsZero(buf, IOHELPER_CHUNK) :
+            buf[0] != 'x' || buf[IOHELPER_CHUNK - 1] != 'x') {
+            fprintf(stderr, "Unexpected data in chunk %zu\n", i);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+
+ cleanup:
+    VIR_FORCE_CLOSE(fd);
+    virFileWrapperFdFree(wfd);
+    unlink(path);
+    return ret;
+}
+
+
+#define IOHELPER_BENCH_CHUNKS 256
+
+/* Measures how fast iohelper saves and restores a file */
+static int
+testFileWrapperFdThroughput(const void *opaque ATTRIBUTE_UNUSED)
+{
+    char path[] = abs_builddir "/fileWrapperFd.XXXXXX";
+    VIR_AUTOFREE(char *) buf = NULL;
+    virFileWrapperFdPtr wfd = NULL;
+    struct timespec start;
+    struct timespec end;
+    double secs[2];
+    int fd = -1;
+    size_t i;
+    size_t j;
+    int ret = -1;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    if (VIR_ALLOC_N(buf, IOHELPER_CHUNK) < 0)
+        return -1;
+
+    if ((fd = testFileWrapperFdCreate(path, O_WRONLY)) < 0)
+        return -1;
+
+    for (i = 0; i < ARRAY_CARDINALITY(secs); i++) {
+        bool save = i == 0;
+
+        if (!save &&
+            (fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+            goto cleanup;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        if (!(wfd = virFileWrapperFdNew(&fd, path,
+                                        VIR_FILE_WRAPPER_NON_BLOCKING)))
+            goto cleanup;
+
+        for (j = 0; j < IOHELPER_BENCH_CHUNKS; j++) {
+            if (save) {
+                memset(buf, 'a' + j % 26, IOHELPER_CHUNK);
+                if (safewrite(fd, buf, IOHELPER_CHUNK) < 0)
+                    goto cleanup;
+            } else {
+                if (saferead(fd, buf, IOHELPER_CHUNK) != IOHELPER_CHUNK)
+                    goto cleanup;
+            }
+        }
+
+        VIR_FORCE_CLOSE(fd);
+        if (virFileWrapperFdClose(wfd) < 0)
+            goto cleanup;
+        virFileWrapperFdFree(wfd);
+        wfd = NULL;
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        secs[i] = (end.tv_sec - start.tv_sec) +
+            (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+
+    VIR_TEST_VERBOSE("save %.1f MiB/s, restore %.1f MiB/s\n",
+                     IOHELPER_BENCH_CHUNKS / secs[0],
+                     IOHELPER_BENCH_CHUNKS / secs[1]);
+
+    ret = 0;
+
+ cleanup:
+    VIR_FORCE_CLOSE(fd);
+    virFileWrapperFdFree(wfd);
+    unlink(path);
+    return ret;
+}
+
+
 struct testFileIsSharedFSType {
     const char *mtabFile;
     const char *filename;
@@ -436,8 +648,38 @@ mymain(void)
         DO_TEST_IN_DATA(false, 8, 8, 8);
         DO_TEST_IN_DATA(true, 8, 16, 32, 64, 128, 256, 512);
         DO_TEST_IN_DATA(false, 8, 16, 32, 64, 128, 256, 512);
+
+        if (virTestRun("iohelper sparse save",
+                       testFileWrapperFdSparse, NULL) < 0)
+            ret = -1;
     }
 
+    if (virTestRun("iohelper throughput",
+                   testFileWrapperFdThroughput, NULL) < 0)
+        ret = -1;
+
+#define DO_TEST_DATA_IS_ZERO(length, offset) \
+    do { \
+        struct testFileDataIsZero data = { \
+            .len = length, .nonzero = offset, \
+        }; \
+        if (virTestRun(virTestCounterNext(), testFileDataIsZero, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    virTestCounterReset("testFileDataIsZero ");
+    DO_TEST_DATA_IS_ZERO(0, -1);
+    DO_TEST_DATA_IS_ZERO(1, -1);
+    DO_TEST_DATA_IS_ZERO(1, 0);
+    DO_TEST_DATA_IS_ZERO(15, 14);
+    DO_TEST_DATA_IS_ZERO(16, -1);
+    DO_TEST_DATA_IS_ZERO(17, 16);
+    DO_TEST_DATA_IS_ZERO(4096, -1);
+    DO_TEST_DATA_IS_ZERO(4096, 0);
+    DO_TEST_DATA_IS_ZERO(4096, 31);
+    DO_TEST_DATA_IS_ZERO(4096, 4095);
+    DO_TEST_DATA_IS_ZERO(1024 * 1024 + 3, 1024 * 1024 + 2);
+
 #define DO_TEST_FILE_IS_SHARED_FS_TYPE(mtab, file, exp) \
     do { \
         struct testFileIsSharedFSType data = { \
@@ -4,10 +4,13 @@
 
 #include "internal.h"
 #include "virjson.h"
+#include "virfile.h"
 #include "testutils.h"
 
 #define VIR_FROM_THIS VIR_FROM_NONE
 
+#define NUM_BENCH_ROUNDS 1000
+
 struct testInfo {
     const char *name;
     const char *doc;
@@ -472,6 +475,77 @@ testJSONObjectFormatSteal(const void *opaque ATTRIBUTE_UNUSED)
 }
 
 
+/* Parses every monitor reply from qemumonitorjsondata repeatedly and
+ * reports the average time needed to parse and free all of them. */
+static int
+testJSONParseBench(const void *data ATTRIBUTE_UNUSED)
+{
+    const char *dirPath = abs_srcdir "/qemumonitorjsondata";
+    DIR *dir = NULL;
+    struct dirent *ent;
+    char **docs = NULL;
+    size_t ndocs = 0;
+    size_t nbytes = 0;
+    struct timespec start, end;
+    unsigned long long elapsed;
+    size_t i, j;
+    int rc;
+    int ret = -1;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    if (virDirOpen(&dir, dirPath) < 0)
+        return -1;
+
+    while ((rc = virDirRead(dir, &ent, dirPath)) > 0) {
+        VIR_AUTOFREE(char *) path = NULL;
+        char *doc = NULL;
+
+        if (!virFileHasSuffix(ent->d_name, ".json"))
+            continue;
+
+        if (virAsprintf(&path, "%s/%s", dirPath, ent->d_name) < 0 ||
+            virTestLoadFile(path, &doc) < 0 ||
+            VIR_APPEND_ELEMENT(docs, ndocs, doc) < 0) {
+            VIR_FREE(doc);
+            goto cleanup;
+        }
+    }
+    if (rc < 0)
+        goto cleanup;
+
+    for (i = 0; i < ndocs; i++)
+        nbytes += strlen(docs[i]);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NUM_BENCH_ROUNDS; i++) {
+        for (j = 0; j < ndocs; j++) {
+            virJSONValuePtr json;
+
+            if (!(json = virJSONValueFromString(docs[j])))
+                goto cleanup;
+            virJSONValueFree(json);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+    VIR_TEST_VERBOSE("%llu us to parse %zu replies (%zu bytes)\n",
+                     elapsed / NUM_BENCH_ROUNDS / 1000, ndocs, nbytes);
+
+    ret = 0;
+
+ cleanup:
+    for (i = 0; i < ndocs; i++)
+        VIR_FREE(docs[i]);
+    VIR_FREE(docs);
+    VIR_DIR_CLOSE(dir);
+    return ret;
+}
+
+
 static int
 mymain(void)
 {
@@ -651,6 +725,10 @@ mymain(void)
     DO_TEST_DEFLATTEN("concat-double-key", false);
     DO_TEST_DEFLATTEN("qemu-sheepdog", true);
 
+    if (virTestRun("parse monitor replies benchmark",
+                   testJSONParseBench, NULL) < 0)
+        ret = -1;
+
     return (ret == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
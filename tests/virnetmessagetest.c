@@ -18,14 +18,21 @@
 
 #include <config.h>
 
+#include <sched.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <time.h>
 
 #include "testutils.h"
 #include "virerror.h"
 #include "viralloc.h"
+#include "viratomic.h"
 #include "virlog.h"
 #include "virstring.h"
+#include "virfile.h"
+#include "virthread.h"
 #include "rpc/virnetmessage.h"
+#include "rpc/virnetsharedring.h"
 
 #define VIR_FROM_THIS VIR_FROM_RPC
 
@@ -518,6 +525,507 @@ static int testMessagePayloadStreamEncode(const void *args ATTRIBUTE_UNUSED)
     return ret;
 }
 
+/* A cut down copy of the remote_typed_param and remote_domain_stats_record
+ * wire formats, large instances of which are what makes messages grow
+ * beyond VIR_NET_MESSAGE_INITIAL in practice. */
+typedef struct {
+    char *field;
+    int type;
+    unsigned long long ul;
+    char *s;
+} testTypedParam;
+
+typedef struct {
+    char *name;
+    u_int nparams;
+    testTypedParam *params;
+} testStatsRecord;
+
+typedef struct {
+    u_int nrecords;
+    testStatsRecord *records;
+} testStatsReply;
+
+static bool_t
+testXDRTypedParam(XDR *xdrs, testTypedParam *param)
+{
+    if (!xdr_string(xdrs, &param->field, VIR_TYPED_PARAM_FIELD_LENGTH) ||
+        !xdr_int(xdrs, &param->type))
+        return FALSE;
+
+    if (param->type == VIR_TYPED_PARAM_STRING)
+        return xdr_string(xdrs, &param->s, VIR_NET_MESSAGE_STRING_MAX);
+
+    return xdr_u_hyper(xdrs, (u_quad_t *)&param->ul);
+}
+
+static bool_t
+testXDRStatsRecord(XDR *xdrs, testStatsRecord *rec)
+{
+    char **params = (char **)&rec->params;
+
+    return xdr_string(xdrs, &rec->name, VIR_NET_MESSAGE_STRING_MAX) &&
+        xdr_array(xdrs, params, &rec->nparams, UINT_MAX,
+                  sizeof(testTypedParam), (xdrproc_t)testXDRTypedParam);
+}
+
+static bool_t
+testXDRStatsReply(XDR *xdrs, testStatsReply *reply)
+{
+    char **records = (char **)&reply->records;
+
+    return xdr_array(xdrs, records, &reply->nrecords, UINT_MAX,
+                     sizeof(testStatsRecord), (xdrproc_t)testXDRStatsRecord);
+}
+
+static void
+testStatsReplyFree(testStatsReply *reply)
+{
+    size_t i, j;
+
+    for (i = 0; i < reply->nrecords; i++) {
+        testStatsRecord *rec = reply->records + i;
+
+        for (j = 0; j < rec->nparams; j++) {
+            VIR_FREE(rec->params[j].field);
+            VIR_FREE(rec->params[j].s);
+        }
+        VIR_FREE(rec->params);
+        VIR_FREE(rec->name);
+    }
+    VIR_FREE(reply->records);
+    reply->nrecords = 0;
+}
+
+static int
+testStatsReplyFill(testStatsReply *reply,
+                   size_t nrecords,
+                   size_t nparams)
+{
+    size_t i, j;
+
+    memset(reply, 0, sizeof(*reply));
+
+    if (VIR_ALLOC_N(reply->records, nrecords) < 0)
+        return -1;
+    reply->nrecords = nrecords;
+
+    for (i = 0; i < nrecords; i++) {
+        testStatsRecord *rec = reply->records + i;
+
+        if (virAsprintf(&rec->name, "domain-%zu", i) < 0 ||
+            VIR_ALLOC_N(rec->params, nparams) < 0)
+            return -1;
+        rec->nparams = nparams;
+
+        for (j = 0; j < nparams; j++) {
+            testTypedParam *param = rec->params + j;
+
+            if (virAsprintf(&param->field, "block.%zu.rd.bytes", j) < 0)
+                return -1;
+
+            if (j % 10 == 0) {
+                param->type = VIR_TYPED_PARAM_STRING;
+                if (virAsprintf(&param->s, "/var/lib/libvirt/images/%zu-%zu.qcow2",
+                                i, j) < 0)
+                    return -1;
+            } else {
+                param->type = VIR_TYPED_PARAM_ULLONG;
+                param->ul = i * nparams + j;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static virNetMessagePtr
+testMessageStatsEncode(testStatsReply *reply)
+{
+    virNetMessagePtr msg = virNetMessageNew(true);
+
+    if (!msg)
+        return NULL;
+
+    msg->header.prog = 0x11223344;
+    msg->header.vers = 0x01;
+    msg->header.proc = 0x666;
+    msg->header.type = VIR_NET_REPLY;
+    msg->header.serial = 0x99;
+    msg->header.status = VIR_NET_OK;
+
+    if (virNetMessageEncodeHeader(msg) < 0 ||
+        virNetMessageEncodePayload(msg, (xdrproc_t)testXDRStatsReply,
+                                   reply) < 0) {
+        virNetMessageFree(msg);
+        return NULL;
+    }
+
+    return msg;
+}
+
+static int testMessagePayloadEncodeLarge(const void *args ATTRIBUTE_UNUSED)
+{
+    testStatsReply reply;
+    testStatsReply copy;
+    virNetMessagePtr msg = NULL;
+    size_t i, j;
+    int ret = -1;
+
+    memset(&copy, 0, sizeof(copy));
+
+    /* Several hundred KiB, so the initial buffer must be grown */
+    if (testStatsReplyFill(&reply, 100, 100) < 0)
+        goto cleanup;
+
+    if (!(msg = testMessageStatsEncode(&reply)))
+        goto cleanup;
+
+    if (msg->bufferLength != VIR_NET_MESSAGE_HEADER_MAX +
+        VIR_NET_MESSAGE_LEN_MAX +
+        xdr_sizeof((xdrproc_t)testXDRStatsReply, &reply)) {
+        VIR_DEBUG("Unexpected message length %zu", msg->bufferLength);
+        goto cleanup;
+    }
+
+    if (virNetMessageDecodeLength(msg) < 0 ||
+        virNetMessageDecodeHeader(msg) < 0 ||
+        virNetMessageDecodePayload(msg, (xdrproc_t)testXDRStatsReply,
+                                   &copy) < 0)
+        goto cleanup;
+
+    if (copy.nrecords != reply.nrecords) {
+        VIR_DEBUG("Expect %u records got %u", reply.nrecords, copy.nrecords);
+        goto cleanup;
+    }
+
+    for (i = 0; i < reply.nrecords; i++) {
+        testStatsRecord *a = reply.records + i;
+        testStatsRecord *b = copy.records + i;
+
+        if (STRNEQ(a->name, b->name) || a->nparams != b->nparams) {
+            VIR_DEBUG("Record %zu mismatch", i);
+            goto cleanup;
+        }
+
+        for (j = 0; j < a->nparams; j++) {
+            if (STRNEQ(a->params[j].field, b->params[j].field) ||
+                a->params[j].type != b->params[j].type ||
+                a->params[j].ul != b->params[j].ul ||
+                STRNEQ_NULLABLE(a->params[j].s, b->params[j].s)) {
+                VIR_DEBUG("Record %zu param %zu mismatch", i, j);
+                goto cleanup;
+            }
+        }
+    }
+
+    ret = 0;
+ cleanup:
+    testStatsReplyFree(&reply);
+    testStatsReplyFree(&copy);
+    virNetMessageFree(msg);
+    return ret;
+}
+
+#define NUM_BENCH_ROUNDS 20
+
+static int testMessagePayloadEncodeBench(const void *args ATTRIBUTE_UNUSED)
+{
+    testStatsReply reply;
+    struct timespec start, end;
+    unsigned long long elapsed;
+    size_t length = 0;
+    size_t i;
+    int ret = -1;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    /* Roughly what 1000 domains with a few disks and NICs each send
+     * back from virConnectGetAllDomainStats */
+    if (testStatsReplyFill(&reply, 1000, 200) < 0)
+        goto cleanup;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NUM_BENCH_ROUNDS; i++) {
+        virNetMessagePtr msg;
+
+        if (!(msg = testMessageStatsEncode(&reply)))
+            goto cleanup;
+        length = msg->bufferLength;
+        virNetMessageFree(msg);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+    VIR_TEST_VERBOSE("%llu us to encode a %zu byte message\n",
+                     elapsed / NUM_BENCH_ROUNDS / 1000, length);
+
+    ret = 0;
+ cleanup:
+    testStatsReplyFree(&reply);
+    return ret;
+}
+
+
+static int testSharedRing(const void *args ATTRIBUTE_UNUSED)
+{
+    virNetSharedRingPtr daemon = NULL;
+    virNetSharedRingPtr client = NULL;
+    char *in = NULL;
+    char *out = NULL;
+    size_t size;
+    size_t len;
+    unsigned int pos[4];
+    size_t i;
+    int fd = -1;
+    int ret = -1;
+
+    if (!virNetSharedRingIsSupported())
+        return EXIT_AM_SKIP;
+
+    /* Rounded up to the minimum size */
+    if (!(daemon = virNetSharedRingNew(1)))
+        goto cleanup;
+    size = virNetSharedRingGetSize(daemon);
+    if (size != 64 * 1024) {
+        VIR_DEBUG("Unexpected ring size %zu", size);
+        goto cleanup;
+    }
+
+    if ((fd = dup(virNetSharedRingGetFD(daemon))) < 0 ||
+        !(client = virNetSharedRingOpen(fd)))
+        goto cleanup;
+    fd = -1;
+
+    len = size * 3 / 8;
+    if (VIR_ALLOC_N(in, len) < 0 ||
+        VIR_ALLOC_N(out, len) < 0)
+        goto cleanup;
+
+    /* The third message would have to wrap around, which leaves
+     * not enough room for it */
+    for (i = 0; i < 2; i++) {
+        memset(in, 'a' + i, len);
+        if (!virNetSharedRingPut(daemon, in, len, &pos[i])) {
+            VIR_DEBUG("Unable to put message %zu", i);
+            goto cleanup;
+        }
+    }
+
+    memset(in, 'x', len);
+    if (virNetSharedRingPut(daemon, in, len, &pos[2])) {
+        VIR_DEBUG("Message put into a full ring");
+        goto cleanup;
+    }
+
+    for (i = 0; i < 2; i++) {
+        if (virNetSharedRingTake(client, pos[i], len, out) < 0)
+            goto cleanup;
+        memset(in, 'a' + i, len);
+        if (memcmp(in, out, len) != 0) {
+            VIR_DEBUG("Message %zu corrupted", i);
+            goto cleanup;
+        }
+    }
+
+    /* Once consumed, the space is available again and the message
+     * skips the end of the ring rather than being split */
+    for (i = 2; i < 4; i++) {
+        memset(in, 'a' + i, len);
+        if (!virNetSharedRingPut(daemon, in, len, &pos[i])) {
+            VIR_DEBUG("Unable to put message %zu", i);
+            goto cleanup;
+        }
+    }
+    if ((pos[2] & (size - 1)) != 0) {
+        VIR_DEBUG("Message did not wrap around, position %u", pos[2]);
+        goto cleanup;
+    }
+
+    for (i = 2; i < 4; i++) {
+        if (virNetSharedRingTake(client, pos[i], len, out) < 0)
+            goto cleanup;
+        memset(in, 'a' + i, len);
+        if (memcmp(in, out, len) != 0) {
+            VIR_DEBUG("Message %zu corrupted", i);
+            goto cleanup;
+        }
+    }
+
+    /* Data already taken, or running past the end of the ring, is
+     * refused */
+    if (virNetSharedRingTake(client, pos[0], len, out) == 0 ||
+        virNetSharedRingTake(client, pos[3] + len + size - 1, len, out) == 0) {
+        VIR_DEBUG("Invalid message taken");
+        goto cleanup;
+    }
+    virResetLastError();
+
+    ret = 0;
+ cleanup:
+    VIR_FORCE_CLOSE(fd);
+    VIR_FREE(in);
+    VIR_FREE(out);
+    virObjectUnref(daemon);
+    virObjectUnref(client);
+    return ret;
+}
+
+
+#define NUM_RING_BENCH_MESSAGES 2000
+#define RING_BENCH_MESSAGE_SIZE (512 * 1024)
+
+struct testSharedRingBenchData {
+    int fd;
+    virNetSharedRingPtr ring;
+    char *buffer;
+    int done;
+    int ret;
+};
+
+/* The stub sent over the socket in place of a message in the ring */
+struct testSharedRingBenchStub {
+    unsigned int pos;
+    unsigned int len;
+};
+
+static void testSharedRingBenchReader(void *opaque)
+{
+    struct testSharedRingBenchData *data = opaque;
+    size_t i;
+
+    data->ret = 0;
+    for (i = 0; i < NUM_RING_BENCH_MESSAGES; i++) {
+        if (data->ring) {
+            struct testSharedRingBenchStub stub;
+
+            if (saferead(data->fd, &stub, sizeof(stub)) != sizeof(stub) ||
+                virNetSharedRingTake(data->ring, stub.pos, stub.len,
+                                     data->buffer) < 0)
+                data->ret = -1;
+        } else {
+            if (saferead(data->fd, data->buffer,
+                         RING_BENCH_MESSAGE_SIZE) != RING_BENCH_MESSAGE_SIZE)
+                data->ret = -1;
+        }
+        if (data->ret < 0)
+            break;
+    }
+
+    virAtomicIntSet(&data->done, 1);
+}
+
+static int
+testSharedRingBenchRun(bool useRing,
+                       unsigned long long *elapsed)
+{
+    struct testSharedRingBenchData data = { -1, NULL, NULL, 0, -1 };
+    virNetSharedRingPtr ring = NULL;
+    virThread thread;
+    bool joined = true;
+    struct timespec start, end;
+    char *message = NULL;
+    int fds[2] = { -1, -1 };
+    int fd = -1;
+    size_t i;
+    int ret = -1;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0 ||
+        VIR_ALLOC_N(message, RING_BENCH_MESSAGE_SIZE) < 0 ||
+        VIR_ALLOC_N(data.buffer, RING_BENCH_MESSAGE_SIZE) < 0)
+        goto cleanup;
+    memset(message, 'm', RING_BENCH_MESSAGE_SIZE);
+    data.fd = fds[1];
+
+    if (useRing) {
+        if (!(ring = virNetSharedRingNew(16 * 1024 * 1024)) ||
+            (fd = dup(virNetSharedRingGetFD(ring))) < 0 ||
+            !(data.ring = virNetSharedRingOpen(fd)))
+            goto cleanup;
+        fd = -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (virThreadCreate(&thread, true, testSharedRingBenchReader, &data) < 0)
+        goto cleanup;
+    joined = false;
+
+    for (i = 0; i < NUM_RING_BENCH_MESSAGES; i++) {
+        if (useRing) {
+            struct testSharedRingBenchStub stub = {
+                .len = RING_BENCH_MESSAGE_SIZE,
+            };
+
+            /* The daemon would send the message over the socket
+             * instead, here wait for the reader to catch up */
+            while (!virNetSharedRingPut(ring, message,
+                                        RING_BENCH_MESSAGE_SIZE, &stub.pos)) {
+                if (virAtomicIntGet(&data.done))
+                    goto cleanup;
+                sched_yield();
+            }
+
+            if (safewrite(fds[0], &stub, sizeof(stub)) != sizeof(stub))
+                goto cleanup;
+        } else {
+            if (safewrite(fds[0], message,
+                          RING_BENCH_MESSAGE_SIZE) != RING_BENCH_MESSAGE_SIZE)
+                goto cleanup;
+        }
+    }
+
+    virThreadJoin(&thread);
+    joined = true;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (data.ret < 0)
+        goto cleanup;
+
+    *elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+
+    ret = 0;
+ cleanup:
+    VIR_FORCE_CLOSE(fds[0]);
+    if (!joined)
+        virThreadJoin(&thread);
+    VIR_FORCE_CLOSE(fds[1]);
+    VIR_FORCE_CLOSE(fd);
+    VIR_FREE(message);
+    VIR_FREE(data.buffer);
+    virObjectUnref(data.ring);
+    virObjectUnref(ring);
+    return ret;
+}
+
+static int testSharedRingBench(const void *args ATTRIBUTE_UNUSED)
+{
+    unsigned long long socketTime;
+    unsigned long long ringTime;
+
+    if (!virTestGetExpensive() ||
+        !virNetSharedRingIsSupported())
+        return EXIT_AM_SKIP;
+
+    if (testSharedRingBenchRun(false, &socketTime) < 0 ||
+        testSharedRingBenchRun(true, &ringTime) < 0)
+        return -1;
+
+    VIR_TEST_VERBOSE("%d messages of %d bytes: socket %llu MiB/s "
+                     "(%llu us each), ring %llu MiB/s (%llu us each)\n",
+                     NUM_RING_BENCH_MESSAGES, RING_BENCH_MESSAGE_SIZE,
+                     1000000ULL * NUM_RING_BENCH_MESSAGES *
+                     (RING_BENCH_MESSAGE_SIZE / 1024) / 1024 / (socketTime / 1000),
+                     socketTime / NUM_RING_BENCH_MESSAGES / 1000,
+                     1000000ULL * NUM_RING_BENCH_MESSAGES *
+                     (RING_BENCH_MESSAGE_SIZE / 1024) / 1024 / (ringTime / 1000),
+                     ringTime / NUM_RING_BENCH_MESSAGES / 1000);
+
+    return 0;
+}
+
 
 static int
 mymain(void)
@@ -541,6 +1049,18 @@ mymain(void)
     if (virTestRun("Message Payload Stream Encode", testMessagePayloadStreamEncode, NULL) < 0)
         ret = -1;
 
+    if (virTestRun("Message Payload Encode Large", testMessagePayloadEncodeLarge, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Message Payload Encode Benchmark", testMessagePayloadEncodeBench, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Shared Ring", testSharedRing, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Shared Ring Benchmark", testSharedRingBench, NULL) < 0)
+        ret = -1;
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -20,6 +20,7 @@
 
 #include "testutils.h"
 #include "virerror.h"
+#include "virfile.h"
 #include "rpc/virnetserverclient.h"
 
 #define VIR_FROM_THIS VIR_FROM_RPC
@@ -45,32 +46,30 @@ testClientFree(void *opaque)
     VIR_FREE(opaque);
 }
 
-static int testIdentity(const void *opaque ATTRIBUTE_UNUSED)
+
+/* Creates a client talking to the returned @peer end of a socket pair */
+static virNetServerClientPtr
+testClientNewPair(int type,
+                  size_t nrequests_max,
+                  int *peer)
 {
     int sv[2];
-    int ret = -1;
     virNetSocketPtr sock = NULL;
     virNetServerClientPtr client = NULL;
-    virIdentityPtr ident = NULL;
-    const char *gotUsername = NULL;
-    const char *gotUserID = NULL;
-    const char *gotGroupname = NULL;
-    const char *gotGroupID = NULL;
-    const char *gotSELinuxContext = NULL;
 
-    if (socketpair(PF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+    if (socketpair(PF_UNIX, type, 0, sv) < 0) {
         virReportSystemError(errno, "%s",
                              "Cannot create socket pair");
-        return -1;
+        return NULL;
     }
 
     if (virNetSocketNewConnectSockFD(sv[0], &sock) < 0) {
         virDispatchError(NULL);
+        VIR_FORCE_CLOSE(sv[0]);
         goto cleanup;
     }
-    sv[0] = -1;
 
-    if (!(client = virNetServerClientNew(1, sock, 0, false, 1,
+    if (!(client = virNetServerClientNew(1, sock, 0, false, nrequests_max,
                                          NULL,
                                          testClientNew,
                                          NULL,
@@ -80,6 +79,30 @@ static int testIdentity(const void *opaque ATTRIBUTE_UNUSED)
         goto cleanup;
     }
 
+    *peer = sv[1];
+    sv[1] = -1;
+
+ cleanup:
+    virObjectUnref(sock);
+    VIR_FORCE_CLOSE(sv[1]);
+    return client;
+}
+
+static int testIdentity(const void *opaque ATTRIBUTE_UNUSED)
+{
+    int peer = -1;
+    int ret = -1;
+    virNetServerClientPtr client = NULL;
+    virIdentityPtr ident = NULL;
+    const char *gotUsername = NULL;
+    const char *gotUserID = NULL;
+    const char *gotGroupname = NULL;
+    const char *gotGroupID = NULL;
+    const char *gotSELinuxContext = NULL;
+
+    if (!(client = testClientNewPair(SOCK_STREAM, 1, &peer)))
+        return -1;
+
     if (!(ident = virNetServerClientGetIdentity(client))) {
         fprintf(stderr, "Failed to create identity\n");
         goto cleanup;
@@ -147,13 +170,314 @@ static int testIdentity(const void *opaque ATTRIBUTE_UNUSED)
 
     ret = 0;
  cleanup:
-    virObjectUnref(sock);
     if (client)
         virNetServerClientClose(client);
     virObjectUnref(client);
     virObjectUnref(ident);
-    VIR_FORCE_CLOSE(sv[0]);
-    VIR_FORCE_CLOSE(sv[1]);
+    VIR_FORCE_CLOSE(peer);
+    return ret;
+}
+
+
+# define TEST_PROG 0x11223344
+# define TEST_PROC_CHEAP 2
+
+struct testDispatchData {
+    virNetMessagePtr msgs[10];
+    size_t nmsgs;
+    bool timedOut;
+};
+
+
+static void
+testDispatch(virNetServerClientPtr client ATTRIBUTE_UNUSED,
+             virNetMessagePtr msg,
+             void *opaque)
+{
+    struct testDispatchData *data = opaque;
+
+    if (data->nmsgs == ARRAY_CARDINALITY(data->msgs)) {
+        virNetMessageFree(msg);
+        return;
+    }
+    data->msgs[data->nmsgs++] = msg;
+}
+
+
+static bool
+testIsPriority(virNetServerClientPtr client ATTRIBUTE_UNUSED,
+               virNetMessagePtr msg,
+               void *opaque ATTRIBUTE_UNUSED)
+{
+    return msg->header.proc == TEST_PROC_CHEAP;
+}
+
+
+static void
+testTimeout(int timer ATTRIBUTE_UNUSED,
+            void *opaque)
+{
+    struct testDispatchData *data = opaque;
+
+    data->timedOut = true;
+}
+
+
+static int
+testSendCall(int fd, int proc)
+{
+    virNetMessagePtr msg = NULL;
+    int ret = -1;
+
+    if (!(msg = virNetMessageNew(false)))
+        return -1;
+
+    msg->header.prog = TEST_PROG;
+    msg->header.vers = 1;
+    msg->header.proc = proc;
+    msg->header.type = VIR_NET_CALL;
+    msg->header.serial = proc;
+    msg->header.status = VIR_NET_OK;
+
+    if (virNetMessageEncodeHeader(msg) < 0 ||
+        virNetMessageEncodePayloadRaw(msg, "", 0) < 0)
+        goto cleanup;
+
+    if (safewrite(fd, msg->buffer, msg->bufferLength) < 0) {
+        virReportSystemError(errno, "%s", "Cannot write call");
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    virNetMessageFree(msg);
+    return ret;
+}
+
+
+static int
+testWaitDispatched(struct testDispatchData *data,
+                   size_t nmsgs)
+{
+    while (data->nmsgs < nmsgs && !data->timedOut) {
+        if (virEventRunDefaultImpl() < 0)
+            return -1;
+    }
+
+    if (data->nmsgs != nmsgs) {
+        fprintf(stderr, "Expected %zu dispatched calls, got %zu\n",
+                nmsgs, data->nmsgs);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testCheckProc(struct testDispatchData *data,
+              size_t idx,
+              int proc)
+{
+    if (data->msgs[idx]->header.proc != proc) {
+        fprintf(stderr, "Expected call %zu to be proc %d, got %d\n",
+                idx, proc, data->msgs[idx]->header.proc);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * With an allowance of two requests in progress, two slow calls
+ * use up the ordinary slots. The next slow call must wait until
+ * one of them is answered, but a cheap one is dispatched at once.
+ */
+static int testPriorityRequests(const void *opaque ATTRIBUTE_UNUSED)
+{
+    int peer = -1;
+    int ret = -1;
+    int timer = -1;
+    virNetServerClientPtr client = NULL;
+    virNetMessagePtr reply;
+    struct testDispatchData data = { 0 };
+    size_t i;
+
+    if (!(client = testClientNewPair(SOCK_STREAM, 2, &peer)))
+        return -1;
+
+    virNetServerClientSetDispatcher(client, testDispatch,
+                                    testIsPriority, &data);
+
+    if (virNetServerClientInit(client) < 0 ||
+        (timer = virEventAddTimeout(5000, testTimeout, &data, NULL)) < 0) {
+        virDispatchError(NULL);
+        goto cleanup;
+    }
+
+    if (testSendCall(peer, 1) < 0 ||
+        testSendCall(peer, 3) < 0 ||
+        testSendCall(peer, 5) < 0 ||
+        testSendCall(peer, TEST_PROC_CHEAP) < 0)
+        goto cleanup;
+
+    if (testWaitDispatched(&data, 3) < 0 ||
+        testCheckProc(&data, 0, 1) < 0 ||
+        testCheckProc(&data, 1, 3) < 0 ||
+        testCheckProc(&data, 2, TEST_PROC_CHEAP) < 0)
+        goto cleanup;
+
+    /* Answer the first call, which lets the deferred one through */
+    reply = data.msgs[0];
+    data.msgs[0] = NULL;
+    virNetMessageClear(reply);
+    reply->header.prog = TEST_PROG;
+    reply->header.vers = 1;
+    reply->header.proc = 1;
+    reply->header.type = VIR_NET_REPLY;
+    reply->header.serial = 1;
+    reply->header.status = VIR_NET_OK;
+    if (virNetMessageEncodeHeader(reply) < 0 ||
+        virNetMessageEncodePayloadRaw(reply, "", 0) < 0 ||
+        virNetServerClientSendMessage(client, reply) < 0) {
+        virNetMessageFree(reply);
+        goto cleanup;
+    }
+
+    if (testWaitDispatched(&data, 4) < 0 ||
+        testCheckProc(&data, 3, 5) < 0)
+        goto cleanup;
+
+    ret = 0;
+ cleanup:
+    if (timer != -1)
+        virEventRemoveTimeout(timer);
+    for (i = 0; i < data.nmsgs; i++)
+        virNetMessageFree(data.msgs[i]);
+    if (client)
+        virNetServerClientClose(client);
+    virObjectUnref(client);
+    VIR_FORCE_CLOSE(peer);
+    return ret;
+}
+
+
+/*
+ * Asynchronous messages queued in a burst are written out together,
+ * but the client must still see them as separate messages. The
+ * socket preserves the boundaries of writes, so the number of reads
+ * tells how many writes were done: the first message is at the head
+ * of the queue on its own, the rest is merged.
+ */
+static int testBatchedMessages(const void *opaque ATTRIBUTE_UNUSED)
+{
+    int peer = -1;
+    int ret = -1;
+    int timer = -1;
+    virNetServerClientPtr client = NULL;
+    virNetMessagePtr msg = NULL;
+    struct testDispatchData data = { 0 };
+    char buf[1024];
+    size_t len = 0;
+    size_t nwrites = 0;
+    size_t nmsgs = 5;
+    /* Each message is just the length word and the header */
+    size_t msglen = VIR_NET_MESSAGE_LEN_MAX + VIR_NET_MESSAGE_HEADER_MAX;
+    size_t i;
+
+    if (!(client = testClientNewPair(SOCK_SEQPACKET, 1, &peer)))
+        return -1;
+
+    if (virNetServerClientInit(client) < 0 ||
+        (timer = virEventAddTimeout(5000, testTimeout, &data, NULL)) < 0) {
+        virDispatchError(NULL);
+        goto cleanup;
+    }
+
+    for (i = 0; i < nmsgs; i++) {
+        if (!(msg = virNetMessageNew(false)))
+            goto cleanup;
+
+        msg->header.prog = TEST_PROG;
+        msg->header.vers = 1;
+        msg->header.proc = i + 1;
+        msg->header.type = VIR_NET_MESSAGE;
+        msg->header.serial = 1;
+        msg->header.status = VIR_NET_OK;
+
+        if (virNetMessageEncodeHeader(msg) < 0 ||
+            virNetMessageEncodePayloadRaw(msg, "", 0) < 0 ||
+            virNetServerClientSendMessage(client, msg) < 0)
+            goto cleanup;
+        msg = NULL;
+    }
+
+    while (len < nmsgs * msglen && !data.timedOut) {
+        ssize_t got;
+
+        if (virEventRunDefaultImpl() < 0)
+            goto cleanup;
+
+        while ((got = recv(peer, buf + len, sizeof(buf) - len,
+                           MSG_DONTWAIT)) > 0) {
+            len += got;
+            nwrites++;
+        }
+        if (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            virReportSystemError(errno, "%s", "Cannot read messages");
+            goto cleanup;
+        }
+    }
+
+    if (len != nmsgs * msglen) {
+        fprintf(stderr, "Expected %zu bytes, got %zu\n",
+                nmsgs * msglen, len);
+        goto cleanup;
+    }
+
+    if (nwrites != 2) {
+        fprintf(stderr, "Expected 2 writes, got %zu\n", nwrites);
+        goto cleanup;
+    }
+
+    for (i = 0; i < nmsgs; i++) {
+        if (!(msg = virNetMessageNew(false)))
+            goto cleanup;
+
+        msg->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
+        if (VIR_ALLOC_N(msg->buffer, msg->bufferLength) < 0)
+            goto cleanup;
+        memcpy(msg->buffer, buf + i * msglen,
+               VIR_NET_MESSAGE_LEN_MAX);
+        if (virNetMessageDecodeLength(msg) < 0 ||
+            msg->bufferLength != msglen) {
+            fprintf(stderr, "Bad length of message %zu\n", i);
+            goto cleanup;
+        }
+
+        memcpy(msg->buffer, buf + i * msglen, msglen);
+        if (virNetMessageDecodeHeader(msg) < 0)
+            goto cleanup;
+
+        if (msg->header.proc != i + 1) {
+            fprintf(stderr, "Expected message %zu to be proc %zu, got %d\n",
+                    i, i + 1, msg->header.proc);
+            goto cleanup;
+        }
+        virNetMessageFree(msg);
+        msg = NULL;
+    }
+
+    ret = 0;
+ cleanup:
+    if (timer != -1)
+        virEventRemoveTimeout(timer);
+    virNetMessageFree(msg);
+    if (client)
+        virNetServerClientClose(client);
+    virObjectUnref(client);
+    VIR_FORCE_CLOSE(peer);
     return ret;
 }
 
@@ -163,10 +487,17 @@ mymain(void)
 {
     int ret = 0;
 
+    virEventRegisterDefaultImpl();
 
     if (virTestRun("Identity",
                    testIdentity, NULL) < 0)
         ret = -1;
+    if (virTestRun("Priority requests",
+                   testPriorityRequests, NULL) < 0)
+        ret = -1;
+    if (virTestRun("Batched messages",
+                   testBatchedMessages, NULL) < 0)
+        ret = -1;
 
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
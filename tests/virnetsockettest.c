@@ -31,8 +31,11 @@
 #include "virlog.h"
 #include "virfile.h"
 #include "virstring.h"
+#include "virthread.h"
+#include "virtime.h"
 
 #include "rpc/virnetsocket.h"
+#include "rpc/virnetclient.h"
 
 #define VIR_FROM_THIS VIR_FROM_RPC
 
@@ -393,6 +396,259 @@ static int testSocketUNIXAddrs(const void *data ATTRIBUTE_UNUSED)
     return ret;
 }
 
+# define TEST_ASYNC_CALLS 16
+
+struct testAsyncData {
+    virMutex lock;
+    virCond cond;
+    size_t ndone;
+    size_t nfailed;
+    unsigned int serials[TEST_ASYNC_CALLS];
+    bool quit;
+};
+
+
+static void
+testClientAsyncDone(virNetClientPtr client ATTRIBUTE_UNUSED,
+                    virNetMessagePtr msg,
+                    int status,
+                    void *opaque)
+{
+    struct testAsyncData *data = opaque;
+
+    virMutexLock(&data->lock);
+    if (status < 0 || msg->header.type != VIR_NET_REPLY)
+        data->nfailed++;
+    else if (data->ndone < TEST_ASYNC_CALLS)
+        data->serials[data->ndone] = msg->header.serial;
+    data->ndone++;
+    virCondSignal(&data->cond);
+    virMutexUnlock(&data->lock);
+
+    virNetMessageFree(msg);
+}
+
+
+static void
+testClientAsyncLoop(void *opaque)
+{
+    struct testAsyncData *data = opaque;
+
+    while (!data->quit)
+        virEventRunDefaultImpl();
+}
+
+
+static void
+testClientAsyncWakeup(int timer, void *opaque ATTRIBUTE_UNUSED)
+{
+    virEventRemoveTimeout(timer);
+}
+
+
+static int
+testClientAsyncWait(struct testAsyncData *data,
+                    size_t ndone)
+{
+    unsigned long long deadline;
+    int ret = 0;
+
+    if (virTimeMillisNow(&deadline) < 0)
+        return -1;
+    deadline += 10 * 1000;
+
+    virMutexLock(&data->lock);
+    while (data->ndone < ndone) {
+        if (virCondWaitUntil(&data->cond, &data->lock, deadline) < 0) {
+            ret = -1;
+            break;
+        }
+    }
+    virMutexUnlock(&data->lock);
+
+    return ret;
+}
+
+
+static int
+testClientAsyncSend(virNetClientPtr client,
+                    unsigned int serial,
+                    struct testAsyncData *data)
+{
+    virNetMessagePtr msg;
+
+    if (!(msg = virNetMessageNew(false)))
+        return -1;
+
+    msg->header.prog = 0x11223344;
+    msg->header.vers = 1;
+    msg->header.proc = 42;
+    msg->header.type = VIR_NET_CALL;
+    msg->header.serial = serial;
+    msg->header.status = VIR_NET_OK;
+
+    if (virNetMessageEncodeHeader(msg) < 0 ||
+        virNetMessageEncodePayloadRaw(msg, "", 0) < 0 ||
+        virNetClientSendWithReplyAsync(client, msg,
+                                       testClientAsyncDone, data) < 0) {
+        virNetMessageFree(msg);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static virNetMessagePtr
+testClientAsyncRead(int fd)
+{
+    virNetMessagePtr msg;
+
+    if (!(msg = virNetMessageNew(false)))
+        return NULL;
+
+    msg->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
+    if (VIR_ALLOC_N(msg->buffer, msg->bufferLength) < 0 ||
+        saferead(fd, msg->buffer, msg->bufferLength) != msg->bufferLength ||
+        virNetMessageDecodeLength(msg) < 0 ||
+        saferead(fd, msg->buffer + msg->bufferOffset,
+                 msg->bufferLength - msg->bufferOffset) !=
+        msg->bufferLength - msg->bufferOffset ||
+        virNetMessageDecodeHeader(msg) < 0) {
+        virNetMessageFree(msg);
+        return NULL;
+    }
+
+    return msg;
+}
+
+
+/*
+ * Queue a bunch of asynchronous calls, have the server answer them in
+ * reverse order and check each completion fires from the event loop.
+ * Then check a call still waiting for its reply fails when the server
+ * goes away.
+ */
+static int testClientAsync(const void *opaque ATTRIBUTE_UNUSED)
+{
+    virNetSocketPtr lsock = NULL;
+    virNetSocketPtr ssock = NULL;
+    virNetClientPtr client = NULL;
+    virNetMessagePtr calls[TEST_ASYNC_CALLS] = { NULL };
+    struct testAsyncData data;
+    virThread loop;
+    bool haveLoop = false;
+    char *path = NULL;
+    char *tmpdir;
+    char template[] = "/tmp/libvirt_XXXXXX";
+    virNetMessagePtr msg = NULL;
+    size_t i;
+    int fd;
+    int ret = -1;
+
+    memset(&data, 0, sizeof(data));
+    if (virMutexInit(&data.lock) < 0 || virCondInit(&data.cond) < 0)
+        return -1;
+
+    if (!(tmpdir = mkdtemp(template))) {
+        VIR_WARN("Failed to create temporary directory");
+        goto cleanup;
+    }
+    if (virAsprintf(&path, "%s/test.sock", tmpdir) < 0)
+        goto cleanup;
+
+    if (virNetSocketNewListenUNIX(path, 0700, -1, getegid(), &lsock) < 0 ||
+        virNetSocketListen(lsock, 0) < 0)
+        goto cleanup;
+
+    if (!(client = virNetClientNewUNIX(path, false, NULL)) ||
+        virNetClientRegisterAsyncIO(client) < 0)
+        goto cleanup;
+
+    if (virNetSocketAccept(lsock, &ssock) < 0 || !ssock)
+        goto cleanup;
+    fd = virNetSocketGetFD(ssock);
+    if (virSetBlocking(fd, true) < 0)
+        goto cleanup;
+
+    if (virThreadCreate(&loop, true, testClientAsyncLoop, &data) < 0)
+        goto cleanup;
+    haveLoop = true;
+
+    for (i = 0; i < TEST_ASYNC_CALLS; i++) {
+        if (testClientAsyncSend(client, i, &data) < 0 ||
+            !(calls[i] = testClientAsyncRead(fd)))
+            goto cleanup;
+    }
+
+    for (i = TEST_ASYNC_CALLS; i > 0; i--) {
+        virNetMessagePtr reply = calls[i - 1];
+
+        reply->header.type = VIR_NET_REPLY;
+        virNetMessageClearPayload(reply);
+        if (virNetMessageEncodeHeader(reply) < 0 ||
+            virNetMessageEncodePayloadRaw(reply, "", 0) < 0)
+            goto cleanup;
+
+        if (safewrite(fd, reply->buffer, reply->bufferLength) < 0)
+            goto cleanup;
+    }
+
+    if (testClientAsyncWait(&data, TEST_ASYNC_CALLS) < 0) {
+        VIR_TEST_DEBUG("Timed out waiting for replies");
+        goto cleanup;
+    }
+
+    for (i = 0; i < TEST_ASYNC_CALLS; i++) {
+        if (data.serials[i] != TEST_ASYNC_CALLS - 1 - i) {
+            VIR_TEST_DEBUG("Reply %zu has serial %u", i, data.serials[i]);
+            goto cleanup;
+        }
+    }
+
+    /* Queue one more call, take it off the wire and hang up */
+    if (testClientAsyncSend(client, TEST_ASYNC_CALLS, &data) < 0 ||
+        !(msg = testClientAsyncRead(fd)))
+        goto cleanup;
+    virObjectUnref(ssock);
+    ssock = NULL;
+
+    if (testClientAsyncWait(&data, TEST_ASYNC_CALLS + 1) < 0) {
+        VIR_TEST_DEBUG("Timed out waiting for the failed call");
+        goto cleanup;
+    }
+
+    if (data.nfailed != 1) {
+        VIR_TEST_DEBUG("Expected 1 failed call, got %zu", data.nfailed);
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    if (client)
+        virNetClientClose(client);
+    virObjectUnref(client);
+    if (haveLoop) {
+        data.quit = true;
+        virEventAddTimeout(0, testClientAsyncWakeup, NULL, NULL);
+        virThreadJoin(&loop);
+    }
+    virNetMessageFree(msg);
+    for (i = 0; i < TEST_ASYNC_CALLS; i++)
+        virNetMessageFree(calls[i]);
+    virObjectUnref(lsock);
+    virObjectUnref(ssock);
+    if (path)
+        unlink(path);
+    VIR_FREE(path);
+    if (tmpdir)
+        rmdir(tmpdir);
+    virMutexDestroy(&data.lock);
+    virCondDestroy(&data.cond);
+    return ret;
+}
+
 static int testSocketCommandNormal(const void *data ATTRIBUTE_UNUSED)
 {
     virNetSocketPtr csock = NULL; /* Client socket */
@@ -562,6 +818,8 @@ mymain(void)
 
     if (virTestRun("Socket UNIX Addrs", testSocketUNIXAddrs, NULL) < 0)
         ret = -1;
+    if (virTestRun("Client async calls", testClientAsync, NULL) < 0)
+        ret = -1;
 
     if (virTestRun("Socket External Command /dev/zero", testSocketCommandNormal, NULL) < 0)
         ret = -1;
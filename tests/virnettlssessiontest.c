@@ -19,7 +19,9 @@
 #include <config.h>
 
 #include <fcntl.h>
+#include <time.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
 
 #include "testutils.h"
 #include "virnettlshelpers.h"
@@ -30,6 +32,7 @@
 #include "virfile.h"
 #include "vircommand.h"
 #include "virsocketaddr.h"
+#include "virthread.h"
 
 #if !defined WIN32 && HAVE_LIBTASN1_H && LIBGNUTLS_VERSION_NUMBER >= 0x020600
 
@@ -234,6 +237,216 @@ static int testTLSSessionInit(const void *opaque)
 }
 
 
+# define BENCH_CHUNK (256 * 1024)
+# define BENCH_TOTAL (1024ULL * 1024 * 1024)
+
+struct testTLSBenchData {
+    const char *cacrt;
+    const char *servercrt;
+    const char *clientcrt;
+    bool kernelOffload;
+};
+
+struct testTLSBenchReader {
+    virNetTLSSessionPtr sess;
+    unsigned long long got;
+    bool failed;
+};
+
+
+/* Kernel TLS only works on TCP sockets, so use loopback */
+static int
+testTLSLoopbackPair(int *serverfd, int *clientfd)
+{
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    int listenfd = -1;
+    int ret = -1;
+
+    *serverfd = *clientfd = -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if ((listenfd = socket(AF_INET, SOCK_STREAM, 0)) < 0 ||
+        bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listenfd, 1) < 0 ||
+        getsockname(listenfd, (struct sockaddr *)&addr, &addrlen) < 0 ||
+        (*clientfd = socket(AF_INET, SOCK_STREAM, 0)) < 0 ||
+        connect(*clientfd, (struct sockaddr *)&addr, addrlen) < 0 ||
+        (*serverfd = accept(listenfd, NULL, NULL)) < 0) {
+        virReportSystemError(errno, "%s", "Cannot create loopback connection");
+        VIR_FORCE_CLOSE(*clientfd);
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    VIR_FORCE_CLOSE(listenfd);
+    return ret;
+}
+
+
+static void
+testTLSBenchRead(void *opaque)
+{
+    struct testTLSBenchReader *reader = opaque;
+    char *buf;
+
+    if (VIR_ALLOC_N_QUIET(buf, BENCH_CHUNK) < 0) {
+        reader->failed = true;
+        return;
+    }
+
+    while (reader->got < BENCH_TOTAL) {
+        ssize_t got = virNetTLSSessionRead(reader->sess, buf, BENCH_CHUNK);
+
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0) {
+            reader->failed = true;
+            break;
+        }
+        reader->got += got;
+    }
+
+    VIR_FREE(buf);
+}
+
+
+/*
+ * Measures how fast the server can push data to the client through
+ * a TLS session over a loopback TCP connection, with or without the
+ * kernel doing the encryption for the server as libvirtd does when
+ * tls_kernel_offload is enabled
+ */
+static int testTLSSessionThroughput(const void *opaque)
+{
+    const struct testTLSBenchData *data = opaque;
+    virNetTLSContextPtr clientCtxt = NULL;
+    virNetTLSContextPtr serverCtxt = NULL;
+    virNetTLSSessionPtr clientSess = NULL;
+    virNetTLSSessionPtr serverSess = NULL;
+    struct testTLSBenchReader reader = { 0 };
+    virThread thread;
+    bool threadRunning = false;
+    int serverfd = -1;
+    int clientfd = -1;
+    bool clientShake = false;
+    bool serverShake = false;
+    unsigned long long sent = 0;
+    struct timespec start;
+    struct timespec end;
+    double secs;
+    char *buf = NULL;
+    int ret = -1;
+
+    if (!virTestGetExpensive())
+        return EXIT_AM_SKIP;
+
+    if (testTLSLoopbackPair(&serverfd, &clientfd) < 0)
+        goto cleanup;
+
+    ignore_value(virSetNonBlock(serverfd));
+    ignore_value(virSetNonBlock(clientfd));
+
+    if (!(serverCtxt = virNetTLSContextNewServer(data->cacrt, NULL,
+                                                 data->servercrt, KEYFILE,
+                                                 NULL, "NORMAL",
+                                                 false, true)) ||
+        !(clientCtxt = virNetTLSContextNewClient(data->cacrt, NULL,
+                                                 data->clientcrt, KEYFILE,
+                                                 "NORMAL", false, true)))
+        goto cleanup;
+
+    virNetTLSContextSetKernelOffload(serverCtxt, data->kernelOffload);
+
+    if (!(serverSess = virNetTLSSessionNew(serverCtxt, NULL)) ||
+        !(clientSess = virNetTLSSessionNew(clientCtxt, "libvirt.org")))
+        goto cleanup;
+
+    virNetTLSSessionSetIOCallbacks(serverSess, testWrite, testRead, &serverfd);
+    virNetTLSSessionSetIOCallbacks(clientSess, testWrite, testRead, &clientfd);
+    virNetTLSSessionSetSocketFD(serverSess, serverfd);
+
+    do {
+        int rv;
+        if (!serverShake) {
+            if ((rv = virNetTLSSessionHandshake(serverSess)) < 0)
+                goto cleanup;
+            if (rv == VIR_NET_TLS_HANDSHAKE_COMPLETE)
+                serverShake = true;
+        }
+        if (!clientShake) {
+            if ((rv = virNetTLSSessionHandshake(clientSess)) < 0)
+                goto cleanup;
+            if (rv == VIR_NET_TLS_HANDSHAKE_COMPLETE)
+                clientShake = true;
+        }
+    } while (!clientShake || !serverShake);
+
+    if (virSetBlocking(serverfd, true) < 0 ||
+        virSetBlocking(clientfd, true) < 0)
+        goto cleanup;
+
+    if (VIR_ALLOC_N(buf, BENCH_CHUNK) < 0)
+        goto cleanup;
+    memset(buf, 'x', BENCH_CHUNK);
+
+    reader.sess = clientSess;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (virThreadCreate(&thread, true, testTLSBenchRead, &reader) < 0)
+        goto cleanup;
+    threadRunning = true;
+
+    while (sent < BENCH_TOTAL) {
+        ssize_t done = virNetTLSSessionWrite(serverSess, buf, BENCH_CHUNK);
+
+        if (done < 0 && errno == EINTR)
+            continue;
+        if (done <= 0) {
+            virReportSystemError(errno, "%s", "Cannot send data");
+            goto cleanup;
+        }
+        sent += done;
+    }
+
+    virThreadJoin(&thread);
+    threadRunning = false;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (reader.failed || reader.got != sent) {
+        fprintf(stderr, "Sent %llu bytes, received %llu\n", sent, reader.got);
+        goto cleanup;
+    }
+
+    secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    VIR_TEST_VERBOSE("\n%llu MiB in %.3f s: %.1f MiB/s, kernel TLS %s\n",
+                     sent / (1024 * 1024), secs,
+                     sent / (1024 * 1024) / secs,
+                     virNetTLSSessionGetKernelOffload(serverSess) ?
+                     "used" : "not available");
+
+    ret = 0;
+
+ cleanup:
+    /* Unblock the reader if we failed half way */
+    if (threadRunning) {
+        shutdown(serverfd, SHUT_RDWR);
+        virThreadJoin(&thread);
+    }
+    VIR_FREE(buf);
+    virObjectUnref(serverCtxt);
+    virObjectUnref(clientCtxt);
+    virObjectUnref(serverSess);
+    virObjectUnref(clientSess);
+    VIR_FORCE_CLOSE(serverfd);
+    VIR_FORCE_CLOSE(clientfd);
+    return ret;
+}
+
+
 static int
 mymain(void)
 {
@@ -340,6 +553,21 @@ mymain(void)
     DO_SESS_TEST_EXT(cacertreq.filename, altcacertreq.filename, servercertreq.filename,
                      clientcertaltreq.filename, true, true, "libvirt.org", NULL);
 
+# define DO_BENCH_TEST(_name, _kernelOffload) \
+    do { \
+        static struct testTLSBenchData data; \
+        data.cacrt = cacertreq.filename; \
+        data.servercrt = servercertreq.filename; \
+        data.clientcrt = clientcertreq.filename; \
+        data.kernelOffload = _kernelOffload; \
+        if (virTestRun("TLS throughput " _name, \
+                       testTLSSessionThroughput, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_BENCH_TEST("user space", false);
+    DO_BENCH_TEST("kernel offload", true);
+
 
     /* When an altname is set, the CN is ignored, so it must be duplicated
      * as an altname for it to match */
@@ -284,6 +284,65 @@ testTypedParamsValidator(void)
     return rv;
 }
 
+static int
+testTypedParamList(const void *opaque ATTRIBUTE_UNUSED)
+{
+    VIR_AUTOPTR(virTypedParamList) list = NULL;
+    virTypedParameterPtr params = NULL;
+    virTypedParameterPtr par;
+    char longname[VIR_TYPED_PARAM_FIELD_LENGTH + 1];
+    size_t nparams = 0;
+    size_t i;
+    int rv = -1;
+
+    if (VIR_ALLOC(list) < 0 ||
+        virTypedParamListReserve(list, 4) < 0)
+        return -1;
+
+    for (i = 0; i < 100; i++) {
+        if (virTypedParamListAddULLong(list, i, "block.%zu.rd.bytes", i) < 0 ||
+            virTypedParamListAddString(list, NULL, "block.%zu.path", i) < 0)
+            goto cleanup;
+    }
+
+    /* first occurrence wins when looked up */
+    if (virTypedParamListAddInt(list, -1, "block.%d.rd.bytes", 0) < 0 ||
+        virTypedParamListAddBoolean(list, true, "block.count") < 0)
+        goto cleanup;
+
+    /* names which don't fit are rejected and not added */
+    memset(longname, 'a', VIR_TYPED_PARAM_FIELD_LENGTH);
+    longname[VIR_TYPED_PARAM_FIELD_LENGTH] = '\0';
+    if (virTypedParamListAddString(list, "x", "%s", longname) == 0)
+        goto cleanup;
+    virResetLastError();
+
+    if ((nparams = virTypedParamListStealParams(list, &params)) != 202 ||
+        list->npar != 0 || list->par)
+        goto cleanup;
+
+    if (STRNEQ(params[201].field, "block.count") ||
+        virTypedParamsGet(params, nparams, longname))
+        goto cleanup;
+
+    if (!(par = virTypedParamsGet(params, nparams, "block.42.rd.bytes")) ||
+        par->type != VIR_TYPED_PARAM_ULLONG || par->value.ul != 42)
+        goto cleanup;
+
+    if (!(par = virTypedParamsGet(params, nparams, "block.0.rd.bytes")) ||
+        par->type != VIR_TYPED_PARAM_ULLONG || par->value.ul != 0)
+        goto cleanup;
+
+    if (!(par = virTypedParamsGet(params, nparams, "block.99.path")) ||
+        par->type != VIR_TYPED_PARAM_STRING || STRNEQ(par->value.s, ""))
+        goto cleanup;
+
+    rv = 0;
+ cleanup:
+    virTypedParamsFree(params, nparams);
+    return rv;
+}
+
 static int
 mymain(void)
 {
@@ -301,6 +360,9 @@ mymain(void)
     if (virTestRun("Add string list", testTypedParamsAddStringList, NULL) < 0)
         rv = -1;
 
+    if (virTestRun("Parameter list", testTypedParamList, NULL) < 0)
+        rv = -1;
+
     if (rv < 0)
         return EXIT_FAILURE;
     return EXIT_SUCCESS;